@@ -0,0 +1,48 @@
+#ifndef LIBICEDFT_BENCH_H
+#define LIBICEDFT_BENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/* monotonic time in ns */
+static inline uint64_t
+bench_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* xorshift32; reproducible inputs */
+static inline uint32_t
+bench_rand(uint32_t *state)
+{
+	uint32_t x = *state;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+
+	return *state = x;
+}
+
+/* 1 with probability pct / 100 */
+static inline uint32_t
+bench_coin(uint32_t *state, uint32_t pct)
+{
+	return bench_rand(state) % 100 < pct;
+}
+
+/* one result line */
+static inline void
+bench_report(const char *what, const char *pattern, uint64_t ns,
+		uint64_t calls)
+{
+	printf("%-28s %-10s %8.2f ns/call\n", what, pattern,
+			(double)ns / (double)calls);
+}
+
+#endif /* LIBICEDFT_BENCH_H */
@@ -0,0 +1,196 @@
+/*
+ * branch-free handlers (IDFT_OPT_BRANCHFREE), A/B
+ *
+ * drives the plain and the branch-free variants of REP STOSD
+ * (r2m_xfer_opln) and CMPXCHG (the If/Then _fast/_slow pair of
+ * ins_inspect, the way the executer runs it) with the same
+ * inputs. "random" draws every data-dependent input (source tag,
+ * EFLAGS.DF, comparison outcome) with even odds, which defeats
+ * the branch predictor; "biased" makes each true 1% of the time
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "libicedft_api.h"
+#include "libicedft_core.h"
+#include "tagmap.h"
+#include "bench.h"
+
+
+#define NINPUT	(1 << 16)			/* inputs; a power of 2 */
+#define CALLS	(20 * 1000 * 1000)		/* per variant and pattern */
+#define DF	0x0400
+
+#ifndef MAP_32BIT
+#define MAP_32BIT	0
+#endif
+
+/* a REP STOSD */
+typedef struct {
+	ADDRINT		dst;
+	ADDRINT		count;
+	ADDRINT		eflags;
+	uint32_t	tag;			/* of EAX */
+} stos_in_t;
+
+/* a CMPXCHG r32, r32 and a CMPXCHG m32, r32 */
+typedef struct {
+	uint32_t	eax;
+	uint32_t	dst_val;		/* == eax if it succeeds */
+	uint32_t	dst;			/* VCPU index */
+	uint32_t	src;			/* VCPU index */
+	ADDRINT		mem;			/* holds dst_val */
+} cmpxchg_in_t;
+
+static const struct {
+	const char	*name;
+	uint32_t	pct;			/* odds of each input */
+} patterns[] = {
+	{ "random",	50 },
+	{ "biased",	1 },
+};
+
+static stos_in_t	stos_in[NINPUT];
+static cmpxchg_in_t	cmpxchg_in[NINPUT];
+static uint32_t		*words;			/* the m32 operands */
+
+static void
+stos_gen(uint32_t pct)
+{
+	uint32_t seed = 0x9E3779B9U, i;
+
+	for (i = 0; i < NINPUT; i++) {
+		stos_in[i].dst		= 0x100000 + (bench_rand(&seed) & 0xFFFF0);
+		stos_in[i].count	= 1 + bench_rand(&seed) % 16;
+		stos_in[i].eflags	= bench_coin(&seed, pct) ? DF : 0;
+		stos_in[i].tag		= bench_coin(&seed, pct) ? VCPU_MASK32 : 0;
+	}
+}
+
+static void
+cmpxchg_gen(uint32_t pct)
+{
+	uint32_t seed = 0x7F4A7C15U, i;
+
+	for (i = 0; i < NINPUT; i++) {
+		cmpxchg_in[i].eax	= bench_rand(&seed);
+		cmpxchg_in[i].dst_val	= cmpxchg_in[i].eax +
+			!bench_coin(&seed, pct);
+		cmpxchg_in[i].dst	= bench_rand(&seed) % 7;
+		cmpxchg_in[i].src	= bench_rand(&seed) % 7;
+		cmpxchg_in[i].mem	= (ADDRINT)(uintptr_t)&words[i];
+		words[i]		= cmpxchg_in[i].dst_val;
+	}
+}
+
+static void
+stos_run(const char *pattern, thread_ctx_t *tc)
+{
+	uint64_t t;
+	uint32_t i;
+
+	t = bench_ns();
+	for (i = 0; i < CALLS; i++) {
+		stos_in_t *in = &stos_in[i & (NINPUT - 1)];
+
+		VCPU_GPR_SET(tc, GPR_EAX, in->tag);
+		r2m_xfer_opln(tc, in->dst, in->count, in->eflags);
+	}
+	bench_report("rep stosd", pattern, bench_ns() - t, CALLS);
+
+	t = bench_ns();
+	for (i = 0; i < CALLS; i++) {
+		stos_in_t *in = &stos_in[i & (NINPUT - 1)];
+
+		VCPU_GPR_SET(tc, GPR_EAX, in->tag);
+		r2m_xfer_opln_bf(tc, in->dst, in->count, in->eflags);
+	}
+	bench_report("rep stosd (bf)", pattern, bench_ns() - t, CALLS);
+}
+
+static void
+cmpxchg_run(const char *pattern, thread_ctx_t *tc)
+{
+	uint64_t t;
+	uint32_t i;
+
+	t = bench_ns();
+	for (i = 0; i < CALLS; i++) {
+		cmpxchg_in_t *in = &cmpxchg_in[i & (NINPUT - 1)];
+
+		if (_cmpxchg_r2r_opl_fast(tc, in->eax, in->dst, in->dst_val))
+			_cmpxchg_r2r_opl_slow(tc, in->dst, in->src);
+	}
+	bench_report("cmpxchg r32, r32", pattern, bench_ns() - t, CALLS);
+
+	t = bench_ns();
+	for (i = 0; i < CALLS; i++) {
+		cmpxchg_in_t *in = &cmpxchg_in[i & (NINPUT - 1)];
+
+		_cmpxchg_r2r_opl_bf(tc, in->eax, in->dst, in->dst_val,
+				in->src);
+	}
+	bench_report("cmpxchg r32, r32 (bf)", pattern, bench_ns() - t,
+			CALLS);
+
+	t = bench_ns();
+	for (i = 0; i < CALLS; i++) {
+		cmpxchg_in_t *in = &cmpxchg_in[i & (NINPUT - 1)];
+
+		if (_cmpxchg_m2r_opl_fast(tc, in->eax, in->mem))
+			_cmpxchg_r2m_opl_slow(tc, in->mem, in->src);
+	}
+	bench_report("cmpxchg m32, r32", pattern, bench_ns() - t, CALLS);
+
+	t = bench_ns();
+	for (i = 0; i < CALLS; i++) {
+		cmpxchg_in_t *in = &cmpxchg_in[i & (NINPUT - 1)];
+
+		_cmpxchg_m2r_opl_bf(tc, in->eax, in->mem, in->src);
+	}
+	bench_report("cmpxchg m32, r32 (bf)", pattern, bench_ns() - t,
+			CALLS);
+}
+
+int
+main(void)
+{
+	thread_ctx_t tc;
+	size_t p;
+	uint32_t i, seed = 1;
+
+	if (tagmap_alloc() != 0) {
+		puts("tagmap_alloc failed");
+		return 1;
+	}
+
+	/* the operands are dereferenced through ADDRINT */
+	if ((words = mmap(NULL, NINPUT * sizeof(*words),
+			PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT,
+			-1, 0)) == MAP_FAILED) {
+		puts("mmap failed");
+		return 1;
+	}
+
+	memset(&tc, 0, sizeof(tc));
+	for (i = 0; i < GPR_NUM; i++)
+		VCPU_GPR_SET(&tc, i, bench_rand(&seed) & VCPU_MASK32);
+	tagmap_setn(0x100000, 0x10000);
+	tagmap_setn((size_t)(uintptr_t)words, NINPUT * sizeof(*words) / 2);
+
+	for (p = 0; p < sizeof(patterns) / sizeof(patterns[0]); p++) {
+		stos_gen(patterns[p].pct);
+		cmpxchg_gen(patterns[p].pct);
+
+		stos_run(patterns[p].name, &tc);
+		cmpxchg_run(patterns[p].name, &tc);
+	}
+
+	munmap(words, NINPUT * sizeof(*words));
+	tagmap_free();
+
+	return 0;
+}
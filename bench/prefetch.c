@@ -0,0 +1,126 @@
+/*
+ * shadow prefetching (IDFT_OPT_PREFETCH), on and off
+ *
+ * replays the analysis calls of a block the way the executer
+ * runs them: gap register handlers (the instructions before
+ * the accesses) and then three m32 loads, with and without
+ * the shadow_prefetch3 call that bbl_inspect puts at its
+ * entry. "scattered" draws the addresses over a 1 GB heap,
+ * whose tags (128 MB) miss in the cache; "cached" keeps them
+ * within 16 KB, which shows what the call costs when there is
+ * no miss to hide. The saving is the difference of each pair
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "libicedft_api.h"
+#include "libicedft_core.h"
+#include "tagmap.h"
+#include "bench.h"
+
+
+#define NINPUT	(1 << 16)			/* inputs; a power of 2 */
+#define CALLS	(4 * 1000 * 1000)		/* blocks per variant and pattern */
+#define HEAP	0x10000000			/* the (untouched) heap */
+#define HEAP_SZ	(1U << 30)
+
+/* the accesses of a block; base register value and displacement */
+typedef struct {
+	ADDRINT		base[3];
+	uint32_t	disp[3];
+} block_in_t;
+
+static const struct {
+	const char	*name;
+	uint32_t	span;			/* of the addresses */
+} patterns[] = {
+	{ "scattered",	HEAP_SZ },
+	{ "cached",	16 * 1024 },
+};
+
+static const uint32_t gaps[] = { 0, 8, 32 };
+
+static block_in_t block_in[NINPUT];
+
+static void
+block_gen(uint32_t span)
+{
+	uint32_t seed = 0x2545F491U, addr, i, k;
+
+	for (i = 0; i < NINPUT; i++)
+		for (k = 0; k < 3; k++) {
+			addr = HEAP + (bench_rand(&seed) % span & ~3U);
+
+			block_in[i].base[k] = addr & ~0xFFFU;
+			block_in[i].disp[k] = addr & 0xFFFU;
+		}
+}
+
+/* the analysis calls of one block after its entry */
+static inline void
+block_body(thread_ctx_t *tc, const block_in_t *in, uint32_t gap)
+{
+	uint32_t j;
+
+	for (j = 0; j < gap; j++)
+		r2r_binary_opl(tc, j % 7, (j + 1) % 7);
+
+	m2r_xfer_opl(tc, 0, in->base[0] + in->disp[0]);
+	m2r_xfer_opl(tc, 1, in->base[1] + in->disp[1]);
+	m2r_xfer_opl(tc, 2, in->base[2] + in->disp[2]);
+}
+
+static void
+block_run(const char *pattern, thread_ctx_t *tc, uint32_t gap)
+{
+	char what[32];
+	uint64_t t;
+	uint32_t i;
+
+	t = bench_ns();
+	for (i = 0; i < CALLS; i++)
+		block_body(tc, &block_in[i & (NINPUT - 1)], gap);
+	snprintf(what, sizeof(what), "block, gap %u", gap);
+	bench_report(what, pattern, bench_ns() - t, CALLS);
+
+	t = bench_ns();
+	for (i = 0; i < CALLS; i++) {
+		block_in_t *in = &block_in[i & (NINPUT - 1)];
+
+		shadow_prefetch3(in->base[0], in->disp[0],
+				in->base[1], in->disp[1],
+				in->base[2], in->disp[2]);
+		block_body(tc, in, gap);
+	}
+	snprintf(what, sizeof(what), "block, gap %u (prefetch)", gap);
+	bench_report(what, pattern, bench_ns() - t, CALLS);
+}
+
+int
+main(void)
+{
+	thread_ctx_t tc;
+	size_t p, g;
+
+	if (tagmap_alloc() != 0) {
+		puts("tagmap_alloc failed");
+		return 1;
+	}
+
+	/* back the tags of the heap; untouched ones share the zero page */
+	tagmap_setn(HEAP, HEAP_SZ);
+
+	memset(&tc, 0, sizeof(tc));
+
+	for (p = 0; p < sizeof(patterns) / sizeof(patterns[0]); p++) {
+		block_gen(patterns[p].span);
+
+		for (g = 0; g < sizeof(gaps) / sizeof(gaps[0]); g++)
+			block_run(patterns[p].name, &tc, gaps[g]);
+	}
+
+	tagmap_free();
+
+	return 0;
+}
@@ -38,7 +38,18 @@
 #include <stdlib.h>
 
 #include "libicedft_api.h"
+#include "libicedft_argpack.h"
+#include "libicedft_coalesce.h"
 #include "libicedft_core.h"
+#include "libicedft_filter.h"
+#include "libicedft_inline.h"
+#include "libicedft_jit.h"
+#include "libicedft_plan.h"
+#include "libicedft_prog.h"
+#include "libicedft_ring.h"
+#include "libicedft_shift.h"
+#include "libicedft_thread.h"
+#include "libicedft_tier.h"
 #include "tagmap.h"
 #include "branch_pred.h"
 
@@ -64,9 +75,22 @@ libdft_init( idft_executer_api_t* executer_api ,   void* executer_context , idft
 
     context = malloc(sizeof(idft_context_t));
 
+	if (unlikely(context == NULL)) {
+		tagmap_free();
+		return 1;
+	}
+
+	memset(context, 0, sizeof(idft_context_t));
+
 	context->executer_api = executer_api;
 
+	context->opts = (IDFT_OPT_IR | IDFT_OPT_IDIOM | IDFT_OPT_ARGPACK |
+		IDFT_OPT_COALESCE) & IDFT_OPT_ALL;
+
 	context->executer_context = executer_context;
+
+	/* shift and rotate maps */
+	shift_init();
     
 	*pcontext = context;
 
@@ -89,6 +113,35 @@ libdft_die(idft_context_t * context)
 	/* deallocate the resources needed for the tagmap */
 	tagmap_free();
 
+	/* recorder and IR buffers (bbl_inspect) */
+	free(context->rec_buf);
+	free(context->ir_block);
+
+	/* native stubs */
+	jit_free(context);
+
+	/* taint programs */
+	prog_cache_free(context);
+
+	/* instrumentation filters */
+	filter_free(context);
+
+	/* argument packs */
+	argpack_free(context);
+
+	/* coalesced access groups */
+	coalesce_free(context);
+
+	/* block execution counters */
+	tier_free(context);
+
+	/* instrumentation plans; saved first */
+	plan_free(context);
+
+	/* event rings and thread contexts */
+	ring_free(context);
+	thread_pool_free(context);
+
     free(context);
 
 
@@ -146,11 +199,167 @@ REG8_INDX(idft_ins_t* ins , idft_context_t * context, idft_reg_t reg)
 	return indx; 
 }
 
+  //Executer 64bit reg to vcpu reg map
+  //param 1: pointer to a instruction , which can be NULL
+  //param 2: idft_context_t context
+  //param 3: Executer reg 
+  //return: the reg index in vcpu (see vcpu_ctx_t comments) 
+uint32_t
+REG64_INDX(idft_ins_t* ins , idft_context_t * context, idft_reg_t reg)
+{
+	/* 32-bit executers do not provide it */
+	if (unlikely(context->executer_api->REG64_INDX == NULL))
+		return GPR_SCRATCH;
+
+	return (uint32_t) context->executer_api->REG64_INDX(ins , context, reg);
+}
+
+
+/*
+ * set engine options
+ *
+ * @context:	the engine context
+ * @opts:	IDFT_OPT_* flags; those this build does not
+ *		support (see IDFT_OPT_ALL) are dropped
+ *
+ * returns: the previous options
+ */
+uint32_t
+libdft_set_opts(idft_context_t * context, uint32_t opts)
+{
+	uint32_t old = context->opts;
+
+	context->opts = opts & IDFT_OPT_ALL;
+
+	return old;
+}
+
+/*
+ * cumulative bbl_inspect statistics
+ *
+ * @context:	the engine context
+ */
+const idft_block_stats_t*
+libdft_stats(idft_context_t * context)
+{
+	return &context->stats;
+}
+
+
+/*
+ * set the native stub invalidation hook
+ *
+ * @context:	the engine context
+ * @cb:		the hook
+ * @arg:	its argument
+ *
+ * returns: 0 on success, 1 on error
+ */
+int
+libdft_jit_set_flush_cb(idft_context_t * context, void (*cb)(void* arg), void* arg)
+{
+	if (!jit_available())
+		return 1;
+
+	return jit_set_flush_cb(context, cb, arg);
+}
+
+/*
+ * invalidate every native stub
+ *
+ * @context:	the engine context
+ */
+void
+libdft_jit_flush(idft_context_t * context)
+{
+	jit_flush(context);
+}
+
 
 uint8_t* libdft_tag_bitmap()
 {
+	/* writes through it are not seen; assume they tag something */
+	tagmap_live_set(1);
+
 	return bitmap;
 }
 
+/*
+ * is taint live
+ *
+ * @thread_ctx:	a thread whose VCPU is checked as well; may be NULL
+ *		(its summary is refreshed)
+ *
+ * returns: non-zero if yes, 0 otherwise
+ */
+uint32_t
+libdft_taint_live(thread_ctx_t* thread_ctx)
+{
+	if (tagmap_is_live())
+		return 1;
+
+	return thread_ctx != NULL && thread_ctx_live(thread_ctx);
+}
+
+/*
+ * register the liveness hook
+ *
+ * @cb:		called on every transition
+ * @arg:	its first argument
+ *
+ * returns: 0 on success
+ */
+int
+libdft_taint_set_cb(void (*cb)(void* arg, uint32_t live), void* arg)
+{
+	tagmap_set_live_cb(cb, arg);
 
+	return 0;
+}
 
+/*
+ * untag everything
+ *
+ * @thread_ctx:	a thread whose VCPU is cleared as well; may be NULL
+ */
+void
+libdft_taint_clear(thread_ctx_t* thread_ctx)
+{
+	tagmap_clear_all();
+
+	if (thread_ctx != NULL) {
+		memset(&thread_ctx->vcpu, 0, sizeof(thread_ctx->vcpu));
+		(void)thread_ctx_live(thread_ctx);
+	}
+}
+
+/* analysis routines with an inline version (libicedft_inline.h) */
+static const idft_handler_info_t handler_info[] = {
+#define HANDLER_INFO(func, name, flags)					\
+	{ (void *)func, #name, IDFT_HANDLER_INLINE | (flags) },
+	IDFT_INLINE_HANDLERS(HANDLER_INFO)
+#undef HANDLER_INFO
+};
+
+/*
+ * look up the metadata of an analysis routine; executers call
+ * this at instrumentation time, to pick the inlined insertion
+ * path (and the idft_inline_* version) where one exists
+ *
+ * @func:	the routine, as passed to an insert-call function
+ *
+ * returns: its metadata, or NULL if it must be called out-of-line
+ */
+const idft_handler_info_t*
+libdft_handler_info(void* func)
+{
+#ifndef USE_CUSTOM_TAG
+	size_t i;
+
+	for (i = 0; i < sizeof(handler_info) / sizeof(handler_info[0]); i++)
+		if (handler_info[i].func == func)
+			return &handler_info[i];
+#endif
+	/* custom tags are not handled by libicedft_inline.h */
+	return NULL;
+}
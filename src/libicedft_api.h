@@ -39,7 +39,40 @@
 
 
 
+#ifndef IDFT_X86_64
 #define GPR_NUM		8			/* general purpose registers */
+#define XMM_NUM		8			/* XMM/YMM registers */
+#else
+#define GPR_NUM		16			/* ditto; x86-64 */
+#define XMM_NUM		16
+#endif
+
+#if defined(IDFT_X86_64) && defined(USE_PACKED_VCPU)
+#error "USE_PACKED_VCPU holds 4-bit registers; it cannot be used with IDFT_X86_64"
+#endif
+
+/* engine options (libdft_set_opts) */
+#define IDFT_OPT_IR	0x01			/* optimize blocks (bbl_inspect) */
+#define IDFT_OPT_IR_LOG	0x02			/* log per-block IR statistics */
+#define IDFT_OPT_JIT	0x04			/* compile register runs (bbl_inspect) */
+#define IDFT_OPT_IDIOM	0x08			/* fuse stack idioms (bbl_inspect) */
+#define IDFT_OPT_ARGPACK	0x10		/* pass operands as argument packs (bbl_inspect) */
+#define IDFT_OPT_COALESCE	0x20		/* coalesce base+displacement accesses (bbl_inspect) */
+#define IDFT_OPT_PREFETCH	0x40		/* prefetch the tags of a block at entry (bbl_inspect) */
+#define IDFT_OPT_TIER	0x80			/* optimize hot blocks only (bbl_inspect) */
+#define IDFT_OPT_BRANCHFREE	0x100		/* branch-free data-dependent handlers (ins_inspect) */
+
+/* the options this build supports */
+#define IDFT_OPT_ALL	0x1FF
+
+/* instrumentation filter actions (libdft_filter_*) */
+#define IDFT_FILTER_INCLUDE		0	/* instrument */
+#define IDFT_FILTER_EXCLUDE		1	/* do not instrument */
+#define IDFT_FILTER_EXCLUDE_CLEAR	2	/* ditto; clear EAX, ECX, EDX tags on entry */
+
+/* analysis routine properties (libdft_handler_info) */
+#define IDFT_HANDLER_INLINE	0x01		/* has an inline version (libicedft_inline.h) */
+#define IDFT_HANDLER_PREDICATE	0x02		/* If-call; its result selects the Then-call */
 
 /* FIXME: turn off the EFLAGS.AC bit by applying the corresponding mask */
 #define CLEAR_EFLAGS_AC(eflags)	((eflags & 0xfffbffff))
@@ -61,7 +94,13 @@ enum {						 /* {en,dis}able (ins_desc_t) */
 };
 
 // NOTE: This uses the same mapping as the vcpu_ctx_t struct defined below!
+#ifndef IDFT_X86_64
 enum gpr {GPR_EDI, GPR_ESI, GPR_EBP, GPR_ESP, GPR_EBX, GPR_EDX, GPR_ECX, GPR_EAX, GPR_SCRATCH};
+#else
+enum gpr {GPR_EDI, GPR_ESI, GPR_EBP, GPR_ESP, GPR_EBX, GPR_EDX, GPR_ECX, GPR_EAX,
+	GPR_R8, GPR_R9, GPR_R10, GPR_R11, GPR_R12, GPR_R13, GPR_R14, GPR_R15,
+	GPR_SCRATCH};
+#endif
 
 #ifdef USE_CUSTOM_TAG
 #define TAGS_PER_GPR 4
@@ -98,12 +137,71 @@ typedef struct {
 	 * 	6: ECX
 	 * 	7: EAX
 	 * 	8: scratch (not a real register; helper) 
+	 *
+	 * IDFT_X86_64: the 64-bit GPRs are represented with
+	 * 8 bits each (the lower 8 bits), with the same
+	 * mapping for RDI to RAX, then 8 to 15 for R8 to R15
+	 * and 16 for scratch
 	 */
 
+#ifndef USE_PACKED_VCPU
 	uint32_t gpr[GPR_NUM + 1];
+#else
+	/*
+	 * USE_PACKED_VCPU: all of the above in one word,
+	 * register i in bits [4i, 4i + 3], so that the
+	 * whole VCPU is checked (or saved) with one access
+	 */
+	uint64_t gpr;
+#endif
+
+	/*
+	 * XMM/YMM registers (XMM0 to XMM7); one bit per
+	 * byte, the lower 16 bits for the XMM register and
+	 * the upper 16 for the rest of its YMM register
+	 */
+	uint32_t xmm[XMM_NUM];
 
 } vcpu_ctx_t;
 
+/*
+ * VCPU register tag accessors; handlers and executers
+ * use these instead of indexing gpr, so that they work
+ * with either layout
+ *
+ * VCPU_GPR:		the tag bits of reg
+ * VCPU_GPR_SET:	replace the tag bits of reg (tag <= VCPU_MASK32, or
+ *			VCPU_MASK64 with IDFT_X86_64)
+ * VCPU_GPR_ANY:	non-zero if any GPR (but scratch) is tagged
+ */
+#ifndef USE_PACKED_VCPU
+#define VCPU_GPR(thread_ctx, reg)	((thread_ctx)->vcpu.gpr[(reg)])
+#define VCPU_GPR_SET(thread_ctx, reg, tag)				\
+	((thread_ctx)->vcpu.gpr[(reg)] = (tag))
+/* the tags of the 8 GPRs starting at base, OR-ed */
+#define VCPU_GPR_ANY8(thread_ctx, base)					\
+	((thread_ctx)->vcpu.gpr[(base)] | (thread_ctx)->vcpu.gpr[(base) + 1] | \
+	 (thread_ctx)->vcpu.gpr[(base) + 2] | (thread_ctx)->vcpu.gpr[(base) + 3] | \
+	 (thread_ctx)->vcpu.gpr[(base) + 4] | (thread_ctx)->vcpu.gpr[(base) + 5] | \
+	 (thread_ctx)->vcpu.gpr[(base) + 6] | (thread_ctx)->vcpu.gpr[(base) + 7])
+#ifndef IDFT_X86_64
+#define VCPU_GPR_ANY(thread_ctx)	VCPU_GPR_ANY8(thread_ctx, GPR_EDI)
+#else
+#define VCPU_GPR_ANY(thread_ctx)					\
+	(VCPU_GPR_ANY8(thread_ctx, GPR_EDI) | VCPU_GPR_ANY8(thread_ctx, GPR_R8))
+#endif
+#else
+#define VCPU_GPR_SHIFT(reg)		((uint32_t)(reg) << 2)
+#define VCPU_GPR(thread_ctx, reg)					\
+	((uint32_t)((thread_ctx)->vcpu.gpr >> VCPU_GPR_SHIFT(reg)) & 0x0F)
+#define VCPU_GPR_SET(thread_ctx, reg, tag)				\
+	((thread_ctx)->vcpu.gpr =					\
+	 ((thread_ctx)->vcpu.gpr & ~(0x0FULL << VCPU_GPR_SHIFT(reg))) |	\
+	 ((uint64_t)((tag) & 0x0F) << VCPU_GPR_SHIFT(reg)))
+#define VCPU_GPR_ANY(thread_ctx)					\
+	((uint32_t)(thread_ctx)->vcpu.gpr)
+#endif
+
 /*
  * system call context definition
  *
@@ -117,13 +215,31 @@ typedef struct {
 /* 	ADDRINT errno; */		/* error code */
 } syscall_ctx_t;
 
-/* thread context definition */
+/*
+ * thread context definition
+ *
+ * live summarizes the VCPU, one bit per GPR (bit i: gpr[i]
+ * is tagged) and bit GPR_NUM for the XMM/YMM registers as a
+ * whole, as of the tagmap epoch in live_epoch; it is
+ * refreshed lazily by the block guards (see thread_ctx_live).
+ * Executers that tag VCPU registers directly must mark it
+ * stale with THREAD_CTX_STALE. slot points back to the context
+ * itself when it comes from the thread pool (libdft_thread_start),
+ * so that copies and executer-owned contexts are never taken for
+ * pool slots
+ */
 typedef struct {
 	vcpu_ctx_t	vcpu;		/* VCPU context */
 	syscall_ctx_t	syscall_ctx;	/* syscall context */
 	void		*uval;		/* local storage */
+	uint32_t	live;		/* tagged GPRs (summary) */
+	uint32_t	live_epoch;	/* tagmap epoch of the summary */
+	void		*slot;		/* itself, if pooled */
 } thread_ctx_t;
 
+/* an odd epoch never matches while taint is dead */
+#define THREAD_CTX_STALE(thread_ctx)	((thread_ctx)->live_epoch = 1)
+
 
 
 #ifdef __cplusplus
@@ -152,12 +268,177 @@ apply dft populate logic to input instruction
 */
 LIBICEDFT_EXPORT void ins_inspect(idft_ins_t* ins , idft_context_t * context);
 
+/*
+ * apply dft populate logic to a basic block; the calls
+ * ins_inspect would insert are lowered into taint micro-ops
+ * and optimized across the block (see libicedft_ir.c)
+ * ins: the instructions of the block, in execution order
+ * ins_num: instruction count
+ * stats: per-block lowering statistics (out); may be NULL
+ */
+LIBICEDFT_EXPORT void bbl_inspect(idft_ins_t* ins , uint32_t ins_num, idft_context_t * context, idft_block_stats_t* stats);
+
+/*
+ * like bbl_inspect, for a single-entry trace of blocks that is
+ * optimized as one superblock
+ * ins: the instructions of the trace, in execution order
+ * bbl_len: the instruction count of each block, in order
+ * bbl_num: block count
+ */
+LIBICEDFT_EXPORT void trace_inspect(idft_ins_t* ins , const uint32_t* bbl_len, uint32_t bbl_num, idft_context_t * context, idft_block_stats_t* stats);
+
+/*
+ * instrument the first instruction of an uninstrumented block
+ * version with a guard that makes taint live, firing the
+ * liveness hook (see libdft_taint_set_cb), if the block runs
+ * while the VCPU of its thread is tagged
+ */
+LIBICEDFT_EXPORT void guard_inspect(idft_ins_t* ins , idft_context_t * context);
+
+/*
+ * is taint live; globally, or (if thread_ctx is not NULL)
+ * in the VCPU of a thread. While it is not, blocks may run
+ * in their uninstrumented versions (see guard_inspect)
+ */
+LIBICEDFT_EXPORT uint32_t libdft_taint_live(thread_ctx_t* thread_ctx);
+
+/*
+ * register the liveness hook; called once per transition, with
+ * live = 1 when taint first enters the tagmap (or a guard trips)
+ * and with live = 0 when it is cleared, so that the executer can
+ * flush its code cache and switch block versions. It runs before
+ * the first tag is written; for no thread to miss that tag, the
+ * hook must not return while a thread may still be inside an
+ * uninstrumented block. Returns 0 on success
+ */
+LIBICEDFT_EXPORT int libdft_taint_set_cb(void (*cb)(void* arg, uint32_t live), void* arg);
+
+/*
+ * untag the whole address space (and the VCPU of thread_ctx,
+ * if not NULL); the other threads must be cleared by the
+ * executer for taint to become dead (see libdft_thread_foreach)
+ */
+LIBICEDFT_EXPORT void libdft_taint_clear(thread_ctx_t* thread_ctx);
+
+/*
+ * thread contexts; start returns the zeroed context of thread
+ * tid, 64-byte aligned (no two share a cache line) and on the
+ * NUMA node of the calling thread, or NULL on error. fini
+ * recycles it; get looks it up, from any thread; foreach
+ * visits every started thread and returns their number
+ */
+LIBICEDFT_EXPORT thread_ctx_t* libdft_thread_start(idft_context_t * context, uint32_t tid);
+LIBICEDFT_EXPORT void libdft_thread_fini(idft_context_t * context, thread_ctx_t* thread_ctx);
+LIBICEDFT_EXPORT thread_ctx_t* libdft_thread_get(idft_context_t * context, uint32_t tid);
+LIBICEDFT_EXPORT uint32_t libdft_thread_foreach(idft_context_t * context, void (*cb)(void* arg, uint32_t tid, thread_ctx_t* thread_ctx), void* arg);
+
+/*
+ * set engine options (IDFT_OPT_*); returns the previous ones
+ */
+LIBICEDFT_EXPORT uint32_t libdft_set_opts(idft_context_t * context, uint32_t opts);
+
+/*
+ * tiered instrumentation (IDFT_OPT_TIER); blocks are first
+ * instrumented plainly, with an execution counter, and are
+ * optimized once they have run threshold times (the executer
+ * re-instruments them; see RemoveInstrumentationInRange)
+ * returns: the previous threshold
+ */
+LIBICEDFT_EXPORT uint32_t libdft_tier_set_threshold(idft_context_t * context, uint32_t threshold);
+
+/*
+ * cumulative bbl_inspect statistics
+ */
+LIBICEDFT_EXPORT const idft_block_stats_t* libdft_stats(idft_context_t * context);
+
+/*
+ * native stubs (IDFT_OPT_JIT); the hook is called before the
+ * stub cache is recycled, and the executer must drop every
+ * instrumented block that may still call a stub
+ * returns: 0 on success, 1 on error (no code generator for this host)
+ */
+LIBICEDFT_EXPORT int libdft_jit_set_flush_cb(idft_context_t * context, void (*cb)(void* arg), void* arg);
+
+/*
+ * invalidate every native stub (the flush hook runs first)
+ */
+LIBICEDFT_EXPORT void libdft_jit_flush(idft_context_t * context);
+
+/*
+ * taint programs; a block's propagation as bytecode, run by
+ * the engine's interpreter instead of per-instruction calls.
+ * Blocks with predicated or If/Then calls have no program
+ * (NULL) and must be instrumented with ins_inspect/bbl_inspect.
+ * Before libdft_prog_run, ea[slot] must hold the effective
+ * address described by each slot (libdft_prog_slots)
+ */
+LIBICEDFT_EXPORT idft_prog_t* libdft_prog_build(idft_ins_t* ins , uint32_t ins_num, idft_context_t * context);
+LIBICEDFT_EXPORT void libdft_prog_free(idft_prog_t* prog);
+LIBICEDFT_EXPORT idft_prog_t* libdft_prog_get(idft_context_t * context, ADDRINT key, idft_ins_t* ins , uint32_t ins_num);
+LIBICEDFT_EXPORT idft_prog_t* libdft_prog_lookup(idft_context_t * context, ADDRINT key);
+LIBICEDFT_EXPORT void libdft_prog_invalidate(idft_context_t * context, ADDRINT key);
+LIBICEDFT_EXPORT void libdft_prog_flush(idft_context_t * context);
+LIBICEDFT_EXPORT const idft_prog_slot_t* libdft_prog_slots(const idft_prog_t* prog, uint32_t* nslots);
+LIBICEDFT_EXPORT void libdft_prog_run(const idft_prog_t* prog, thread_ctx_t* thread_ctx, const ADDRINT* ea);
+
+/*
+ * decoupled analysis; push appends a program (and ea, as for
+ * libdft_prog_run) to the ring of the calling thread instead of
+ * running it, and stalls while the ring is full. Analysis threads
+ * replay the rings with poll, which returns the number of records
+ * replayed. drain returns once the ring of thread_ctx is replayed;
+ * a thread must drain before syscalls, sinks, and blocks without
+ * a program. Needs contexts from libdft_thread_start
+ */
+LIBICEDFT_EXPORT void libdft_ring_push(idft_context_t * context, thread_ctx_t* thread_ctx, const idft_prog_t* prog, const ADDRINT* ea);
+LIBICEDFT_EXPORT void libdft_ring_drain(thread_ctx_t* thread_ctx);
+LIBICEDFT_EXPORT uint32_t libdft_ring_poll(idft_context_t * context, uint32_t budget);
+
+/*
+ * instrumentation filters; excluded code gets no analysis calls.
+ * Priority, lowest first: module patterns, address ranges,
+ * function overrides. Needs INS_Address from the executer, which
+ * must flush already instrumented code after changing the rules.
+ * lo and hi are both inclusive; all return 0 on success, 1 on error
+ */
+LIBICEDFT_EXPORT int libdft_filter_range(idft_context_t * context, ADDRINT lo, ADDRINT hi, uint32_t action);
+LIBICEDFT_EXPORT int libdft_filter_function(idft_context_t * context, ADDRINT lo, ADDRINT hi, uint32_t action);
+LIBICEDFT_EXPORT int libdft_filter_module(idft_context_t * context, const char* glob, uint32_t action);
+LIBICEDFT_EXPORT int libdft_filter_module_load(idft_context_t * context, const char* name, ADDRINT lo, ADDRINT hi);
+LIBICEDFT_EXPORT void libdft_filter_module_unload(idft_context_t * context, ADDRINT lo);
+LIBICEDFT_EXPORT uint32_t libdft_filter_check(idft_context_t * context, ADDRINT addr);
+LIBICEDFT_EXPORT void libdft_filter_reset(idft_context_t * context);
+
+/*
+ * persistent instrumentation plans; for the instructions of a
+ * module with a plan file, the calls ins_inspect inserts are
+ * stored (at libdft_plan_save, libdft_plan_unload or libdft_die)
+ * and, on later runs, inserted from the file instead. The key
+ * (the module build-id, or a hash of its contents; less than
+ * 64 bytes) must match for a file to be used, as must the options
+ * ins_inspect depends on (IDFT_OPT_BRANCHFREE), as of the load.
+ * Needs INS_Address. lo and hi are both inclusive; all return 0 on
+ * success, 1 on error
+ */
+LIBICEDFT_EXPORT int libdft_plan_load(idft_context_t * context, const char* path, const char* key, ADDRINT lo, ADDRINT hi);
+LIBICEDFT_EXPORT int libdft_plan_save(idft_context_t * context);
+LIBICEDFT_EXPORT void libdft_plan_unload(idft_context_t * context, ADDRINT lo);
+
+/*
+ * metadata of the analysis routine func, as passed to the
+ * executer by the insert-call functions; NULL for routines
+ * that must be called out-of-line
+ */
+LIBICEDFT_EXPORT const idft_handler_info_t* libdft_handler_info(void* func);
+
 /* REG API */
 LIBICEDFT_EXPORT uint32_t REG32_INDX(idft_ins_t* ins , idft_context_t * context, idft_reg_t reg);
 LIBICEDFT_EXPORT uint32_t REG16_INDX(idft_ins_t* ins , idft_context_t * context, idft_reg_t reg);
 LIBICEDFT_EXPORT uint32_t REG8_INDX(idft_ins_t* ins , idft_context_t * context, idft_reg_t reg);
+LIBICEDFT_EXPORT uint32_t REG64_INDX(idft_ins_t* ins , idft_context_t * context, idft_reg_t reg);
 
-//get tag bitmap
+//get tag bitmap; taint becomes live (see libdft_taint_set_cb), since
+//the engine cannot tell what is written through it
 LIBICEDFT_EXPORT uint8_t* libdft_tag_bitmap();
 
 
@@ -0,0 +1,233 @@
+/*
+ * precompiled argument packs
+ *
+ * the analysis calls handed to the executer take their
+ * operands as variadic IARG_* lists, which the executer
+ * parses at instrumentation time and turns into 3-7 separate
+ * arguments at run time. With IDFT_OPT_ARGPACK, bbl_inspect
+ * instead describes every register or register/memory
+ * micro-op (see libicedft_ir.c) with an argument pack: the
+ * VCPU indices, lane shifts and masks of the operation,
+ * computed once. The call then takes the thread context, a
+ * pointer to the pack (IARG_ADDRINT) and, for memory, the
+ * effective address; three generic routines (argpack_r2r,
+ * argpack_m2r and argpack_r2m in libicedft_core.c) execute
+ * all of them, without branches.
+ *
+ * packs are interned per context, so equal operands share
+ * one pack; there are only a few thousand distinct ones,
+ * and they are never modified or released before libdft_die
+ * (the executer may keep instrumented code around)
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "libicedft_api.h"
+#include "libicedft_argpack.h"
+#include "libicedft_core.h"
+#include "branch_pred.h"
+
+
+/* lowest lane of a mask, and the number of lanes in it */
+static uint8_t
+argpack_first(uint8_t mask)
+{
+	uint8_t i = 0;
+
+	while (i < 7 && (mask & (1 << i)) == 0)
+		i++;
+
+	return i;
+}
+
+static uint8_t
+argpack_lanes(uint8_t mask)
+{
+	uint8_t n = 0;
+
+	for (; mask; mask >>= 1)
+		n += (mask & 1);
+
+	return n;
+}
+
+/*
+ * describe a micro-op as an argument pack
+ *
+ * NOTE: as in libicedft_jit.c, all the lane masks in
+ * use are contiguous, so moving lanes is a shift
+ *
+ * @uop:	the micro-op
+ * @pack:	the pack (out)
+ *
+ * returns: the routine that executes it, or NULL
+ * if it cannot be described
+ */
+void *
+argpack_make(ir_uop_t *uop, idft_argpack_t *pack)
+{
+	uint8_t ns, nd;
+
+	memset(pack, 0, sizeof(*pack));
+
+	switch (uop->op) {
+		case UOP_CLEAR:
+			if (uop->dst.kind != LOC_REG)
+				return NULL;
+			/* t[dst] = (t[dst] & ~dclr) | 0 */
+			pack->dst	= uop->dst.reg;
+			pack->src	= uop->dst.reg;
+			pack->dclr	= uop->dst.mask | IR_ZEXT(&uop->dst);
+			return (void *)argpack_r2r;
+		case UOP_COPY:
+		case UOP_UNION:
+		case UOP_EXTEND:
+			break;
+		default:
+			return NULL;
+	}
+
+	/* memory to memory has two addresses; left as it is */
+	if (uop->dst.kind == LOC_MEM && uop->src.kind == LOC_MEM)
+		return NULL;
+
+	if (uop->src.kind == LOC_REG) {
+		pack->src	= uop->src.reg;
+		pack->sshift	= argpack_first(uop->src.mask);
+		ns		= argpack_lanes(uop->src.mask);
+	}
+	else
+		ns		= uop->src.len;
+	pack->smask = (uint8_t)((1U << ns) - 1);
+
+	if (uop->dst.kind == LOC_REG) {
+		pack->dst	= uop->dst.reg;
+		pack->dshift	= argpack_first(uop->dst.mask);
+		nd		= argpack_lanes(uop->dst.mask);
+		pack->dclr	= uop->dst.mask | IR_ZEXT(&uop->dst);
+	}
+	else {
+		nd		= uop->dst.len;
+		pack->dclr	= (uint8_t)((1U << nd) - 1);
+	}
+
+	/* unions keep the destination (but zero-extend it) */
+	if (uop->op == UOP_UNION)
+		pack->dclr = IR_ZEXT(&uop->dst);
+
+	/* sign extension; repeat the source lanes */
+	for (pack->mul = 1; uop->op == UOP_EXTEND && ns < nd; ns <<= 1)
+		pack->mul |= (uint8_t)(pack->mul << ns);
+
+	if (uop->dst.kind == LOC_MEM)
+		return (void *)argpack_r2m;
+	if (uop->src.kind == LOC_MEM)
+		return (void *)argpack_m2r;
+
+	return (void *)argpack_r2r;
+}
+
+/*
+ * intern a pack
+ *
+ * @context:	the engine context
+ * @pack:	the pack
+ *
+ * returns: the shared copy, or NULL if the table is full
+ */
+static const idft_argpack_t *
+argpack_intern(idft_context_t *context, const idft_argpack_t *pack)
+{
+	argpack_tbl_t *tbl = (argpack_tbl_t *)context->argpacks;
+	uint64_t key;
+	uint32_t h;
+
+	if (unlikely(tbl == NULL)) {
+		if ((tbl = calloc(1, sizeof(argpack_tbl_t))) == NULL)
+			return NULL;
+		context->argpacks = tbl;
+	}
+
+	/* the 8 bytes of the pack; top 13 bits (ARGPACK_HASH_SZ) */
+	memcpy(&key, pack, sizeof(key));
+	h = (uint32_t)((key * 0x9E3779B97F4A7C15ULL) >> 51);
+
+	/* linear probing */
+	for (;; h = (h + 1) & (ARGPACK_HASH_SZ - 1)) {
+		if (tbl->hash[h] == 0)
+			break;
+		if (memcmp(&tbl->packs[tbl->hash[h] - 1], pack,
+				sizeof(*pack)) == 0)
+			return &tbl->packs[tbl->hash[h] - 1];
+	}
+
+	if (unlikely(tbl->npacks == ARGPACK_MAX))
+		return NULL;
+
+	tbl->packs[tbl->npacks] = *pack;
+	tbl->hash[h] = (uint16_t)++tbl->npacks;
+
+	return &tbl->packs[tbl->npacks - 1];
+}
+
+/*
+ * insert a micro-op as one argument pack call
+ *
+ * @context:	the engine context
+ * @call:	the recorded call it comes from
+ * @uop:	the micro-op
+ * @stats:	statistics
+ *
+ * returns: 0 on success, 1 if the micro-op has no pack
+ * (the caller inserts it the usual way)
+ */
+int
+argpack_emit(idft_context_t *context, rec_call_t *call, ir_uop_t *uop,
+		idft_block_stats_t *stats)
+{
+	ADDRINT argv[REC_ARG_MAX];
+	uint32_t argc = 0;
+	const idft_argpack_t *pack;
+	idft_argpack_t tmp;
+	ir_loc_t *ea;
+	void *fn;
+
+	if ((fn = argpack_make(uop, &tmp)) == NULL ||
+			(pack = argpack_intern(context, &tmp)) == NULL)
+		return 1;
+
+	/* IARG_ADDRINT carries a pointer on 32-bit hosts only */
+	if (unlikely((uintptr_t)(ADDRINT)(uintptr_t)pack != (uintptr_t)pack))
+		return 1;
+
+	argv[argc++] = IARG_THREAD_CONTEXT;
+	argv[argc++] = IARG_ADDRINT;
+	argv[argc++] = (ADDRINT)(uintptr_t)pack;
+
+	ea = (uop->dst.kind == LOC_MEM) ? &uop->dst :
+		(uop->src.kind == LOC_MEM) ? &uop->src : NULL;
+	if (ea != NULL) {
+		argv[argc++] = ea->ea;
+		if (REC_IARG_HASVAL(ea->ea))
+			argv[argc++] = ea->eaval;
+	}
+
+	rec_insert(context, call->ins, uop->pred ? REC_PREDICATED : REC_CALL,
+			IDFT_IPOINT_BEFORE, fn, argc, argv);
+	stats->calls_out++;
+	stats->packed++;
+
+	return 0;
+}
+
+/*
+ * release the packs of a context; only when no
+ * instrumented code can run anymore (libdft_die)
+ */
+void
+argpack_free(idft_context_t *context)
+{
+	free(context->argpacks);
+	context->argpacks = NULL;
+}
@@ -0,0 +1,24 @@
+#ifndef LIBICEDFT_ARGPACK_H
+#define LIBICEDFT_ARGPACK_H
+
+#include <stdint.h>
+#include "libicedft_api.h"
+#include "libicedft_ir.h"
+#include "libicedft_rec.h"
+
+#define ARGPACK_MAX	4096			/* distinct packs per context */
+#define ARGPACK_HASH_SZ	8192			/* hash slots; a power of 2 */
+
+/* interned argument packs */
+typedef struct {
+	uint32_t	npacks;
+	uint16_t	hash[ARGPACK_HASH_SZ];	/* pack index + 1; 0 if free */
+	idft_argpack_t	packs[ARGPACK_MAX];
+} argpack_tbl_t;
+
+void	*argpack_make(ir_uop_t *uop, idft_argpack_t *pack);
+int	argpack_emit(idft_context_t *context, rec_call_t *call, ir_uop_t *uop,
+		idft_block_stats_t *stats);
+void	argpack_free(idft_context_t *context);
+
+#endif /* LIBICEDFT_ARGPACK_H */
@@ -0,0 +1,391 @@
+/*
+ * block-level memory access coalescing
+ *
+ * code that spills registers, sets up call arguments or
+ * fills a structure does so with runs of plain moves
+ * relative to one base register, e.g.,
+ *
+ *	mov [esp+0x8], eax; mov [esp+0x4], ecx; mov [esp], 0x0
+ *	mov eax, [ebp-0x10]; mov edx, [ebp-0xc]
+ *
+ * each of which costs one analysis call that computes its
+ * own effective address and tagmap location. Once a block
+ * has been optimized (see libicedft_ir.c), the survivors of
+ * such runs are replaced by one call to _mem_group, which
+ * takes the address of the first access only and updates
+ * the tags of a window of up to COALESCE_SPAN bytes with
+ * one tagmap read and write (see idft_memgroup_t).
+ *
+ * the members of a group are adjacent MOV, MOVZX or MOVSX
+ * instructions with the same base and index registers, so
+ * their addresses only differ by their displacements (see
+ * INS_MemoryDisplacement) as long as the registers do not
+ * change; a load into either one ends the group. Absolute
+ * addresses (no base register) are left alone, and so are
+ * accesses with a segment override (see INS_SegmentRegPrefix):
+ * fs:[eax+4] and [eax+8] are not 4 bytes apart. Members thus
+ * all use the default segment of their (common) base
+ * register. The fused routine runs before the first member,
+ * which is equivalent, since it applies the accesses in
+ * order and nothing in between reads the tags it writes.
+ *
+ * groups are interned per context, like argument packs
+ * (see libicedft_argpack.c), and never released before
+ * libdft_die
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "libicedft_api.h"
+#include "libicedft_argpack.h"
+#include "libicedft_coalesce.h"
+#include "libicedft_core.h"
+#include "libicedft_x64.h"
+#include "tagmap.h"
+#include "branch_pred.h"
+
+
+#define EXE context->executer_api
+
+/* a member of a group */
+typedef struct {
+	uint32_t	i;			/* its micro-op */
+	idft_ins_t	*ins;			/* its instruction */
+	idft_reg_t	base;			/* executer register ids */
+	idft_reg_t	indx;
+	int32_t		disp;
+	uint8_t		len;			/* bytes accessed */
+	uint8_t		store;			/* 1 for stores */
+	uint8_t		wreg;			/* VCPU index loaded, or IR_NOREG */
+	idft_argpack_t	pack;			/* the access; memory side at 0 */
+} coalesce_acc_t;
+
+
+/* the first live micro-op at, or after, i */
+static uint32_t
+coalesce_next(ir_block_t *blk, uint32_t i)
+{
+	while (i < blk->nuops && blk->uops[i].op == UOP_NOP)
+		i++;
+
+	return i;
+}
+
+/* is a micro-op the only one of its call */
+static int
+coalesce_alone(ir_block_t *blk, uint32_t i)
+{
+	return (i == 0 || blk->uops[i - 1].rec != blk->uops[i].rec) &&
+		(i + 1 == blk->nuops || blk->uops[i + 1].rec != blk->uops[i].rec);
+}
+
+/*
+ * describe a micro-op as a group member
+ *
+ * @context:	the engine context
+ * @buf:	the record buffer
+ * @blk:	the block
+ * @i:		the micro-op (live)
+ * @acc:	the member (out)
+ *
+ * returns: 1 if it can be coalesced, 0 otherwise
+ */
+static int
+coalesce_member(idft_context_t *context, rec_buf_t *buf, ir_block_t *blk,
+		uint32_t i, coalesce_acc_t *acc)
+{
+	ir_uop_t *uop = &blk->uops[i];
+	rec_call_t *call = &buf->calls[uop->rec];
+	idft_ins_t *ins = call->ins;
+	uint32_t opcode;
+
+	if (uop->pred || call->how != REC_CALL ||
+			call->ipoint != IDFT_IPOINT_BEFORE ||
+			!coalesce_alone(blk, i))
+		return 0;
+
+	opcode = EXE->INS_Opcode(ins, context);
+	if (opcode != XED_ICLASS_MOV && opcode != XED_ICLASS_MOVZX &&
+			opcode != XED_ICLASS_MOVSX)
+		return 0;
+
+	memset(acc, 0, sizeof(*acc));
+	acc->i		= i;
+	acc->ins	= ins;
+	acc->wreg	= IR_NOREG;
+
+	/* mov m, imm */
+	if (uop->op == UOP_OPAQUE) {
+		if (call->argc != 1 || call->argv[0] != IARG_MEMORYWRITE_EA)
+			return 0;
+		if (call->func == (void *)tagmap_clrq)
+			acc->len = 8;
+		else if (call->func == (void *)tagmap_clrl)
+			acc->len = 4;
+		else if (call->func == (void *)tagmap_clrw)
+			acc->len = 2;
+		else if (call->func == (void *)tagmap_clrb)
+			acc->len = 1;
+		else
+			return 0;
+		acc->store	= 1;
+		acc->pack.dclr	= (uint8_t)((1U << acc->len) - 1);
+	}
+	/* loads (mov/movzx/movsx r, m) */
+	else if ((uop->op == UOP_COPY || uop->op == UOP_EXTEND) &&
+			uop->dst.kind == LOC_REG && uop->src.kind == LOC_MEM &&
+			uop->src.ea == IARG_MEMORYREAD_EA) {
+		if (argpack_make(uop, &acc->pack) == NULL)
+			return 0;
+		acc->len	= uop->src.len;
+		acc->wreg	= uop->dst.reg;
+	}
+	/* stores (mov m, r) */
+	else if (uop->op == UOP_COPY && uop->dst.kind == LOC_MEM &&
+			uop->src.kind == LOC_REG &&
+			uop->dst.ea == IARG_MEMORYWRITE_EA) {
+		if (argpack_make(uop, &acc->pack) == NULL)
+			return 0;
+		acc->len	= uop->dst.len;
+		acc->store	= 1;
+	}
+	else
+		return 0;
+
+	/* fs:, gs: (or any other) override */
+	if (EXE->INS_SegmentRegPrefix(ins, context) !=
+			EXE->REG_INVALID(ins, context))
+		return 0;
+
+	acc->base = EXE->INS_MemoryBaseReg(ins, context);
+	if (acc->base == EXE->REG_INVALID(ins, context))
+		return 0;
+	acc->indx = EXE->INS_MemoryIndexReg(ins, context);
+	acc->disp = (int32_t)EXE->INS_MemoryDisplacement(ins, context);
+
+	return 1;
+}
+
+/* the VCPU index of an address register (64-bit ones with IDFT_X86_64) */
+static uint32_t
+coalesce_indx(idft_context_t *context, idft_ins_t *ins, idft_reg_t reg)
+{
+	return x64_gr64(ins, context, reg) ? REG64_INDX(ins, context, reg) :
+		REG32_INDX(ins, context, reg);
+}
+
+/* does a member load the base or the index register */
+static int
+coalesce_clobbers(idft_context_t *context, coalesce_acc_t *acc)
+{
+	if (acc->wreg == IR_NOREG)
+		return 0;
+
+	if (acc->wreg == coalesce_indx(context, acc->ins, acc->base))
+		return 1;
+
+	return acc->indx != EXE->REG_INVALID(acc->ins, context) &&
+		acc->wreg == coalesce_indx(context, acc->ins, acc->indx);
+}
+
+/*
+ * intern a group
+ *
+ * @context:	the engine context
+ * @group:	the group; unused members zeroed
+ *
+ * returns: the shared copy, or NULL if the table is full
+ */
+static const idft_memgroup_t *
+coalesce_intern(idft_context_t *context, const idft_memgroup_t *group)
+{
+	coalesce_tbl_t *tbl = (coalesce_tbl_t *)context->memgroups;
+	const uint8_t *p = (const uint8_t *)group;
+	uint32_t h = 2166136261U, k;
+
+	if (unlikely(tbl == NULL)) {
+		if ((tbl = calloc(1, sizeof(coalesce_tbl_t))) == NULL)
+			return NULL;
+		context->memgroups = tbl;
+	}
+
+	/* FNV-1a over the whole group */
+	for (k = 0; k < sizeof(*group); k++)
+		h = (h ^ p[k]) * 16777619U;
+	h &= COALESCE_HASH_SZ - 1;
+
+	/* linear probing */
+	for (;; h = (h + 1) & (COALESCE_HASH_SZ - 1)) {
+		if (tbl->hash[h] == 0)
+			break;
+		if (memcmp(&tbl->groups[tbl->hash[h] - 1], group,
+				sizeof(*group)) == 0)
+			return &tbl->groups[tbl->hash[h] - 1];
+	}
+
+	if (unlikely(tbl->ngroups == COALESCE_GROUPS_MAX))
+		return NULL;
+
+	tbl->groups[tbl->ngroups] = *group;
+	tbl->hash[h] = (uint16_t)++tbl->ngroups;
+
+	return &tbl->groups[tbl->ngroups - 1];
+}
+
+/*
+ * replace the members of a group by one call
+ *
+ * @context:	the engine context
+ * @buf:	the record buffer; the call is appended
+ * @blk:	the block
+ * @acc:	the members, in order
+ * @n:		their count
+ *
+ * returns: 0 on success, 1 if the group was left alone
+ */
+static int
+coalesce_emit(idft_context_t *context, rec_buf_t *buf, ir_block_t *blk,
+		coalesce_acc_t *acc, uint32_t n)
+{
+	const idft_memgroup_t *shared;
+	idft_memgroup_t group;
+	ir_uop_t *at = &blk->uops[acc[0].i];
+	rec_call_t *call;
+	int32_t lo, hi;
+	uint32_t k, off;
+
+	for (k = 0, lo = hi = acc[0].disp; k < n; k++) {
+		if (acc[k].disp < lo)
+			lo = acc[k].disp;
+		if (acc[k].disp + acc[k].len > hi)
+			hi = acc[k].disp + acc[k].len;
+	}
+
+	memset(&group, 0, sizeof(group));
+	group.lo	= lo - acc[0].disp;
+	group.span	= (uint8_t)(hi - lo);
+	group.n		= (uint8_t)n;
+
+	/* move the memory side of every access into the window */
+	for (k = 0; k < n; k++) {
+		off		= (uint32_t)(acc[k].disp - lo);
+		group.ops[k]	= acc[k].pack;
+		if (acc[k].store) {
+			group.stores	|= (uint8_t)(1U << k);
+			group.ops[k].dshift = (uint8_t)off;
+		}
+		else
+			group.ops[k].sshift = (uint8_t)off;
+	}
+
+	if ((shared = coalesce_intern(context, &group)) == NULL)
+		return 1;
+
+	/* IARG_ADDRINT carries a pointer on 32-bit hosts only */
+	if (unlikely((uintptr_t)(ADDRINT)(uintptr_t)shared !=
+			(uintptr_t)shared))
+		return 1;
+
+	if (unlikely(buf->ncalls >= REC_CALL_MAX))
+		return 1;
+
+	call = &buf->calls[buf->ncalls];
+	memset(call, 0, sizeof(*call));
+
+	call->ins	= acc[0].ins;
+	call->how	= REC_CALL;
+	call->ipoint	= IDFT_IPOINT_BEFORE;
+	call->func	= (void *)_mem_group;
+
+	call->argv[call->argc++] = IARG_THREAD_CONTEXT;
+	call->argv[call->argc++] = IARG_ADDRINT;
+	call->argv[call->argc++] = (ADDRINT)(uintptr_t)shared;
+	call->argv[call->argc++] = acc[0].store ?
+		IARG_MEMORYWRITE_EA : IARG_MEMORYREAD_EA;
+
+	/* replayed as is by ir_emit */
+	memset(at, 0, sizeof(*at));
+	at->op	= UOP_OPAQUE;
+	at->rec	= buf->ncalls++;
+
+	for (k = 1; k < n; k++)
+		blk->uops[acc[k].i].op = UOP_NOP;
+
+	return 0;
+}
+
+/*
+ * coalesce the memory accesses of an optimized block
+ *
+ * @context:	the engine context
+ * @buf:	the record buffer; fused calls are appended
+ * @blk:	the block
+ * @stats:	statistics
+ */
+void
+coalesce_fuse(idft_context_t *context, rec_buf_t *buf, ir_block_t *blk,
+		idft_block_stats_t *stats)
+{
+	coalesce_acc_t acc[COALESCE_MAX];
+	uint32_t i, j, n;
+	int32_t lo, hi, nlo, nhi;
+
+	/* the executer cannot tell displacements or segments */
+	if (EXE->INS_MemoryDisplacement == NULL ||
+			EXE->INS_SegmentRegPrefix == NULL)
+		return;
+
+	for (i = coalesce_next(blk, 0); i < blk->nuops;
+			i = coalesce_next(blk, i + 1)) {
+		if (!coalesce_member(context, buf, blk, i, &acc[0]))
+			continue;
+
+		lo = acc[0].disp;
+		hi = acc[0].disp + acc[0].len;
+
+		/* collect the adjacent members */
+		for (n = 1, j = coalesce_next(blk, i + 1);
+				n < COALESCE_MAX && j < blk->nuops &&
+				!coalesce_clobbers(context, &acc[n - 1]);
+				j = coalesce_next(blk, j + 1)) {
+			if (buf->calls[blk->uops[j].rec].ins !=
+					acc[n - 1].ins + 1 ||
+				!coalesce_member(context, buf, blk, j, &acc[n]) ||
+				acc[n].base != acc[0].base ||
+				acc[n].indx != acc[0].indx)
+				break;
+
+			/* the window must fit */
+			nlo = (acc[n].disp < lo) ? acc[n].disp : lo;
+			nhi = (acc[n].disp + acc[n].len > hi) ?
+				acc[n].disp + acc[n].len : hi;
+			if (nhi - nlo > COALESCE_SPAN)
+				break;
+
+			lo = nlo;
+			hi = nhi;
+			n++;
+		}
+
+		if (n < 2)
+			continue;
+
+		if (coalesce_emit(context, buf, blk, acc, n))
+			continue;
+
+		stats->coalesced += n;
+		i = acc[n - 1].i;
+	}
+}
+
+/*
+ * release the groups of a context; only when no
+ * instrumented code can run anymore (libdft_die)
+ */
+void
+coalesce_free(idft_context_t *context)
+{
+	free(context->memgroups);
+	context->memgroups = NULL;
+}
@@ -0,0 +1,25 @@
+#ifndef LIBICEDFT_COALESCE_H
+#define LIBICEDFT_COALESCE_H
+
+#include <stdint.h>
+#include "libicedft_api.h"
+#include "libicedft_ir.h"
+#include "libicedft_rec.h"
+
+#define COALESCE_MAX		8		/* accesses per group (idft_memgroup_t) */
+#define COALESCE_SPAN		56		/* window bytes; one 64-bit tagmap access */
+#define COALESCE_GROUPS_MAX	4096		/* distinct groups per context */
+#define COALESCE_HASH_SZ	8192		/* hash slots; a power of 2 */
+
+/* interned memory access groups */
+typedef struct {
+	uint32_t	ngroups;
+	uint16_t	hash[COALESCE_HASH_SZ];	/* group index + 1; 0 if free */
+	idft_memgroup_t	groups[COALESCE_GROUPS_MAX];
+} coalesce_tbl_t;
+
+void	coalesce_fuse(idft_context_t *context, rec_buf_t *buf, ir_block_t *blk,
+		idft_block_stats_t *stats);
+void	coalesce_free(idft_context_t *context);
+
+#endif /* LIBICEDFT_COALESCE_H */
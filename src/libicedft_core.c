@@ -2,6 +2,12 @@
 #include "libicedft_types.h"
 #include "libicedft_util.h"
 #include "libicedft_api.h"
+#include "libicedft_filter.h"
+#include "libicedft_inline.h"
+#include "libicedft_plan.h"
+#include "libicedft_shift.h"
+#include "libicedft_simd.h"
+#include "libicedft_x64.h"
 #include "tagmap.h"
 
 // add by menertry
@@ -16,19 +22,6 @@
 /* tagmap */
 extern uint8_t	*bitmap;
 
-/* fast tag extension (helper); [0] -> 0, [1] -> VCPU_MASK16 */
-static uint32_t	MAP_8L_16[] = {0, VCPU_MASK16};
-
-/* fast tag extension (helper); [0] -> 0, [2] -> VCPU_MASK16 */
-static uint32_t	MAP_8H_16[] = {0, 0, VCPU_MASK16};
-
-/* fast tag extension (helper); [0] -> 0, [1] -> VCPU_MASK32 */
-static uint32_t	MAP_8L_32[] = {0, VCPU_MASK32};
-
-/* fast tag extension (helper); [0] -> 0, [2] -> VCPU_MASK32 */
-static uint32_t	MAP_8H_32[] = {0, 0, VCPU_MASK32};
-
-
 /* Register reference helper macro's */
 
 // Quickly reference the tags of register, only valid in a context where
@@ -55,2510 +48,1317 @@ static uint32_t	MAP_8H_32[] = {0, 0, VCPU_MASK32};
     {M8TAG(ADDR), M8TAG(ADDR+1), M8TAG(ADDR+2), M8TAG(ADDR+3) }
 
 
-
 /*
- * tag propagation (analysis function)
- *
- * extend the tag as follows: t[upper(eax)] = t[ax]
- *
- * NOTE: special case for the CWDE instruction
- *
- * @thread_ctx:	the thread context
+ * out-of-line instances of the routines in libicedft_inline.h
+ * (see there for their documentation); these are the ones that
+ * ins_inspect inserts, and libdft_handler_info reports
  */
-void _cwde(thread_ctx_t *thread_ctx)
-{
-	/* temporary tag value */
-	size_t src_tag = thread_ctx->vcpu.gpr[7] & VCPU_MASK16;
-
-	/* extension; 16-bit to 32-bit */
-	src_tag |= (src_tag << 2);
 
-	/* update the destination */
-	thread_ctx->vcpu.gpr[7] = src_tag;
+/* an instance of a two-operand routine */
+#define OUTLINE(fn, name, dtype, stype)					\
+void fn(thread_ctx_t *thread_ctx, dtype dst, stype src)			\
+{									\
+	idft_inline_##name(thread_ctx, dst, src);			\
+}
 
+void _cwde(thread_ctx_t *thread_ctx)
+{
+	idft_inline_cwde(thread_ctx);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate and extend tag between a 16-bit 
- * register and an 8-bit register as t[dst] = t[upper(src)]
- *
- * NOTE: special case for MOVSX instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
 void _movsx_r2r_opwb_u(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	/* temporary tag value */
-	size_t src_tag = thread_ctx->vcpu.gpr[src] & (VCPU_MASK8 << 1);
-
-	/* update the destination (xfer) */
-	thread_ctx->vcpu.gpr[dst] =
-		(thread_ctx->vcpu.gpr[dst] & ~VCPU_MASK16) | MAP_8H_16[src_tag];
-
+	idft_inline_movsx_r2r_opwb_u(thread_ctx, dst, src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate and extend tag between a 16-bit 
- * register and an 8-bit register as t[dst] = t[lower(src)]
- *
- * NOTE: special case for MOVSX instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
 void _movsx_r2r_opwb_l(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	/* temporary tag value */
-	size_t src_tag = 
-		thread_ctx->vcpu.gpr[src] & VCPU_MASK8;
-	
-	/* update the destination (xfer) */
-	thread_ctx->vcpu.gpr[dst] =
-		(thread_ctx->vcpu.gpr[dst] & ~VCPU_MASK16) | MAP_8L_16[src_tag];
-
+	idft_inline_movsx_r2r_opwb_l(thread_ctx, dst, src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate and extend tag between a 32-bit register
- * and an upper 8-bit register as t[dst] = t[upper(src)]
- *
- * NOTE: special case for MOVSX instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
 void _movsx_r2r_oplb_u(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-
-	/* temporary tag value */
-	size_t src_tag = thread_ctx->vcpu.gpr[src] & (VCPU_MASK8 << 1);
-
-	/* update the destination (xfer) */
-	thread_ctx->vcpu.gpr[dst] = MAP_8H_32[src_tag]; 
+	idft_inline_movsx_r2r_oplb_u(thread_ctx, dst, src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate and extend tag between a 32-bit register
- * and a lower 8-bit register as t[dst] = t[lower(src)]
- *
- * NOTE: special case for MOVSX instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
 void _movsx_r2r_oplb_l(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	/* temporary tag value */
-	size_t src_tag = thread_ctx->vcpu.gpr[src] & VCPU_MASK8;
-
-	/* update the destination (xfer) */
-	thread_ctx->vcpu.gpr[dst] = MAP_8L_32[src_tag]; 
+	idft_inline_movsx_r2r_oplb_l(thread_ctx, dst, src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate and extend tag between a 32-bit register
- * and a 16-bit register as t[dst] = t[src]
- *
- * NOTE: special case for MOVSX instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
 void _movsx_r2r_oplw(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	/* temporary tag value */
-	size_t src_tag = thread_ctx->vcpu.gpr[src] & VCPU_MASK16;
-
-	/* extension; 16-bit to 32-bit */
-	src_tag |= (src_tag << 2);
-
-	/* update the destination (xfer) */
-	thread_ctx->vcpu.gpr[dst] = src_tag;
+	idft_inline_movsx_r2r_oplw(thread_ctx, dst, src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate and extend tag between a 16-bit 
- * register and an 8-bit memory location as
- * t[dst] = t[src]
- *
- * NOTE: special case for MOVSX instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source memory address
- */
 void _movsx_m2r_opwb(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
 {
-	/* temporary tag value */
-	size_t src_tag = 
-		(bitmap[VIRT2BYTE(src)] >> VIRT2BIT(src)) & VCPU_MASK8;
-	
-	/* update the destination (xfer) */ 
-	thread_ctx->vcpu.gpr[dst] =
-		(thread_ctx->vcpu.gpr[dst] & ~VCPU_MASK16) | MAP_8L_16[src_tag];
-
+	idft_inline_movsx_m2r_opwb(thread_ctx, dst, src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate and extend tag between a 32-bit 
- * register and an 8-bit memory location as
- * t[dst] = t[src]
- *
- * NOTE: special case for MOVSX instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source memory address
- */
 void _movsx_m2r_oplb(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
 {
-	/* temporary tag value */
-	size_t src_tag = 
-		(bitmap[VIRT2BYTE(src)] >> VIRT2BIT(src)) & VCPU_MASK8;
-	
-	/* update the destination (xfer) */
-	thread_ctx->vcpu.gpr[dst] = MAP_8L_32[src_tag];
-
+	idft_inline_movsx_m2r_oplb(thread_ctx, dst, src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate and extend tag between a 32-bit register
- * and a 16-bit memory location as t[dst] = t[src]
- *
- * NOTE: special case for MOVSX instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source memory address 
- */
 void _movsx_m2r_oplw(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
 {
-	/* temporary tag value */
-	size_t src_tag = 
-		((*((uint16_t *)(bitmap + VIRT2BYTE(src))) >> VIRT2BIT(src)) &
-		VCPU_MASK16);
-
-	/* extension; 16-bit to 32-bit */
-	src_tag |= (src_tag << 2);
-
-	/* update the destination (xfer) */
-	thread_ctx->vcpu.gpr[dst] = src_tag;
+	idft_inline_movsx_m2r_oplw(thread_ctx, dst, src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate and extend tag between a 16-bit 
- * register and an 8-bit register as t[dst] = t[upper(src)]
- *
- * NOTE: special case for MOVZX instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
 void _movzx_r2r_opwb_u(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	/* temporary tag value */
-	size_t src_tag =
-		(thread_ctx->vcpu.gpr[src] & (VCPU_MASK8 << 1)) >> 1;
-
-	/* update the destination (xfer) */
-	thread_ctx->vcpu.gpr[dst] =
-		(thread_ctx->vcpu.gpr[dst] & ~VCPU_MASK16) | src_tag;
+	idft_inline_movzx_r2r_opwb_u(thread_ctx, dst, src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate and extend tag between a 16-bit 
- * register and an 8-bit register as t[dst] = t[lower(src)]
- *
- * NOTE: special case for MOVZX instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
 void _movzx_r2r_opwb_l(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	/* temporary tag value */
-	size_t src_tag = 
-		thread_ctx->vcpu.gpr[src] & VCPU_MASK8;
-	
-	/* update the destination (xfer) */
-	thread_ctx->vcpu.gpr[dst] =
-		(thread_ctx->vcpu.gpr[dst] & ~VCPU_MASK16) | src_tag;
-
+	idft_inline_movzx_r2r_opwb_l(thread_ctx, dst, src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate and extend tag between a 32-bit register
- * and an upper 8-bit register as t[dst] = t[upper(src)]
- *
- * NOTE: special case for MOVZX instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
 void _movzx_r2r_oplb_u(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	/* temporary tag value */
-	size_t src_tag =
-		(thread_ctx->vcpu.gpr[src] & (VCPU_MASK8 << 1)) >> 1;
-
-	/* update the destination (xfer) */
-	thread_ctx->vcpu.gpr[dst] = src_tag; 
-
+	idft_inline_movzx_r2r_oplb_u(thread_ctx, dst, src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate and extend tag between a 32-bit register
- * and a lower 8-bit register as t[dst] = t[lower(src)]
- *
- * NOTE: special case for MOVZX instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
 void _movzx_r2r_oplb_l(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	/* temporary tag value */
-	size_t src_tag = thread_ctx->vcpu.gpr[src] & VCPU_MASK8;
-
-	/* update the destination (xfer) */
-	thread_ctx->vcpu.gpr[dst] = src_tag; 
-
+	idft_inline_movzx_r2r_oplb_l(thread_ctx, dst, src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate and extend tag between a 32-bit register
- * and a 16-bit register as t[dst] = t[src]
- *
- * NOTE: special case for MOVZX instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
 void _movzx_r2r_oplw(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	/* temporary tag value */
-	size_t src_tag = thread_ctx->vcpu.gpr[src] & VCPU_MASK16;
-
-	/* update the destination (xfer) */
-	thread_ctx->vcpu.gpr[dst] = src_tag;
+	idft_inline_movzx_r2r_oplw(thread_ctx, dst, src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate and extend tag between a 16-bit 
- * register and an 8-bit memory location as
- * t[dst] = t[src]
- *
- * NOTE: special case for MOVZX instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source memory address
- */
 void _movzx_m2r_opwb(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
 {
-	/* temporary tag value */
-	size_t src_tag = 
-		(bitmap[VIRT2BYTE(src)] >> VIRT2BIT(src)) & VCPU_MASK8;
-	
-	/* update the destination (xfer) */ 
-	thread_ctx->vcpu.gpr[dst] =
-		(thread_ctx->vcpu.gpr[dst] & ~VCPU_MASK16) | src_tag;
-
+	idft_inline_movzx_m2r_opwb(thread_ctx, dst, src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate and extend tag between a 32-bit 
- * register and an 8-bit memory location as
- * t[dst] = t[src]
- *
- * NOTE: special case for MOVZX instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source memory address
- */
 void _movzx_m2r_oplb(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
 {
-	/* temporary tag value */
-	size_t src_tag = 
-		(bitmap[VIRT2BYTE(src)] >> VIRT2BIT(src)) & VCPU_MASK8;
-	
-	/* update the destination (xfer) */
-	thread_ctx->vcpu.gpr[dst] = src_tag;
+	idft_inline_movzx_m2r_oplb(thread_ctx, dst, src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate and extend tag between a 32-bit register
- * and a 16-bit memory location as t[dst] = t[src]
- *
- * NOTE: special case for MOVZX instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source memory address 
- */
 void _movzx_m2r_oplw(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
 {
-	/* temporary tag value */
-	size_t src_tag = 
-		((*((uint16_t *)(bitmap + VIRT2BYTE(src))) >> VIRT2BIT(src)) &
-		VCPU_MASK16);
+	idft_inline_movzx_m2r_oplw(thread_ctx, dst, src);
+}
 
-	/* update the destination (xfer) */
-	thread_ctx->vcpu.gpr[dst] = src_tag;
+void _movsx_r2r_opql(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	idft_inline_movsx_r2r_opql(thread_ctx, dst, src);
+}
 
+void _movsx_r2r_opqw(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	idft_inline_movsx_r2r_opqw(thread_ctx, dst, src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 32-bit
- * registers as t[EAX] = t[src]; return
- * the result of EAX == src and also
- * store the original tag value of
- * EAX in the scratch register
- *
- * NOTE: special case for the CMPXCHG instruction
- *
- * @thread_ctx:	the thread context
- * @dst_val:	EAX register value
- * @src:	source register index (VCPU)
- * @src_val:	source register value
- */
-ADDRINT _cmpxchg_r2r_opl_fast(thread_ctx_t *thread_ctx, uint32_t dst_val, uint32_t src,
-							uint32_t src_val)
+void _movsx_r2r_opqb_u(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
+	idft_inline_movsx_r2r_opqb_u(thread_ctx, dst, src);
+}
 
-	/* save the tag value of dst in the scratch register */
-	thread_ctx->vcpu.gpr[8] = 
-		thread_ctx->vcpu.gpr[7];
-	
-	/* update */
-	thread_ctx->vcpu.gpr[7] =
-		thread_ctx->vcpu.gpr[src];
+void _movsx_r2r_opqb_l(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	idft_inline_movsx_r2r_opqb_l(thread_ctx, dst, src);
+}
 
+void _movsx_m2r_opql(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+{
+	idft_inline_movsx_m2r_opql(thread_ctx, dst, src);
+}
 
-	/* compare the dst and src values */
-	return (dst_val == src_val);
+void _movsx_m2r_opqw(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+{
+	idft_inline_movsx_m2r_opqw(thread_ctx, dst, src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 32-bit 
- * registers as t[dst] = t[src]; restore the
- * value of EAX from the scratch register
- *
- * NOTE: special case for the CMPXCHG instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
-void _cmpxchg_r2r_opl_slow(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+void _movsx_m2r_opqb(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
 {
-	/* restore the tag value from the scratch register */
-	thread_ctx->vcpu.gpr[7] = 
-		thread_ctx->vcpu.gpr[8];
-	
-	/* update */
-	thread_ctx->vcpu.gpr[dst] =
-		thread_ctx->vcpu.gpr[src];
+	idft_inline_movsx_m2r_opqb(thread_ctx, dst, src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 16-bit
- * registers as t[AX] = t[src]; return
- * the result of AX == src and also
- * store the original tag value of
- * AX in the scratch register
- *
- * NOTE: special case for the CMPXCHG instruction
- *
- * @thread_ctx:	the thread context
- * @dst_val:	AX register value
- * @src:	source register index (VCPU)
- * @src_val:	source register value
- */
-ADDRINT _cmpxchg_r2r_opw_fast(thread_ctx_t *thread_ctx, uint16_t dst_val, uint32_t src,
-						uint16_t src_val)
+void _cqo(thread_ctx_t *thread_ctx)
 {
+	idft_inline_cqo(thread_ctx);
+}
 
-	/* save the tag value of dst in the scratch register */
-	thread_ctx->vcpu.gpr[8] = 
-		thread_ctx->vcpu.gpr[7];
-	
-	/* update */
-	thread_ctx->vcpu.gpr[7] =
-		(thread_ctx->vcpu.gpr[7] & ~VCPU_MASK16) |
-		(thread_ctx->vcpu.gpr[src] & VCPU_MASK16);
+ADDRINT _cmpxchg_r2r_opl_fast(thread_ctx_t *thread_ctx, uint32_t dst_val, uint32_t src,
+							uint32_t src_val)
+{
+	return idft_inline_cmpxchg_r2r_opl_fast(thread_ctx, dst_val, src, src_val);
+}
 
+void _cmpxchg_r2r_opl_slow(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	idft_inline_cmpxchg_r2r_opl_slow(thread_ctx, dst, src);
+}
 
-	/* compare the dst and src values */
-	return (dst_val == src_val);
+ADDRINT _cmpxchg_r2r_opw_fast(thread_ctx_t *thread_ctx, uint16_t dst_val, uint32_t src,
+						uint16_t src_val)
+{
+	return idft_inline_cmpxchg_r2r_opw_fast(thread_ctx, dst_val, src, src_val);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 16-bit 
- * registers as t[dst] = t[src]; restore the
- * value of AX from the scratch register
- *
- * NOTE: special case for the CMPXCHG instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
 void _cmpxchg_r2r_opw_slow(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	/* restore the tag value from the scratch register */
-	thread_ctx->vcpu.gpr[7] = 
-		thread_ctx->vcpu.gpr[8];
-	
-	/* update */
-	thread_ctx->vcpu.gpr[dst] =
-		(thread_ctx->vcpu.gpr[dst] & ~VCPU_MASK16) |
-		(thread_ctx->vcpu.gpr[src] & VCPU_MASK16);
-
+	idft_inline_cmpxchg_r2r_opw_slow(thread_ctx, dst, src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between a 32-bit
- * register and a memory location
- * as t[EAX] = t[src]; return the result
- * of EAX == src and also store the
- * original tag value of EAX in
- * the scratch register
- *
- * NOTE: special case for the CMPXCHG instruction
- *
- * @thread_ctx:	the thread context
- * @dst_val:	destination register value
- * @src:	source memory address
- */
 ADDRINT _cmpxchg_m2r_opl_fast(thread_ctx_t *thread_ctx, uint32_t dst_val, ADDRINT src)
 {
-	/* save the tag value of dst in the scratch register */
-	thread_ctx->vcpu.gpr[8] = 
-		thread_ctx->vcpu.gpr[7];
-	
-	/* update */
-	thread_ctx->vcpu.gpr[7] =
-		(*((uint16_t *)(bitmap + VIRT2BYTE(src))) >> VIRT2BIT(src)) &
-		VCPU_MASK32;
-	
-	/* compare the dst and src values; the original values the tag bits */
-	return (dst_val == *(uint32_t *)src);
+	return idft_inline_cmpxchg_m2r_opl_fast(thread_ctx, dst_val, src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between a 32-bit 
- * register and a memory location
- * as t[dst] = t[src]; restore the value
- * of EAX from the scratch register
- *
- * NOTE: special case for the CMPXCHG instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination memory address
- * @src:	source register index (VCPU)
- */
 void _cmpxchg_r2m_opl_slow(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
 {
-	/* restore the tag value from the scratch register */
-	thread_ctx->vcpu.gpr[7] = 
-		thread_ctx->vcpu.gpr[8];
-	
-	/* update */
-	*((uint16_t *)(bitmap + VIRT2BYTE(dst))) =
-		(*((uint16_t *)(bitmap + VIRT2BYTE(dst))) & ~(LONG_MASK <<
-							      VIRT2BIT(dst))) |
-		((uint16_t)(thread_ctx->vcpu.gpr[src] & VCPU_MASK32) <<
-		VIRT2BIT(dst));
+	idft_inline_cmpxchg_r2m_opl_slow(thread_ctx, dst, src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between a 16-bit
- * register and a memory location
- * as t[AX] = t[src]; return the result
- * of AX == src and also store the
- * original tag value of AX in
- * the scratch register
- *
- * NOTE: special case for the CMPXCHG instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @dst_val:	destination register value
- * @src:	source memory address
- */
 ADDRINT _cmpxchg_m2r_opw_fast(thread_ctx_t *thread_ctx, uint16_t dst_val, ADDRINT src)
 {
+	return idft_inline_cmpxchg_m2r_opw_fast(thread_ctx, dst_val, src);
+}
 
-	/* save the tag value of dst in the scratch register */
-	thread_ctx->vcpu.gpr[8] = 
-		thread_ctx->vcpu.gpr[7];
-	
-	/* update */
-	thread_ctx->vcpu.gpr[7] =
-		(thread_ctx->vcpu.gpr[7] & ~VCPU_MASK16) |
-		((*((uint16_t *)(bitmap + VIRT2BYTE(src))) >> VIRT2BIT(src)) &
-		VCPU_MASK16);
-	
-	/* compare the dst and src values; the original values the tag bits */
-	return (dst_val == *(uint16_t *)src);
-}
-
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between a 16-bit 
- * register and a memory location
- * as t[dst] = t[src]; restore the value
- * of AX from the scratch register
- *
- * NOTE: special case for the CMPXCHG instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination memory address
- * @src:	source register index (VCPU)
- * @res:	restore register index (VCPU)
- */
 void _cmpxchg_r2m_opw_slow(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
 {
-
-	/* restore the tag value from the scratch register */
-	thread_ctx->vcpu.gpr[7] = 
-		thread_ctx->vcpu.gpr[8];
-	
-	/* update */
-	*((uint16_t *)(bitmap + VIRT2BYTE(dst))) =
-		(*((uint16_t *)(bitmap + VIRT2BYTE(dst))) & ~(WORD_MASK <<
-							      VIRT2BIT(dst))) |
-		((uint16_t)(thread_ctx->vcpu.gpr[src] & VCPU_MASK16) <<
-		VIRT2BIT(dst));
-
+	idft_inline_cmpxchg_r2m_opw_slow(thread_ctx, dst, src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 8-bit 
- * registers as t[upper(dst)] = t[lower(src)]
- * and t[lower(src)] = t[upper(dst)]
- *
- * NOTE: special case for the XCHG instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
-void _xchg_r2r_opb_ul(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+void _cmpxchg_r2r_opl_bf(thread_ctx_t *thread_ctx, uint32_t eax_val, uint32_t dst,
+							uint32_t dst_val, uint32_t src)
 {
-	/* temporary tag value */
-	size_t tmp_tag = thread_ctx->vcpu.gpr[dst] & (VCPU_MASK8 << 1);
-
-	/* swap */
-	thread_ctx->vcpu.gpr[dst] =
-		 (thread_ctx->vcpu.gpr[dst] & ~(VCPU_MASK8 << 1)) |
-		 ((thread_ctx->vcpu.gpr[src] & VCPU_MASK8) << 1);
-	
-	thread_ctx->vcpu.gpr[src] =
-		 (thread_ctx->vcpu.gpr[src] & ~VCPU_MASK8) | (tmp_tag >> 1);
+	idft_inline_cmpxchg_r2r_opl_bf(thread_ctx, eax_val, dst, dst_val, src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 8-bit 
- * registers as t[lower(dst)] = t[upper(src)]
- * and t[upper(src)] = t[lower(dst)]
- *
- * NOTE: special case for the XCHG instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
-void _xchg_r2r_opb_lu(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+void _cmpxchg_r2r_opw_bf(thread_ctx_t *thread_ctx, uint16_t ax_val, uint32_t dst,
+							uint16_t dst_val, uint32_t src)
 {
-	/* temporary tag value */
-	size_t tmp_tag = thread_ctx->vcpu.gpr[dst] & VCPU_MASK8;
-
-	/* swap */
-	thread_ctx->vcpu.gpr[dst] =
-		(thread_ctx->vcpu.gpr[dst] & ~VCPU_MASK8) | 
-		((thread_ctx->vcpu.gpr[src] & (VCPU_MASK8 << 1)) >> 1);
-	
-	thread_ctx->vcpu.gpr[src] =
-	 (thread_ctx->vcpu.gpr[src] & ~(VCPU_MASK8 << 1)) | (tmp_tag << 1);
-
+	idft_inline_cmpxchg_r2r_opw_bf(thread_ctx, ax_val, dst, dst_val, src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 8-bit 
- * registers as t[upper(dst)] = t[upper(src)]
- * and t[upper(src)] = t[upper(dst)]
- *
- * NOTE: special case for the XCHG instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
-void _xchg_r2r_opb_u(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+void _cmpxchg_m2r_opl_bf(thread_ctx_t *thread_ctx, uint32_t eax_val, ADDRINT dst,
+							uint32_t src)
 {
-
-	/* temporary tag value */
-	size_t tmp_tag = thread_ctx->vcpu.gpr[dst] & (VCPU_MASK8 << 1);
-
-	/* swap */
-	thread_ctx->vcpu.gpr[dst] =
-		(thread_ctx->vcpu.gpr[dst] & ~(VCPU_MASK8 << 1)) |
-		(thread_ctx->vcpu.gpr[src] & (VCPU_MASK8 << 1));
-	
-	thread_ctx->vcpu.gpr[src] =
-		(thread_ctx->vcpu.gpr[src] & ~(VCPU_MASK8 << 1)) | tmp_tag;
-
+	idft_inline_cmpxchg_m2r_opl_bf(thread_ctx, eax_val, dst, src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 8-bit 
- * registers as t[lower(dst)] = t[lower(src)]
- * and t[lower(src)] = t[lower(dst)]
- *
- * NOTE: special case for the XCHG instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
-void _xchg_r2r_opb_l(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+void _cmpxchg_m2r_opw_bf(thread_ctx_t *thread_ctx, uint16_t ax_val, ADDRINT dst,
+							uint32_t src)
 {
-	/* temporary tag value */
-	size_t tmp_tag = thread_ctx->vcpu.gpr[dst] & VCPU_MASK8; 
-
-	/* swap */
-	thread_ctx->vcpu.gpr[dst] =
-		(thread_ctx->vcpu.gpr[dst] & ~VCPU_MASK8) |
-		(thread_ctx->vcpu.gpr[src] & VCPU_MASK8);
-	
-	thread_ctx->vcpu.gpr[src] =
-		(thread_ctx->vcpu.gpr[src] & ~VCPU_MASK8) | tmp_tag;
+	idft_inline_cmpxchg_m2r_opw_bf(thread_ctx, ax_val, dst, src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 16-bit 
- * registers as t[dst] = t[src]
- * and t[src] = t[dst]
- *
- * NOTE: special case for the XCHG instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
-void _xchg_r2r_opw(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+void _cmpxchg8b_m2r_bf(thread_ctx_t *thread_ctx, uint32_t eax_val,
+							uint32_t edx_val, ADDRINT dst)
 {
-	/* temporary tag value */
-	size_t tmp_tag = thread_ctx->vcpu.gpr[dst] & VCPU_MASK16; 
-
-	/* swap */
-	thread_ctx->vcpu.gpr[dst] =
-		(thread_ctx->vcpu.gpr[dst] & ~VCPU_MASK16) |
-		(thread_ctx->vcpu.gpr[src] & VCPU_MASK16);
-	
-	thread_ctx->vcpu.gpr[src] =
-		(thread_ctx->vcpu.gpr[src] & ~VCPU_MASK16) | tmp_tag;
+	idft_inline_cmpxchg8b_m2r_bf(thread_ctx, eax_val, edx_val, dst);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between an upper 8-bit 
- * register and a memory location as
- * t[dst] = t[src] and t[src] = t[dst]
- * (dst is a register)
- *
- * NOTE: special case for the XCHG instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source memory address
- */
-void _xchg_m2r_opb_u(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+void _cmpxchg16b_m2r_bf(thread_ctx_t *thread_ctx, ADDRINT rax_val,
+							ADDRINT rdx_val, ADDRINT dst)
 {
-	/* temporary tag value */
-	size_t tmp_tag = thread_ctx->vcpu.gpr[dst] & (VCPU_MASK8 << 1);
-
-	/* swap */
-	thread_ctx->vcpu.gpr[dst] =
-		(thread_ctx->vcpu.gpr[dst] & ~(VCPU_MASK8 << 1)) |
-		(((bitmap[VIRT2BYTE(src)] >> VIRT2BIT(src)) << 1) &
-		(VCPU_MASK8 << 1));
-
-	bitmap[VIRT2BYTE(src)] =
-		(bitmap[VIRT2BYTE(src)] & ~(BYTE_MASK << VIRT2BIT(src))) |
-		((tmp_tag >> 1) << VIRT2BIT(src));
+	idft_inline_cmpxchg16b_m2r_bf(thread_ctx, rax_val, rdx_val, dst);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between a lower 8-bit 
- * register and a memory location as
- * t[dst] = t[src] and t[src] = t[dst]
- * (dst is a register)
- *
- * NOTE: special case for the XCHG instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source memory address
- */
-void _xchg_m2r_opb_l(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+void _cmpxchg_r2r_opq_bf(thread_ctx_t *thread_ctx, ADDRINT rax_val, uint32_t dst,
+							ADDRINT dst_val, uint32_t src)
 {
-	/* temporary tag value */
-	size_t tmp_tag = thread_ctx->vcpu.gpr[dst] & VCPU_MASK8;
-	
-	/* swap */
-	thread_ctx->vcpu.gpr[dst] =
-		(thread_ctx->vcpu.gpr[dst] & ~VCPU_MASK8) |
-		((bitmap[VIRT2BYTE(src)] >> VIRT2BIT(src)) & VCPU_MASK8);
-	
-	bitmap[VIRT2BYTE(src)] =
-		(bitmap[VIRT2BYTE(src)] & ~(BYTE_MASK << VIRT2BIT(src))) |
-		(tmp_tag << VIRT2BIT(src));
-
+	idft_inline_cmpxchg_r2r_opq_bf(thread_ctx, rax_val, dst, dst_val, src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between a 16-bit 
- * register and a memory location as
- * t[dst] = t[src] and t[src] = t[dst]
- * (dst is a register)
- *
- * NOTE: special case for the XCHG instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source memory address
- */
-void _xchg_m2r_opw(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+void _cmpxchg_m2r_opq_bf(thread_ctx_t *thread_ctx, ADDRINT rax_val, ADDRINT dst,
+							uint32_t src)
 {
-	/* temporary tag value */
-	size_t tmp_tag = thread_ctx->vcpu.gpr[dst] & VCPU_MASK16;
-
-	/* swap */	
-	thread_ctx->vcpu.gpr[dst] =
-		(thread_ctx->vcpu.gpr[dst] & ~VCPU_MASK16) |
-		((*((uint16_t *)(bitmap + VIRT2BYTE(src))) >> VIRT2BIT(src)) &
-		VCPU_MASK16);
-
-	*((uint16_t *)(bitmap + VIRT2BYTE(src))) =
-		(*((uint16_t *)(bitmap + VIRT2BYTE(src))) & ~(WORD_MASK <<
-							      VIRT2BIT(src))) |
-		((uint16_t)(tmp_tag) < VIRT2BIT(src));
-
+	idft_inline_cmpxchg_m2r_opq_bf(thread_ctx, rax_val, dst, src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between a 32-bit 
- * register and a memory location as
- * t[dst] = t[src] and t[src] = t[dst]
- * (dst is a register)
- *
- * NOTE: special case for the XCHG instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source memory address
- */
-void _xchg_m2r_opl(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
-{
-	/* temporary tag value */
-	size_t tmp_tag = thread_ctx->vcpu.gpr[dst];
-	
-	/* swap */
-	thread_ctx->vcpu.gpr[dst] =
-		(*((uint16_t *)(bitmap + VIRT2BYTE(src))) >> VIRT2BIT(src)) &
-		VCPU_MASK32;
-	
-	*((uint16_t *)(bitmap + VIRT2BYTE(src))) =
-		(*((uint16_t *)(bitmap + VIRT2BYTE(src))) & ~(LONG_MASK <<
-							      VIRT2BIT(src))) |
-		((uint16_t)(tmp_tag) << VIRT2BIT(src));
+OUTLINE(_xchg_r2r_opb_ul, xchg_r2r_opb_ul, uint32_t, uint32_t)
+OUTLINE(_xchg_r2r_opb_lu, xchg_r2r_opb_lu, uint32_t, uint32_t)
+OUTLINE(_xchg_r2r_opb_u, xchg_r2r_opb_u, uint32_t, uint32_t)
+OUTLINE(_xchg_r2r_opb_l, xchg_r2r_opb_l, uint32_t, uint32_t)
+OUTLINE(_xchg_r2r_opw, xchg_r2r_opw, uint32_t, uint32_t)
+OUTLINE(_xchg_m2r_opb_u, xchg_m2r_opb_u, uint32_t, ADDRINT)
+OUTLINE(_xchg_m2r_opb_l, xchg_m2r_opb_l, uint32_t, ADDRINT)
+OUTLINE(_xchg_m2r_opw, xchg_m2r_opw, uint32_t, ADDRINT)
+OUTLINE(_xchg_m2r_opl, xchg_m2r_opl, uint32_t, ADDRINT)
+OUTLINE(_xadd_r2r_opb_ul, xadd_r2r_opb_ul, uint32_t, uint32_t)
+OUTLINE(_xadd_r2r_opb_lu, xadd_r2r_opb_lu, uint32_t, uint32_t)
+OUTLINE(_xadd_r2r_opb_u, xadd_r2r_opb_u, uint32_t, uint32_t)
+OUTLINE(_xadd_r2r_opb_l, xadd_r2r_opb_l, uint32_t, uint32_t)
+OUTLINE(_xadd_r2r_opw, xadd_r2r_opw, uint32_t, uint32_t)
+OUTLINE(_xadd_m2r_opb_u, xadd_m2r_opb_u, uint32_t, ADDRINT)
+OUTLINE(_xadd_m2r_opb_l, xadd_m2r_opb_l, uint32_t, ADDRINT)
+OUTLINE(_xadd_m2r_opw, xadd_m2r_opw, uint32_t, ADDRINT)
+OUTLINE(_xadd_m2r_opl, xadd_m2r_opl, uint32_t, ADDRINT)
+OUTLINE(_xchg_m2r_opq, xchg_m2r_opq, uint32_t, ADDRINT)
+OUTLINE(_xadd_r2r_opq, xadd_r2r_opq, uint32_t, uint32_t)
+OUTLINE(_xadd_m2r_opq, xadd_m2r_opq, uint32_t, ADDRINT)
 
-}
-
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 8-bit 
- * registers as t[upper(dst)] |= t[lower(src)]
- * and t[lower(src)] = t[upper(dst)]
- *
- * NOTE: special case for the XADD instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
-void _xadd_r2r_opb_ul(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+void _lea_r2r_opw(thread_ctx_t *thread_ctx,
+		uint32_t dst,
+		uint32_t base,
+		uint32_t index)
 {
-	/* temporary tag value */
-	size_t tmp_tag = thread_ctx->vcpu.gpr[dst] & (VCPU_MASK8 << 1);
-
-	/* swap */
-	thread_ctx->vcpu.gpr[dst] =
-		 (thread_ctx->vcpu.gpr[dst] & (VCPU_MASK8 << 1)) |
-		 ((thread_ctx->vcpu.gpr[src] & VCPU_MASK8) << 1);
-	
-	thread_ctx->vcpu.gpr[src] =
-		 (thread_ctx->vcpu.gpr[src] & ~VCPU_MASK8) | (tmp_tag >> 1);
+	idft_inline_lea_r2r_opw(thread_ctx, dst, base, index);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 8-bit 
- * registers as t[lower(dst)] |= t[upper(src)]
- * and t[upper(src)] = t[lower(dst)]
- *
- * NOTE: special case for the XADD instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
-void _xadd_r2r_opb_lu(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+void _lea_r2r_opl(thread_ctx_t *thread_ctx,
+		uint32_t dst,
+		uint32_t base,
+		uint32_t index)
 {
-	/* temporary tag value */
-	size_t tmp_tag = thread_ctx->vcpu.gpr[dst] & VCPU_MASK8;
-
-	/* swap */
-	thread_ctx->vcpu.gpr[dst] =
-		(thread_ctx->vcpu.gpr[dst] & VCPU_MASK8) | 
-		((thread_ctx->vcpu.gpr[src] & (VCPU_MASK8 << 1)) >> 1);
-	
-	thread_ctx->vcpu.gpr[src] =
-	 (thread_ctx->vcpu.gpr[src] & ~(VCPU_MASK8 << 1)) | (tmp_tag << 1);
+	idft_inline_lea_r2r_opl(thread_ctx, dst, base, index);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 8-bit 
- * registers as t[upper(dst)] |= t[upper(src)]
- * and t[upper(src)] = t[upper(dst)]
- *
- * NOTE: special case for the XADD instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
-void _xadd_r2r_opb_u(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+void _lea_r2r_opq(thread_ctx_t *thread_ctx,
+		uint32_t dst,
+		uint32_t base,
+		uint32_t index)
 {
-	/* temporary tag value */
-	size_t tmp_tag = thread_ctx->vcpu.gpr[dst] & (VCPU_MASK8 << 1);
-
-	/* swap */
-	thread_ctx->vcpu.gpr[dst] =
-		(thread_ctx->vcpu.gpr[dst] & (VCPU_MASK8 << 1)) |
-		(thread_ctx->vcpu.gpr[src] & (VCPU_MASK8 << 1));
-	
-	thread_ctx->vcpu.gpr[src] =
-		(thread_ctx->vcpu.gpr[src] & ~(VCPU_MASK8 << 1)) | tmp_tag;
-
+	idft_inline_lea_r2r_opq(thread_ctx, dst, base, index);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 8-bit 
- * registers as t[lower(dst)] |= t[lower(src)]
- * and t[lower(src)] = t[lower(dst)]
- *
- * NOTE: special case for the XADD instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
-void _xadd_r2r_opb_l(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
-{
-	/* temporary tag value */
-	size_t tmp_tag = thread_ctx->vcpu.gpr[dst] & VCPU_MASK8; 
-
-	/* swap */
-	thread_ctx->vcpu.gpr[dst] =
-		(thread_ctx->vcpu.gpr[dst] & VCPU_MASK8) |
-		(thread_ctx->vcpu.gpr[src] & VCPU_MASK8);
-	
-	thread_ctx->vcpu.gpr[src] =
-		(thread_ctx->vcpu.gpr[src] & ~VCPU_MASK8) | tmp_tag;
 
+void r2r_ternary_opb_u(thread_ctx_t *thread_ctx, uint32_t src)
+{
+	idft_inline_r2r_ternary_opb_u(thread_ctx, src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 16-bit 
- * registers as t[dst] |= t[src]
- * and t[src] = t[dst]
- *
- * NOTE: special case for the XADD instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
-void _xadd_r2r_opw(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+void r2r_ternary_opb_l(thread_ctx_t *thread_ctx, uint32_t src)
 {
-	/* temporary tag value */
-	size_t tmp_tag = thread_ctx->vcpu.gpr[dst] & VCPU_MASK16; 
-
-	/* swap */
-	thread_ctx->vcpu.gpr[dst] =
-		(thread_ctx->vcpu.gpr[dst] & VCPU_MASK16) |
-		(thread_ctx->vcpu.gpr[src] & VCPU_MASK16);
-	
-	thread_ctx->vcpu.gpr[src] =
-		(thread_ctx->vcpu.gpr[src] & ~VCPU_MASK16) | tmp_tag;
-
+	idft_inline_r2r_ternary_opb_l(thread_ctx, src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between an upper 8-bit 
- * register and a memory location as
- * t[dst] |= t[src] and t[src] = t[dst]
- * (dst is a register)
- *
- * NOTE: special case for the XADD instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source memory address
- */
-void _xadd_m2r_opb_u(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+void r2r_ternary_opw(thread_ctx_t *thread_ctx, uint32_t src)
 {
-	/* temporary tag value */
-	size_t tmp_tag = thread_ctx->vcpu.gpr[dst] & (VCPU_MASK8 << 1);
-
-	/* swap */
-	thread_ctx->vcpu.gpr[dst] =
-		(thread_ctx->vcpu.gpr[dst] & (VCPU_MASK8 << 1)) |
-		(((bitmap[VIRT2BYTE(src)] >> VIRT2BIT(src)) << 1) &
-		(VCPU_MASK8 << 1));
-
-	bitmap[VIRT2BYTE(src)] =
-		(bitmap[VIRT2BYTE(src)] & ~(BYTE_MASK << VIRT2BIT(src))) |
-		((tmp_tag >> 1) << VIRT2BIT(src));
-
+	idft_inline_r2r_ternary_opw(thread_ctx, src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between a lower 8-bit 
- * register and a memory location as
- * t[dst] |= t[src] and t[src] = t[dst]
- * (dst is a register)
- *
- * NOTE: special case for the XADD instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source memory address
- */
-void _xadd_m2r_opb_l(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+void r2r_ternary_opl(thread_ctx_t *thread_ctx, uint32_t src)
 {
-	/* temporary tag value */
-	size_t tmp_tag = thread_ctx->vcpu.gpr[dst] & VCPU_MASK8;
-	
-	/* swap */
-	thread_ctx->vcpu.gpr[dst] =
-		(thread_ctx->vcpu.gpr[dst] & VCPU_MASK8) |
-		((bitmap[VIRT2BYTE(src)] >> VIRT2BIT(src)) & VCPU_MASK8);
-	
-	bitmap[VIRT2BYTE(src)] =
-		(bitmap[VIRT2BYTE(src)] & ~(BYTE_MASK << VIRT2BIT(src))) |
-		(tmp_tag << VIRT2BIT(src));
-
+	idft_inline_r2r_ternary_opl(thread_ctx, src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between a 16-bit 
- * register and a memory location as
- * t[dst] |= t[src] and t[src] = t[dst]
- * (dst is a register)
- *
- * NOTE: special case for the XADD instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source memory address
- */
-void _xadd_m2r_opw(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+void m2r_ternary_opb(thread_ctx_t *thread_ctx, ADDRINT src)
 {
-	/* temporary tag value */
-	size_t tmp_tag = thread_ctx->vcpu.gpr[dst] & VCPU_MASK16;
-
-	/* swap */	
-	thread_ctx->vcpu.gpr[dst] =
-		(thread_ctx->vcpu.gpr[dst] & VCPU_MASK16) |
-		((*((uint16_t *)(bitmap + VIRT2BYTE(src))) >> VIRT2BIT(src)) &
-		VCPU_MASK16);
-
-	*((uint16_t *)(bitmap + VIRT2BYTE(src))) =
-		(*((uint16_t *)(bitmap + VIRT2BYTE(src))) & ~(WORD_MASK <<
-							      VIRT2BIT(src))) |
-		((uint16_t)(tmp_tag) < VIRT2BIT(src));
+	idft_inline_m2r_ternary_opb(thread_ctx, src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between a 32-bit 
- * register and a memory location as
- * t[dst] |= t[src] and t[src] = t[dst]
- * (dst is a register)
- *
- * NOTE: special case for the XADD instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source memory address
- */
-void _xadd_m2r_opl(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+void m2r_ternary_opw(thread_ctx_t *thread_ctx, ADDRINT src)
 {
-	/* temporary tag value */
-	size_t tmp_tag = thread_ctx->vcpu.gpr[dst];
-	
-	/* swap */
-	thread_ctx->vcpu.gpr[dst] =
-		(*((uint16_t *)(bitmap + VIRT2BYTE(src))) >> VIRT2BIT(src)) &
-		VCPU_MASK32;
-	
-	*((uint16_t *)(bitmap + VIRT2BYTE(src))) =
-		(*((uint16_t *)(bitmap + VIRT2BYTE(src))) & (LONG_MASK <<
-							      VIRT2BIT(src))) |
-		((uint16_t)(tmp_tag) << VIRT2BIT(src));
+	idft_inline_m2r_ternary_opw(thread_ctx, src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between three 16-bit 
- * registers as t[dst] = t[base] | t[index]
- *
- * NOTE: special case for the LEA instruction
- *
- * @thread_ctx: the thread context
- * @dst:        destination register
- * @base:       base register
- * @index:      index register
- */
-void _lea_r2r_opw(thread_ctx_t *thread_ctx,
-		uint32_t dst,
-		uint32_t base,
-		uint32_t index)
+void m2r_ternary_opl(thread_ctx_t *thread_ctx, ADDRINT src)
 {
-	/* update the destination */
-	thread_ctx->vcpu.gpr[dst] =
-		((thread_ctx->vcpu.gpr[dst] & ~VCPU_MASK16) |
-		(thread_ctx->vcpu.gpr[base] & VCPU_MASK16) |
-		(thread_ctx->vcpu.gpr[index] & VCPU_MASK16));
+	idft_inline_m2r_ternary_opl(thread_ctx, src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between three 32-bit 
- * registers as t[dst] = t[base] | t[index]
- *
- * NOTE: special case for the LEA instruction
- *
- * @thread_ctx: the thread context
- * @dst:        destination register
- * @base:       base register
- * @index:      index register
- */
-void _lea_r2r_opl(thread_ctx_t *thread_ctx,
-		uint32_t dst,
-		uint32_t base,
-		uint32_t index)
+void m2r_ternary_opq(thread_ctx_t *thread_ctx, ADDRINT src)
 {
-	/* update the destination */
-	thread_ctx->vcpu.gpr[dst] =
-		thread_ctx->vcpu.gpr[base] | thread_ctx->vcpu.gpr[index];
+	idft_inline_m2r_ternary_opq(thread_ctx, src);
 }
 
+OUTLINE(r2r_binary_opb_ul, r2r_binary_opb_ul, uint32_t, uint32_t)
+OUTLINE(r2r_binary_opb_lu, r2r_binary_opb_lu, uint32_t, uint32_t)
+OUTLINE(r2r_binary_opb_u, r2r_binary_opb_u, uint32_t, uint32_t)
+OUTLINE(r2r_binary_opb_l, r2r_binary_opb_l, uint32_t, uint32_t)
+OUTLINE(r2r_binary_opw, r2r_binary_opw, uint32_t, uint32_t)
+OUTLINE(r2r_binary_opl, r2r_binary_opl, uint32_t, uint32_t)
+OUTLINE(m2r_binary_opb_u, m2r_binary_opb_u, uint32_t, ADDRINT)
+OUTLINE(m2r_binary_opb_l, m2r_binary_opb_l, uint32_t, ADDRINT)
+OUTLINE(m2r_binary_opw, m2r_binary_opw, uint32_t, ADDRINT)
+OUTLINE(m2r_binary_opl, m2r_binary_opl, uint32_t, ADDRINT)
+OUTLINE(r2m_binary_opb_u, r2m_binary_opb_u, ADDRINT, uint32_t)
+OUTLINE(r2m_binary_opb_l, r2m_binary_opb_l, ADDRINT, uint32_t)
+OUTLINE(r2m_binary_opw, r2m_binary_opw, ADDRINT, uint32_t)
+OUTLINE(r2m_binary_opl, r2m_binary_opl, ADDRINT, uint32_t)
+OUTLINE(r2r_binary_opq, r2r_binary_opq, uint32_t, uint32_t)
+OUTLINE(m2r_binary_opq, m2r_binary_opq, uint32_t, ADDRINT)
+OUTLINE(r2m_binary_opq, r2m_binary_opq, ADDRINT, uint32_t)
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag among three 8-bit registers as t[dst] |= t[upper(src)];
- * dst is AX, whereas src is an upper 8-bit register (e.g., CH, BH, ...)
- *
- * NOTE: special case for DIV and IDIV instructions
- *
- * @thread_ctx:	the thread context
- * @src:	source register index (VCPU)
- */
-void r2r_ternary_opb_u(thread_ctx_t *thread_ctx, idft_reg_t src)
+void r_clrl4(thread_ctx_t *thread_ctx)
 {
-	/* temporary tag value */
-	idft_reg_t tmp_tag = thread_ctx->vcpu.gpr[src] & (VCPU_MASK8 << 1);
-	
-	/* update the destination (ternary) */
-	thread_ctx->vcpu.gpr[7] |= MAP_8H_16[tmp_tag];
-
+	idft_inline_r_clrl4(thread_ctx);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag among three 8-bit registers as t[dst] |= t[lower(src)];
- * dst is AX, whereas src is a lower 8-bit register (e.g., CL, BL, ...)
- *
- * NOTE: special case for DIV and IDIV instructions
- *
- * @thread_ctx:	the thread context
- * @src:	source register index (VCPU)
- */
-void r2r_ternary_opb_l(thread_ctx_t *thread_ctx, idft_reg_t src)
+void r_clrl3(thread_ctx_t *thread_ctx)
 {
-	/* temporary tag value */
-	idft_reg_t tmp_tag = thread_ctx->vcpu.gpr[src] & VCPU_MASK8;
-
-	/* update the destination (ternary) */
-	thread_ctx->vcpu.gpr[7] |= MAP_8L_16[tmp_tag];
-
+	idft_inline_r_clrl3(thread_ctx);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between among three 16-bit 
- * registers as t[dst1] |= t[src] and t[dst2] |= t[src];
- * dst1 is DX, dst2 is AX, and src is a 16-bit register 
- * (e.g., CX, BX, ...)
- *
- * NOTE: special case for DIV and IDIV instructions
- *
- * @thread_ctx:	the thread context
- * @src:	source register index (VCPU)
- */
-void r2r_ternary_opw(thread_ctx_t *thread_ctx, idft_reg_t src)
+void r_clrl2(thread_ctx_t *thread_ctx)
 {
-	/* temporary tag value */
-	idft_reg_t tmp_tag = thread_ctx->vcpu.gpr[src] & VCPU_MASK16;
-	
-	/* update the destinations */
-	thread_ctx->vcpu.gpr[5] |= tmp_tag;
-	thread_ctx->vcpu.gpr[7] |= tmp_tag;
-
+	idft_inline_r_clrl2(thread_ctx);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between among three 32-bit 
- * registers as t[dst1] |= t[src] and t[dst2] |= t[src];
- * dst1 is EDX, dst2 is EAX, and src is a 32-bit register
- * (e.g., ECX, EBX, ...)
- *
- * NOTE: special case for DIV and IDIV instructions
- *
- * @thread_ctx:	the thread context
- * @src:	source register index (VCPU)
- */
-void r2r_ternary_opl(thread_ctx_t *thread_ctx, idft_reg_t src)
-{ 
-	/* update the destinations */
-	thread_ctx->vcpu.gpr[5] |= thread_ctx->vcpu.gpr[src];
-	thread_ctx->vcpu.gpr[7] |= thread_ctx->vcpu.gpr[src];
-
+void r_clrl(thread_ctx_t *thread_ctx, uint32_t reg)
+{
+	idft_inline_r_clrl(thread_ctx, reg);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag among two 8-bit registers
- * and an 8-bit memory location as t[dst] |= t[src];
- * dst is AX, whereas src is an 8-bit memory location
- *
- * NOTE: special case for DIV and IDIV instructions
- *
- * @thread_ctx:	the thread context
- * @src:	source memory address
- */
-void m2r_ternary_opb(thread_ctx_t *thread_ctx, ADDRINT src)
-{
-	/* temporary tag value */
-	idft_reg_t tmp_tag = 
-		(bitmap[VIRT2BYTE(src)] >> VIRT2BIT(src)) & VCPU_MASK8;
-	
-	/* update the destination (ternary) */
-	thread_ctx->vcpu.gpr[7] |= MAP_8L_16[tmp_tag];
 
-}
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag among two 16-bit registers
- * and a 16-bit memory address as
- * t[dst1] |= t[src] and t[dst1] |= t[src];
- *
- * dst1 is DX, dst2 is AX, and src is a 16-bit
- * memory location
- *
- * NOTE: special case for DIV and IDIV instructions
- *
- * @thread_ctx:	the thread context
- * @src:	source memory address
- */
-void m2r_ternary_opw(thread_ctx_t *thread_ctx, ADDRINT src)
+void r_clrw(thread_ctx_t *thread_ctx, uint32_t reg)
 {
-	/* temporary tag value */
-	idft_reg_t tmp_tag = 
-		(*((uint16_t *)(bitmap + VIRT2BYTE(src))) >> VIRT2BIT(src)) &
-		VCPU_MASK16;
-	
-	/* update the destinations */
-	thread_ctx->vcpu.gpr[5] |= tmp_tag; 
-	thread_ctx->vcpu.gpr[7] |= tmp_tag; 
-
+	idft_inline_r_clrw(thread_ctx, reg);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag among two 32-bit 
- * registers and a 32-bit memory as
- * t[dst1] |= t[src] and t[dst2] |= t[src];
- * dst1 is EDX, dst2 is EAX, and src is a 32-bit
- * memory location
- *
- * NOTE: special case for DIV and IDIV instructions
- *
- * @thread_ctx:	the thread context
- * @src:	source memory address
- */
-void m2r_ternary_opl(thread_ctx_t *thread_ctx, ADDRINT src)
-{
-	/* temporary tag value */
-	idft_reg_t tmp_tag = 
-		(*((uint16_t *)(bitmap + VIRT2BYTE(src))) >> VIRT2BIT(src)) &
-		VCPU_MASK32;
 
-	/* update the destinations */
-	thread_ctx->vcpu.gpr[5] |= tmp_tag;
-	thread_ctx->vcpu.gpr[7] |= tmp_tag;
 
-}
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 8-bit 
- * registers as t[upper(dst)] |= t[lower(src)];
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
-void r2r_binary_opb_ul(thread_ctx_t *thread_ctx, idft_reg_t dst, idft_reg_t src)
+void r_clrb_u(thread_ctx_t *thread_ctx, uint32_t reg)
 {
-	thread_ctx->vcpu.gpr[dst] |=
-		(thread_ctx->vcpu.gpr[src] & VCPU_MASK8) << 1;
-
+	idft_inline_r_clrb_u(thread_ctx, reg);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 8-bit 
- * registers as t[lower(dst)] |= t[upper(src)];
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
-void r2r_binary_opb_lu(thread_ctx_t *thread_ctx, idft_reg_t dst, idft_reg_t src)
-{
-	thread_ctx->vcpu.gpr[dst] |=
-		(thread_ctx->vcpu.gpr[src] & (VCPU_MASK8 << 1)) >> 1;
-
-}
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 8-bit 
- * registers as t[upper(dst)] |= t[upper(src)]
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
-void r2r_binary_opb_u(thread_ctx_t *thread_ctx, idft_reg_t dst, idft_reg_t src)
+void r_clrb_l(thread_ctx_t *thread_ctx, uint32_t reg)
 {
-	thread_ctx->vcpu.gpr[dst] |=
-		thread_ctx->vcpu.gpr[src] & (VCPU_MASK8 << 1);
-
+	idft_inline_r_clrb_l(thread_ctx, reg);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 8-bit 
- * registers as t[lower(dst)] |= t[lower(src)]
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
-void r2r_binary_opb_l(thread_ctx_t *thread_ctx, idft_reg_t dst, idft_reg_t src)
-{
-	thread_ctx->vcpu.gpr[dst] |=
-		thread_ctx->vcpu.gpr[src] & VCPU_MASK8;
 
-}
+OUTLINE(r2r_xfer_opb_ul, r2r_xfer_opb_ul, uint32_t, uint32_t)
+OUTLINE(r2r_xfer_opb_lu, r2r_xfer_opb_lu, uint32_t, uint32_t)
+OUTLINE(r2r_xfer_opb_u, r2r_xfer_opb_u, uint32_t, uint32_t)
+OUTLINE(r2r_xfer_opb_l, r2r_xfer_opb_l, uint32_t, uint32_t)
+OUTLINE(r2r_xfer_opw, r2r_xfer_opw, uint32_t, uint32_t)
+OUTLINE(r2r_xfer_opl, r2r_xfer_opl, uint32_t, uint32_t)
+OUTLINE(m2r_xfer_opb_u, m2r_xfer_opb_u, uint32_t, ADDRINT)
+OUTLINE(m2r_xfer_opb_l, m2r_xfer_opb_l, uint32_t, ADDRINT)
+OUTLINE(m2r_xfer_opw, m2r_xfer_opw, uint32_t, ADDRINT)
+OUTLINE(m2r_xfer_opl, m2r_xfer_opl, uint32_t, ADDRINT)
+OUTLINE(r2r_xfer_opq, r2r_xfer_opq, uint32_t, uint32_t)
+OUTLINE(m2r_xfer_opq, m2r_xfer_opq, uint32_t, ADDRINT)
 
 /*
  * tag propagation (analysis function)
  *
- * propagate tag between two 16-bit registers
- * as t[dst] |= t[src]
+ * propagate tag between an 8-bit 
+ * register and a n-memory locations as
+ * t[dst] = t[src]; src is AL
  *
  * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
-void r2r_binary_opw(thread_ctx_t *thread_ctx, idft_reg_t dst, idft_reg_t src)
-{
-	thread_ctx->vcpu.gpr[dst] |=
-		thread_ctx->vcpu.gpr[src] & VCPU_MASK16;
-}
-
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 32-bit 
- * registers as t[dst] |= t[src]
+ * @dst:	destination memory address
+ * @count:	memory bytes
+ * @eflags:	the value of the EFLAGS register
  *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
  */
-void r2r_binary_opl(thread_ctx_t *thread_ctx, idft_reg_t dst, idft_reg_t src)
+void r2m_xfer_opbn(thread_ctx_t *thread_ctx, ADDRINT dst, ADDRINT count, 
+        ADDRINT eflags)
 {
-	thread_ctx->vcpu.gpr[dst] |= thread_ctx->vcpu.gpr[src];
+	if (likely(EFLAGS_DF(eflags) == 0)) {
+		/* EFLAGS.DF = 0 */
 
-}
+		/* the source register is taged */
+		if (VCPU_GPR(thread_ctx, 7) & VCPU_MASK8)
+			tagmap_setn(dst, count);
+		/* the source register is clear */
+		else
+			tagmap_clrn(dst, count);
+	}
+	else {
+		/* EFLAGS.DF = 1 */
+
+		/* the source register is taged */
+		if (VCPU_GPR(thread_ctx, 7) & VCPU_MASK8)
+			tagmap_setn(dst - count + 1, count);
+		/* the source register is clear */
+		else
+			tagmap_clrn(dst - count + 1, count);
+	
+	}
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between an 8-bit 
- * register and a memory location as
- * t[upper(dst)] |= t[src] (dst is a register)
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source memory address
- */
-void m2r_binary_opb_u(thread_ctx_t *thread_ctx, idft_reg_t dst, ADDRINT src)
-{
-	thread_ctx->vcpu.gpr[dst] |=
-		((bitmap[VIRT2BYTE(src)] >> VIRT2BIT(src)) & VCPU_MASK8) << 1;
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between an 8-bit 
- * register and a memory location as
- * t[lower(dst)] |= t[src] (dst is a register)
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source memory address
- */
-void m2r_binary_opb_l(thread_ctx_t *thread_ctx, idft_reg_t dst, ADDRINT src)
+void r2m_xfer_opb_u(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
 {
-	thread_ctx->vcpu.gpr[dst] |=
-		(bitmap[VIRT2BYTE(src)] >> VIRT2BIT(src)) & VCPU_MASK8;
+#ifndef USE_CUSTOM_TAG
+	idft_inline_r2m_xfer_opb_u(thread_ctx, dst, src);
+#else
+    tag_t src_tag = RTAG[src][1];
+
+    tag_dir_setb(tag_dir, dst, src_tag);
+#endif
 }
 
+OUTLINE(r2m_xfer_opb_l, r2m_xfer_opb_l, ADDRINT, uint32_t)
+
 /*
  * tag propagation (analysis function)
  *
  * propagate tag between a 16-bit 
- * register and a memory location as
- * t[dst] |= t[src] (dst is a register)
+ * register and a n-memory locations as
+ * t[dst] = t[src]; src is AX
  *
  * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source memory address
+ * @dst:	destination memory address
+ * @count:	memory words
+ * @eflags:	the value of the EFLAGS register
  */
-void m2r_binary_opw(thread_ctx_t *thread_ctx, idft_reg_t dst, ADDRINT src)
+void r2m_xfer_opwn(thread_ctx_t *thread_ctx,
+		ADDRINT dst,
+		ADDRINT count,
+		ADDRINT eflags)
 {
-	thread_ctx->vcpu.gpr[dst] |=
-		(*((uint16_t *)(bitmap + VIRT2BYTE(src))) >> VIRT2BIT(src)) &
-		VCPU_MASK16;
+	if (likely(EFLAGS_DF(eflags) == 0)) {
+		/* EFLAGS.DF = 0 */
 
-}
+		/* the source register is taged */
+		if (VCPU_GPR(thread_ctx, 7) & VCPU_MASK16)
+			tagmap_setn(dst, (count << 1));
+		/* the source register is clear */
+		else
+			tagmap_clrn(dst, (count << 1));
+	}
+	else {
+		/* EFLAGS.DF = 1 */
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between a 32-bit 
- * register and a memory location as
- * t[dst] |= t[src] (dst is a register)
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source memory address
- */
-void m2r_binary_opl(thread_ctx_t *thread_ctx, idft_reg_t dst, ADDRINT src)
-{
-	thread_ctx->vcpu.gpr[dst] |=
-		(*((uint16_t *)(bitmap + VIRT2BYTE(src))) >> VIRT2BIT(src)) &
-		VCPU_MASK32;
+		/* the source register is taged */
+		if (VCPU_GPR(thread_ctx, 7) & VCPU_MASK16)
+			tagmap_setn(dst - (count << 1) + 2, (count << 1));
+		/* the source register is clear */
+		else
+			tagmap_clrn(dst - (count << 1) + 2, (count << 1));
+	}
 
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between an 8-bit 
- * register and a memory location as
- * t[dst] |= t[upper(src)] (src is a register)
- *
- * @thread_ctx:	the thread context
- * @dst:	destination memory address
- * @src:	source register index (VCPU)
- */
-void r2m_binary_opb_u(thread_ctx_t *thread_ctx, ADDRINT dst, idft_reg_t src)
-{
-	bitmap[VIRT2BYTE(dst)] |=
-		((thread_ctx->vcpu.gpr[src] & (VCPU_MASK8 << 1)) >> 1)
-		<< VIRT2BIT(dst);
-}
+OUTLINE(r2m_xfer_opw, r2m_xfer_opw, ADDRINT, uint32_t)
 
 /*
  * tag propagation (analysis function)
  *
- * propagate tag between an 8-bit 
- * register and a memory location as
- * t[dst] |= t[lower(src)] (src is a register)
+ * propagate tag between a 32-bit 
+ * register and a n-memory locations as
+ * t[dst] = t[src]; src is EAX
  *
  * @thread_ctx:	the thread context
  * @dst:	destination memory address
  * @src:	source register index (VCPU)
+ * @count:	memory double words
+ * @eflags:	the value of the EFLAGS register
  */
-void r2m_binary_opb_l(thread_ctx_t *thread_ctx, ADDRINT dst, idft_reg_t src)
+void r2m_xfer_opln(thread_ctx_t *thread_ctx,
+		ADDRINT dst,
+		ADDRINT count,
+		ADDRINT eflags)
 {
-	bitmap[VIRT2BYTE(dst)] |=
-		(thread_ctx->vcpu.gpr[src] & VCPU_MASK8) << VIRT2BIT(dst);
+#ifndef USE_CUSTOM_TAG
+	if (likely(EFLAGS_DF(eflags) == 0)) {
+		/* EFLAGS.DF = 0 */
 
+		/* the source register is taged */
+		if (VCPU_GPR(thread_ctx, 7) & VCPU_MASK32)
+			tagmap_setn(dst, (count << 2));
+		/* the source register is clear */
+		else
+			tagmap_clrn(dst, (count << 2));
+	}
+	else {
+		/* EFLAGS.DF = 1 */
+
+		/* the source register is taged */
+		if (VCPU_GPR(thread_ctx, 7) & VCPU_MASK32)
+			tagmap_setn(dst - (count << 2) + 4, (count << 2));
+		/* the source register is clear */
+		else
+			tagmap_clrn(dst - (count << 2) + 4, (count << 2));
+	}
+#else
+    tag_t src_tag[] = R32TAG(GPR_EAX);
+	if (likely(EFLAGS_DF(eflags) == 0)) {
+		/* EFLAGS.DF = 0 */
+
+        for (size_t i = 0; i < (count << 2); i++)
+        {
+            tag_dir_setb(tag_dir, dst+i, src_tag[i%4]);
+
+        }
+	}
+	else {
+		/* EFLAGS.DF = 1 */
+
+        for (size_t i = 0; i < (count << 2); i++)
+        {
+            size_t dst_addr = dst - (count << 2) + 4 + i;
+            tag_dir_setb(tag_dir, dst_addr, src_tag[i%4]);
+
+        }
+	}
+#endif
 }
 
+OUTLINE(r2m_xfer_opl, r2m_xfer_opl, ADDRINT, uint32_t)
+OUTLINE(r2m_xfer_opq, r2m_xfer_opq, ADDRINT, uint32_t)
+
 /*
  * tag propagation (analysis function)
  *
- * propagate tag between a 16-bit 
- * register and a memory location as
- * t[dst] |= t[src] (src is a register)
+ * branch-free r2m_xfer_opbn/opwn/opln; whether the source
+ * register is tagged selects the fill value of the bytes,
+ * and EFLAGS.DF their start (dst is the last element if set,
+ * so the bytes start at dst - num + size)
  *
- * @thread_ctx:	the thread context
  * @dst:	destination memory address
- * @src:	source register index (VCPU)
+ * @count:	elements (ECX)
+ * @eflags:	the value of the EFLAGS register
+ * @tag:	the tag of the source register (AL, AX or EAX)
+ * @size:	element size
  */
-void r2m_binary_opw(thread_ctx_t *thread_ctx, ADDRINT dst, idft_reg_t src)
+static inline void
+r2m_xfer_opn_bf(ADDRINT dst, ADDRINT count, ADDRINT eflags, uint32_t tag,
+		size_t size)
 {
-	*((uint16_t *)(bitmap + VIRT2BYTE(dst))) |=
-		(thread_ctx->vcpu.gpr[src] & VCPU_MASK16) <<
-		VIRT2BIT(dst);
+	size_t num = count * size;
+
+	/* all ones if EFLAGS.DF = 1, 0 otherwise */
+	ADDRINT down = 0U - (ADDRINT)(EFLAGS_DF(eflags) != 0);
+
+	tagmap_filln(dst - ((num - size) & down), num, tag != 0);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between a 32-bit 
- * register and a memory location as
- * t[dst] |= t[src] (src is a register)
- *
- * @thread_ctx:	the thread context
- * @dst:	destination memory address
- * @src:	source register index (VCPU)
- */
-void r2m_binary_opl(thread_ctx_t *thread_ctx, ADDRINT dst, idft_reg_t src)
+void r2m_xfer_opbn_bf(thread_ctx_t *thread_ctx, ADDRINT dst, ADDRINT count,
+		ADDRINT eflags)
 {
-	*((uint16_t *)(bitmap + VIRT2BYTE(dst))) |=
-		(thread_ctx->vcpu.gpr[src] & VCPU_MASK32) <<
-		VIRT2BIT(dst);
-
+	r2m_xfer_opn_bf(dst, count, eflags,
+			VCPU_GPR(thread_ctx, 7) & VCPU_MASK8, 1);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * clear the tag of EAX, EBX, ECX, EDX
- *
- * @thread_ctx:	the thread context
- * @reg:	register index (VCPU) 
- */
-void r_clrl4(thread_ctx_t *thread_ctx)
+void r2m_xfer_opwn_bf(thread_ctx_t *thread_ctx, ADDRINT dst, ADDRINT count,
+		ADDRINT eflags)
 {
-	thread_ctx->vcpu.gpr[4] = 0;
-	thread_ctx->vcpu.gpr[5] = 0;
-	thread_ctx->vcpu.gpr[6] = 0;
-	thread_ctx->vcpu.gpr[7] = 0;
+	r2m_xfer_opn_bf(dst, count, eflags,
+			VCPU_GPR(thread_ctx, 7) & VCPU_MASK16, 2);
+}
 
+void r2m_xfer_opln_bf(thread_ctx_t *thread_ctx, ADDRINT dst, ADDRINT count,
+		ADDRINT eflags)
+{
+#ifndef USE_CUSTOM_TAG
+	r2m_xfer_opn_bf(dst, count, eflags,
+			VCPU_GPR(thread_ctx, 7) & VCPU_MASK32, 4);
+#else
+	r2m_xfer_opln(thread_ctx, dst, count, eflags);
+#endif
 }
 
 /*
  * tag propagation (analysis function)
  *
- * clear the tag of EAX, EDX
+ * REP STOSQ (IDFT_X86_64); t[dst] = t[RAX] over the string,
+ * always branch-free (see r2m_xfer_opn_bf)
  *
  * @thread_ctx:	the thread context
- * @reg:	register index (VCPU) 
+ * @dst:	destination memory address
+ * @count:	memory quad words
+ * @eflags:	the value of the EFLAGS register
  */
-void r_clrl2(thread_ctx_t *thread_ctx)
+void r2m_xfer_opqn(thread_ctx_t *thread_ctx, ADDRINT dst, ADDRINT count,
+		ADDRINT eflags)
 {
-	thread_ctx->vcpu.gpr[5] = 0;
-	thread_ctx->vcpu.gpr[7] = 0;
+	r2m_xfer_opn_bf(dst, count, eflags, VCPU_GPR(thread_ctx, 7), 8);
 }
 
 /*
  * tag propagation (analysis function)
  *
- * clear the tag of a 16-bit register
+ * propagate tag between n-memory locations as
+ * t[dst] = t[src], in element (size) steps; REP MOVS
+ * (see tagmap_movsn for overlapping strings)
  *
- * @thread_ctx:	the thread context
- * @reg:	register index (VCPU) 
+ * @dst:	destination memory address (EDI)
+ * @src:	source memory address (ESI)
+ * @count:	elements (ECX)
+ * @eflags:	the value of the EFLAGS register
+ * @size:	element size
  */
-void r_clrl(thread_ctx_t *thread_ctx, idft_reg_t reg)
+static inline void
+m2m_xfer_opn(ADDRINT dst, ADDRINT src, ADDRINT count, ADDRINT eflags,
+		size_t size)
 {
+	size_t num = count * size;
+#ifndef USE_CUSTOM_TAG
+	if (likely(EFLAGS_DF(eflags) == 0))
+		/* EFLAGS.DF = 0 */
+		tagmap_movsn(dst, src, num, size, 0);
+	else
+		/* EFLAGS.DF = 1; dst and src are the last elements */
+		tagmap_movsn(dst - num + size, src - num + size, num, size,
+				1);
+#else
+	ptrdiff_t step = (EFLAGS_DF(eflags) == 0) ? (ptrdiff_t)size :
+		-(ptrdiff_t)size;
+	tag_t src_tag[8];
+
+	for (; count > 0; count--, dst += step, src += step) {
+		for (size_t i = 0; i < size; i++)
+			src_tag[i] = M8TAG(src + i);
+		for (size_t i = 0; i < size; i++)
+			tag_dir_setb(tag_dir, dst + i, src_tag[i]);
+	}
+#endif
+}
 
-	thread_ctx->vcpu.gpr[reg] = 0;
-
+void m2m_xfer_opbn(ADDRINT dst, ADDRINT src, ADDRINT count, ADDRINT eflags)
+{
+	m2m_xfer_opn(dst, src, count, eflags, 1);
 }
 
+void m2m_xfer_opwn(ADDRINT dst, ADDRINT src, ADDRINT count, ADDRINT eflags)
+{
+	m2m_xfer_opn(dst, src, count, eflags, 2);
+}
 
+void m2m_xfer_opln(ADDRINT dst, ADDRINT src, ADDRINT count, ADDRINT eflags)
+{
+	m2m_xfer_opn(dst, src, count, eflags, 4);
+}
 
-/*
- * tag propagation (analysis function)
- *
- * clear the tag of a 16-bit register
- *
- * @thread_ctx:	the thread context
- * @reg:	register index (VCPU) 
- */
-void r_clrw(thread_ctx_t *thread_ctx, idft_reg_t reg)
+void m2m_xfer_opqn(ADDRINT dst, ADDRINT src, ADDRINT count, ADDRINT eflags)
 {
+	m2m_xfer_opn(dst, src, count, eflags, 8);
+}
 
-	thread_ctx->vcpu.gpr[reg] &= ~VCPU_MASK16;
+void m2m_xfer_opw(ADDRINT dst, ADDRINT src)
+{
+	idft_inline_m2m_xfer_opw(dst, src);
+}
 
+void m2m_xfer_opb(ADDRINT dst, ADDRINT src)
+{
+	idft_inline_m2m_xfer_opb(dst, src);
 }
 
+void m2m_xfer_opl(ADDRINT dst, ADDRINT src)
+{
+	idft_inline_m2m_xfer_opl(dst, src);
+}
 
+void m2m_xfer_opq(ADDRINT dst, ADDRINT src)
+{
+	idft_inline_m2m_xfer_opq(dst, src);
+}
 
+ADDRINT rep_predicate(BOOL first_iteration)
+{
+	return idft_inline_rep_predicate(first_iteration);
+}
 
-/*
- * tag propagation (analysis function)
- *
- * clear the tag of an upper 8-bit register
- *
- * @thread_ctx:	the thread context
- * @reg:	register index (VCPU) 
- */
-void r_clrb_u(thread_ctx_t *thread_ctx, idft_reg_t reg)
+void m2r_restore_opw(thread_ctx_t *thread_ctx, ADDRINT src)
 {
-	thread_ctx->vcpu.gpr[reg] &= ~(VCPU_MASK8 << 1);
+	idft_inline_m2r_restore_opw(thread_ctx, src);
 }
 
+void m2r_restore_opl(thread_ctx_t *thread_ctx, ADDRINT src)
+{
+	idft_inline_m2r_restore_opl(thread_ctx, src);
+}
 
-/*
- * tag propagation (analysis function)
- *
- * clear the tag of a lower 8-bit register
- *
- * @thread_ctx:	the thread context
- * @reg:	register index (VCPU) 
- */
-void r_clrb_l(thread_ctx_t *thread_ctx, idft_reg_t reg)
+void r2m_save_opw(thread_ctx_t *thread_ctx, ADDRINT dst)
 {
-	thread_ctx->vcpu.gpr[reg] &= ~VCPU_MASK8;
+	idft_inline_r2m_save_opw(thread_ctx, dst);
+}
 
+void r2m_save_opl(thread_ctx_t *thread_ctx, ADDRINT dst)
+{
+	idft_inline_r2m_save_opl(thread_ctx, dst);
 }
 
 
+
 /*
- * tag propagation (analysis function)
- *
- * propagate tag between two 8-bit 
- * registers as t[upper(dst)] = t[lower(src)]
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
+ * stack idioms (see libicedft_idiom.c)
+ *
+ * the routines below stand for runs of consecutive
+ * PUSH/POP instructions (and the prologue/epilogue
+ * instructions around them); regs packs the VCPU index
+ * of the i-th register of the run in bits [4i, 4i + 4),
+ * in execution order, for up to IDIOM_RUN_MAX registers.
+ * The tags of a whole run (4 * n bits, at most 32) are
+ * moved with a single 64-bit access to the tagmap
  */
-void r2r_xfer_opb_ul(thread_ctx_t *thread_ctx, idft_reg_t dst, idft_reg_t src)
+
+/* the tags of n registers, the first one in the topmost nibble */
+static inline uint64_t
+stack_run_tags(thread_ctx_t *thread_ctx, uint32_t regs, uint32_t n)
 {
-	 thread_ctx->vcpu.gpr[dst] =
-		 (thread_ctx->vcpu.gpr[dst] & ~(VCPU_MASK8 << 1)) |
-		 ((thread_ctx->vcpu.gpr[src] & VCPU_MASK8) << 1);
+	uint64_t tags = 0;
+
+	for (; n > 0; n--, regs >>= 4)
+		tags |= (uint64_t)(VCPU_GPR(thread_ctx, regs & 0x0F) &
+				VCPU_MASK32) << ((n - 1) << 2);
+
+	return tags;
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 8-bit 
- * registers as t[lower(dst)] = t[upper(src)];
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
-void r2r_xfer_opb_lu(thread_ctx_t *thread_ctx, idft_reg_t dst, idft_reg_t src)
+/* store the tags of n stack slots, starting at the lowest one */
+static inline void
+stack_run_store(ADDRINT lo, uint64_t tags, uint32_t n)
 {
-	thread_ctx->vcpu.gpr[dst] =
-		(thread_ctx->vcpu.gpr[dst] & ~VCPU_MASK8) | 
-		((thread_ctx->vcpu.gpr[src] & (VCPU_MASK8 << 1)) >> 1);
+	uint64_t mask = (1ULL << (n << 2)) - 1;
 
+	*((uint64_t *)(bitmap + VIRT2BYTE(lo))) =
+		(*((uint64_t *)(bitmap + VIRT2BYTE(lo))) &
+		~(mask << VIRT2BIT(lo))) | (tags << VIRT2BIT(lo));
 }
 
 /*
  * tag propagation (analysis function)
  *
- * propagate tag between two 8-bit 
- * registers as t[upper(dst)] = t[upper(src)]
+ * push r32 x n
  *
  * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
+ * @ea:		the slot of the first push
+ * @regs:	the pushed registers (VCPU)
+ * @n:		their count
  */
-void r2r_xfer_opb_u(thread_ctx_t *thread_ctx, idft_reg_t dst, idft_reg_t src)
+void _push_run(thread_ctx_t *thread_ctx, ADDRINT ea, uint32_t regs,
+		uint32_t n)
 {
-	thread_ctx->vcpu.gpr[dst] =
-		(thread_ctx->vcpu.gpr[dst] & ~(VCPU_MASK8 << 1)) |
-		(thread_ctx->vcpu.gpr[src] & (VCPU_MASK8 << 1));
+	/* the first push takes the highest slot */
+	stack_run_store(ea - ((n - 1) << 2),
+			stack_run_tags(thread_ctx, regs, n), n);
 }
 
 /*
  * tag propagation (analysis function)
  *
- * propagate tag between two 8-bit 
- * registers as t[lower(dst)] = t[lower(src)]
+ * pop r32 x n
  *
  * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
+ * @ea:		the slot of the first pop
+ * @regs:	the popped registers (VCPU; ESP excluded)
+ * @n:		their count
  */
-void r2r_xfer_opb_l(thread_ctx_t *thread_ctx, idft_reg_t dst, idft_reg_t src)
+void _pop_run(thread_ctx_t *thread_ctx, ADDRINT ea, uint32_t regs,
+		uint32_t n)
 {
-	thread_ctx->vcpu.gpr[dst] =
-		(thread_ctx->vcpu.gpr[dst] & ~VCPU_MASK8) |
-		(thread_ctx->vcpu.gpr[src] & VCPU_MASK8);
+	uint64_t tags = *((uint64_t *)(bitmap + VIRT2BYTE(ea))) >>
+		VIRT2BIT(ea);
 
+	/* in order; the last pop to a register wins */
+	for (; n > 0; n--, regs >>= 4, tags >>= 4)
+		VCPU_GPR_SET(thread_ctx, regs & 0x0F, tags & VCPU_MASK32);
 }
 
 /*
  * tag propagation (analysis function)
  *
- * propagate tag between two 16-bit 
- * registers as t[dst] = t[src]
+ * push ebp; mov ebp, esp; push r32 x n
  *
  * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
+ * @ea:		the slot of EBP
+ * @regs:	the registers pushed afterwards (VCPU)
+ * @n:		their count; may be 0
  */
-void r2r_xfer_opw(thread_ctx_t *thread_ctx, idft_reg_t dst, idft_reg_t src)
+void _prologue(thread_ctx_t *thread_ctx, ADDRINT ea, uint32_t regs,
+		uint32_t n)
 {
-	thread_ctx->vcpu.gpr[dst] =
-		(thread_ctx->vcpu.gpr[dst] & ~VCPU_MASK16) |
-		(thread_ctx->vcpu.gpr[src] & VCPU_MASK16);
+	uint64_t ebp = VCPU_GPR(thread_ctx, GPR_EBP) & VCPU_MASK32;
+
+	VCPU_GPR_SET(thread_ctx, GPR_EBP, VCPU_GPR(thread_ctx, GPR_ESP));
 
+	/* the old EBP sits above the rest */
+	stack_run_store(ea - (n << 2),
+			(ebp << (n << 2)) | stack_run_tags(thread_ctx, regs, n),
+			n + 1);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 32-bit 
- * registers as t[dst] = t[src]
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
-void r2r_xfer_opl(thread_ctx_t *thread_ctx, idft_reg_t dst, idft_reg_t src)
+void _leave(thread_ctx_t *thread_ctx, ADDRINT ea)
 {
-	thread_ctx->vcpu.gpr[dst] =
-		thread_ctx->vcpu.gpr[src];
+	idft_inline_leave(thread_ctx, ea);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between an upper 8-bit 
- * register and a memory location as
- * t[dst] = t[src] (dst is a register)
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source memory address
- */
-void m2r_xfer_opb_u(thread_ctx_t *thread_ctx, idft_reg_t dst, ADDRINT src)
+void argpack_r2r(thread_ctx_t *thread_ctx, const idft_argpack_t *pack)
 {
-	thread_ctx->vcpu.gpr[dst] =
-		(thread_ctx->vcpu.gpr[dst] & ~(VCPU_MASK8 << 1)) |
-		(((bitmap[VIRT2BYTE(src)] >> VIRT2BIT(src)) << 1) &
-		(VCPU_MASK8 << 1));
+	idft_inline_argpack_r2r(thread_ctx, pack);
+}
 
+void argpack_m2r(thread_ctx_t *thread_ctx, const idft_argpack_t *pack,
+		ADDRINT src)
+{
+	idft_inline_argpack_m2r(thread_ctx, pack, src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between a lower 8-bit 
- * register and a memory location as
- * t[dst] = t[src] (dst is a register)
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source memory address
- */
-void m2r_xfer_opb_l(thread_ctx_t *thread_ctx, idft_reg_t dst, ADDRINT src)
+void argpack_r2m(thread_ctx_t *thread_ctx, const idft_argpack_t *pack,
+		ADDRINT dst)
 {
-	thread_ctx->vcpu.gpr[dst] =
-		(thread_ctx->vcpu.gpr[dst] & ~VCPU_MASK8) |
-		((bitmap[VIRT2BYTE(src)] >> VIRT2BIT(src)) & VCPU_MASK8);
+	idft_inline_argpack_r2m(thread_ctx, pack, dst);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between a 16-bit 
- * register and a memory location as
- * t[dst] = t[src] (dst is a register)
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source memory address
- */
-void m2r_xfer_opw(thread_ctx_t *thread_ctx, idft_reg_t dst, ADDRINT src)
+void _mem_group(thread_ctx_t *thread_ctx, const idft_memgroup_t *group,
+		ADDRINT ea)
 {
-	thread_ctx->vcpu.gpr[dst] =
-		(thread_ctx->vcpu.gpr[dst] & ~VCPU_MASK16) |
-		((*((uint16_t *)(bitmap + VIRT2BYTE(src))) >> VIRT2BIT(src)) &
-		VCPU_MASK16);
+	idft_inline_mem_group(thread_ctx, group, ea);
+}
 
+void _cmov_r2r_opl(thread_ctx_t *thread_ctx, uint32_t cc, ADDRINT eflags,
+		uint32_t dst, uint32_t src)
+{
+	idft_inline_cmov_r2r_opl(thread_ctx, cc, eflags, dst, src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between a 32-bit 
- * register and a memory location as
- * t[dst] = t[src] (dst is a register)
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source memory address
- */
-void m2r_xfer_opl(thread_ctx_t *thread_ctx, idft_reg_t dst, ADDRINT src)
+void _cmov_r2r_opw(thread_ctx_t *thread_ctx, uint32_t cc, ADDRINT eflags,
+		uint32_t dst, uint32_t src)
 {
-	thread_ctx->vcpu.gpr[dst] =
-		(*((uint16_t *)(bitmap + VIRT2BYTE(src))) >> VIRT2BIT(src)) &
-		VCPU_MASK32;
+	idft_inline_cmov_r2r_opw(thread_ctx, cc, eflags, dst, src);
+}
 
+void _cmov_m2r_opl(thread_ctx_t *thread_ctx, uint32_t cc, ADDRINT eflags,
+		uint32_t dst, ADDRINT src)
+{
+	idft_inline_cmov_m2r_opl(thread_ctx, cc, eflags, dst, src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between an 8-bit 
- * register and a n-memory locations as
- * t[dst] = t[src]; src is AL
- *
- * @thread_ctx:	the thread context
- * @dst:	destination memory address
- * @count:	memory bytes
- * @eflags:	the value of the EFLAGS register
- *
- */
-void r2m_xfer_opbn(thread_ctx_t *thread_ctx, ADDRINT dst, ADDRINT count, 
-        ADDRINT eflags)
+void _cmov_m2r_opw(thread_ctx_t *thread_ctx, uint32_t cc, ADDRINT eflags,
+		uint32_t dst, ADDRINT src)
 {
-	if (likely(EFLAGS_DF(eflags) == 0)) {
-		/* EFLAGS.DF = 0 */
+	idft_inline_cmov_m2r_opw(thread_ctx, cc, eflags, dst, src);
+}
 
-		/* the source register is taged */
-		if (thread_ctx->vcpu.gpr[7] & VCPU_MASK8)
-			tagmap_setn(dst, count);
-		/* the source register is clear */
-		else
-			tagmap_clrn(dst, count);
-	}
-	else {
-		/* EFLAGS.DF = 1 */
+void _cmov_r2r_opq(thread_ctx_t *thread_ctx, uint32_t cc, ADDRINT eflags,
+		uint32_t dst, uint32_t src)
+{
+	idft_inline_cmov_r2r_opq(thread_ctx, cc, eflags, dst, src);
+}
 
-		/* the source register is taged */
-		if (thread_ctx->vcpu.gpr[7] & VCPU_MASK8)
-			tagmap_setn(dst - count + 1, count);
-		/* the source register is clear */
-		else
-			tagmap_clrn(dst - count + 1, count);
-	
-	}
+void _cmov_m2r_opq(thread_ctx_t *thread_ctx, uint32_t cc, ADDRINT eflags,
+		uint32_t dst, ADDRINT src)
+{
+	idft_inline_cmov_m2r_opq(thread_ctx, cc, eflags, dst, src);
+}
 
+void shadow_prefetch1(ADDRINT a, uint32_t da)
+{
+	idft_inline_shadow_prefetch1(a, da);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between an 8-bit 
- * register and a memory location as
- * t[dst] = t[upper(src)] (src is a register)
- *
- * @thread_ctx:	the thread context
- * @dst:	destination memory address
- * @src:	source register index (VCPU)
- */
-void r2m_xfer_opb_u(thread_ctx_t *thread_ctx, ADDRINT dst, idft_reg_t src)
+void shadow_prefetch2(ADDRINT a, uint32_t da, ADDRINT b, uint32_t db)
 {
-#ifndef USE_CUSTOM_TAG
-	bitmap[VIRT2BYTE(dst)] =
-		(bitmap[VIRT2BYTE(dst)] & ~(BYTE_MASK << VIRT2BIT(dst))) |
-		(((thread_ctx->vcpu.gpr[src] & (VCPU_MASK8 << 1)) >> 1)
-		<< VIRT2BIT(dst));
-#else
-    tag_t src_tag = RTAG[src][1];
+	idft_inline_shadow_prefetch2(a, da, b, db);
+}
 
-    tag_dir_setb(tag_dir, dst, src_tag);
-#endif
+void shadow_prefetch3(ADDRINT a, uint32_t da, ADDRINT b, uint32_t db,
+		ADDRINT c, uint32_t dc)
+{
+	idft_inline_shadow_prefetch3(a, da, b, db, c, dc);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between an 8-bit 
- * register and a memory location as
- * t[dst] = t[lower(src)] (src is a register)
- *
- * @thread_ctx:	the thread context
- * @dst:	destination memory address
- * @src:	source register index (VCPU)
- */
-void r2m_xfer_opb_l(thread_ctx_t *thread_ctx, ADDRINT dst, idft_reg_t src)
+OUTLINE(xmm_r2r_xfer_opx, xmm_r2r_xfer_opx, uint32_t, uint32_t)
+OUTLINE(xmm_r2r_xfer_opq, xmm_r2r_xfer_opq, uint32_t, uint32_t)
+OUTLINE(xmm_m2r_xfer_opx, xmm_m2r_xfer_opx, uint32_t, ADDRINT)
+OUTLINE(xmm_m2r_xfer_opq, xmm_m2r_xfer_opq, uint32_t, ADDRINT)
+OUTLINE(xmm_m2r_xfer_opl, xmm_m2r_xfer_opl, uint32_t, ADDRINT)
+OUTLINE(xmm_r2m_xfer_opx, xmm_r2m_xfer_opx, ADDRINT, uint32_t)
+OUTLINE(xmm_r2m_xfer_opq, xmm_r2m_xfer_opq, ADDRINT, uint32_t)
+OUTLINE(xmm_r2m_xfer_opl, xmm_r2m_xfer_opl, ADDRINT, uint32_t)
+OUTLINE(xmm_r2x_xfer_opl, xmm_r2x_xfer_opl, uint32_t, uint32_t)
+OUTLINE(xmm_x2r_xfer_opl, xmm_x2r_xfer_opl, uint32_t, uint32_t)
+OUTLINE(xmm_x2r_mask_opx, xmm_x2r_mask_opx, uint32_t, uint32_t)
+OUTLINE(ymm_x2r_mask_opy, ymm_x2r_mask_opy, uint32_t, uint32_t)
+OUTLINE(xmm_r2r_binary_opx, xmm_r2r_binary_opx, uint32_t, uint32_t)
+OUTLINE(xmm_m2r_binary_opx, xmm_m2r_binary_opx, uint32_t, ADDRINT)
+OUTLINE(ymm_r2r_xfer_opx, ymm_r2r_xfer_opx, uint32_t, uint32_t)
+OUTLINE(ymm_r2r_xfer_opy, ymm_r2r_xfer_opy, uint32_t, uint32_t)
+OUTLINE(ymm_m2r_xfer_opx, ymm_m2r_xfer_opx, uint32_t, ADDRINT)
+OUTLINE(ymm_m2r_xfer_opy, ymm_m2r_xfer_opy, uint32_t, ADDRINT)
+OUTLINE(ymm_r2m_xfer_opy, ymm_r2m_xfer_opy, ADDRINT, uint32_t)
+
+void xmm_clr_opx(thread_ctx_t *thread_ctx, uint32_t reg)
 {
+	idft_inline_xmm_clr_opx(thread_ctx, reg);
+}
 
-	bitmap[VIRT2BYTE(dst)] =
-		(bitmap[VIRT2BYTE(dst)] & ~(BYTE_MASK << VIRT2BIT(dst))) |
-		((thread_ctx->vcpu.gpr[src] & VCPU_MASK8) << VIRT2BIT(dst));
+void ymm_clr_opy(thread_ctx_t *thread_ctx, uint32_t reg)
+{
+	idft_inline_ymm_clr_opy(thread_ctx, reg);
+}
 
+void ymm_clr_upper(thread_ctx_t *thread_ctx)
+{
+	idft_inline_ymm_clr_upper(thread_ctx);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between a 16-bit 
- * register and a n-memory locations as
- * t[dst] = t[src]; src is AX
- *
- * @thread_ctx:	the thread context
- * @dst:	destination memory address
- * @count:	memory words
- * @eflags:	the value of the EFLAGS register
- */
-void r2m_xfer_opwn(thread_ctx_t *thread_ctx,
-		ADDRINT dst,
-		ADDRINT count,
-		ADDRINT eflags)
+void ymm_clr_all(thread_ctx_t *thread_ctx)
 {
-	if (likely(EFLAGS_DF(eflags) == 0)) {
-		/* EFLAGS.DF = 0 */
+	idft_inline_ymm_clr_all(thread_ctx);
+}
 
-		/* the source register is taged */
-		if (thread_ctx->vcpu.gpr[7] & VCPU_MASK16)
-			tagmap_setn(dst, (count << 1));
-		/* the source register is clear */
-		else
-			tagmap_clrn(dst, (count << 1));
-	}
-	else {
-		/* EFLAGS.DF = 1 */
+void ymm_rr2r_binary_opx(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src1,
+		uint32_t src2)
+{
+	idft_inline_ymm_rr2r_binary_opx(thread_ctx, dst, src1, src2);
+}
 
-		/* the source register is taged */
-		if (thread_ctx->vcpu.gpr[7] & VCPU_MASK16)
-			tagmap_setn(dst - (count << 1) + 1, (count << 1));
-		/* the source register is clear */
-		else
-			tagmap_clrn(dst - (count << 1) + 1, (count << 1));
-	}
+void ymm_rr2r_binary_opy(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src1,
+		uint32_t src2)
+{
+	idft_inline_ymm_rr2r_binary_opy(thread_ctx, dst, src1, src2);
+}
+
+void ymm_rm2r_binary_opx(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src1,
+		ADDRINT src2)
+{
+	idft_inline_ymm_rm2r_binary_opx(thread_ctx, dst, src1, src2);
+}
 
+void ymm_rm2r_binary_opy(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src1,
+		ADDRINT src2)
+{
+	idft_inline_ymm_rm2r_binary_opy(thread_ctx, dst, src1, src2);
 }
 
 /*
  * tag propagation (analysis function)
  *
- * propagate tag between a 16-bit 
- * register and a memory location as
- * t[dst] = t[src] (src is a register)
+ * ENTER; the tag of EBP is pushed, the frame pointers of the
+ * enclosing frames (nesting level > 0) are copied along with
+ * theirs, t[EBP] = t[ESP], and the locals of the new frame are
+ * cleared in bulk; the program has not written them yet, and the
+ * tags that older frames left there are stale
+ *
+ * NOTE: special case for the ENTER instruction
  *
  * @thread_ctx:	the thread context
- * @dst:	destination memory address
- * @src:	source register index (VCPU)
+ * @esp:	ESP register value
+ * @ebp:	EBP register value
+ * @size:	the size of the locals
+ * @level:	the nesting level
  */
-void r2m_xfer_opw(thread_ctx_t *thread_ctx, ADDRINT dst, idft_reg_t src)
+void
+_enter_opl(thread_ctx_t *thread_ctx, ADDRINT esp, ADDRINT ebp, uint32_t size,
+		uint32_t level)
 {
-	*((uint16_t *)(bitmap + VIRT2BYTE(dst))) =
-		(*((uint16_t *)(bitmap + VIRT2BYTE(dst))) & ~(WORD_MASK <<
-							      VIRT2BIT(dst))) |
-		((uint16_t)(thread_ctx->vcpu.gpr[src] & VCPU_MASK16) <<
-		VIRT2BIT(dst));
+	/* the value of EBP in the new frame */
+	ADDRINT frame = esp - 4;
+	uint32_t esp_tag = VCPU_GPR(thread_ctx, 3) & VCPU_MASK32;
+	uint32_t i;
+
+	/* modulo 32 */
+	level &= 0x1F;
+
+	idft_gen_vec_store(frame, VCPU_MASK32, VCPU_GPR(thread_ctx, 2));
+
+	if (level > 0) {
+		/*
+		 * one pointer at a time, as the CPU pushes them; the
+		 * enclosing frames may overlap the new one
+		 */
+		for (i = 1; i < level; i++)
+			idft_gen_vec_store(frame - 4 * i, VCPU_MASK32,
+				idft_gen_vec_load(ebp - 4 * i, VCPU_MASK32));
+
+		idft_gen_vec_store(frame - 4 * level, VCPU_MASK32, esp_tag);
+	}
+
+	tagmap_filln(frame - 4 * level - size, size, 0);
 
+	VCPU_GPR_SET(thread_ctx, 2, esp_tag);
 }
 
 /*
  * tag propagation (analysis function)
  *
- * propagate tag between a 32-bit 
- * register and a n-memory locations as
- * t[dst] = t[src]; src is EAX
+ * ENTER of a 64-bit stack (IDFT_X86_64); as _enter_opl, with quad
+ * word slots
+ *
+ * NOTE: special case for the ENTER instruction
  *
  * @thread_ctx:	the thread context
- * @dst:	destination memory address
- * @src:	source register index (VCPU)
- * @count:	memory double words
- * @eflags:	the value of the EFLAGS register
+ * @rsp:	RSP register value
+ * @rbp:	RBP register value
+ * @size:	the size of the locals
+ * @level:	the nesting level
  */
-void r2m_xfer_opln(thread_ctx_t *thread_ctx,
-		ADDRINT dst,
-		ADDRINT count,
-		ADDRINT eflags)
+void
+_enter_opq(thread_ctx_t *thread_ctx, ADDRINT rsp, ADDRINT rbp, uint32_t size,
+		uint32_t level)
 {
-#ifndef USE_CUSTOM_TAG
-	if (likely(EFLAGS_DF(eflags) == 0)) {
-		/* EFLAGS.DF = 0 */
+	/* the value of RBP in the new frame */
+	ADDRINT frame = rsp - 8;
+	uint32_t rsp_tag = VCPU_GPR(thread_ctx, 3) & VCPU_MASK64;
+	uint32_t i;
 
-		/* the source register is taged */
-		if (thread_ctx->vcpu.gpr[7])
-			tagmap_setn(dst, (count << 2));
-		/* the source register is clear */
-		else
-			tagmap_clrn(dst, (count << 2));
-	}
-	else {
-		/* EFLAGS.DF = 1 */
+	/* modulo 32 */
+	level &= 0x1F;
 
-		/* the source register is taged */
-		if (thread_ctx->vcpu.gpr[7])
-			tagmap_setn(dst - (count << 2) + 1, (count << 2));
-		/* the source register is clear */
-		else
-			tagmap_clrn(dst - (count << 2) + 1, (count << 2));
-	}
-#else
-    tag_t src_tag[] = R32TAG(GPR_EAX);
-	if (likely(EFLAGS_DF(eflags) == 0)) {
-		/* EFLAGS.DF = 0 */
+	idft_gen_vec_store(frame, VCPU_MASK64, VCPU_GPR(thread_ctx, 2));
 
-        for (size_t i = 0; i < (count << 2); i++)
-        {
-            tag_dir_setb(tag_dir, dst+i, src_tag[i%4]);
+	if (level > 0) {
+		/* one pointer at a time (see _enter_opl) */
+		for (i = 1; i < level; i++)
+			idft_gen_vec_store(frame - 8 * i, VCPU_MASK64,
+				idft_gen_vec_load(rbp - 8 * i, VCPU_MASK64));
 
-        }
+		idft_gen_vec_store(frame - 8 * level, VCPU_MASK64, rsp_tag);
 	}
-	else {
-		/* EFLAGS.DF = 1 */
 
-        for (size_t i = 0; i < (count << 2); i++)
-        {
-            size_t dst_addr = dst - (count << 2) + 1 + i;
-            tag_dir_setb(tag_dir, dst_addr, src_tag[i%4]);
+	tagmap_filln(frame - 8 * level - size, size, 0);
 
-        }
-	}
-#endif
+	VCPU_GPR_SET(thread_ctx, 2, rsp_tag);
 }
 
 /*
- * tag propagation (analysis function)
- *
- * propagate tag between a 32-bit 
- * register and a memory location as
- * t[dst] = t[src] (src is a register)
+ * summarize the VCPU of a thread (see thread_ctx_t)
  *
  * @thread_ctx:	the thread context
- * @dst:	destination memory address
- * @src:	source register index (VCPU)
+ *
+ * returns: the tagged GPRs; bit i for gpr[i], and bit
+ * GPR_NUM for any XMM/YMM register
  */
-void r2m_xfer_opl(thread_ctx_t *thread_ctx, ADDRINT dst, idft_reg_t src)
+uint32_t
+thread_ctx_live(thread_ctx_t *thread_ctx)
 {
-	*((uint16_t *)(bitmap + VIRT2BYTE(dst))) =
-		(*((uint16_t *)(bitmap + VIRT2BYTE(dst))) & ~(LONG_MASK <<
-							      VIRT2BIT(dst))) |
-		((uint16_t)(thread_ctx->vcpu.gpr[src] & VCPU_MASK32) <<
-		VIRT2BIT(dst));
+	uint32_t live = 0, xmm = 0;
+	size_t i;
 
-}
+	/* the scratch register does not count */
+	if (VCPU_GPR_ANY(thread_ctx))
+		for (i = 0; i < GPR_NUM; i++)
+			live |= (VCPU_GPR(thread_ctx, i) != 0) << i;
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 16-bit 
- * memory locations as t[dst] = t[src]
- *
- * @dst:	destination memory address
- * @src:	source memory address
- */
-void m2m_xfer_opw(ADDRINT dst, ADDRINT src)
-{
+	for (i = 0; i < XMM_NUM; i++)
+		xmm |= thread_ctx->vcpu.xmm[i];
+
+	live |= (xmm != 0) << GPR_NUM;
 
-	*((uint16_t *)(bitmap + VIRT2BYTE(dst))) =
-		(*((uint16_t *)(bitmap + VIRT2BYTE(dst))) & ~(WORD_MASK <<
-							      VIRT2BIT(dst))) |
-		(((*((uint16_t *)(bitmap + VIRT2BYTE(src)))) >> VIRT2BIT(src))
-		& WORD_MASK) << VIRT2BIT(dst);
+	thread_ctx->live	= live;
+	thread_ctx->live_epoch	= tagmap_epoch;
 
+	return live;
 }
 
 /*
- * tag propagation (analysis function)
+ * block-entry guard (analysis function)
  *
- * propagate tag between two 8-bit 
- * memory locations as t[dst] = t[src]
+ * is there taint that uninstrumented code would miss;
+ * either in the tagmap, or in the VCPU of the thread.
+ * While taint is dead, registers can only be tagged by
+ * the executer (see THREAD_CTX_STALE), so a summary of
+ * the current epoch is still good; that is one load and
+ * one test in the common case
  *
- * @dst:	destination memory address
- * @src:	source memory address
+ * @thread_ctx:	the thread context
+ *
+ * returns: non-zero if yes, 0 otherwise
  */
-void m2m_xfer_opb(ADDRINT dst, ADDRINT src)
+ADDRINT
+taint_guard(thread_ctx_t *thread_ctx)
 {
-	*((uint16_t *)(bitmap + VIRT2BYTE(dst))) =
-		(*((uint16_t *)(bitmap + VIRT2BYTE(dst))) & ~(BYTE_MASK <<
-							      VIRT2BIT(dst))) |
-		(((*((uint16_t *)(bitmap + VIRT2BYTE(src)))) >> VIRT2BIT(src))
-		& BYTE_MASK) << VIRT2BIT(dst);
+	uint32_t epoch = tagmap_epoch;
+
+	if (likely(thread_ctx->live_epoch == epoch))
+		return thread_ctx->live | (epoch & 1);
+
+	/* taint is live; no need to look at the VCPU */
+	if (epoch & 1)
+		return 1;
+
+	return thread_ctx_live(thread_ctx);
 }
 
 /*
- * tag propagation (analysis function)
- *
- * propagate tag between two 32-bit 
- * memory locations as t[dst] = t[src]
+ * block-entry guard tripped (analysis function)
  *
- * @dst:	destination memory address
- * @src:	source memory address
+ * taint showed up while running uninstrumented code; make
+ * it live, so that the executer switches to the instrumented
+ * versions (it is told once, on the transition)
  */
-void m2m_xfer_opl(ADDRINT dst, ADDRINT src)
+void
+taint_guard_trip(void)
 {
-	*((uint16_t *)(bitmap + VIRT2BYTE(dst))) =
-		(*((uint16_t *)(bitmap + VIRT2BYTE(dst))) & ~(LONG_MASK <<
-							      VIRT2BIT(dst))) |
-		(((*((uint16_t *)(bitmap + VIRT2BYTE(src)))) >> VIRT2BIT(src))
-		& LONG_MASK) << VIRT2BIT(dst);
-
+	tagmap_live_set(1);
 }
 
 /*
- * tag propagation (analysis function)
+ * guard inspection (instrumentation function)
  *
- * instrumentation helper; returns the flag that
- * takes as argument -- seems lame, but it is
- * necessary for aiding conditional analysis to
- * be inlined. Typically used with INS_InsertIfCall()
- * in order to return true (i.e., allow the execution
- * of the function that has been instrumented with
- * INS_InsertThenCall()) only once
+ * instrument the first instruction of the uninstrumented
+ * version of a block with a guard that makes taint live, and
+ * thus notifies the executer (see libdft_taint_set_cb), if the
+ * block runs while the VCPU of its thread is tagged
  *
- * first_iteration:	flag; indicates whether the rep-prefixed instruction is
- * 			executed for the first time or not
+ * @ins:	the first instruction of the block
  */
-ADDRINT rep_predicate(BOOL first_iteration)
+void
+guard_inspect(idft_ins_t* ins , idft_context_t * context)
 {
-	/* return the flag; typically this is true only once */
-	return first_iteration; 
+	EXE->INS_InsertIfCall(ins, context, IDFT_IPOINT_BEFORE,
+		taint_guard,
+		1,
+		IARG_THREAD_CONTEXT
+		);
+	EXE->INS_InsertThenCall(ins, context, IDFT_IPOINT_BEFORE,
+		taint_guard_trip,
+		0
+		);
 }
 
+
 /*
- * tag propagation (analysis function)
- *
- * restore the tag values for all the
- * 16-bit general purpose registers from
- * the memory
+ * the condition code of a CMOVcc (see idft_inline_cc_mask)
  *
- * NOTE: special case for POPA instruction 
+ * @opcode:	the instruction class
  *
- * @thread_ctx:	the thread context
- * @src:	the source memory address	
+ * returns: the code, in the encoding order of the opcodes
  */
-void m2r_restore_opw(thread_ctx_t *thread_ctx, ADDRINT src)
+uint32_t
+cmov_cc(uint32_t opcode)
 {
-	/* tagmap value */
-	uint16_t src_val = *(uint16_t *)(bitmap + VIRT2BYTE(src));
-
-	/* restore DI */
-	thread_ctx->vcpu.gpr[0] =
-		(thread_ctx->vcpu.gpr[0] & ~VCPU_MASK16) |
-		((src_val >> VIRT2BIT(src)) & VCPU_MASK16);
-	
-	/* restore SI */
-	thread_ctx->vcpu.gpr[1] =
-		(thread_ctx->vcpu.gpr[1] & ~VCPU_MASK16) |
-		((src_val >> VIRT2BIT(src + 2)) & VCPU_MASK16);
-	
-	/* restore BP */
-	thread_ctx->vcpu.gpr[2] =
-		(thread_ctx->vcpu.gpr[2] & ~VCPU_MASK16) |
-		((src_val >> VIRT2BIT(src + 4)) & VCPU_MASK16);
-	
-	/* update the tagmap value */
-	src	+= 8;
-	src_val	= *(uint16_t *)(bitmap + VIRT2BYTE(src));
-
-	/* restore BX */
-	thread_ctx->vcpu.gpr[4] =
-		(thread_ctx->vcpu.gpr[4] & ~VCPU_MASK16) |
-		((src_val >> VIRT2BIT(src)) & VCPU_MASK16);
-	
-	/* restore DX */
-	thread_ctx->vcpu.gpr[5] =
-		(thread_ctx->vcpu.gpr[5] & ~VCPU_MASK16) |
-		((src_val >> VIRT2BIT(src + 2)) & VCPU_MASK16);
-	
-	/* restore CX */
-	thread_ctx->vcpu.gpr[6] =
-		(thread_ctx->vcpu.gpr[6] & ~VCPU_MASK16) |
-		((src_val >> VIRT2BIT(src + 4)) & VCPU_MASK16);
-	
-	/* restore AX */
-	thread_ctx->vcpu.gpr[7] =
-		(thread_ctx->vcpu.gpr[7] & ~VCPU_MASK16) |
-		((src_val >> VIRT2BIT(src + 6)) & VCPU_MASK16);
-
+	switch (opcode) {
+		case XED_ICLASS_CMOVO:		return 0x0;
+		case XED_ICLASS_CMOVNO:		return 0x1;
+		case XED_ICLASS_CMOVB:		return 0x2;
+		case XED_ICLASS_CMOVNB:		return 0x3;
+		case XED_ICLASS_CMOVZ:		return 0x4;
+		case XED_ICLASS_CMOVNZ:		return 0x5;
+		case XED_ICLASS_CMOVBE:		return 0x6;
+		case XED_ICLASS_CMOVNBE:	return 0x7;
+		case XED_ICLASS_CMOVS:		return 0x8;
+		case XED_ICLASS_CMOVNS:		return 0x9;
+		case XED_ICLASS_CMOVP:		return 0xA;
+		case XED_ICLASS_CMOVNP:		return 0xB;
+		case XED_ICLASS_CMOVL:		return 0xC;
+		case XED_ICLASS_CMOVNL:		return 0xD;
+		case XED_ICLASS_CMOVLE:		return 0xE;
+		case XED_ICLASS_CMOVNLE:
+		default:			return 0xF;
+	}
 }
 
 /*
- * tag propagation (analysis function)
+ * instrument an ENTER (see _enter_opl and _enter_opq); the size and
+ * nesting level are immediates, which the executer may not tell (in
+ * which case only the push of EBP and the move to it are propagated)
  *
- * restore the tag values for all the
- * 32-bit general purpose registers from
- * the memory
- *
- * NOTE: special case for POPAD instruction 
- *
- * @thread_ctx:	the thread context
- * @src:	the source memory address	
+ * @ins:	the instruction
  */
-void m2r_restore_opl(thread_ctx_t *thread_ctx, ADDRINT src)
+static void
+enter_inspect(idft_ins_t *ins, idft_context_t *context)
 {
-	/* tagmap value */
-	uint16_t src_val = *(uint16_t *)(bitmap + VIRT2BYTE(src));
-
-	/* restore EDI */
-	thread_ctx->vcpu.gpr[0] =
-		(src_val >> VIRT2BIT(src)) & VCPU_MASK32;
-
-	/* restore ESI */
-	thread_ctx->vcpu.gpr[1] =
-		(src_val >> VIRT2BIT(src + 4)) & VCPU_MASK32;
-	
-	/* update the tagmap value */
-	src	+= 8;
-	src_val	= *(uint16_t *)(bitmap + VIRT2BYTE(src));
-
-	/* restore EBP */
-	thread_ctx->vcpu.gpr[2] =
-		(src_val >> VIRT2BIT(src)) & VCPU_MASK32;
-	
-	/* update the tagmap value */
-	src	+= 8;
-	src_val	= *(uint16_t *)(bitmap + VIRT2BYTE(src));
-
-	/* restore EBX */
-	thread_ctx->vcpu.gpr[4] =
-		(src_val >> VIRT2BIT(src)) & VCPU_MASK32;
-	
-	/* restore EDX */
-	thread_ctx->vcpu.gpr[5] =
-		(src_val >> VIRT2BIT(src + 4)) & VCPU_MASK32;
-	
-	/* update the tagmap value */
-	src	+= 8;
-	src_val	= *(uint16_t *)(bitmap + VIRT2BYTE(src));
+	uint32_t size = 0, level = 0;
+	void *func;
 
-	/* restore ECX */
-	thread_ctx->vcpu.gpr[6] =
-		(src_val >> VIRT2BIT(src)) & VCPU_MASK32;
-	
-	/* restore EAX */
-	thread_ctx->vcpu.gpr[7] =
-		(src_val >> VIRT2BIT(src + 4)) & VCPU_MASK32;
+	switch (EXE->INS_MemoryWriteSize(ins, context)) {
+		case BIT2BYTE(MEM_LONG_LEN):
+			func = (void *)_enter_opl;
+			break;
+#ifdef IDFT_X86_64
+		case BIT2BYTE(MEM_QUAD_LEN):
+			func = (void *)_enter_opq;
+			break;
+#endif
+		/* 16-bit operand size; left as is */
+		default:
+			return;
+	}
 
-}
+	if (EXE->INS_OperandImmediate != NULL) {
+		size	= (uint32_t)EXE->INS_OperandImmediate(ins, context, 0) &
+			0xFFFF;
+		level	= (uint32_t)EXE->INS_OperandImmediate(ins, context, 1) &
+			0x1F;
+	}
 
-/*
- * tag propagation (analysis function)
- *
- * save the tag values for all the 16-bit
- * general purpose registers into the memory
- *
- * NOTE: special case for PUSHA instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	the destination memory address
- */
-void r2m_save_opw(thread_ctx_t *thread_ctx, ADDRINT dst)
-{
-	/* save DI */
-	*((uint16_t *)(bitmap + VIRT2BYTE(dst))) =
-		(*((uint16_t *)(bitmap + VIRT2BYTE(dst))) & ~(WORD_MASK <<
-							      VIRT2BIT(dst))) |
-		((uint16_t)(thread_ctx->vcpu.gpr[0] & VCPU_MASK16) <<
-		VIRT2BIT(dst));
-
-	/* update the destination memory */
-	dst += 2;
-
-	/* save SI */
-	*((uint16_t *)(bitmap + VIRT2BYTE(dst))) =
-		(*((uint16_t *)(bitmap + VIRT2BYTE(dst))) & ~(WORD_MASK <<
-							      VIRT2BIT(dst))) |
-		((uint16_t)(thread_ctx->vcpu.gpr[1] & VCPU_MASK16) <<
-		VIRT2BIT(dst));
-
-	/* update the destination memory */
-	dst += 2;
-
-	/* save BP */
-	*((uint16_t *)(bitmap + VIRT2BYTE(dst))) =
-		(*((uint16_t *)(bitmap + VIRT2BYTE(dst))) & ~(WORD_MASK <<
-							      VIRT2BIT(dst))) |
-		((uint16_t)(thread_ctx->vcpu.gpr[2] & VCPU_MASK16) <<
-		VIRT2BIT(dst));
-
-	/* update the destination memory */
-	dst += 2;
-
-	/* save SP */
-	*((uint16_t *)(bitmap + VIRT2BYTE(dst))) =
-		(*((uint16_t *)(bitmap + VIRT2BYTE(dst))) & ~(WORD_MASK <<
-							      VIRT2BIT(dst))) |
-		((uint16_t)(thread_ctx->vcpu.gpr[3] & VCPU_MASK16) <<
-		VIRT2BIT(dst));
-
-	/* update the destination memory */
-	dst += 2;
-
-	/* save BX */
-	*((uint16_t *)(bitmap + VIRT2BYTE(dst))) =
-		(*((uint16_t *)(bitmap + VIRT2BYTE(dst))) & ~(WORD_MASK <<
-							      VIRT2BIT(dst))) |
-		((uint16_t)(thread_ctx->vcpu.gpr[4] & VCPU_MASK16) <<
-		VIRT2BIT(dst));
-
-	/* update the destination memory */
-	dst += 2;
-
-	/* save DX */
-	*((uint16_t *)(bitmap + VIRT2BYTE(dst))) =
-		(*((uint16_t *)(bitmap + VIRT2BYTE(dst))) & ~(WORD_MASK <<
-							      VIRT2BIT(dst))) |
-		((uint16_t)(thread_ctx->vcpu.gpr[5] & VCPU_MASK16) <<
-		VIRT2BIT(dst));
-
-	/* update the destination memory */
-	dst += 2;
-
-	/* save CX */
-	*((uint16_t *)(bitmap + VIRT2BYTE(dst))) =
-		(*((uint16_t *)(bitmap + VIRT2BYTE(dst))) & ~(WORD_MASK <<
-							      VIRT2BIT(dst))) |
-		((uint16_t)(thread_ctx->vcpu.gpr[6] & VCPU_MASK16) <<
-		VIRT2BIT(dst));
-
-	/* update the destination memory */
-	dst += 2;
-
-	/* save AX */
-	*((uint16_t *)(bitmap + VIRT2BYTE(dst))) =
-		(*((uint16_t *)(bitmap + VIRT2BYTE(dst))) & ~(WORD_MASK <<
-							      VIRT2BIT(dst))) |
-		((uint16_t)(thread_ctx->vcpu.gpr[7] & VCPU_MASK16) <<
-		VIRT2BIT(dst));
+	EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+		func,
+		9,
+		IARG_THREAD_CONTEXT,
+		IARG_REG_VALUE,
+		EXE->REG_ESP(ins, context),
+		IARG_REG_VALUE,
+		EXE->REG_EBP(ins, context),
+		IARG_UINT32,
+		size,
+		IARG_UINT32,
+		level
+		);
 }
 
 /*
- * tag propagation (analysis function)
- *
- * save the tag values for all the 32-bit
- * general purpose registers into the memory
+ * instrument a CMPXCHG with one branch-free call (IDFT_OPT_BRANCHFREE),
+ * instead of the _fast/_slow predicated pair of ins_inspect
  *
- * NOTE: special case for PUSHAD instruction 
+ * @ins:	the instruction
  *
- * @thread_ctx:	the thread context
- * @dst:	the destination memory address
+ * returns: 1 if instrumented, 0 otherwise (8-bit operands)
  */
-void r2m_save_opl(thread_ctx_t *thread_ctx, ADDRINT dst)
+static int
+cmpxchg_bf(idft_ins_t *ins, idft_context_t *context)
 {
-
-	/* save EDI */
-	*((uint16_t *)(bitmap + VIRT2BYTE(dst))) =
-		(*((uint16_t *)(bitmap + VIRT2BYTE(dst))) & ~(LONG_MASK <<
-							      VIRT2BIT(dst))) |
-		((uint16_t)(thread_ctx->vcpu.gpr[0] & VCPU_MASK32) <<
-		VIRT2BIT(dst));
-
-	/* update the destination memory address */
-	dst += 4;
-
-	/* save ESI */
-	*((uint16_t *)(bitmap + VIRT2BYTE(dst))) =
-		(*((uint16_t *)(bitmap + VIRT2BYTE(dst))) & ~(LONG_MASK <<
-							      VIRT2BIT(dst))) |
-		((uint16_t)(thread_ctx->vcpu.gpr[1] & VCPU_MASK32) <<
-		VIRT2BIT(dst));
-	
-	/* update the destination memory address */
-	dst += 4;
-
-	/* save EBP */
-	*((uint16_t *)(bitmap + VIRT2BYTE(dst))) =
-		(*((uint16_t *)(bitmap + VIRT2BYTE(dst))) & ~(LONG_MASK <<
-							      VIRT2BIT(dst))) |
-		((uint16_t)(thread_ctx->vcpu.gpr[2] & VCPU_MASK32) <<
-		VIRT2BIT(dst));
-	
-	/* update the destination memory address */
-	dst += 4;
-
-	/* save ESP */
-	*((uint16_t *)(bitmap + VIRT2BYTE(dst))) =
-		(*((uint16_t *)(bitmap + VIRT2BYTE(dst))) & ~(LONG_MASK <<
-							      VIRT2BIT(dst))) |
-		((uint16_t)(thread_ctx->vcpu.gpr[3] & VCPU_MASK32) <<
-		VIRT2BIT(dst));
-
-	/* update the destination memory address */
-	dst += 4;
-
-	/* save EBX */
-	*((uint16_t *)(bitmap + VIRT2BYTE(dst))) =
-		(*((uint16_t *)(bitmap + VIRT2BYTE(dst))) & ~(LONG_MASK <<
-							      VIRT2BIT(dst))) |
-		((uint16_t)(thread_ctx->vcpu.gpr[4] & VCPU_MASK32) <<
-		VIRT2BIT(dst));
-	
-	/* update the destination memory address */
-	dst += 4;
-
-	/* save EDX */
-	*((uint16_t *)(bitmap + VIRT2BYTE(dst))) =
-		(*((uint16_t *)(bitmap + VIRT2BYTE(dst))) & ~(LONG_MASK <<
-							      VIRT2BIT(dst))) |
-		((uint16_t)(thread_ctx->vcpu.gpr[5] & VCPU_MASK32) <<
-		VIRT2BIT(dst));
-	
-	/* update the destination memory address */
-	dst += 4;
-
-	/* save ECX */
-	*((uint16_t *)(bitmap + VIRT2BYTE(dst))) =
-		(*((uint16_t *)(bitmap + VIRT2BYTE(dst))) & ~(LONG_MASK <<
-							      VIRT2BIT(dst))) |
-		((uint16_t)(thread_ctx->vcpu.gpr[6] & VCPU_MASK32) <<
-		VIRT2BIT(dst));
-	
-	/* update the destination memory address */
-	dst += 4;
-	
-	/* save EAX */
-	*((uint16_t *)(bitmap + VIRT2BYTE(dst))) =
-		(*((uint16_t *)(bitmap + VIRT2BYTE(dst))) & ~(LONG_MASK <<
-							      VIRT2BIT(dst))) |
-		((uint16_t)(thread_ctx->vcpu.gpr[7] & VCPU_MASK32) <<
-		VIRT2BIT(dst));
-
+	idft_reg_t reg_dst, reg_src = EXE->INS_OperandReg(ins, context, 1);
+
+	/* both operands are registers */
+	if (EXE->INS_MemoryOperandCount(ins, context) == 0) {
+		reg_dst = EXE->INS_OperandReg(ins, context, 0);
+
+		if (EXE->REG_is_gr32(ins, context, reg_dst))
+			EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+				_cmpxchg_r2r_opl_bf,
+				9,
+				IARG_THREAD_CONTEXT,
+				IARG_REG_VALUE,
+				EXE->REG_EAX(ins, context),
+				IARG_UINT32,
+				(uint32_t)REG32_INDX(ins, context, reg_dst),
+				IARG_REG_VALUE,
+				reg_dst,
+				IARG_UINT32,
+				(uint32_t)REG32_INDX(ins, context, reg_src)
+				);
+		else if (EXE->REG_is_gr16(ins, context, reg_dst))
+			EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+				_cmpxchg_r2r_opw_bf,
+				9,
+				IARG_THREAD_CONTEXT,
+				IARG_REG_VALUE,
+				EXE->REG_AX(ins, context),
+				IARG_UINT32,
+				(uint32_t)REG16_INDX(ins, context, reg_dst),
+				IARG_REG_VALUE,
+				reg_dst,
+				IARG_UINT32,
+				(uint32_t)REG16_INDX(ins, context, reg_src)
+				);
+		else
+			return 0;
+	}
+	/* 1st operand is memory */
+	else if (EXE->REG_is_gr32(ins, context, reg_src))
+		EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+			_cmpxchg_m2r_opl_bf,
+			6,
+			IARG_THREAD_CONTEXT,
+			IARG_REG_VALUE,
+			EXE->REG_EAX(ins, context),
+			IARG_MEMORYWRITE_EA,
+			IARG_UINT32,
+			(uint32_t)REG32_INDX(ins, context, reg_src)
+			);
+	else if (EXE->REG_is_gr16(ins, context, reg_src))
+		EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+			_cmpxchg_m2r_opw_bf,
+			6,
+			IARG_THREAD_CONTEXT,
+			IARG_REG_VALUE,
+			EXE->REG_AX(ins, context),
+			IARG_MEMORYWRITE_EA,
+			IARG_UINT32,
+			(uint32_t)REG16_INDX(ins, context, reg_src)
+			);
+	else
+		return 0;
+
+	return 1;
 }
 
 
-
 /*
  * instruction inspection (instrumentation function)
  *
@@ -2578,6 +1378,16 @@ ins_inspect(idft_ins_t* ins , idft_context_t * context)
 	 */
     idft_reg_t reg_dst, reg_src, reg_base, reg_indx;
 
+	/* branch-free variants of the data-dependent handlers */
+	int bf = (context->opts & IDFT_OPT_BRANCHFREE) != 0;
+
+	/* filtered out (see libicedft_filter.c) */
+	if (unlikely(context->filter != NULL) && filter_skip(ins, context))
+		return;
+
+	/* planned already (see libicedft_plan.c) */
+	if (unlikely(context->plans != NULL) && plan_inspect(ins, context))
+		return;
 
     /* use XED to decode the instruction and extract its opcode */
 	xed_iclass_enum_t ins_indx = (xed_iclass_enum_t)EXE->INS_Opcode(ins, context);
@@ -2592,6 +1402,12 @@ ins_inspect(idft_ins_t* ins , idft_context_t * context)
 		return;
 	}
 
+#ifdef IDFT_X86_64
+	/* 64-bit operands (see libicedft_x64.c) */
+	if (x64_inspect(ins, context, ins_indx))
+		return;
+#endif
+
 	/* analyze the instruction */
 	switch(ins_indx){
 		/* adc */
@@ -2732,7 +1548,7 @@ ins_inspect(idft_ins_t* ins , idft_context_t * context)
 										3,
 										IARG_THREAD_CONTEXT,
 										IARG_UINT32,
-									    (idft_reg_t)REG8_INDX(ins, context, reg_dst)
+									    (uint32_t)REG8_INDX(ins, context, reg_dst)
 										);
 
 								/* done */
@@ -3266,6 +2082,12 @@ ins_inspect(idft_ins_t* ins , idft_context_t * context)
 				* move the tag of the source to the destination
 				* iff the corresponding condition is met
 				* (i.e., t[dst] = t[src])
+				*
+				* NOTE: the condition is evaluated by the
+				* analysis routine, with a mask, instead of
+				* predicating the call; there is no branch
+				* to mispredict, and executers need not
+				* support predication
 				*/
 				/* both operands are registers */
 				if (EXE->INS_MemoryOperandCount(ins , context) == 0) {
@@ -3276,10 +2098,14 @@ ins_inspect(idft_ins_t* ins , idft_context_t * context)
 					/* 32-bit operands */
 					if (EXE->REG_is_gr32(ins, context, reg_dst))
 						/* propagate the tag accordingly */
-						EXE->INS_InsertPredicatedCall(ins, context, IDFT_IPOINT_BEFORE,
-							r2r_xfer_opl,
-							5, 
+						EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+							_cmov_r2r_opl,
+							9, 
 							IARG_THREAD_CONTEXT,
+							IARG_UINT32,
+							cmov_cc(ins_indx),
+							IARG_REG_VALUE,
+							EXE->REG_EFLAGS(ins, context),
 							IARG_UINT32, 
 							(uint32_t)REG32_INDX(ins, context, reg_dst),
 							IARG_UINT32, 
@@ -3288,10 +2114,14 @@ ins_inspect(idft_ins_t* ins , idft_context_t * context)
 					/* 16-bit operands */
 					else 
 						/* propagate tag accordingly */
-						EXE->INS_InsertPredicatedCall(ins, context, IDFT_IPOINT_BEFORE,
-							r2r_xfer_opw,
-							5, 
+						EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+							_cmov_r2r_opw,
+							9, 
 							IARG_THREAD_CONTEXT,
+							IARG_UINT32,
+							cmov_cc(ins_indx),
+							IARG_REG_VALUE,
+							EXE->REG_EFLAGS(ins, context),
 							IARG_UINT32, 
 							(uint32_t)REG16_INDX(ins, context, reg_dst),
 							IARG_UINT32, 
@@ -3313,11 +2143,14 @@ ins_inspect(idft_ins_t* ins , idft_context_t * context)
 					/* 32-bit operands */
 					if (EXE->REG_is_gr32(ins, context,reg_dst))
 						/* propagate the tag accordingly */
-						// modify by menertry
-						EXE->INS_InsertPredicatedCall(ins,  context, IDFT_IPOINT_BEFORE,
-							m2r_xfer_opl,
-							4,
+						EXE->INS_InsertCall(ins,  context, IDFT_IPOINT_BEFORE,
+							_cmov_m2r_opl,
+							8,
 							IARG_THREAD_CONTEXT,
+							IARG_UINT32,
+							cmov_cc(ins_indx),
+							IARG_REG_VALUE,
+							EXE->REG_EFLAGS(ins, context),
 							IARG_UINT32, 
 							(uint32_t)REG32_INDX(ins, context, reg_dst),
 							IARG_MEMORYREAD_EA
@@ -3325,11 +2158,14 @@ ins_inspect(idft_ins_t* ins , idft_context_t * context)
 					/* 16-bit operands */
 					else
 						/* propagate the tag accordingly */
-						// modify by menertry
-						EXE->INS_InsertPredicatedCall(ins,  context, IDFT_IPOINT_BEFORE,
-							m2r_xfer_opw,
-							4,
+						EXE->INS_InsertCall(ins,  context, IDFT_IPOINT_BEFORE,
+							_cmov_m2r_opw,
+							8,
 							IARG_THREAD_CONTEXT,
+							IARG_UINT32,
+							cmov_cc(ins_indx),
+							IARG_REG_VALUE,
+							EXE->REG_EFLAGS(ins, context),
 							IARG_UINT32, 
 							(uint32_t)REG16_INDX(ins, context, reg_dst),
 							IARG_MEMORYREAD_EA
@@ -4161,6 +2997,10 @@ ins_inspect(idft_ins_t* ins , idft_context_t * context)
 			* and I'm really tired to comment this crap...
 			*/
 			case XED_ICLASS_CMPXCHG:
+				/* one branch-free call */
+				if (bf && cmpxchg_bf(ins, context))
+					break;
+
 				/* both operands are registers */
 				if (EXE->INS_MemoryOperandCount(ins, context) == 0) {
 					/* extract the operands */
@@ -4296,7 +3136,7 @@ ins_inspect(idft_ins_t* ins , idft_context_t * context)
 							5, 
 							IARG_THREAD_CONTEXT,
 							IARG_UINT32, 
-							8,
+							GPR_SCRATCH,
 							IARG_UINT32, 
 							REG32_INDX(ins, context,  reg_dst)
 							);
@@ -4316,7 +3156,7 @@ ins_inspect(idft_ins_t* ins , idft_context_t * context)
 							IARG_UINT32, 
 							(uint32_t)REG32_INDX(ins, context, reg_src),
 							IARG_UINT32, 
-							8
+							GPR_SCRATCH
 							);
 					}
 					/* 16-bit operands */
@@ -4521,7 +3361,7 @@ ins_inspect(idft_ins_t* ins , idft_context_t * context)
 							5, 
 							IARG_THREAD_CONTEXT,
 							IARG_UINT32, 
-							8,
+							GPR_SCRATCH,
 							IARG_UINT32, 
 							(uint32_t)REG32_INDX(ins,  context, reg_dst)
 							);
@@ -4541,7 +3381,7 @@ ins_inspect(idft_ins_t* ins , idft_context_t * context)
 							IARG_UINT32, 
 							(uint32_t)REG32_INDX(ins,  context, reg_src),
 							IARG_UINT32, 
-							8
+							GPR_SCRATCH
 							);
 						EXE->INS_InsertCall(ins,  context, IDFT_IPOINT_BEFORE,
 							r2r_binary_opl,
@@ -4755,7 +3595,8 @@ ins_inspect(idft_ins_t* ins , idft_context_t * context)
 						IARG_FIRST_REP_ITERATION
 						);
 					EXE->INS_InsertThenPredicatedCall(ins, context, IDFT_IPOINT_BEFORE,
-						r2m_xfer_opbn,
+						bf ? (void *)r2m_xfer_opbn_bf :
+							(void *)r2m_xfer_opbn,
 						6, 
 						IARG_THREAD_CONTEXT,
 						IARG_MEMORYWRITE_EA,
@@ -4800,7 +3641,8 @@ ins_inspect(idft_ins_t* ins , idft_context_t * context)
 						IARG_FIRST_REP_ITERATION
 						);
 					EXE->INS_InsertThenPredicatedCall(ins,  context, IDFT_IPOINT_BEFORE,
-						r2m_xfer_opwn,
+						bf ? (void *)r2m_xfer_opwn_bf :
+							(void *)r2m_xfer_opwn,
 						6, 
 						IARG_THREAD_CONTEXT,
 						IARG_MEMORYWRITE_EA,
@@ -4845,7 +3687,8 @@ ins_inspect(idft_ins_t* ins , idft_context_t * context)
 						);
 					
 					EXE->INS_InsertThenPredicatedCall(ins,  context, IDFT_IPOINT_BEFORE,
-						r2m_xfer_opln,
+						bf ? (void *)r2m_xfer_opln_bf :
+							(void *)r2m_xfer_opln,
 						6, 
 						IARG_THREAD_CONTEXT,
 						IARG_MEMORYWRITE_EA,
@@ -4872,37 +3715,100 @@ ins_inspect(idft_ins_t* ins , idft_context_t * context)
 				break;
 			/* movsd */
 			case XED_ICLASS_MOVSD:
-				/* propagate the tag accordingly */
-				EXE->INS_InsertPredicatedCall(ins,  context, IDFT_IPOINT_BEFORE,
-					m2m_xfer_opl,
-					2,
-					IARG_MEMORYWRITE_EA,
-					IARG_MEMORYREAD_EA
-					);
+				/* the instruction is rep prefixed */
+				if (EXE->INS_RepPrefix(ins, context)) {
+					/* the whole string at once */
+					EXE->INS_InsertIfPredicatedCall(ins,  context, IDFT_IPOINT_BEFORE,
+						rep_predicate,
+						1,
+						IARG_FIRST_REP_ITERATION
+						);
+
+					EXE->INS_InsertThenPredicatedCall(ins,  context, IDFT_IPOINT_BEFORE,
+						m2m_xfer_opln,
+						6,
+						IARG_MEMORYWRITE_EA,
+						IARG_MEMORYREAD_EA,
+						IARG_REG_VALUE,
+						EXE->INS_RepCountRegister(ins, context),
+						IARG_REG_VALUE,
+						EXE->REG_EFLAGS(ins, context)
+						);
+				}
+				/* no rep prefix */
+				else
+					EXE->INS_InsertPredicatedCall(ins,  context, IDFT_IPOINT_BEFORE,
+						m2m_xfer_opl,
+						2,
+						IARG_MEMORYWRITE_EA,
+						IARG_MEMORYREAD_EA
+						);
 
 				/* done */
 				break;
 			/* movsw */
 			case XED_ICLASS_MOVSW:
-				/* propagate the tag accordingly */
-				EXE->INS_InsertPredicatedCall(ins,  context, IDFT_IPOINT_BEFORE,
-					m2m_xfer_opw,
-					2,
-					IARG_MEMORYWRITE_EA,
-					IARG_MEMORYREAD_EA
-					);
+				/* the instruction is rep prefixed */
+				if (EXE->INS_RepPrefix(ins, context)) {
+					/* the whole string at once */
+					EXE->INS_InsertIfPredicatedCall(ins,  context, IDFT_IPOINT_BEFORE,
+						rep_predicate,
+						1,
+						IARG_FIRST_REP_ITERATION
+						);
+
+					EXE->INS_InsertThenPredicatedCall(ins,  context, IDFT_IPOINT_BEFORE,
+						m2m_xfer_opwn,
+						6,
+						IARG_MEMORYWRITE_EA,
+						IARG_MEMORYREAD_EA,
+						IARG_REG_VALUE,
+						EXE->INS_RepCountRegister(ins, context),
+						IARG_REG_VALUE,
+						EXE->REG_EFLAGS(ins, context)
+						);
+				}
+				/* no rep prefix */
+				else
+					EXE->INS_InsertPredicatedCall(ins,  context, IDFT_IPOINT_BEFORE,
+						m2m_xfer_opw,
+						2,
+						IARG_MEMORYWRITE_EA,
+						IARG_MEMORYREAD_EA
+						);
 
 				/* done */
 				break;
 			/* movsb */
 			case XED_ICLASS_MOVSB:
-				/* propagate the tag accordingly */
-				EXE->INS_InsertPredicatedCall(ins,  context, IDFT_IPOINT_BEFORE,
-					m2m_xfer_opb,
-					2,
-					IARG_MEMORYWRITE_EA,
-					IARG_MEMORYREAD_EA
-					);
+				/* the instruction is rep prefixed */
+				if (EXE->INS_RepPrefix(ins, context)) {
+					/* the whole string at once */
+					EXE->INS_InsertIfPredicatedCall(ins,  context, IDFT_IPOINT_BEFORE,
+						rep_predicate,
+						1,
+						IARG_FIRST_REP_ITERATION
+						);
+
+					EXE->INS_InsertThenPredicatedCall(ins,  context, IDFT_IPOINT_BEFORE,
+						m2m_xfer_opbn,
+						6,
+						IARG_MEMORYWRITE_EA,
+						IARG_MEMORYREAD_EA,
+						IARG_REG_VALUE,
+						EXE->INS_RepCountRegister(ins, context),
+						IARG_REG_VALUE,
+						EXE->REG_EFLAGS(ins, context)
+						);
+				}
+				/* no rep prefix */
+				else
+					EXE->INS_InsertPredicatedCall(ins,  context, IDFT_IPOINT_BEFORE,
+						m2m_xfer_opb,
+						2,
+						IARG_MEMORYWRITE_EA,
+						IARG_MEMORYREAD_EA
+						);
 
 				/* done */
 				break;
@@ -4919,7 +3825,6 @@ ins_inspect(idft_ins_t* ins , idft_context_t * context)
 
 				/* done */
 				break;
-			/* TODO: shifts are not handled (yet) */
 			/* rcl */
 			case XED_ICLASS_RCL:
 			/* rcr */        
@@ -4936,7 +3841,14 @@ ins_inspect(idft_ins_t* ins , idft_context_t * context)
 			case XED_ICLASS_SHR:
 			/* shld */
 			case XED_ICLASS_SHLD:
+			/* shrd */
 			case XED_ICLASS_SHRD:
+			/* bswap */
+			case XED_ICLASS_BSWAP:
+			/* movbe */
+			case XED_ICLASS_MOVBE:
+				/* see libicedft_shift.c */
+				shift_inspect(ins, context, ins_indx);
 
 				/* done */
 				break;
@@ -5428,11 +4340,29 @@ ins_inspect(idft_ins_t* ins , idft_context_t * context)
 				}
 				/* done */
 				break;
-			/* cmpxchg */
+			/* 
+			* cmpxchg8b;
+			* t[m64] = t[ECX:EBX] iff EDX:EAX == m64, else
+			* t[EDX:EAX] = t[m64]
+			*/
 			case XED_ICLASS_CMPXCHG8B:
-			/* enter */
+				/* propagate the tag accordingly; one call */
+				EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+					_cmpxchg8b_m2r_bf,
+					6,
+					IARG_THREAD_CONTEXT,
+					IARG_REG_VALUE,
+					EXE->REG_EAX(ins, context),
+					IARG_REG_VALUE,
+					EXE->REG_EDX(ins, context),
+					IARG_MEMORYWRITE_EA
+					);
+
+				/* done */
+				break;
+			/* enter; a push of EBP, and a frame (see enter_inspect) */
 			case XED_ICLASS_ENTER:
-				IDFT_LOG("unhandled operand： %s\n",EXE->INS_Disassemble(ins, context) );
+				enter_inspect(ins, context);
 
 				/* done */
 				break;
@@ -5441,6 +4371,8 @@ ins_inspect(idft_ins_t* ins , idft_context_t * context)
 			* default handler
 			*/
 			default:
+				/* SSE/AVX (see libicedft_simd.c) */
+				simd_inspect(ins, context, ins_indx);
 			/* (void)fprintf(stdout, "%s\n",
 				INS_Disassemble(ins).c_str()); */
 			break;
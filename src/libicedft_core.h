@@ -34,13 +34,20 @@
 #define LIBICEDFT_CORE_H
 
 #include "libicedft_types.h"
+#include "libicedft_api.h"
 
 #define VCPU_MASK32	0x0F			/* 32-bit VCPU mask */
 #define VCPU_MASK16	0x03			/* 16-bit VCPU mask */
 #define VCPU_MASK8	0x01			/* 8-bit VCPU mask */
+#define VCPU_MASK64	0xFF			/* 64-bit (MMX/low XMM) mask */
+#define VCPU_MASK128	0xFFFF			/* 128-bit (XMM) mask */
+#define VCPU_MASK256	0xFFFFFFFFU		/* 256-bit (YMM) mask */
+#define MEM_QUAD_LEN	64			/* quad size (64-bit) */
 #define MEM_LONG_LEN	32			/* long size (32-bit) */
 #define MEM_WORD_LEN	16			/* word size (16-bit) */
 #define MEM_BYTE_LEN	8			/* byte size (8-bit) */
+#define MEM_XMM_LEN	128			/* XMM size (128-bit) */
+#define MEM_YMM_LEN	256			/* YMM size (256-bit) */
 #define BIT2BYTE(len)	((len) >> 3)		/* scale change; macro */
 
 /* extract the EFLAGS.DF bit by applying the corresponding mask */
@@ -55,4 +62,196 @@ enum {
 };
 
 
+/*
+ * analysis routines (libicedft_core.c)
+ *
+ * ins_inspect hands these to the executer; they are
+ * declared here so that other lowering stages can
+ * recognize and re-issue them
+ */
+void	_cwde(thread_ctx_t *thread_ctx);
+void	_movsx_r2r_opwb_u(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	_movsx_r2r_opwb_l(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	_movsx_r2r_oplb_u(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	_movsx_r2r_oplb_l(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	_movsx_r2r_oplw(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	_movsx_m2r_opwb(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src);
+void	_movsx_m2r_oplb(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src);
+void	_movsx_m2r_oplw(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src);
+void	_movzx_r2r_opwb_u(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	_movzx_r2r_opwb_l(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	_movzx_r2r_oplb_u(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	_movzx_r2r_oplb_l(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	_movzx_r2r_oplw(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	_movzx_m2r_opwb(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src);
+void	_movzx_m2r_oplb(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src);
+void	_movzx_m2r_oplw(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src);
+ADDRINT	_cmpxchg_r2r_opl_fast(thread_ctx_t *thread_ctx, uint32_t dst_val, uint32_t src, uint32_t src_val);
+void	_cmpxchg_r2r_opl_slow(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+ADDRINT	_cmpxchg_r2r_opw_fast(thread_ctx_t *thread_ctx, uint16_t dst_val, uint32_t src, uint16_t src_val);
+void	_cmpxchg_r2r_opw_slow(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+ADDRINT	_cmpxchg_m2r_opl_fast(thread_ctx_t *thread_ctx, uint32_t dst_val, ADDRINT src);
+void	_cmpxchg_r2m_opl_slow(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src);
+ADDRINT	_cmpxchg_m2r_opw_fast(thread_ctx_t *thread_ctx, uint16_t dst_val, ADDRINT src);
+void	_cmpxchg_r2m_opw_slow(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src);
+void	_cmpxchg_r2r_opl_bf(thread_ctx_t *thread_ctx, uint32_t eax_val, uint32_t dst, uint32_t dst_val, uint32_t src);
+void	_cmpxchg_r2r_opw_bf(thread_ctx_t *thread_ctx, uint16_t ax_val, uint32_t dst, uint16_t dst_val, uint32_t src);
+void	_cmpxchg_m2r_opl_bf(thread_ctx_t *thread_ctx, uint32_t eax_val, ADDRINT dst, uint32_t src);
+void	_cmpxchg_m2r_opw_bf(thread_ctx_t *thread_ctx, uint16_t ax_val, ADDRINT dst, uint32_t src);
+void	_cmpxchg8b_m2r_bf(thread_ctx_t *thread_ctx, uint32_t eax_val, uint32_t edx_val, ADDRINT dst);
+void	_xchg_r2r_opb_ul(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	_xchg_r2r_opb_lu(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	_xchg_r2r_opb_u(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	_xchg_r2r_opb_l(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	_xchg_r2r_opw(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	_xchg_m2r_opb_u(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src);
+void	_xchg_m2r_opb_l(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src);
+void	_xchg_m2r_opw(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src);
+void	_xchg_m2r_opl(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src);
+void	_xadd_r2r_opb_ul(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	_xadd_r2r_opb_lu(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	_xadd_r2r_opb_u(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	_xadd_r2r_opb_l(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	_xadd_r2r_opw(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	_xadd_m2r_opb_u(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src);
+void	_xadd_m2r_opb_l(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src);
+void	_xadd_m2r_opw(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src);
+void	_xadd_m2r_opl(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src);
+void	_lea_r2r_opw(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t base, uint32_t index);
+void	_lea_r2r_opl(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t base, uint32_t index);
+void	r2r_ternary_opb_u(thread_ctx_t *thread_ctx, uint32_t src);
+void	r2r_ternary_opb_l(thread_ctx_t *thread_ctx, uint32_t src);
+void	r2r_ternary_opw(thread_ctx_t *thread_ctx, uint32_t src);
+void	r2r_ternary_opl(thread_ctx_t *thread_ctx, uint32_t src);
+void	m2r_ternary_opb(thread_ctx_t *thread_ctx, ADDRINT src);
+void	m2r_ternary_opw(thread_ctx_t *thread_ctx, ADDRINT src);
+void	m2r_ternary_opl(thread_ctx_t *thread_ctx, ADDRINT src);
+void	r2r_binary_opb_ul(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	r2r_binary_opb_lu(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	r2r_binary_opb_u(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	r2r_binary_opb_l(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	r2r_binary_opw(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	r2r_binary_opl(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	m2r_binary_opb_u(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src);
+void	m2r_binary_opb_l(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src);
+void	m2r_binary_opw(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src);
+void	m2r_binary_opl(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src);
+void	r2m_binary_opb_u(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src);
+void	r2m_binary_opb_l(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src);
+void	r2m_binary_opw(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src);
+void	r2m_binary_opl(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src);
+void	r_clrl4(thread_ctx_t *thread_ctx);
+void	r_clrl3(thread_ctx_t *thread_ctx);
+void	r_clrl2(thread_ctx_t *thread_ctx);
+void	r_clrl(thread_ctx_t *thread_ctx, uint32_t reg);
+void	r_clrw(thread_ctx_t *thread_ctx, uint32_t reg);
+void	r_clrb_u(thread_ctx_t *thread_ctx, uint32_t reg);
+void	r_clrb_l(thread_ctx_t *thread_ctx, uint32_t reg);
+void	r2r_xfer_opb_ul(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	r2r_xfer_opb_lu(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	r2r_xfer_opb_u(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	r2r_xfer_opb_l(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	r2r_xfer_opw(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	r2r_xfer_opl(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	m2r_xfer_opb_u(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src);
+void	m2r_xfer_opb_l(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src);
+void	m2r_xfer_opw(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src);
+void	m2r_xfer_opl(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src);
+void	r2m_xfer_opbn(thread_ctx_t *thread_ctx, ADDRINT dst, ADDRINT count, ADDRINT eflags);
+void	r2m_xfer_opb_u(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src);
+void	r2m_xfer_opb_l(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src);
+void	r2m_xfer_opwn(thread_ctx_t *thread_ctx, ADDRINT dst, ADDRINT count, ADDRINT eflags);
+void	r2m_xfer_opw(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src);
+void	r2m_xfer_opln(thread_ctx_t *thread_ctx, ADDRINT dst, ADDRINT count, ADDRINT eflags);
+void	r2m_xfer_opbn_bf(thread_ctx_t *thread_ctx, ADDRINT dst, ADDRINT count, ADDRINT eflags);
+void	r2m_xfer_opwn_bf(thread_ctx_t *thread_ctx, ADDRINT dst, ADDRINT count, ADDRINT eflags);
+void	r2m_xfer_opln_bf(thread_ctx_t *thread_ctx, ADDRINT dst, ADDRINT count, ADDRINT eflags);
+void	r2m_xfer_opl(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src);
+void	m2m_xfer_opw(ADDRINT dst, ADDRINT src);
+void	m2m_xfer_opb(ADDRINT dst, ADDRINT src);
+void	m2m_xfer_opl(ADDRINT dst, ADDRINT src);
+void	m2m_xfer_opbn(ADDRINT dst, ADDRINT src, ADDRINT count, ADDRINT eflags);
+void	m2m_xfer_opwn(ADDRINT dst, ADDRINT src, ADDRINT count, ADDRINT eflags);
+void	m2m_xfer_opln(ADDRINT dst, ADDRINT src, ADDRINT count, ADDRINT eflags);
+ADDRINT	rep_predicate(BOOL first_iteration);
+void	m2r_restore_opw(thread_ctx_t *thread_ctx, ADDRINT src);
+void	m2r_restore_opl(thread_ctx_t *thread_ctx, ADDRINT src);
+void	r2m_save_opw(thread_ctx_t *thread_ctx, ADDRINT dst);
+void	r2m_save_opl(thread_ctx_t *thread_ctx, ADDRINT dst);
+void	_push_run(thread_ctx_t *thread_ctx, ADDRINT ea, uint32_t regs, uint32_t n);
+void	_pop_run(thread_ctx_t *thread_ctx, ADDRINT ea, uint32_t regs, uint32_t n);
+void	_prologue(thread_ctx_t *thread_ctx, ADDRINT ea, uint32_t regs, uint32_t n);
+void	_leave(thread_ctx_t *thread_ctx, ADDRINT ea);
+void	argpack_r2r(thread_ctx_t *thread_ctx, const idft_argpack_t *pack);
+void	argpack_m2r(thread_ctx_t *thread_ctx, const idft_argpack_t *pack, ADDRINT src);
+void	argpack_r2m(thread_ctx_t *thread_ctx, const idft_argpack_t *pack, ADDRINT dst);
+void	_mem_group(thread_ctx_t *thread_ctx, const idft_memgroup_t *group, ADDRINT ea);
+void	_cmov_r2r_opl(thread_ctx_t *thread_ctx, uint32_t cc, ADDRINT eflags, uint32_t dst, uint32_t src);
+void	_cmov_r2r_opw(thread_ctx_t *thread_ctx, uint32_t cc, ADDRINT eflags, uint32_t dst, uint32_t src);
+void	_cmov_m2r_opl(thread_ctx_t *thread_ctx, uint32_t cc, ADDRINT eflags, uint32_t dst, ADDRINT src);
+void	_cmov_m2r_opw(thread_ctx_t *thread_ctx, uint32_t cc, ADDRINT eflags, uint32_t dst, ADDRINT src);
+void	shadow_prefetch1(ADDRINT a, uint32_t da);
+void	shadow_prefetch2(ADDRINT a, uint32_t da, ADDRINT b, uint32_t db);
+void	shadow_prefetch3(ADDRINT a, uint32_t da, ADDRINT b, uint32_t db, ADDRINT c, uint32_t dc);
+void	xmm_r2r_xfer_opx(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	xmm_r2r_xfer_opq(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	xmm_m2r_xfer_opx(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src);
+void	xmm_m2r_xfer_opq(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src);
+void	xmm_m2r_xfer_opl(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src);
+void	xmm_r2m_xfer_opx(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src);
+void	xmm_r2m_xfer_opq(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src);
+void	xmm_r2m_xfer_opl(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src);
+void	xmm_r2x_xfer_opl(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	xmm_x2r_xfer_opl(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	xmm_x2r_mask_opx(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	ymm_x2r_mask_opy(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	xmm_r2r_binary_opx(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	xmm_m2r_binary_opx(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src);
+void	xmm_clr_opx(thread_ctx_t *thread_ctx, uint32_t reg);
+void	ymm_clr_opy(thread_ctx_t *thread_ctx, uint32_t reg);
+void	ymm_clr_upper(thread_ctx_t *thread_ctx);
+void	ymm_clr_all(thread_ctx_t *thread_ctx);
+void	ymm_r2r_xfer_opx(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	ymm_r2r_xfer_opy(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	ymm_m2r_xfer_opx(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src);
+void	ymm_m2r_xfer_opy(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src);
+void	ymm_r2m_xfer_opy(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src);
+void	ymm_rr2r_binary_opx(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src1, uint32_t src2);
+void	ymm_rr2r_binary_opy(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src1, uint32_t src2);
+void	ymm_rm2r_binary_opx(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src1, ADDRINT src2);
+void	ymm_rm2r_binary_opy(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src1, ADDRINT src2);
+void	_enter_opl(thread_ctx_t *thread_ctx, ADDRINT esp, ADDRINT ebp, uint32_t size, uint32_t level);
+void	_movsx_r2r_opql(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	_movsx_r2r_opqw(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	_movsx_r2r_opqb_u(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	_movsx_r2r_opqb_l(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	_movsx_m2r_opql(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src);
+void	_movsx_m2r_opqw(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src);
+void	_movsx_m2r_opqb(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src);
+void	_cqo(thread_ctx_t *thread_ctx);
+void	_cmpxchg_r2r_opq_bf(thread_ctx_t *thread_ctx, ADDRINT rax_val, uint32_t dst, ADDRINT dst_val, uint32_t src);
+void	_cmpxchg_m2r_opq_bf(thread_ctx_t *thread_ctx, ADDRINT rax_val, ADDRINT dst, uint32_t src);
+void	_xchg_m2r_opq(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src);
+void	_xadd_r2r_opq(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	_xadd_m2r_opq(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src);
+void	_lea_r2r_opq(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t base, uint32_t index);
+void	m2r_ternary_opq(thread_ctx_t *thread_ctx, ADDRINT src);
+void	r2r_binary_opq(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	m2r_binary_opq(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src);
+void	r2m_binary_opq(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src);
+void	r2r_xfer_opq(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src);
+void	m2r_xfer_opq(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src);
+void	r2m_xfer_opq(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src);
+void	r2m_xfer_opqn(thread_ctx_t *thread_ctx, ADDRINT dst, ADDRINT count, ADDRINT eflags);
+void	m2m_xfer_opq(ADDRINT dst, ADDRINT src);
+void	m2m_xfer_opqn(ADDRINT dst, ADDRINT src, ADDRINT count, ADDRINT eflags);
+void	_cmov_r2r_opq(thread_ctx_t *thread_ctx, uint32_t cc, ADDRINT eflags, uint32_t dst, uint32_t src);
+void	_cmov_m2r_opq(thread_ctx_t *thread_ctx, uint32_t cc, ADDRINT eflags, uint32_t dst, ADDRINT src);
+void	_cmpxchg16b_m2r_bf(thread_ctx_t *thread_ctx, ADDRINT rax_val, ADDRINT rdx_val, ADDRINT dst);
+void	_enter_opq(thread_ctx_t *thread_ctx, ADDRINT rsp, ADDRINT rbp, uint32_t size, uint32_t level);
+uint32_t	cmov_cc(uint32_t opcode);
+uint32_t	thread_ctx_live(thread_ctx_t *thread_ctx);
+ADDRINT	taint_guard(thread_ctx_t *thread_ctx);
+void	taint_guard_trip(void);
+
 #endif /* LIBDFT_CORE_H */
@@ -0,0 +1,605 @@
+/*
+ * instrumentation filters
+ *
+ * code the user does not care about (the loader, libc, crypto
+ * libraries, ...) can be left uninstrumented. Rules come in
+ * three flavours, from lowest to highest priority: module name
+ * patterns (matched against the modules the executer reports
+ * as loaded), address ranges, and per-function overrides. A
+ * later rule of the same flavour wins over an earlier one.
+ *
+ * the rules are compiled (lazily, on the first lookup after a
+ * change) into one sorted table of disjoint ranges, so that
+ * deciding whether an instruction is instrumented is a binary
+ * search. If there is at least one include rule (range or
+ * module) everything not covered is excluded; otherwise
+ * everything not covered is included.
+ *
+ * excluded code gets no analysis calls at all, hence whatever
+ * it does to the tags goes unnoticed. IDFT_FILTER_EXCLUDE_CLEAR
+ * ranges and functions also get a bulk clear of the caller-saved
+ * registers (EAX, ECX, EDX) at their first address, so that the
+ * return value of, e.g., a skipped library call is not left
+ * carrying stale tags; callee-saved registers are restored by the
+ * callee and keep theirs. Memory written by excluded code keeps
+ * its old tags.
+ *
+ * NOTE: rules are consulted at instrumentation time; code that
+ * the executer has already instrumented must be flushed for a
+ * change to take effect
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "libicedft_api.h"
+#include "libicedft_core.h"
+#include "libicedft_filter.h"
+#include "branch_pred.h"
+
+
+#define EXE context->executer_api
+
+
+/*
+ * get (allocate on first use) the filters of a context
+ */
+static filter_t *
+filter_get(idft_context_t *context)
+{
+	filter_t *f = (filter_t *)context->filter;
+
+	if (likely(f != NULL))
+		return f;
+
+	if ((f = calloc(1, sizeof(filter_t))) == NULL)
+		return NULL;
+
+	context->filter = f;
+
+	return f;
+}
+
+/*
+ * grow an array by one element
+ *
+ * @arr:	the array (in/out)
+ * @n:		its current length
+ * @sz:		element size
+ *
+ * returns: the new (last) element, or NULL on error
+ */
+static void *
+filter_push(void **arr, uint32_t n, size_t sz)
+{
+	void *p;
+
+	if ((p = realloc(*arr, (n + 1) * sz)) == NULL)
+		return NULL;
+
+	*arr = p;
+
+	return (uint8_t *)p + n * sz;
+}
+
+/*
+ * match a name against a glob ('*' and '?'); patterns
+ * without a path separator are matched against the base
+ * name only
+ *
+ * returns: 1 on match, 0 otherwise
+ */
+static int
+filter_glob_match(const char *glob, const char *name)
+{
+	const char *star = NULL, *back = NULL, *p;
+
+	if (strchr(glob, '/') == NULL && strchr(glob, '\\') == NULL)
+		for (p = name; *p != '\0'; p++)
+			if (*p == '/' || *p == '\\')
+				name = p + 1;
+
+	while (*name != '\0') {
+		if (*glob == '*') {
+			star = glob++;
+			back = name;
+		}
+		else if (*glob == '?' || *glob == *name) {
+			glob++;
+			name++;
+		}
+		else if (star != NULL) {
+			glob = star + 1;
+			name = ++back;
+		}
+		else
+			return 0;
+	}
+
+	while (*glob == '*')
+		glob++;
+
+	return *glob == '\0';
+}
+
+/*
+ * set the action of [lo, hi] in the compiled table,
+ * overriding whatever was there
+ *
+ * returns: 0 on success, 1 on error
+ */
+static int
+filter_paint(filter_t *f, ADDRINT lo, ADDRINT hi, uint32_t action)
+{
+	filter_range_t *t, *e, right;
+	uint32_t i, n = 0, has_right = 0;
+
+	/* at most one range is split in two */
+	if ((t = malloc((f->ntbl + 2) * sizeof(filter_range_t))) == NULL)
+		return 1;
+
+	for (i = 0; i < f->ntbl; i++) {
+		e = &f->tbl[i];
+
+		/* before */
+		if (e->hi < lo) {
+			t[n++] = *e;
+			continue;
+		}
+
+		/* after */
+		if (e->lo > hi)
+			break;
+
+		/* overlapping; keep what sticks out */
+		if (e->lo < lo) {
+			t[n] = *e;
+			t[n++].hi = lo - 1;
+		}
+		if (e->hi > hi) {
+			right		= *e;
+			right.lo	= hi + 1;
+			has_right	= 1;
+		}
+	}
+
+	t[n].lo		= lo;
+	t[n].hi		= hi;
+	t[n++].action	= action;
+
+	if (has_right)
+		t[n++] = right;
+
+	for (; i < f->ntbl; i++)
+		t[n++] = f->tbl[i];
+
+	free(f->tbl);
+	f->tbl	= t;
+	f->ntbl	= n;
+
+	return 0;
+}
+
+static int
+filter_addr_cmp(const void *a, const void *b)
+{
+	ADDRINT x = *(const ADDRINT *)a, y = *(const ADDRINT *)b;
+
+	return (x > y) - (x < y);
+}
+
+/*
+ * add the first address of a range to the clear points
+ *
+ * returns: 0 on success, 1 on error
+ */
+static int
+filter_entry_add(filter_t *f, const filter_range_t *r)
+{
+	ADDRINT *e;
+
+	if (r->action != IDFT_FILTER_EXCLUDE_CLEAR)
+		return 0;
+
+	if ((e = filter_push((void **)&f->entries, f->nentries,
+					sizeof(ADDRINT))) == NULL)
+		return 1;
+
+	*e = r->lo;
+	f->nentries++;
+
+	return 0;
+}
+
+/*
+ * compile the rules into the lookup table
+ *
+ * returns: 0 on success, 1 on error
+ */
+static int
+filter_compile(filter_t *f)
+{
+	uint32_t i, j, action;
+	int found;
+
+	free(f->tbl);
+	free(f->entries);
+	f->tbl		= NULL;
+	f->entries	= NULL;
+	f->ntbl		= 0;
+	f->nentries	= 0;
+
+	/* any include rule makes the rest excluded */
+	f->def = IDFT_FILTER_INCLUDE;
+	for (i = 0; i < f->nranges; i++)
+		if (f->ranges[i].action == IDFT_FILTER_INCLUDE)
+			f->def = IDFT_FILTER_EXCLUDE;
+	for (i = 0; i < f->nglobs; i++)
+		if (f->globs[i].action == IDFT_FILTER_INCLUDE)
+			f->def = IDFT_FILTER_EXCLUDE;
+
+	/* modules; the last matching pattern wins */
+	for (i = 0; i < f->nmods; i++) {
+		for (found = 0, action = 0, j = 0; j < f->nglobs; j++)
+			if (filter_glob_match(f->globs[j].glob,
+						f->mods[i].name)) {
+				action	= f->globs[j].action;
+				found	= 1;
+			}
+
+		if (found && unlikely(filter_paint(f, f->mods[i].lo,
+						f->mods[i].hi, action)))
+			goto err;
+	}
+
+	/* address ranges, then function overrides */
+	for (i = 0; i < f->nranges; i++)
+		if (unlikely(filter_paint(f, f->ranges[i].lo,
+					f->ranges[i].hi, f->ranges[i].action) ||
+				filter_entry_add(f, &f->ranges[i])))
+			goto err;
+
+	for (i = 0; i < f->nfuncs; i++)
+		if (unlikely(filter_paint(f, f->funcs[i].lo,
+					f->funcs[i].hi, f->funcs[i].action) ||
+				filter_entry_add(f, &f->funcs[i])))
+			goto err;
+
+	if (f->nentries > 1)
+		qsort(f->entries, f->nentries, sizeof(ADDRINT),
+				filter_addr_cmp);
+
+	f->dirty = 0;
+
+	/* success */
+	return 0;
+
+err:
+	free(f->tbl);
+	free(f->entries);
+	f->tbl		= NULL;
+	f->entries	= NULL;
+	f->ntbl		= 0;
+	f->nentries	= 0;
+
+	/* failed */
+	return 1;
+}
+
+/*
+ * what to do with an address
+ *
+ * @f:		the filters
+ * @addr:	the address
+ *
+ * returns: IDFT_FILTER_*; IDFT_FILTER_INCLUDE if the
+ * rules could not be compiled
+ */
+uint32_t
+filter_lookup(filter_t *f, ADDRINT addr)
+{
+	uint32_t lo = 0, hi, mid;
+
+	if (unlikely(f->dirty) && unlikely(filter_compile(f)))
+		return IDFT_FILTER_INCLUDE;
+
+	hi = f->ntbl;
+	while (lo < hi) {
+		mid = (lo + hi) >> 1;
+
+		if (addr < f->tbl[mid].lo)
+			hi = mid;
+		else if (addr > f->tbl[mid].hi)
+			lo = mid + 1;
+		else
+			return f->tbl[mid].action;
+	}
+
+	return f->def;
+}
+
+/*
+ * is an address the first of an IDFT_FILTER_EXCLUDE_CLEAR
+ * range (see filter_lookup; the table is compiled)
+ */
+static int
+filter_is_entry(filter_t *f, ADDRINT addr)
+{
+	return bsearch(&addr, f->entries, f->nentries, sizeof(ADDRINT),
+			filter_addr_cmp) != NULL;
+}
+
+/*
+ * filter an instruction (called first thing by ins_inspect)
+ *
+ * @ins:	the instruction
+ * @context:	the engine context
+ *
+ * returns: 1 if it must not be instrumented, 0 otherwise
+ */
+int
+filter_skip(idft_ins_t *ins, idft_context_t *context)
+{
+	filter_t *f = (filter_t *)context->filter;
+	ADDRINT addr;
+	uint32_t action;
+
+	/* the executer cannot tell */
+	if (unlikely(EXE->INS_Address == NULL))
+		return 0;
+
+	addr	= (ADDRINT)EXE->INS_Address(ins, context);
+	action	= filter_lookup(f, addr);
+
+	if (likely(action == IDFT_FILTER_INCLUDE))
+		return 0;
+
+	/* entry of an excluded function; drop what it will clobber */
+	if (action == IDFT_FILTER_EXCLUDE_CLEAR && filter_is_entry(f, addr))
+		EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+			r_clrl3,
+			1,
+			IARG_THREAD_CONTEXT
+			);
+
+	return 1;
+}
+
+/*
+ * add a rule to an address range array
+ *
+ * returns: 0 on success, 1 on error
+ */
+static int
+filter_range_add(idft_context_t *context, int func, ADDRINT lo,
+		ADDRINT hi, uint32_t action)
+{
+	filter_t *f;
+	filter_range_t *r;
+
+	if (unlikely(lo > hi || action > IDFT_FILTER_EXCLUDE_CLEAR ||
+				(f = filter_get(context)) == NULL))
+		return 1;
+
+	if (func)
+		r = filter_push((void **)&f->funcs, f->nfuncs,
+				sizeof(filter_range_t));
+	else
+		r = filter_push((void **)&f->ranges, f->nranges,
+				sizeof(filter_range_t));
+
+	if (unlikely(r == NULL))
+		return 1;
+
+	r->lo		= lo;
+	r->hi		= hi;
+	r->action	= action;
+
+	if (func)
+		f->nfuncs++;
+	else
+		f->nranges++;
+
+	f->dirty = 1;
+
+	return 0;
+}
+
+/*
+ * include or exclude an address range
+ *
+ * @context:	the engine context
+ * @lo:		first address
+ * @hi:		last address
+ * @action:	IDFT_FILTER_*
+ *
+ * returns: 0 on success, 1 on error
+ */
+int
+libdft_filter_range(idft_context_t *context, ADDRINT lo, ADDRINT hi,
+		uint32_t action)
+{
+	return filter_range_add(context, 0, lo, hi, action);
+}
+
+/*
+ * override the filters for a function
+ *
+ * @context:	the engine context
+ * @lo:		first address (the entry point)
+ * @hi:		last address
+ * @action:	IDFT_FILTER_*
+ *
+ * returns: 0 on success, 1 on error
+ */
+int
+libdft_filter_function(idft_context_t *context, ADDRINT lo, ADDRINT hi,
+		uint32_t action)
+{
+	return filter_range_add(context, 1, lo, hi, action);
+}
+
+/*
+ * include or exclude the modules whose name matches a glob
+ *
+ * @context:	the engine context
+ * @glob:	the pattern ('*' and '?')
+ * @action:	IDFT_FILTER_INCLUDE or IDFT_FILTER_EXCLUDE
+ *
+ * returns: 0 on success, 1 on error
+ */
+int
+libdft_filter_module(idft_context_t *context, const char *glob,
+		uint32_t action)
+{
+	filter_t *f;
+	filter_glob_t *g;
+	char *s;
+
+	if (unlikely(glob == NULL || action > IDFT_FILTER_EXCLUDE_CLEAR ||
+				(f = filter_get(context)) == NULL))
+		return 1;
+
+	if ((s = malloc(strlen(glob) + 1)) == NULL)
+		return 1;
+	strcpy(s, glob);
+
+	if ((g = filter_push((void **)&f->globs, f->nglobs,
+					sizeof(filter_glob_t))) == NULL) {
+		free(s);
+		return 1;
+	}
+
+	/* there is no entry point to clear at */
+	g->glob		= s;
+	g->action	= (action == IDFT_FILTER_EXCLUDE_CLEAR) ?
+				IDFT_FILTER_EXCLUDE : action;
+	f->nglobs++;
+	f->dirty	= 1;
+
+	return 0;
+}
+
+/*
+ * tell the filters about a loaded module
+ *
+ * @context:	the engine context
+ * @name:	the module name (or path)
+ * @lo:		lowest address
+ * @hi:		highest address
+ *
+ * returns: 0 on success, 1 on error
+ */
+int
+libdft_filter_module_load(idft_context_t *context, const char *name,
+		ADDRINT lo, ADDRINT hi)
+{
+	filter_t *f;
+	filter_mod_t *m;
+	char *s;
+
+	if (unlikely(name == NULL || lo > hi ||
+				(f = filter_get(context)) == NULL))
+		return 1;
+
+	if ((s = malloc(strlen(name) + 1)) == NULL)
+		return 1;
+	strcpy(s, name);
+
+	if ((m = filter_push((void **)&f->mods, f->nmods,
+					sizeof(filter_mod_t))) == NULL) {
+		free(s);
+		return 1;
+	}
+
+	m->name		= s;
+	m->lo		= lo;
+	m->hi		= hi;
+	f->nmods++;
+	f->dirty	= 1;
+
+	return 0;
+}
+
+/*
+ * tell the filters that a module is gone
+ *
+ * @context:	the engine context
+ * @lo:		its lowest address
+ */
+void
+libdft_filter_module_unload(idft_context_t *context, ADDRINT lo)
+{
+	filter_t *f = (filter_t *)context->filter;
+	uint32_t i;
+
+	if (f == NULL)
+		return;
+
+	for (i = 0; i < f->nmods; i++)
+		if (f->mods[i].lo == lo) {
+			free(f->mods[i].name);
+			f->mods[i]	= f->mods[--f->nmods];
+			f->dirty	= 1;
+			return;
+		}
+}
+
+/*
+ * what the filters say about an address; executers may use it
+ * to skip whole blocks or traces
+ *
+ * @context:	the engine context
+ * @addr:	the address
+ *
+ * returns: IDFT_FILTER_*
+ */
+uint32_t
+libdft_filter_check(idft_context_t *context, ADDRINT addr)
+{
+	if (context->filter == NULL)
+		return IDFT_FILTER_INCLUDE;
+
+	return filter_lookup((filter_t *)context->filter, addr);
+}
+
+/*
+ * drop every rule and module
+ *
+ * @context:	the engine context
+ */
+void
+libdft_filter_reset(idft_context_t *context)
+{
+	filter_free(context);
+}
+
+/*
+ * release the filters of a context
+ *
+ * @context:	the engine context
+ */
+void
+filter_free(idft_context_t *context)
+{
+	filter_t *f = (filter_t *)context->filter;
+	uint32_t i;
+
+	if (f == NULL)
+		return;
+
+	for (i = 0; i < f->nglobs; i++)
+		free(f->globs[i].glob);
+	for (i = 0; i < f->nmods; i++)
+		free(f->mods[i].name);
+
+	free(f->ranges);
+	free(f->funcs);
+	free(f->globs);
+	free(f->mods);
+	free(f->tbl);
+	free(f->entries);
+	free(f);
+
+	context->filter = NULL;
+}
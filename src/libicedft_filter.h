@@ -0,0 +1,51 @@
+#ifndef LIBICEDFT_FILTER_H
+#define LIBICEDFT_FILTER_H
+
+#include <stdint.h>
+#include "libicedft_api.h"
+
+/* an address range and what to do with it */
+typedef struct {
+	ADDRINT		lo;			/* first byte */
+	ADDRINT		hi;			/* last byte */
+	uint32_t	action;			/* IDFT_FILTER_* */
+} filter_range_t;
+
+/* a module name pattern */
+typedef struct {
+	char		*glob;
+	uint32_t	action;
+} filter_glob_t;
+
+/* a loaded module */
+typedef struct {
+	char		*name;
+	ADDRINT		lo;
+	ADDRINT		hi;
+} filter_mod_t;
+
+/* the filters of a context */
+typedef struct {
+	filter_range_t	*ranges;		/* address ranges */
+	uint32_t	nranges;
+	filter_range_t	*funcs;			/* function overrides */
+	uint32_t	nfuncs;
+	filter_glob_t	*globs;			/* module patterns */
+	uint32_t	nglobs;
+	filter_mod_t	*mods;			/* loaded modules */
+	uint32_t	nmods;
+
+	/* compiled; sorted and disjoint */
+	filter_range_t	*tbl;
+	uint32_t	ntbl;
+	ADDRINT		*entries;		/* IDFT_FILTER_EXCLUDE_CLEAR starts */
+	uint32_t	nentries;
+	uint32_t	def;			/* action outside tbl */
+	uint32_t	dirty;			/* rules changed since compiled */
+} filter_t;
+
+uint32_t	filter_lookup(filter_t *f, ADDRINT addr);
+int		filter_skip(idft_ins_t *ins, idft_context_t *context);
+void		filter_free(idft_context_t *context);
+
+#endif /* LIBICEDFT_FILTER_H */
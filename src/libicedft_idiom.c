@@ -0,0 +1,299 @@
+/*
+ * stack idiom fusion
+ *
+ * function prologues and epilogues, and the argument pushes
+ * before calls, are runs of stack instructions that each cost
+ * one analysis call (r2m_xfer_opl/m2r_xfer_opl). Once a block
+ * has been optimized (see libicedft_ir.c), the survivors of
+ *
+ *	push ebp; mov ebp, esp [; push r32 ...]	-> _prologue
+ *	push r32; push r32 ...				-> _push_run
+ *	pop r32; pop r32 ...				-> _pop_run
+ *	leave						-> _leave
+ *	mov esp, ebp; pop ebp				-> _leave
+ *
+ * are replaced by one call to a routine that moves the tags of
+ * all the stack slots involved at once.
+ *
+ * the instructions of an idiom must be adjacent, so that the
+ * stack slots of a run are too (nothing else moves ESP in
+ * between); the fused routine runs before the instruction that
+ * supplies its effective address (the first one of a run, the
+ * POP of a mov/pop pair), which is equivalent, since nothing in
+ * between reads the tags it writes. The idioms are those of
+ * 32-bit stacks; 64-bit code (IDFT_X86_64) pushes and pops
+ * 8-byte slots, and is left as it is
+ */
+
+#include <string.h>
+
+#include "libicedft_api.h"
+#include "libicedft_core.h"
+#include "libicedft_idiom.h"
+#include "branch_pred.h"
+
+
+#define EXE context->executer_api
+
+/* is a location a whole 32-bit register (any, if reg is IR_NOREG) */
+#define LOC_R32(loc, r)							\
+	((loc)->kind == LOC_REG && (loc)->mask == VCPU_MASK32 &&	\
+	 ((r) == IR_NOREG || (loc)->reg == (r)))
+
+/* is a location a stack slot */
+#define LOC_SLOT(loc, iarg)						\
+	((loc)->kind == LOC_MEM && (loc)->len == 4 && (loc)->ea == (iarg))
+
+
+/* the instruction of a micro-op */
+static idft_ins_t *
+idiom_ins(rec_buf_t *buf, ir_uop_t *uop)
+{
+	return buf->calls[uop->rec].ins;
+}
+
+static uint32_t
+idiom_opcode(idft_context_t *context, rec_buf_t *buf, ir_uop_t *uop)
+{
+	return EXE->INS_Opcode(idiom_ins(buf, uop), context);
+}
+
+/* push r32 */
+static int
+idiom_push(idft_context_t *context, rec_buf_t *buf, ir_uop_t *uop)
+{
+	return uop->op == UOP_COPY && !uop->pred &&
+		LOC_SLOT(&uop->dst, IARG_MEMORYWRITE_EA) &&
+		LOC_R32(&uop->src, IR_NOREG) &&
+		idiom_opcode(context, buf, uop) == XED_ICLASS_PUSH;
+}
+
+/* pop r32 (but ESP) */
+static int
+idiom_pop(idft_context_t *context, rec_buf_t *buf, ir_uop_t *uop)
+{
+	return uop->op == UOP_COPY && !uop->pred &&
+		LOC_R32(&uop->dst, IR_NOREG) && uop->dst.reg != GPR_ESP &&
+		LOC_SLOT(&uop->src, IARG_MEMORYREAD_EA) &&
+		idiom_opcode(context, buf, uop) == XED_ICLASS_POP;
+}
+
+/* mov dst, src (32-bit registers) */
+static int
+idiom_mov(idft_context_t *context, rec_buf_t *buf, ir_uop_t *uop,
+		uint8_t dst, uint8_t src, uint32_t opcode)
+{
+	return uop->op == UOP_COPY && !uop->pred &&
+		LOC_R32(&uop->dst, dst) && LOC_R32(&uop->src, src) &&
+		idiom_opcode(context, buf, uop) == opcode;
+}
+
+/* the first live micro-op at, or after, i */
+static uint32_t
+idiom_next(ir_block_t *blk, uint32_t i)
+{
+	while (i < blk->nuops && blk->uops[i].op == UOP_NOP)
+		i++;
+
+	return i;
+}
+
+/*
+ * replace an idiom by one call
+ *
+ * @buf:	the record buffer
+ * @at:		the micro-op that takes the call; it
+ *		becomes opaque, and the rest of the idiom
+ *		must be turned into UOP_NOP by the caller
+ * @func:	the fused routine
+ * @ea:		the stack slot operand (its IARG_* kind)
+ * @regs:	packed registers (if has_regs)
+ * @n:		register count (if has_regs)
+ * @has_regs:	does the routine take them
+ *
+ * returns: 0 on success, 1 if the record buffer is full
+ */
+static int
+idiom_emit(rec_buf_t *buf, ir_uop_t *at, void *func, ir_loc_t *ea,
+		uint32_t regs, uint32_t n, int has_regs)
+{
+	rec_call_t *call;
+
+	if (unlikely(buf->ncalls >= REC_CALL_MAX))
+		return 1;
+
+	call = &buf->calls[buf->ncalls];
+	memset(call, 0, sizeof(*call));
+
+	call->ins	= buf->calls[at->rec].ins;
+	call->how	= REC_CALL;
+	call->ipoint	= IDFT_IPOINT_BEFORE;
+	call->func	= func;
+
+	call->argv[call->argc++] = IARG_THREAD_CONTEXT;
+	call->argv[call->argc++] = ea->ea;
+	if (REC_IARG_HASVAL(ea->ea))
+		call->argv[call->argc++] = ea->eaval;
+
+	if (has_regs) {
+		call->argv[call->argc++] = IARG_UINT32;
+		call->argv[call->argc++] = regs;
+		call->argv[call->argc++] = IARG_UINT32;
+		call->argv[call->argc++] = n;
+	}
+
+	/* replayed as is by ir_emit */
+	memset(at, 0, sizeof(*at));
+	at->op	= UOP_OPAQUE;
+	at->rec	= buf->ncalls++;
+
+	return 0;
+}
+
+/*
+ * collect a run of pushes (or pops) of adjacent instructions
+ *
+ * @blk:	the block
+ * @i:		the first micro-op of the run (live)
+ * @prev:	the instruction before the run, or NULL
+ * @max:	maximum length
+ * @push:	1 for pushes, 0 for pops
+ * @regs:	packed registers (out)
+ * @last:	the last micro-op of the run (out)
+ *
+ * returns: the run length
+ */
+static uint32_t
+idiom_run(idft_context_t *context, rec_buf_t *buf, ir_block_t *blk,
+		uint32_t i, idft_ins_t *prev, uint32_t max, int push,
+		uint32_t *regs, uint32_t *last)
+{
+	ir_uop_t *uop;
+	uint32_t n = 0;
+
+	*regs = 0;
+
+	for (; i < blk->nuops && n < max; i = idiom_next(blk, i + 1), n++) {
+		uop = &blk->uops[i];
+
+		if (prev != NULL && idiom_ins(buf, uop) != prev + 1)
+			break;
+
+		if (push ? !idiom_push(context, buf, uop) :
+				!idiom_pop(context, buf, uop))
+			break;
+
+		*regs |= (uint32_t)(push ? uop->src.reg : uop->dst.reg) <<
+			(n << 2);
+		prev	= idiom_ins(buf, uop);
+		*last	= i;
+	}
+
+	return n;
+}
+
+/* drop the micro-ops in (first, last] */
+static void
+idiom_drop(ir_block_t *blk, uint32_t first, uint32_t last)
+{
+	for (first++; first <= last; first++)
+		blk->uops[first].op = UOP_NOP;
+}
+
+/*
+ * fuse the stack idioms of an optimized block
+ *
+ * @context:	the engine context
+ * @buf:	the record buffer; fused calls are appended
+ * @blk:	the block
+ * @stats:	statistics
+ */
+void
+idiom_fuse(idft_context_t *context, rec_buf_t *buf, ir_block_t *blk,
+		idft_block_stats_t *stats)
+{
+	uint32_t i, j, k, n, regs, last;
+	ir_uop_t *u, *v;
+
+	for (i = idiom_next(blk, 0); i < blk->nuops;
+			i = idiom_next(blk, i + 1)) {
+		u = &blk->uops[i];
+		j = idiom_next(blk, i + 1);
+		v = (j < blk->nuops) ? &blk->uops[j] : NULL;
+
+		/* push ebp; mov ebp, esp [; push r32 ...] */
+		if (v != NULL && idiom_push(context, buf, u) &&
+			u->src.reg == GPR_EBP &&
+			idiom_ins(buf, v) == idiom_ins(buf, u) + 1 &&
+			idiom_mov(context, buf, v, GPR_EBP, GPR_ESP,
+				XED_ICLASS_MOV)) {
+			n	= 0;
+			regs	= 0;
+			last	= j;
+			if ((k = idiom_next(blk, j + 1)) < blk->nuops)
+				n = idiom_run(context, buf, blk, k,
+					idiom_ins(buf, v), IDIOM_RUN_MAX - 1,
+					1, &regs, &last);
+
+			if (idiom_emit(buf, u, (void *)_prologue, &u->dst,
+					regs, n, 1))
+				return;
+
+			idiom_drop(blk, i, last);
+			stats->fused += n + 2;
+			i = last;
+			continue;
+		}
+
+		/* mov esp, ebp; pop ebp */
+		if (v != NULL && idiom_mov(context, buf, u, GPR_ESP, GPR_EBP,
+				XED_ICLASS_MOV) &&
+			idiom_ins(buf, v) == idiom_ins(buf, u) + 1 &&
+			idiom_pop(context, buf, v) && v->dst.reg == GPR_EBP) {
+			if (idiom_emit(buf, v, (void *)_leave, &v->src, 0, 0, 0))
+				return;
+
+			u->op = UOP_NOP;
+			stats->fused += 2;
+			i = j;
+			continue;
+		}
+
+		/* leave */
+		if (v != NULL && idiom_ins(buf, v) == idiom_ins(buf, u) &&
+			idiom_mov(context, buf, u, GPR_ESP, GPR_EBP,
+				XED_ICLASS_LEAVE) &&
+			v->op == UOP_COPY && !v->pred &&
+			LOC_R32(&v->dst, GPR_EBP) &&
+			LOC_SLOT(&v->src, IARG_MEMORYREAD_EA)) {
+			if (idiom_emit(buf, u, (void *)_leave, &v->src, 0, 0, 0))
+				return;
+
+			v->op = UOP_NOP;
+			stats->fused += 2;
+			i = j;
+			continue;
+		}
+
+		/* push r32 x n */
+		if ((n = idiom_run(context, buf, blk, i, NULL, IDIOM_RUN_MAX,
+				1, &regs, &last)) > 1) {
+			if (idiom_emit(buf, u, (void *)_push_run, &u->dst,
+					regs, n, 1))
+				return;
+		}
+		/* pop r32 x n */
+		else if ((n = idiom_run(context, buf, blk, i, NULL,
+				IDIOM_RUN_MAX, 0, &regs, &last)) > 1) {
+			if (idiom_emit(buf, u, (void *)_pop_run, &u->src,
+					regs, n, 1))
+				return;
+		}
+		else
+			continue;
+
+		idiom_drop(blk, i, last);
+		stats->fused += n;
+		i = last;
+	}
+}
@@ -0,0 +1,14 @@
+#ifndef LIBICEDFT_IDIOM_H
+#define LIBICEDFT_IDIOM_H
+
+#include <stdint.h>
+#include "libicedft_api.h"
+#include "libicedft_ir.h"
+#include "libicedft_rec.h"
+
+#define IDIOM_RUN_MAX	8			/* registers per fused run */
+
+void	idiom_fuse(idft_context_t *context, rec_buf_t *buf, ir_block_t *blk,
+		idft_block_stats_t *stats);
+
+#endif /* LIBICEDFT_IDIOM_H */
@@ -0,0 +1,2953 @@
+/*
+ * inlinable analysis routines
+ *
+ * the straight-line tag propagation routines of libicedft_core.c,
+ * as self-contained static inline code: no calls, no globals but
+ * the tagmap (bitmap), and no branches but the implicit ones of
+ * the memory accesses. Executers that can inline analysis code
+ * (e.g., Pin's INS_InsertCall with IARG_FAST_ANALYSIS_CALL, or a
+ * code generator that compiles this header) use these in place of
+ * the out-of-line instances that ins_inspect hands to them; which
+ * routines have an inline version is reported by libdft_handler_info
+ * (IDFT_HANDLER_INLINE).
+ *
+ * every idft_inline_<name> has the same arguments, and semantics, as
+ * the out-of-line routine it comes from (<name>, or _<name> for the
+ * instruction-specific ones)
+ */
+
+#ifndef LIBICEDFT_INLINE_H
+#define LIBICEDFT_INLINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "libicedft_api.h"
+#include "libicedft_core.h"
+#include "tagmap.h"
+
+#if defined(__SSE2__) && !defined(USE_PACKED_VCPU)
+#include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__)
+#define IDFT_INLINE	static inline __attribute__((always_inline))
+#define IDFT_PREFETCH(p)	__builtin_prefetch((p), 0, 3)
+#else
+#define IDFT_INLINE	static __inline
+#define IDFT_PREFETCH(p)	((void)(p))
+#endif
+
+/*
+ * fast tag extension; the tag of the lower (IDFT_EXT8L) or upper
+ * (IDFT_EXT8H) 8-bit register, as isolated with VCPU_MASK8 and
+ * VCPU_MASK8 << 1 respectively, is spread over mask (0 if clear)
+ */
+#define IDFT_EXT8L(tag, mask)	((0U - (uint32_t)(tag)) & (mask))
+#define IDFT_EXT8H(tag, mask)	((0U - ((uint32_t)(tag) >> 1)) & (mask))
+
+/*
+ * generic tag propagation
+ *
+ * the register/memory transfer, binary, XCHG and XADD routines
+ * differ only in the kind of their operands (register or memory),
+ * the width of the operation and the byte lane of the 8-bit
+ * registers; each family is one generic routine below, and its
+ * members (e.g., idft_inline_r2r_xfer_opb_ul) are instances with
+ * constant arguments that the compiler folds away after inlining
+ *
+ * @mask:	operation width; VCPU_MASK8, VCPU_MASK16, VCPU_MASK32 or,
+ *		with IDFT_X86_64, VCPU_MASK64 (equal to BYTE_MASK,
+ *		WORD_MASK, LONG_MASK and QUAD_MASK)
+ * @lane:	register lane; IDFT_LANE_L, or IDFT_LANE_U for the
+ *		upper 8-bit registers (always IDFT_LANE_L otherwise)
+ * @op:		IDFT_GEN_XFER (t[dst] = t[src]) or IDFT_GEN_BINARY
+ *		(t[dst] |= t[src])
+ */
+#define IDFT_LANE_L	0			/* lower 8-bit, or whole */
+#define IDFT_LANE_U	1			/* upper 8-bit */
+
+#define IDFT_GEN_XFER	0			/* t[dst] = t[src] */
+#define IDFT_GEN_BINARY	1			/* t[dst] |= t[src] */
+
+/* move the tag of a register lane to another lane */
+#define IDFT_GEN_LANE(tag, mask, from, to)				\
+	((((tag) & ((mask) << (from))) >> (from)) << (to))
+
+/* merge tag (already in lane) into the tag of a register */
+IDFT_INLINE uint32_t
+idft_gen_reg_merge(uint32_t old, uint32_t tag, uint32_t mask, uint32_t lane,
+		uint32_t op)
+{
+	if (op == IDFT_GEN_BINARY) {
+#ifdef IDFT_X86_64
+		/* writing a 32-bit register zero-extends it */
+		if (mask == VCPU_MASK32)
+			return (old & mask) | tag;
+#endif
+		return old | tag;
+	}
+
+	/* whole register (or, IDFT_X86_64, zero-extended) */
+	if (mask >= VCPU_MASK32)
+		return tag;
+
+	return (old & ~(mask << lane)) | tag;
+}
+
+/* the tag of a memory operand */
+IDFT_INLINE uint32_t
+idft_gen_mem_load(ADDRINT addr, uint32_t mask)
+{
+	/* 8-bit operands never read past their tagmap byte */
+	if (mask == VCPU_MASK8)
+		return (bitmap[VIRT2BYTE(addr)] >> VIRT2BIT(addr)) & mask;
+
+	return (*((uint16_t *)(bitmap + VIRT2BYTE(addr))) >> VIRT2BIT(addr)) &
+		mask;
+}
+
+/* update the tag of a memory operand */
+IDFT_INLINE void
+idft_gen_mem_store(ADDRINT addr, uint32_t mask, uint32_t tag, uint32_t op)
+{
+	if (mask == VCPU_MASK8) {
+		if (op == IDFT_GEN_BINARY)
+			bitmap[VIRT2BYTE(addr)] |= tag << VIRT2BIT(addr);
+		else
+			bitmap[VIRT2BYTE(addr)] =
+				(bitmap[VIRT2BYTE(addr)] &
+				~(mask << VIRT2BIT(addr))) |
+				(tag << VIRT2BIT(addr));
+	}
+	else {
+		if (op == IDFT_GEN_BINARY)
+			*((uint16_t *)(bitmap + VIRT2BYTE(addr))) |=
+				(uint16_t)tag << VIRT2BIT(addr);
+		else
+			*((uint16_t *)(bitmap + VIRT2BYTE(addr))) =
+				(*((uint16_t *)(bitmap + VIRT2BYTE(addr))) &
+				~(mask << VIRT2BIT(addr))) |
+				((uint16_t)tag << VIRT2BIT(addr));
+	}
+}
+
+/*
+ * t[dst] op t[src]; both are registers
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ * @dlane:	destination lane
+ * @slane:	source lane
+ */
+IDFT_INLINE void
+idft_gen_r2r(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src,
+		uint32_t mask, uint32_t dlane, uint32_t slane, uint32_t op)
+{
+	VCPU_GPR_SET(thread_ctx, dst,
+		idft_gen_reg_merge(VCPU_GPR(thread_ctx, dst),
+			IDFT_GEN_LANE(VCPU_GPR(thread_ctx, src), mask, slane,
+				dlane),
+			mask, dlane, op));
+}
+
+/*
+ * t[dst] op t[src]; dst is a register
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source memory address
+ * @dlane:	destination lane
+ */
+IDFT_INLINE void
+idft_gen_m2r(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src,
+		uint32_t mask, uint32_t dlane, uint32_t op)
+{
+	VCPU_GPR_SET(thread_ctx, dst,
+		idft_gen_reg_merge(VCPU_GPR(thread_ctx, dst),
+			idft_gen_mem_load(src, mask) << dlane,
+			mask, dlane, op));
+}
+
+/*
+ * t[dst] op t[src]; src is a register
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination memory address
+ * @src:	source register index (VCPU)
+ * @slane:	source lane
+ */
+IDFT_INLINE void
+idft_gen_r2m(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src,
+		uint32_t mask, uint32_t slane, uint32_t op)
+{
+	idft_gen_mem_store(dst,
+		mask,
+		IDFT_GEN_LANE(VCPU_GPR(thread_ctx, src), mask, slane,
+			IDFT_LANE_L),
+		op);
+}
+
+/*
+ * t[dst] op t[src] and t[src] = t[dst]; both are registers
+ * (XCHG with IDFT_GEN_XFER, XADD with IDFT_GEN_BINARY)
+ *
+ * NOTE: dst and src may be the same VCPU register (e.g., XCHG AH, AL)
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ * @dlane:	destination lane
+ * @slane:	source lane
+ */
+IDFT_INLINE void
+idft_gen_xchg_r2r(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src,
+		uint32_t mask, uint32_t dlane, uint32_t slane, uint32_t op)
+{
+	/* temporary tag value */
+	uint32_t tmp_tag =
+		IDFT_GEN_LANE(VCPU_GPR(thread_ctx, dst), mask, dlane, slane);
+
+	idft_gen_r2r(thread_ctx, dst, src, mask, dlane, slane, op);
+
+	VCPU_GPR_SET(thread_ctx, src,
+		idft_gen_reg_merge(VCPU_GPR(thread_ctx, src), tmp_tag, mask,
+			slane, IDFT_GEN_XFER));
+}
+
+/*
+ * t[dst] = t[src] and t[src] op t[dst]; dst is a register and
+ * src the memory operand (XCHG with IDFT_GEN_XFER, XADD with
+ * IDFT_GEN_BINARY; XADD [m], r leaves m + r in memory and the
+ * old m in r)
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	register index (VCPU)
+ * @src:	memory address
+ * @dlane:	register lane
+ */
+IDFT_INLINE void
+idft_gen_xchg_m2r(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src,
+		uint32_t mask, uint32_t dlane, uint32_t op)
+{
+	/* temporary tag value */
+	uint32_t tmp_tag =
+		IDFT_GEN_LANE(VCPU_GPR(thread_ctx, dst), mask, dlane,
+			IDFT_LANE_L);
+
+	idft_gen_m2r(thread_ctx, dst, src, mask, dlane, IDFT_GEN_XFER);
+	idft_gen_mem_store(src, mask, tmp_tag, op);
+}
+
+/* instances; idft_inline_<name> with the arguments of <name> */
+#define IDFT_GEN_R2R(name, op, mask, dlane, slane)			\
+IDFT_INLINE void							\
+idft_inline_##name(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)\
+{									\
+	idft_gen_r2r(thread_ctx, dst, src, mask, dlane, slane, op);	\
+}
+
+#define IDFT_GEN_M2R(name, op, mask, dlane)				\
+IDFT_INLINE void							\
+idft_inline_##name(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)\
+{									\
+	idft_gen_m2r(thread_ctx, dst, src, mask, dlane, op);		\
+}
+
+#define IDFT_GEN_R2M(name, op, mask, slane)				\
+IDFT_INLINE void							\
+idft_inline_##name(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)\
+{									\
+	idft_gen_r2m(thread_ctx, dst, src, mask, slane, op);		\
+}
+
+#define IDFT_GEN_XCHG_R2R(name, op, mask, dlane, slane)		\
+IDFT_INLINE void							\
+idft_inline_##name(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)\
+{									\
+	idft_gen_xchg_r2r(thread_ctx, dst, src, mask, dlane, slane, op);\
+}
+
+#define IDFT_GEN_XCHG_M2R(name, op, mask, dlane)			\
+IDFT_INLINE void							\
+idft_inline_##name(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)\
+{									\
+	idft_gen_xchg_m2r(thread_ctx, dst, src, mask, dlane, op);	\
+}
+
+
+/*
+ * tag propagation (analysis function)
+ *
+ * extend the tag as follows: t[upper(eax)] = t[ax]
+ *
+ * NOTE: special case for the CWDE instruction
+ *
+ * @thread_ctx:	the thread context
+ */
+IDFT_INLINE void
+idft_inline_cwde(thread_ctx_t *thread_ctx)
+{
+	/* temporary tag value */
+	size_t src_tag = VCPU_GPR(thread_ctx, 7) & VCPU_MASK16;
+
+	/* extension; 16-bit to 32-bit */
+	src_tag |= (src_tag << 2);
+
+	/* update the destination */
+	VCPU_GPR_SET(thread_ctx, 7, src_tag);
+
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 16-bit 
+ * register and an 8-bit register as t[dst] = t[upper(src)]
+ *
+ * NOTE: special case for MOVSX instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+IDFT_INLINE void
+idft_inline_movsx_r2r_opwb_u(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	/* temporary tag value */
+	size_t src_tag = VCPU_GPR(thread_ctx, src) & (VCPU_MASK8 << 1);
+
+	/* update the destination (xfer) */
+	VCPU_GPR_SET(thread_ctx, dst,
+		(VCPU_GPR(thread_ctx, dst) & ~VCPU_MASK16) | IDFT_EXT8H(src_tag, VCPU_MASK16));
+
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 16-bit 
+ * register and an 8-bit register as t[dst] = t[lower(src)]
+ *
+ * NOTE: special case for MOVSX instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+IDFT_INLINE void
+idft_inline_movsx_r2r_opwb_l(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	/* temporary tag value */
+	size_t src_tag = 
+		VCPU_GPR(thread_ctx, src) & VCPU_MASK8;
+	
+	/* update the destination (xfer) */
+	VCPU_GPR_SET(thread_ctx, dst,
+		(VCPU_GPR(thread_ctx, dst) & ~VCPU_MASK16) | IDFT_EXT8L(src_tag, VCPU_MASK16));
+
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 32-bit register
+ * and an upper 8-bit register as t[dst] = t[upper(src)]
+ *
+ * NOTE: special case for MOVSX instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+IDFT_INLINE void
+idft_inline_movsx_r2r_oplb_u(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+
+	/* temporary tag value */
+	size_t src_tag = VCPU_GPR(thread_ctx, src) & (VCPU_MASK8 << 1);
+
+	/* update the destination (xfer) */
+	VCPU_GPR_SET(thread_ctx, dst, IDFT_EXT8H(src_tag, VCPU_MASK32)); 
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 32-bit register
+ * and a lower 8-bit register as t[dst] = t[lower(src)]
+ *
+ * NOTE: special case for MOVSX instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+IDFT_INLINE void
+idft_inline_movsx_r2r_oplb_l(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	/* temporary tag value */
+	size_t src_tag = VCPU_GPR(thread_ctx, src) & VCPU_MASK8;
+
+	/* update the destination (xfer) */
+	VCPU_GPR_SET(thread_ctx, dst, IDFT_EXT8L(src_tag, VCPU_MASK32)); 
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 32-bit register
+ * and a 16-bit register as t[dst] = t[src]
+ *
+ * NOTE: special case for MOVSX instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+IDFT_INLINE void
+idft_inline_movsx_r2r_oplw(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	/* temporary tag value */
+	size_t src_tag = VCPU_GPR(thread_ctx, src) & VCPU_MASK16;
+
+	/* extension; 16-bit to 32-bit */
+	src_tag |= (src_tag << 2);
+
+	/* update the destination (xfer) */
+	VCPU_GPR_SET(thread_ctx, dst, src_tag);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 16-bit 
+ * register and an 8-bit memory location as
+ * t[dst] = t[src]
+ *
+ * NOTE: special case for MOVSX instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source memory address
+ */
+IDFT_INLINE void
+idft_inline_movsx_m2r_opwb(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+{
+	/* temporary tag value */
+	size_t src_tag = 
+		(bitmap[VIRT2BYTE(src)] >> VIRT2BIT(src)) & VCPU_MASK8;
+	
+	/* update the destination (xfer) */ 
+	VCPU_GPR_SET(thread_ctx, dst,
+		(VCPU_GPR(thread_ctx, dst) & ~VCPU_MASK16) | IDFT_EXT8L(src_tag, VCPU_MASK16));
+
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 32-bit 
+ * register and an 8-bit memory location as
+ * t[dst] = t[src]
+ *
+ * NOTE: special case for MOVSX instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source memory address
+ */
+IDFT_INLINE void
+idft_inline_movsx_m2r_oplb(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+{
+	/* temporary tag value */
+	size_t src_tag = 
+		(bitmap[VIRT2BYTE(src)] >> VIRT2BIT(src)) & VCPU_MASK8;
+	
+	/* update the destination (xfer) */
+	VCPU_GPR_SET(thread_ctx, dst, IDFT_EXT8L(src_tag, VCPU_MASK32));
+
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 32-bit register
+ * and a 16-bit memory location as t[dst] = t[src]
+ *
+ * NOTE: special case for MOVSX instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source memory address 
+ */
+IDFT_INLINE void
+idft_inline_movsx_m2r_oplw(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+{
+	/* temporary tag value */
+	size_t src_tag = 
+		((*((uint16_t *)(bitmap + VIRT2BYTE(src))) >> VIRT2BIT(src)) &
+		VCPU_MASK16);
+
+	/* extension; 16-bit to 32-bit */
+	src_tag |= (src_tag << 2);
+
+	/* update the destination (xfer) */
+	VCPU_GPR_SET(thread_ctx, dst, src_tag);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 64-bit register
+ * and a 32-bit register as t[dst] = t[src]
+ *
+ * NOTE: special case for the MOVSXD and CDQE instructions
+ * (IDFT_X86_64)
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+IDFT_INLINE void
+idft_inline_movsx_r2r_opql(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	/* temporary tag value */
+	size_t src_tag = VCPU_GPR(thread_ctx, src) & VCPU_MASK32;
+
+	/* extension; 32-bit to 64-bit */
+	src_tag |= (src_tag << 4);
+
+	/* update the destination (xfer) */
+	VCPU_GPR_SET(thread_ctx, dst, src_tag);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 64-bit register
+ * and a 16-bit register as t[dst] = t[src]
+ *
+ * NOTE: special case for MOVSX instruction (IDFT_X86_64)
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+IDFT_INLINE void
+idft_inline_movsx_r2r_opqw(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	/* extension; 16-bit to 64-bit, as 4 copies */
+	VCPU_GPR_SET(thread_ctx, dst,
+		(VCPU_GPR(thread_ctx, src) & VCPU_MASK16) * 0x55);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 64-bit register
+ * and an upper 8-bit register as t[dst] = t[upper(src)]
+ *
+ * NOTE: special case for MOVSX instruction (IDFT_X86_64)
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+IDFT_INLINE void
+idft_inline_movsx_r2r_opqb_u(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	/* temporary tag value */
+	size_t src_tag = VCPU_GPR(thread_ctx, src) & (VCPU_MASK8 << 1);
+
+	/* update the destination (xfer) */
+	VCPU_GPR_SET(thread_ctx, dst, IDFT_EXT8H(src_tag, VCPU_MASK64));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 64-bit register
+ * and a lower 8-bit register as t[dst] = t[lower(src)]
+ *
+ * NOTE: special case for MOVSX instruction (IDFT_X86_64)
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+IDFT_INLINE void
+idft_inline_movsx_r2r_opqb_l(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	/* temporary tag value */
+	size_t src_tag = VCPU_GPR(thread_ctx, src) & VCPU_MASK8;
+
+	/* update the destination (xfer) */
+	VCPU_GPR_SET(thread_ctx, dst, IDFT_EXT8L(src_tag, VCPU_MASK64));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 64-bit register
+ * and a 32-bit memory location as t[dst] = t[src]
+ *
+ * NOTE: special case for MOVSXD instruction (IDFT_X86_64)
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source memory address
+ */
+IDFT_INLINE void
+idft_inline_movsx_m2r_opql(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+{
+	/* temporary tag value */
+	size_t src_tag = 
+		((*((uint16_t *)(bitmap + VIRT2BYTE(src))) >> VIRT2BIT(src)) &
+		VCPU_MASK32);
+
+	/* extension; 32-bit to 64-bit */
+	src_tag |= (src_tag << 4);
+
+	/* update the destination (xfer) */
+	VCPU_GPR_SET(thread_ctx, dst, src_tag);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 64-bit register
+ * and a 16-bit memory location as t[dst] = t[src]
+ *
+ * NOTE: special case for MOVSX instruction (IDFT_X86_64)
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source memory address
+ */
+IDFT_INLINE void
+idft_inline_movsx_m2r_opqw(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+{
+	/* extension; 16-bit to 64-bit, as 4 copies */
+	VCPU_GPR_SET(thread_ctx, dst,
+		((*((uint16_t *)(bitmap + VIRT2BYTE(src))) >> VIRT2BIT(src)) &
+		VCPU_MASK16) * 0x55);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 64-bit register
+ * and an 8-bit memory location as t[dst] = t[src]
+ *
+ * NOTE: special case for MOVSX instruction (IDFT_X86_64)
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source memory address
+ */
+IDFT_INLINE void
+idft_inline_movsx_m2r_opqb(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+{
+	/* temporary tag value */
+	size_t src_tag = 
+		(bitmap[VIRT2BYTE(src)] >> VIRT2BIT(src)) & VCPU_MASK8;
+
+	/* update the destination (xfer) */
+	VCPU_GPR_SET(thread_ctx, dst, IDFT_EXT8L(src_tag, VCPU_MASK64));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * extend the tag as follows: t[rdx] = t[sign(rax)]
+ *
+ * NOTE: special case for the CQO instruction (IDFT_X86_64)
+ *
+ * @thread_ctx:	the thread context
+ */
+IDFT_INLINE void
+idft_inline_cqo(thread_ctx_t *thread_ctx)
+{
+	/* the sign byte (byte 7) fills RDX */
+	VCPU_GPR_SET(thread_ctx, GPR_EDX,
+		((VCPU_GPR(thread_ctx, GPR_EAX) >> 7) & 1) * VCPU_MASK64);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 16-bit 
+ * register and an 8-bit register as t[dst] = t[upper(src)]
+ *
+ * NOTE: special case for MOVZX instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+IDFT_INLINE void
+idft_inline_movzx_r2r_opwb_u(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	/* temporary tag value */
+	size_t src_tag =
+		(VCPU_GPR(thread_ctx, src) & (VCPU_MASK8 << 1)) >> 1;
+
+	/* update the destination (xfer) */
+	VCPU_GPR_SET(thread_ctx, dst,
+		(VCPU_GPR(thread_ctx, dst) & ~VCPU_MASK16) | src_tag);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 16-bit 
+ * register and an 8-bit register as t[dst] = t[lower(src)]
+ *
+ * NOTE: special case for MOVZX instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+IDFT_INLINE void
+idft_inline_movzx_r2r_opwb_l(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	/* temporary tag value */
+	size_t src_tag = 
+		VCPU_GPR(thread_ctx, src) & VCPU_MASK8;
+	
+	/* update the destination (xfer) */
+	VCPU_GPR_SET(thread_ctx, dst,
+		(VCPU_GPR(thread_ctx, dst) & ~VCPU_MASK16) | src_tag);
+
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 32-bit register
+ * and an upper 8-bit register as t[dst] = t[upper(src)]
+ *
+ * NOTE: special case for MOVZX instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+IDFT_INLINE void
+idft_inline_movzx_r2r_oplb_u(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	/* temporary tag value */
+	size_t src_tag =
+		(VCPU_GPR(thread_ctx, src) & (VCPU_MASK8 << 1)) >> 1;
+
+	/* update the destination (xfer) */
+	VCPU_GPR_SET(thread_ctx, dst, src_tag); 
+
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 32-bit register
+ * and a lower 8-bit register as t[dst] = t[lower(src)]
+ *
+ * NOTE: special case for MOVZX instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+IDFT_INLINE void
+idft_inline_movzx_r2r_oplb_l(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	/* temporary tag value */
+	size_t src_tag = VCPU_GPR(thread_ctx, src) & VCPU_MASK8;
+
+	/* update the destination (xfer) */
+	VCPU_GPR_SET(thread_ctx, dst, src_tag); 
+
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 32-bit register
+ * and a 16-bit register as t[dst] = t[src]
+ *
+ * NOTE: special case for MOVZX instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+IDFT_INLINE void
+idft_inline_movzx_r2r_oplw(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	/* temporary tag value */
+	size_t src_tag = VCPU_GPR(thread_ctx, src) & VCPU_MASK16;
+
+	/* update the destination (xfer) */
+	VCPU_GPR_SET(thread_ctx, dst, src_tag);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 16-bit 
+ * register and an 8-bit memory location as
+ * t[dst] = t[src]
+ *
+ * NOTE: special case for MOVZX instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source memory address
+ */
+IDFT_INLINE void
+idft_inline_movzx_m2r_opwb(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+{
+	/* temporary tag value */
+	size_t src_tag = 
+		(bitmap[VIRT2BYTE(src)] >> VIRT2BIT(src)) & VCPU_MASK8;
+	
+	/* update the destination (xfer) */ 
+	VCPU_GPR_SET(thread_ctx, dst,
+		(VCPU_GPR(thread_ctx, dst) & ~VCPU_MASK16) | src_tag);
+
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 32-bit 
+ * register and an 8-bit memory location as
+ * t[dst] = t[src]
+ *
+ * NOTE: special case for MOVZX instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source memory address
+ */
+IDFT_INLINE void
+idft_inline_movzx_m2r_oplb(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+{
+	/* temporary tag value */
+	size_t src_tag = 
+		(bitmap[VIRT2BYTE(src)] >> VIRT2BIT(src)) & VCPU_MASK8;
+	
+	/* update the destination (xfer) */
+	VCPU_GPR_SET(thread_ctx, dst, src_tag);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 32-bit register
+ * and a 16-bit memory location as t[dst] = t[src]
+ *
+ * NOTE: special case for MOVZX instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source memory address 
+ */
+IDFT_INLINE void
+idft_inline_movzx_m2r_oplw(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+{
+	/* temporary tag value */
+	size_t src_tag = 
+		((*((uint16_t *)(bitmap + VIRT2BYTE(src))) >> VIRT2BIT(src)) &
+		VCPU_MASK16);
+
+	/* update the destination (xfer) */
+	VCPU_GPR_SET(thread_ctx, dst, src_tag);
+
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between two 32-bit
+ * registers as t[EAX] = t[src]; return
+ * the result of EAX == src and also
+ * store the original tag value of
+ * EAX in the scratch register
+ *
+ * NOTE: special case for the CMPXCHG instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst_val:	EAX register value
+ * @src:	source register index (VCPU)
+ * @src_val:	source register value
+ */
+IDFT_INLINE ADDRINT
+idft_inline_cmpxchg_r2r_opl_fast(thread_ctx_t *thread_ctx, uint32_t dst_val, uint32_t src,
+							uint32_t src_val)
+{
+
+	/* save the tag value of dst in the scratch register */
+	VCPU_GPR_SET(thread_ctx, GPR_SCRATCH,
+		VCPU_GPR(thread_ctx, 7));
+	
+	/* update */
+	VCPU_GPR_SET(thread_ctx, 7,
+		VCPU_GPR(thread_ctx, src));
+
+
+	/* compare the dst and src values */
+	return (dst_val == src_val);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between two 32-bit 
+ * registers as t[dst] = t[src]; restore the
+ * value of EAX from the scratch register
+ *
+ * NOTE: special case for the CMPXCHG instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+IDFT_INLINE void
+idft_inline_cmpxchg_r2r_opl_slow(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	/* restore the tag value from the scratch register */
+	VCPU_GPR_SET(thread_ctx, 7, 
+		VCPU_GPR(thread_ctx, GPR_SCRATCH));
+	
+	/* update */
+	VCPU_GPR_SET(thread_ctx, dst,
+		VCPU_GPR(thread_ctx, src));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between two 16-bit
+ * registers as t[AX] = t[src]; return
+ * the result of AX == src and also
+ * store the original tag value of
+ * AX in the scratch register
+ *
+ * NOTE: special case for the CMPXCHG instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst_val:	AX register value
+ * @src:	source register index (VCPU)
+ * @src_val:	source register value
+ */
+IDFT_INLINE ADDRINT
+idft_inline_cmpxchg_r2r_opw_fast(thread_ctx_t *thread_ctx, uint16_t dst_val, uint32_t src,
+						uint16_t src_val)
+{
+
+	/* save the tag value of dst in the scratch register */
+	VCPU_GPR_SET(thread_ctx, GPR_SCRATCH,
+		VCPU_GPR(thread_ctx, 7));
+	
+	/* update */
+	VCPU_GPR_SET(thread_ctx, 7,
+		(VCPU_GPR(thread_ctx, 7) & ~VCPU_MASK16) |
+		(VCPU_GPR(thread_ctx, src) & VCPU_MASK16));
+
+
+	/* compare the dst and src values */
+	return (dst_val == src_val);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between two 16-bit 
+ * registers as t[dst] = t[src]; restore the
+ * value of AX from the scratch register
+ *
+ * NOTE: special case for the CMPXCHG instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+IDFT_INLINE void
+idft_inline_cmpxchg_r2r_opw_slow(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	/* restore the tag value from the scratch register */
+	VCPU_GPR_SET(thread_ctx, 7, 
+		VCPU_GPR(thread_ctx, GPR_SCRATCH));
+	
+	/* update */
+	VCPU_GPR_SET(thread_ctx, dst,
+		(VCPU_GPR(thread_ctx, dst) & ~VCPU_MASK16) |
+		(VCPU_GPR(thread_ctx, src) & VCPU_MASK16));
+
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between a 32-bit
+ * register and a memory location
+ * as t[EAX] = t[src]; return the result
+ * of EAX == src and also store the
+ * original tag value of EAX in
+ * the scratch register
+ *
+ * NOTE: special case for the CMPXCHG instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst_val:	destination register value
+ * @src:	source memory address
+ */
+IDFT_INLINE ADDRINT
+idft_inline_cmpxchg_m2r_opl_fast(thread_ctx_t *thread_ctx, uint32_t dst_val, ADDRINT src)
+{
+	/* save the tag value of dst in the scratch register */
+	VCPU_GPR_SET(thread_ctx, GPR_SCRATCH,
+		VCPU_GPR(thread_ctx, 7));
+	
+	/* update */
+	VCPU_GPR_SET(thread_ctx, 7,
+		(*((uint16_t *)(bitmap + VIRT2BYTE(src))) >> VIRT2BIT(src)) &
+		VCPU_MASK32);
+	
+	/* compare the dst and src values; the original values the tag bits */
+	return (dst_val == *(uint32_t *)src);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between a 32-bit 
+ * register and a memory location
+ * as t[dst] = t[src]; restore the value
+ * of EAX from the scratch register
+ *
+ * NOTE: special case for the CMPXCHG instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination memory address
+ * @src:	source register index (VCPU)
+ */
+IDFT_INLINE void
+idft_inline_cmpxchg_r2m_opl_slow(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
+{
+	/* restore the tag value from the scratch register */
+	VCPU_GPR_SET(thread_ctx, 7, 
+		VCPU_GPR(thread_ctx, GPR_SCRATCH));
+	
+	/* update */
+	*((uint16_t *)(bitmap + VIRT2BYTE(dst))) =
+		(*((uint16_t *)(bitmap + VIRT2BYTE(dst))) & ~(LONG_MASK <<
+							      VIRT2BIT(dst))) |
+		((uint16_t)(VCPU_GPR(thread_ctx, src) & VCPU_MASK32) <<
+		VIRT2BIT(dst));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between a 16-bit
+ * register and a memory location
+ * as t[AX] = t[src]; return the result
+ * of AX == src and also store the
+ * original tag value of AX in
+ * the scratch register
+ *
+ * NOTE: special case for the CMPXCHG instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @dst_val:	destination register value
+ * @src:	source memory address
+ */
+IDFT_INLINE ADDRINT
+idft_inline_cmpxchg_m2r_opw_fast(thread_ctx_t *thread_ctx, uint16_t dst_val, ADDRINT src)
+{
+
+	/* save the tag value of dst in the scratch register */
+	VCPU_GPR_SET(thread_ctx, GPR_SCRATCH,
+		VCPU_GPR(thread_ctx, 7));
+	
+	/* update */
+	VCPU_GPR_SET(thread_ctx, 7,
+		(VCPU_GPR(thread_ctx, 7) & ~VCPU_MASK16) |
+		((*((uint16_t *)(bitmap + VIRT2BYTE(src))) >> VIRT2BIT(src)) &
+		VCPU_MASK16));
+	
+	/* compare the dst and src values; the original values the tag bits */
+	return (dst_val == *(uint16_t *)src);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between a 16-bit 
+ * register and a memory location
+ * as t[dst] = t[src]; restore the value
+ * of AX from the scratch register
+ *
+ * NOTE: special case for the CMPXCHG instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination memory address
+ * @src:	source register index (VCPU)
+ * @res:	restore register index (VCPU)
+ */
+IDFT_INLINE void
+idft_inline_cmpxchg_r2m_opw_slow(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
+{
+
+	/* restore the tag value from the scratch register */
+	VCPU_GPR_SET(thread_ctx, 7, 
+		VCPU_GPR(thread_ctx, GPR_SCRATCH));
+	
+	/* update */
+	*((uint16_t *)(bitmap + VIRT2BYTE(dst))) =
+		(*((uint16_t *)(bitmap + VIRT2BYTE(dst))) & ~(WORD_MASK <<
+							      VIRT2BIT(dst))) |
+		((uint16_t)(VCPU_GPR(thread_ctx, src) & VCPU_MASK16) <<
+		VIRT2BIT(dst));
+
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * CMPXCHG between two 32-bit registers, in one branch-free call;
+ * if EAX == dst, t[dst] = t[src], otherwise t[EAX] = t[dst]. It
+ * replaces the If/Then _fast/_slow pair of ins_inspect, and unlike
+ * that pair it never stages the tag of EAX in the scratch register
+ *
+ * NOTE: special case for the CMPXCHG instruction
+ *
+ * @thread_ctx:	the thread context
+ * @eax_val:	EAX register value
+ * @dst:	destination register index (VCPU)
+ * @dst_val:	destination register value
+ * @src:	source register index (VCPU)
+ */
+IDFT_INLINE void
+idft_inline_cmpxchg_r2r_opl_bf(thread_ctx_t *thread_ctx, uint32_t eax_val,
+		uint32_t dst, uint32_t dst_val, uint32_t src)
+{
+	/* all ones if equal, 0 otherwise */
+	uint32_t eq = 0U - (uint32_t)(eax_val == dst_val);
+	uint32_t dst_tag = VCPU_GPR(thread_ctx, dst);
+	uint32_t src_tag = VCPU_GPR(thread_ctx, src);
+
+	VCPU_GPR_SET(thread_ctx, 7,
+		(VCPU_GPR(thread_ctx, 7) & eq) | (dst_tag & ~eq));
+
+	/* dst may be EAX; read it again */
+	VCPU_GPR_SET(thread_ctx, dst,
+		(VCPU_GPR(thread_ctx, dst) & ~eq) | (src_tag & eq));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * CMPXCHG between two 16-bit registers, in one branch-free call;
+ * if AX == dst, t[dst] = t[src], otherwise t[AX] = t[dst]
+ *
+ * NOTE: special case for the CMPXCHG instruction
+ *
+ * @thread_ctx:	the thread context
+ * @ax_val:	AX register value
+ * @dst:	destination register index (VCPU)
+ * @dst_val:	destination register value
+ * @src:	source register index (VCPU)
+ */
+IDFT_INLINE void
+idft_inline_cmpxchg_r2r_opw_bf(thread_ctx_t *thread_ctx, uint16_t ax_val,
+		uint32_t dst, uint16_t dst_val, uint32_t src)
+{
+	/* VCPU_MASK16 if equal, 0 otherwise */
+	uint32_t eq = (0U - (uint32_t)(ax_val == dst_val)) & VCPU_MASK16;
+	uint32_t ne = eq ^ VCPU_MASK16;
+	uint32_t dst_tag = VCPU_GPR(thread_ctx, dst);
+	uint32_t src_tag = VCPU_GPR(thread_ctx, src);
+
+	VCPU_GPR_SET(thread_ctx, 7,
+		(VCPU_GPR(thread_ctx, 7) & ~ne) | (dst_tag & ne));
+
+	/* dst may be EAX; read it again */
+	VCPU_GPR_SET(thread_ctx, dst,
+		(VCPU_GPR(thread_ctx, dst) & ~eq) | (src_tag & eq));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * CMPXCHG between a 32-bit memory location and a register, in
+ * one branch-free call; if EAX == [dst], t[dst] = t[src], otherwise
+ * t[EAX] = t[dst]
+ *
+ * NOTE: special case for the CMPXCHG instruction
+ *
+ * @thread_ctx:	the thread context
+ * @eax_val:	EAX register value
+ * @dst:	destination memory address
+ * @src:	source register index (VCPU)
+ */
+IDFT_INLINE void
+idft_inline_cmpxchg_m2r_opl_bf(thread_ctx_t *thread_ctx, uint32_t eax_val,
+		ADDRINT dst, uint32_t src)
+{
+	/* all ones if equal, 0 otherwise; the original value, not the tag */
+	uint32_t eq = 0U - (uint32_t)(eax_val == *(uint32_t *)dst);
+	uint32_t dst_tag =
+		(*((uint16_t *)(bitmap + VIRT2BYTE(dst))) >> VIRT2BIT(dst)) &
+		VCPU_MASK32;
+	uint32_t src_tag = VCPU_GPR(thread_ctx, src) & VCPU_MASK32;
+
+	VCPU_GPR_SET(thread_ctx, 7,
+		(VCPU_GPR(thread_ctx, 7) & eq) | (dst_tag & ~eq));
+
+	*((uint16_t *)(bitmap + VIRT2BYTE(dst))) =
+		(*((uint16_t *)(bitmap + VIRT2BYTE(dst))) & ~(LONG_MASK <<
+							      VIRT2BIT(dst))) |
+		((uint16_t)((dst_tag & ~eq) | (src_tag & eq)) <<
+		VIRT2BIT(dst));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * CMPXCHG between a 16-bit memory location and a register, in
+ * one branch-free call; if AX == [dst], t[dst] = t[src], otherwise
+ * t[AX] = t[dst]
+ *
+ * NOTE: special case for the CMPXCHG instruction
+ *
+ * @thread_ctx:	the thread context
+ * @ax_val:	AX register value
+ * @dst:	destination memory address
+ * @src:	source register index (VCPU)
+ */
+IDFT_INLINE void
+idft_inline_cmpxchg_m2r_opw_bf(thread_ctx_t *thread_ctx, uint16_t ax_val,
+		ADDRINT dst, uint32_t src)
+{
+	/* VCPU_MASK16 if equal, 0 otherwise */
+	uint32_t eq =
+		(0U - (uint32_t)(ax_val == *(uint16_t *)dst)) & VCPU_MASK16;
+	uint32_t ne = eq ^ VCPU_MASK16;
+	uint32_t dst_tag =
+		(*((uint16_t *)(bitmap + VIRT2BYTE(dst))) >> VIRT2BIT(dst)) &
+		VCPU_MASK16;
+	uint32_t src_tag = VCPU_GPR(thread_ctx, src) & VCPU_MASK16;
+
+	VCPU_GPR_SET(thread_ctx, 7,
+		(VCPU_GPR(thread_ctx, 7) & ~ne) | (dst_tag & ne));
+
+	*((uint16_t *)(bitmap + VIRT2BYTE(dst))) =
+		(*((uint16_t *)(bitmap + VIRT2BYTE(dst))) & ~(WORD_MASK <<
+							      VIRT2BIT(dst))) |
+		((uint16_t)((dst_tag & ne) | (src_tag & eq)) <<
+		VIRT2BIT(dst));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * CMPXCHG8B, in one branch-free call; if EDX:EAX == [dst],
+ * t[dst] = t[ECX:EBX], otherwise t[EDX:EAX] = t[dst]
+ *
+ * NOTE: special case for the CMPXCHG8B instruction
+ *
+ * @thread_ctx:	the thread context
+ * @eax_val:	EAX register value
+ * @edx_val:	EDX register value
+ * @dst:	destination memory address
+ */
+IDFT_INLINE void
+idft_inline_cmpxchg8b_m2r_bf(thread_ctx_t *thread_ctx, uint32_t eax_val,
+		uint32_t edx_val, ADDRINT dst)
+{
+	/* all ones if equal, 0 otherwise; the original values */
+	uint32_t eq = 0U - (uint32_t)(eax_val == *(uint32_t *)dst &&
+			edx_val == *(uint32_t *)(dst + 4));
+	uint32_t dst_tag =
+		(*((uint16_t *)(bitmap + VIRT2BYTE(dst))) >> VIRT2BIT(dst)) &
+		VCPU_MASK64;
+	uint32_t src_tag = (VCPU_GPR(thread_ctx, 4) & VCPU_MASK32) |
+		((VCPU_GPR(thread_ctx, 6) & VCPU_MASK32) << 4);
+
+	/* EAX and EDX */
+	VCPU_GPR_SET(thread_ctx, 7,
+		(VCPU_GPR(thread_ctx, 7) & eq) | (dst_tag & VCPU_MASK32 & ~eq));
+	VCPU_GPR_SET(thread_ctx, 5,
+		(VCPU_GPR(thread_ctx, 5) & eq) | ((dst_tag >> 4) & ~eq));
+
+	*((uint16_t *)(bitmap + VIRT2BYTE(dst))) =
+		(*((uint16_t *)(bitmap + VIRT2BYTE(dst))) & ~(QUAD_MASK <<
+							      VIRT2BIT(dst))) |
+		((uint16_t)((dst_tag & ~eq) | (src_tag & eq)) <<
+		VIRT2BIT(dst));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * CMPXCHG16B, in one branch-free call; if RDX:RAX == [dst],
+ * t[dst] = t[RCX:RBX], otherwise t[RDX:RAX] = t[dst]
+ *
+ * NOTE: special case for the CMPXCHG16B instruction (IDFT_X86_64);
+ * dst is 16-byte aligned, so its tags are two whole tagmap bytes
+ *
+ * @thread_ctx:	the thread context
+ * @rax_val:	RAX register value
+ * @rdx_val:	RDX register value
+ * @dst:	destination memory address
+ */
+IDFT_INLINE void
+idft_inline_cmpxchg16b_m2r_bf(thread_ctx_t *thread_ctx, ADDRINT rax_val,
+		ADDRINT rdx_val, ADDRINT dst)
+{
+	/* all ones if equal, 0 otherwise; the original values */
+	uint32_t eq = 0U - (uint32_t)(rax_val == *(ADDRINT *)dst &&
+			rdx_val == *(ADDRINT *)(dst + 8));
+	uint32_t dst_tag = *((uint16_t *)(bitmap + VIRT2BYTE(dst)));
+	uint32_t src_tag = (VCPU_GPR(thread_ctx, 4) & VCPU_MASK64) |
+		((VCPU_GPR(thread_ctx, 6) & VCPU_MASK64) << 8);
+
+	/* RAX and RDX */
+	VCPU_GPR_SET(thread_ctx, 7,
+		(VCPU_GPR(thread_ctx, 7) & eq) | (dst_tag & VCPU_MASK64 & ~eq));
+	VCPU_GPR_SET(thread_ctx, 5,
+		(VCPU_GPR(thread_ctx, 5) & eq) | ((dst_tag >> 8) & ~eq));
+
+	*((uint16_t *)(bitmap + VIRT2BYTE(dst))) =
+		(uint16_t)((dst_tag & ~eq) | (src_tag & eq));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * CMPXCHG between two 64-bit registers, in one branch-free call;
+ * if RAX == dst, t[dst] = t[src], otherwise t[RAX] = t[dst]
+ *
+ * NOTE: special case for the CMPXCHG instruction (IDFT_X86_64)
+ *
+ * @thread_ctx:	the thread context
+ * @rax_val:	RAX register value
+ * @dst:	destination register index (VCPU)
+ * @dst_val:	destination register value
+ * @src:	source register index (VCPU)
+ */
+IDFT_INLINE void
+idft_inline_cmpxchg_r2r_opq_bf(thread_ctx_t *thread_ctx, ADDRINT rax_val,
+		uint32_t dst, ADDRINT dst_val, uint32_t src)
+{
+	/* all ones if equal, 0 otherwise */
+	uint32_t eq = 0U - (uint32_t)(rax_val == dst_val);
+	uint32_t dst_tag = VCPU_GPR(thread_ctx, dst);
+	uint32_t src_tag = VCPU_GPR(thread_ctx, src);
+
+	VCPU_GPR_SET(thread_ctx, 7,
+		(VCPU_GPR(thread_ctx, 7) & eq) | (dst_tag & ~eq));
+
+	/* dst may be RAX; read it again */
+	VCPU_GPR_SET(thread_ctx, dst,
+		(VCPU_GPR(thread_ctx, dst) & ~eq) | (src_tag & eq));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * CMPXCHG between a 64-bit memory location and a register, in
+ * one branch-free call; if RAX == [dst], t[dst] = t[src], otherwise
+ * t[RAX] = t[dst]
+ *
+ * NOTE: special case for the CMPXCHG instruction (IDFT_X86_64)
+ *
+ * @thread_ctx:	the thread context
+ * @rax_val:	RAX register value
+ * @dst:	destination memory address
+ * @src:	source register index (VCPU)
+ */
+IDFT_INLINE void
+idft_inline_cmpxchg_m2r_opq_bf(thread_ctx_t *thread_ctx, ADDRINT rax_val,
+		ADDRINT dst, uint32_t src)
+{
+	/* all ones if equal, 0 otherwise; the original value, not the tag */
+	uint32_t eq = 0U - (uint32_t)(rax_val == *(ADDRINT *)dst);
+	uint32_t dst_tag =
+		(*((uint16_t *)(bitmap + VIRT2BYTE(dst))) >> VIRT2BIT(dst)) &
+		VCPU_MASK64;
+	uint32_t src_tag = VCPU_GPR(thread_ctx, src) & VCPU_MASK64;
+
+	VCPU_GPR_SET(thread_ctx, 7,
+		(VCPU_GPR(thread_ctx, 7) & eq) | (dst_tag & ~eq));
+
+	*((uint16_t *)(bitmap + VIRT2BYTE(dst))) =
+		(*((uint16_t *)(bitmap + VIRT2BYTE(dst))) & ~(QUAD_MASK <<
+							      VIRT2BIT(dst))) |
+		((uint16_t)((dst_tag & ~eq) | (src_tag & eq)) <<
+		VIRT2BIT(dst));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * XCHG and XADD between two registers, or between a register (dst)
+ * and a memory location (src); XCHG swaps the tags as t[dst] = t[src]
+ * and t[src] = t[dst]. XADD unites them into its destination operand
+ * and moves the old destination tag into the source one: between two
+ * registers t[dst] |= t[src] and t[src] = t[dst], and with memory
+ * t[src] |= t[dst] and t[dst] = t[src] (see idft_gen_xchg_r2r and
+ * idft_gen_xchg_m2r)
+ *
+ * NOTE: special cases for the XCHG and XADD instructions
+ */
+IDFT_GEN_XCHG_R2R(xchg_r2r_opb_ul, IDFT_GEN_XFER, VCPU_MASK8, IDFT_LANE_U, IDFT_LANE_L)
+IDFT_GEN_XCHG_R2R(xchg_r2r_opb_lu, IDFT_GEN_XFER, VCPU_MASK8, IDFT_LANE_L, IDFT_LANE_U)
+IDFT_GEN_XCHG_R2R(xchg_r2r_opb_u, IDFT_GEN_XFER, VCPU_MASK8, IDFT_LANE_U, IDFT_LANE_U)
+IDFT_GEN_XCHG_R2R(xchg_r2r_opb_l, IDFT_GEN_XFER, VCPU_MASK8, IDFT_LANE_L, IDFT_LANE_L)
+IDFT_GEN_XCHG_R2R(xchg_r2r_opw, IDFT_GEN_XFER, VCPU_MASK16, IDFT_LANE_L, IDFT_LANE_L)
+IDFT_GEN_XCHG_M2R(xchg_m2r_opb_u, IDFT_GEN_XFER, VCPU_MASK8, IDFT_LANE_U)
+IDFT_GEN_XCHG_M2R(xchg_m2r_opb_l, IDFT_GEN_XFER, VCPU_MASK8, IDFT_LANE_L)
+IDFT_GEN_XCHG_M2R(xchg_m2r_opw, IDFT_GEN_XFER, VCPU_MASK16, IDFT_LANE_L)
+IDFT_GEN_XCHG_M2R(xchg_m2r_opl, IDFT_GEN_XFER, VCPU_MASK32, IDFT_LANE_L)
+IDFT_GEN_XCHG_R2R(xadd_r2r_opb_ul, IDFT_GEN_BINARY, VCPU_MASK8, IDFT_LANE_U, IDFT_LANE_L)
+IDFT_GEN_XCHG_R2R(xadd_r2r_opb_lu, IDFT_GEN_BINARY, VCPU_MASK8, IDFT_LANE_L, IDFT_LANE_U)
+IDFT_GEN_XCHG_R2R(xadd_r2r_opb_u, IDFT_GEN_BINARY, VCPU_MASK8, IDFT_LANE_U, IDFT_LANE_U)
+IDFT_GEN_XCHG_R2R(xadd_r2r_opb_l, IDFT_GEN_BINARY, VCPU_MASK8, IDFT_LANE_L, IDFT_LANE_L)
+IDFT_GEN_XCHG_R2R(xadd_r2r_opw, IDFT_GEN_BINARY, VCPU_MASK16, IDFT_LANE_L, IDFT_LANE_L)
+IDFT_GEN_XCHG_M2R(xadd_m2r_opb_u, IDFT_GEN_BINARY, VCPU_MASK8, IDFT_LANE_U)
+IDFT_GEN_XCHG_M2R(xadd_m2r_opb_l, IDFT_GEN_BINARY, VCPU_MASK8, IDFT_LANE_L)
+IDFT_GEN_XCHG_M2R(xadd_m2r_opw, IDFT_GEN_BINARY, VCPU_MASK16, IDFT_LANE_L)
+IDFT_GEN_XCHG_M2R(xadd_m2r_opl, IDFT_GEN_BINARY, VCPU_MASK32, IDFT_LANE_L)
+IDFT_GEN_XCHG_M2R(xchg_m2r_opq, IDFT_GEN_XFER, VCPU_MASK64, IDFT_LANE_L)
+IDFT_GEN_XCHG_R2R(xadd_r2r_opq, IDFT_GEN_BINARY, VCPU_MASK64, IDFT_LANE_L, IDFT_LANE_L)
+IDFT_GEN_XCHG_M2R(xadd_m2r_opq, IDFT_GEN_BINARY, VCPU_MASK64, IDFT_LANE_L)
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between three 16-bit 
+ * registers as t[dst] = t[base] | t[index]
+ *
+ * NOTE: special case for the LEA instruction
+ *
+ * @thread_ctx: the thread context
+ * @dst:        destination register
+ * @base:       base register
+ * @index:      index register
+ */
+IDFT_INLINE void
+idft_inline_lea_r2r_opw(thread_ctx_t *thread_ctx,
+		uint32_t dst,
+		uint32_t base,
+		uint32_t index)
+{
+	/* update the destination */
+	VCPU_GPR_SET(thread_ctx, dst,
+		((VCPU_GPR(thread_ctx, dst) & ~VCPU_MASK16) |
+		(VCPU_GPR(thread_ctx, base) & VCPU_MASK16) |
+		(VCPU_GPR(thread_ctx, index) & VCPU_MASK16)));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between three 32-bit 
+ * registers as t[dst] = t[base] | t[index]
+ *
+ * NOTE: special case for the LEA instruction
+ *
+ * @thread_ctx: the thread context
+ * @dst:        destination register
+ * @base:       base register
+ * @index:      index register
+ */
+IDFT_INLINE void
+idft_inline_lea_r2r_opl(thread_ctx_t *thread_ctx,
+		uint32_t dst,
+		uint32_t base,
+		uint32_t index)
+{
+	/* update the destination; base and index may be 64-bit (IDFT_X86_64) */
+	VCPU_GPR_SET(thread_ctx, dst,
+		(VCPU_GPR(thread_ctx, base) | VCPU_GPR(thread_ctx, index)) &
+		VCPU_MASK32);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between three 64-bit 
+ * registers as t[dst] = t[base] | t[index]
+ *
+ * NOTE: special case for the LEA instruction (IDFT_X86_64)
+ *
+ * @thread_ctx: the thread context
+ * @dst:        destination register
+ * @base:       base register
+ * @index:      index register
+ */
+IDFT_INLINE void
+idft_inline_lea_r2r_opq(thread_ctx_t *thread_ctx,
+		uint32_t dst,
+		uint32_t base,
+		uint32_t index)
+{
+	/* update the destination */
+	VCPU_GPR_SET(thread_ctx, dst,
+		VCPU_GPR(thread_ctx, base) | VCPU_GPR(thread_ctx, index));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag among three 8-bit registers as t[dst] |= t[upper(src)];
+ * dst is AX, whereas src is an upper 8-bit register (e.g., CH, BH, ...)
+ *
+ * NOTE: special case for DIV and IDIV instructions
+ *
+ * @thread_ctx:	the thread context
+ * @src:	source register index (VCPU)
+ */
+IDFT_INLINE void
+idft_inline_r2r_ternary_opb_u(thread_ctx_t *thread_ctx, uint32_t src)
+{
+	/* temporary tag value */
+	idft_reg_t tmp_tag = VCPU_GPR(thread_ctx, src) & (VCPU_MASK8 << 1);
+	
+	/* update the destination (ternary) */
+	VCPU_GPR_SET(thread_ctx, 7,
+		VCPU_GPR(thread_ctx, 7) | IDFT_EXT8H(tmp_tag, VCPU_MASK16));
+
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag among three 8-bit registers as t[dst] |= t[lower(src)];
+ * dst is AX, whereas src is a lower 8-bit register (e.g., CL, BL, ...)
+ *
+ * NOTE: special case for DIV and IDIV instructions
+ *
+ * @thread_ctx:	the thread context
+ * @src:	source register index (VCPU)
+ */
+IDFT_INLINE void
+idft_inline_r2r_ternary_opb_l(thread_ctx_t *thread_ctx, uint32_t src)
+{
+	/* temporary tag value */
+	idft_reg_t tmp_tag = VCPU_GPR(thread_ctx, src) & VCPU_MASK8;
+
+	/* update the destination (ternary) */
+	VCPU_GPR_SET(thread_ctx, 7,
+		VCPU_GPR(thread_ctx, 7) | IDFT_EXT8L(tmp_tag, VCPU_MASK16));
+
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between among three 16-bit 
+ * registers as t[dst1] |= t[src] and t[dst2] |= t[src];
+ * dst1 is DX, dst2 is AX, and src is a 16-bit register 
+ * (e.g., CX, BX, ...)
+ *
+ * NOTE: special case for DIV and IDIV instructions
+ *
+ * @thread_ctx:	the thread context
+ * @src:	source register index (VCPU)
+ */
+IDFT_INLINE void
+idft_inline_r2r_ternary_opw(thread_ctx_t *thread_ctx, uint32_t src)
+{
+	/* temporary tag value */
+	idft_reg_t tmp_tag = VCPU_GPR(thread_ctx, src) & VCPU_MASK16;
+	
+	/* update the destinations */
+	VCPU_GPR_SET(thread_ctx, 5, VCPU_GPR(thread_ctx, 5) | tmp_tag);
+	VCPU_GPR_SET(thread_ctx, 7, VCPU_GPR(thread_ctx, 7) | tmp_tag);
+
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between among three 32-bit 
+ * registers as t[dst1] |= t[src] and t[dst2] |= t[src];
+ * dst1 is EDX, dst2 is EAX, and src is a 32-bit register
+ * (e.g., ECX, EBX, ...)
+ *
+ * NOTE: special case for DIV and IDIV instructions
+ *
+ * @thread_ctx:	the thread context
+ * @src:	source register index (VCPU)
+ */
+IDFT_INLINE void
+idft_inline_r2r_ternary_opl(thread_ctx_t *thread_ctx, uint32_t src)
+{ 
+	/* update the destinations */
+	VCPU_GPR_SET(thread_ctx, 5,
+		VCPU_GPR(thread_ctx, 5) | VCPU_GPR(thread_ctx, src));
+	VCPU_GPR_SET(thread_ctx, 7,
+		VCPU_GPR(thread_ctx, 7) | VCPU_GPR(thread_ctx, src));
+
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag among two 8-bit registers
+ * and an 8-bit memory location as t[dst] |= t[src];
+ * dst is AX, whereas src is an 8-bit memory location
+ *
+ * NOTE: special case for DIV and IDIV instructions
+ *
+ * @thread_ctx:	the thread context
+ * @src:	source memory address
+ */
+IDFT_INLINE void
+idft_inline_m2r_ternary_opb(thread_ctx_t *thread_ctx, ADDRINT src)
+{
+	/* temporary tag value */
+	idft_reg_t tmp_tag = 
+		(bitmap[VIRT2BYTE(src)] >> VIRT2BIT(src)) & VCPU_MASK8;
+	
+	/* update the destination (ternary) */
+	VCPU_GPR_SET(thread_ctx, 7,
+		VCPU_GPR(thread_ctx, 7) | IDFT_EXT8L(tmp_tag, VCPU_MASK16));
+
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag among two 16-bit registers
+ * and a 16-bit memory address as
+ * t[dst1] |= t[src] and t[dst1] |= t[src];
+ *
+ * dst1 is DX, dst2 is AX, and src is a 16-bit
+ * memory location
+ *
+ * NOTE: special case for DIV and IDIV instructions
+ *
+ * @thread_ctx:	the thread context
+ * @src:	source memory address
+ */
+IDFT_INLINE void
+idft_inline_m2r_ternary_opw(thread_ctx_t *thread_ctx, ADDRINT src)
+{
+	/* temporary tag value */
+	idft_reg_t tmp_tag = 
+		(*((uint16_t *)(bitmap + VIRT2BYTE(src))) >> VIRT2BIT(src)) &
+		VCPU_MASK16;
+	
+	/* update the destinations */
+	VCPU_GPR_SET(thread_ctx, 5, VCPU_GPR(thread_ctx, 5) | tmp_tag); 
+	VCPU_GPR_SET(thread_ctx, 7, VCPU_GPR(thread_ctx, 7) | tmp_tag); 
+
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag among two 32-bit 
+ * registers and a 32-bit memory as
+ * t[dst1] |= t[src] and t[dst2] |= t[src];
+ * dst1 is EDX, dst2 is EAX, and src is a 32-bit
+ * memory location
+ *
+ * NOTE: special case for DIV and IDIV instructions
+ *
+ * @thread_ctx:	the thread context
+ * @src:	source memory address
+ */
+IDFT_INLINE void
+idft_inline_m2r_ternary_opl(thread_ctx_t *thread_ctx, ADDRINT src)
+{
+	/* temporary tag value */
+	idft_reg_t tmp_tag = 
+		(*((uint16_t *)(bitmap + VIRT2BYTE(src))) >> VIRT2BIT(src)) &
+		VCPU_MASK32;
+
+	/* update the destinations */
+	VCPU_GPR_SET(thread_ctx, 5, VCPU_GPR(thread_ctx, 5) | tmp_tag);
+	VCPU_GPR_SET(thread_ctx, 7, VCPU_GPR(thread_ctx, 7) | tmp_tag);
+
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag among two 64-bit registers
+ * and a 64-bit memory location as
+ * t[dst1] |= t[src] and t[dst2] |= t[src];
+ * dst1 is RDX, dst2 is RAX
+ *
+ * NOTE: special case for MUL, IMUL, DIV and IDIV instructions
+ * (IDFT_X86_64; the 64-bit register forms use r2r_ternary_opl,
+ * which takes the whole source register)
+ *
+ * @thread_ctx:	the thread context
+ * @src:	source memory address
+ */
+IDFT_INLINE void
+idft_inline_m2r_ternary_opq(thread_ctx_t *thread_ctx, ADDRINT src)
+{
+	/* temporary tag value */
+	uint32_t tmp_tag = idft_gen_mem_load(src, VCPU_MASK64);
+
+	/* update the destinations */
+	VCPU_GPR_SET(thread_ctx, 5, VCPU_GPR(thread_ctx, 5) | tmp_tag);
+	VCPU_GPR_SET(thread_ctx, 7, VCPU_GPR(thread_ctx, 7) | tmp_tag);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between two registers, a memory location and a
+ * register, or a register and a memory location, as t[dst] |= t[src];
+ * the upper (u) and lower (l) 8-bit variants name the lane of the
+ * destination first (see idft_gen_r2r, idft_gen_m2r and idft_gen_r2m)
+ */
+IDFT_GEN_R2R(r2r_binary_opb_ul, IDFT_GEN_BINARY, VCPU_MASK8, IDFT_LANE_U, IDFT_LANE_L)
+IDFT_GEN_R2R(r2r_binary_opb_lu, IDFT_GEN_BINARY, VCPU_MASK8, IDFT_LANE_L, IDFT_LANE_U)
+IDFT_GEN_R2R(r2r_binary_opb_u, IDFT_GEN_BINARY, VCPU_MASK8, IDFT_LANE_U, IDFT_LANE_U)
+IDFT_GEN_R2R(r2r_binary_opb_l, IDFT_GEN_BINARY, VCPU_MASK8, IDFT_LANE_L, IDFT_LANE_L)
+IDFT_GEN_R2R(r2r_binary_opw, IDFT_GEN_BINARY, VCPU_MASK16, IDFT_LANE_L, IDFT_LANE_L)
+IDFT_GEN_R2R(r2r_binary_opl, IDFT_GEN_BINARY, VCPU_MASK32, IDFT_LANE_L, IDFT_LANE_L)
+IDFT_GEN_M2R(m2r_binary_opb_u, IDFT_GEN_BINARY, VCPU_MASK8, IDFT_LANE_U)
+IDFT_GEN_M2R(m2r_binary_opb_l, IDFT_GEN_BINARY, VCPU_MASK8, IDFT_LANE_L)
+IDFT_GEN_M2R(m2r_binary_opw, IDFT_GEN_BINARY, VCPU_MASK16, IDFT_LANE_L)
+IDFT_GEN_M2R(m2r_binary_opl, IDFT_GEN_BINARY, VCPU_MASK32, IDFT_LANE_L)
+IDFT_GEN_R2M(r2m_binary_opb_u, IDFT_GEN_BINARY, VCPU_MASK8, IDFT_LANE_U)
+IDFT_GEN_R2M(r2m_binary_opb_l, IDFT_GEN_BINARY, VCPU_MASK8, IDFT_LANE_L)
+IDFT_GEN_R2M(r2m_binary_opw, IDFT_GEN_BINARY, VCPU_MASK16, IDFT_LANE_L)
+IDFT_GEN_R2M(r2m_binary_opl, IDFT_GEN_BINARY, VCPU_MASK32, IDFT_LANE_L)
+IDFT_GEN_R2R(r2r_binary_opq, IDFT_GEN_BINARY, VCPU_MASK64, IDFT_LANE_L, IDFT_LANE_L)
+IDFT_GEN_M2R(m2r_binary_opq, IDFT_GEN_BINARY, VCPU_MASK64, IDFT_LANE_L)
+IDFT_GEN_R2M(r2m_binary_opq, IDFT_GEN_BINARY, VCPU_MASK64, IDFT_LANE_L)
+
+/*
+ * tag propagation (analysis function)
+ *
+ * clear the tag of EAX, EBX, ECX, EDX
+ *
+ * @thread_ctx:	the thread context
+ * @reg:	register index (VCPU) 
+ */
+IDFT_INLINE void
+idft_inline_r_clrl4(thread_ctx_t *thread_ctx)
+{
+	VCPU_GPR_SET(thread_ctx, 4, 0);
+	VCPU_GPR_SET(thread_ctx, 5, 0);
+	VCPU_GPR_SET(thread_ctx, 6, 0);
+	VCPU_GPR_SET(thread_ctx, 7, 0);
+
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * clear the tag of EAX, ECX, EDX
+ * (the caller-saved registers; see libicedft_filter.c)
+ *
+ * @thread_ctx:	the thread context
+ */
+IDFT_INLINE void
+idft_inline_r_clrl3(thread_ctx_t *thread_ctx)
+{
+	VCPU_GPR_SET(thread_ctx, 5, 0);
+	VCPU_GPR_SET(thread_ctx, 6, 0);
+	VCPU_GPR_SET(thread_ctx, 7, 0);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * clear the tag of EAX, EDX
+ *
+ * @thread_ctx:	the thread context
+ * @reg:	register index (VCPU) 
+ */
+IDFT_INLINE void
+idft_inline_r_clrl2(thread_ctx_t *thread_ctx)
+{
+	VCPU_GPR_SET(thread_ctx, 5, 0);
+	VCPU_GPR_SET(thread_ctx, 7, 0);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * clear the tag of a 16-bit register
+ *
+ * @thread_ctx:	the thread context
+ * @reg:	register index (VCPU) 
+ */
+IDFT_INLINE void
+idft_inline_r_clrl(thread_ctx_t *thread_ctx, uint32_t reg)
+{
+
+	VCPU_GPR_SET(thread_ctx, reg, 0);
+
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * clear the tag of a 16-bit register
+ *
+ * @thread_ctx:	the thread context
+ * @reg:	register index (VCPU) 
+ */
+IDFT_INLINE void
+idft_inline_r_clrw(thread_ctx_t *thread_ctx, uint32_t reg)
+{
+
+	VCPU_GPR_SET(thread_ctx, reg,
+		VCPU_GPR(thread_ctx, reg) & ~VCPU_MASK16);
+
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * clear the tag of an upper 8-bit register
+ *
+ * @thread_ctx:	the thread context
+ * @reg:	register index (VCPU) 
+ */
+IDFT_INLINE void
+idft_inline_r_clrb_u(thread_ctx_t *thread_ctx, uint32_t reg)
+{
+	VCPU_GPR_SET(thread_ctx, reg,
+		VCPU_GPR(thread_ctx, reg) & ~(VCPU_MASK8 << 1));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * clear the tag of a lower 8-bit register
+ *
+ * @thread_ctx:	the thread context
+ * @reg:	register index (VCPU) 
+ */
+IDFT_INLINE void
+idft_inline_r_clrb_l(thread_ctx_t *thread_ctx, uint32_t reg)
+{
+	VCPU_GPR_SET(thread_ctx, reg,
+		VCPU_GPR(thread_ctx, reg) & ~VCPU_MASK8);
+
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between two registers, a memory location and a
+ * register, or a register and a memory location, as t[dst] = t[src];
+ * the upper (u) and lower (l) 8-bit variants name the lane of the
+ * destination first (see idft_gen_r2r, idft_gen_m2r and idft_gen_r2m)
+ */
+IDFT_GEN_R2R(r2r_xfer_opb_ul, IDFT_GEN_XFER, VCPU_MASK8, IDFT_LANE_U, IDFT_LANE_L)
+IDFT_GEN_R2R(r2r_xfer_opb_lu, IDFT_GEN_XFER, VCPU_MASK8, IDFT_LANE_L, IDFT_LANE_U)
+IDFT_GEN_R2R(r2r_xfer_opb_u, IDFT_GEN_XFER, VCPU_MASK8, IDFT_LANE_U, IDFT_LANE_U)
+IDFT_GEN_R2R(r2r_xfer_opb_l, IDFT_GEN_XFER, VCPU_MASK8, IDFT_LANE_L, IDFT_LANE_L)
+IDFT_GEN_R2R(r2r_xfer_opw, IDFT_GEN_XFER, VCPU_MASK16, IDFT_LANE_L, IDFT_LANE_L)
+IDFT_GEN_R2R(r2r_xfer_opl, IDFT_GEN_XFER, VCPU_MASK32, IDFT_LANE_L, IDFT_LANE_L)
+IDFT_GEN_M2R(m2r_xfer_opb_u, IDFT_GEN_XFER, VCPU_MASK8, IDFT_LANE_U)
+IDFT_GEN_M2R(m2r_xfer_opb_l, IDFT_GEN_XFER, VCPU_MASK8, IDFT_LANE_L)
+IDFT_GEN_M2R(m2r_xfer_opw, IDFT_GEN_XFER, VCPU_MASK16, IDFT_LANE_L)
+IDFT_GEN_M2R(m2r_xfer_opl, IDFT_GEN_XFER, VCPU_MASK32, IDFT_LANE_L)
+IDFT_GEN_R2M(r2m_xfer_opb_u, IDFT_GEN_XFER, VCPU_MASK8, IDFT_LANE_U)
+IDFT_GEN_R2M(r2m_xfer_opb_l, IDFT_GEN_XFER, VCPU_MASK8, IDFT_LANE_L)
+IDFT_GEN_R2M(r2m_xfer_opw, IDFT_GEN_XFER, VCPU_MASK16, IDFT_LANE_L)
+IDFT_GEN_R2M(r2m_xfer_opl, IDFT_GEN_XFER, VCPU_MASK32, IDFT_LANE_L)
+IDFT_GEN_R2R(r2r_xfer_opq, IDFT_GEN_XFER, VCPU_MASK64, IDFT_LANE_L, IDFT_LANE_L)
+IDFT_GEN_M2R(m2r_xfer_opq, IDFT_GEN_XFER, VCPU_MASK64, IDFT_LANE_L)
+IDFT_GEN_R2M(r2m_xfer_opq, IDFT_GEN_XFER, VCPU_MASK64, IDFT_LANE_L)
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between two 16-bit 
+ * memory locations as t[dst] = t[src]
+ *
+ * @dst:	destination memory address
+ * @src:	source memory address
+ */
+IDFT_INLINE void
+idft_inline_m2m_xfer_opw(ADDRINT dst, ADDRINT src)
+{
+
+	*((uint16_t *)(bitmap + VIRT2BYTE(dst))) =
+		(*((uint16_t *)(bitmap + VIRT2BYTE(dst))) & ~(WORD_MASK <<
+							      VIRT2BIT(dst))) |
+		(((*((uint16_t *)(bitmap + VIRT2BYTE(src)))) >> VIRT2BIT(src))
+		& WORD_MASK) << VIRT2BIT(dst);
+
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between two 8-bit 
+ * memory locations as t[dst] = t[src]
+ *
+ * @dst:	destination memory address
+ * @src:	source memory address
+ */
+IDFT_INLINE void
+idft_inline_m2m_xfer_opb(ADDRINT dst, ADDRINT src)
+{
+	*((uint16_t *)(bitmap + VIRT2BYTE(dst))) =
+		(*((uint16_t *)(bitmap + VIRT2BYTE(dst))) & ~(BYTE_MASK <<
+							      VIRT2BIT(dst))) |
+		(((*((uint16_t *)(bitmap + VIRT2BYTE(src)))) >> VIRT2BIT(src))
+		& BYTE_MASK) << VIRT2BIT(dst);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between two 32-bit 
+ * memory locations as t[dst] = t[src]
+ *
+ * @dst:	destination memory address
+ * @src:	source memory address
+ */
+IDFT_INLINE void
+idft_inline_m2m_xfer_opl(ADDRINT dst, ADDRINT src)
+{
+	*((uint16_t *)(bitmap + VIRT2BYTE(dst))) =
+		(*((uint16_t *)(bitmap + VIRT2BYTE(dst))) & ~(LONG_MASK <<
+							      VIRT2BIT(dst))) |
+		(((*((uint16_t *)(bitmap + VIRT2BYTE(src)))) >> VIRT2BIT(src))
+		& LONG_MASK) << VIRT2BIT(dst);
+
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between two 64-bit 
+ * memory locations as t[dst] = t[src]
+ *
+ * @dst:	destination memory address
+ * @src:	source memory address
+ */
+IDFT_INLINE void
+idft_inline_m2m_xfer_opq(ADDRINT dst, ADDRINT src)
+{
+	*((uint16_t *)(bitmap + VIRT2BYTE(dst))) =
+		(*((uint16_t *)(bitmap + VIRT2BYTE(dst))) & ~(QUAD_MASK <<
+							      VIRT2BIT(dst))) |
+		(((*((uint16_t *)(bitmap + VIRT2BYTE(src)))) >> VIRT2BIT(src))
+		& QUAD_MASK) << VIRT2BIT(dst);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * instrumentation helper; returns the flag that
+ * takes as argument -- seems lame, but it is
+ * necessary for aiding conditional analysis to
+ * be inlined. Typically used with INS_InsertIfCall()
+ * in order to return true (i.e., allow the execution
+ * of the function that has been instrumented with
+ * INS_InsertThenCall()) only once
+ *
+ * first_iteration:	flag; indicates whether the rep-prefixed instruction is
+ * 			executed for the first time or not
+ */
+IDFT_INLINE ADDRINT
+idft_inline_rep_predicate(BOOL first_iteration)
+{
+	/* return the flag; typically this is true only once */
+	return first_iteration; 
+}
+
+/*
+ * the tags of the 8 general purpose registers, 4 bits each and
+ * in PUSHAD order (EDI in the lowest nibble); the register work
+ * of PUSHA/PUSHAD, done with one SSE2 pack where available (or
+ * a plain load of the USE_PACKED_VCPU layout)
+ *
+ * @thread_ctx:	the thread context
+ */
+IDFT_INLINE uint32_t
+idft_inline_gpr_pack(thread_ctx_t *thread_ctx)
+{
+#if defined(USE_PACKED_VCPU)
+	/* already in that order */
+	return (uint32_t)thread_ctx->vcpu.gpr;
+#elif defined(__SSE2__)
+	__m128i m = _mm_set1_epi32(VCPU_MASK32);
+	__m128i lo = _mm_and_si128(m,
+		_mm_loadu_si128((const __m128i *)&thread_ctx->vcpu.gpr[0]));
+	__m128i hi = _mm_and_si128(m,
+		_mm_loadu_si128((const __m128i *)&thread_ctx->vcpu.gpr[4]));
+
+	/* one tag per byte */
+	__m128i b = _mm_packus_epi16(_mm_packs_epi32(lo, hi),
+			_mm_setzero_si128());
+
+	/* two tags per byte; t[2k] | t[2k + 1] << 4 */
+	b = _mm_and_si128(_mm_or_si128(b, _mm_srli_epi16(b, 4)),
+			_mm_set1_epi16(0x00FF));
+
+	return (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(b, b));
+#else
+	uint32_t tags = 0, i;
+
+	for (i = 0; i < 8; i++)
+		tags |= (VCPU_GPR(thread_ctx, i) & VCPU_MASK32) << (i << 2);
+
+	return tags;
+#endif
+}
+
+/*
+ * the inverse of idft_inline_gpr_pack; the register work of
+ * POPA/POPAD. ESP is not restored, and only the bits of each
+ * register that are not in keep are replaced
+ *
+ * @thread_ctx:	the thread context
+ * @tags:	the packed tags
+ * @keep:	the register tag bits to preserve
+ */
+IDFT_INLINE void
+idft_inline_gpr_unpack(thread_ctx_t *thread_ctx, uint32_t tags, uint32_t keep)
+{
+#if defined(USE_PACKED_VCPU)
+	/* the bits to keep; ESP and the scratch register as a whole */
+	uint64_t k = ((keep & VCPU_MASK32) * 0x11111111U) |
+		((uint64_t)VCPU_MASK32 << (GPR_ESP << 2)) | ~0xFFFFFFFFULL;
+
+	thread_ctx->vcpu.gpr = (thread_ctx->vcpu.gpr & k) | (tags & ~k);
+#else
+	/* ESP is not popped */
+	uint32_t esp = VCPU_GPR(thread_ctx, GPR_ESP);
+#if defined(__SSE2__)
+	__m128i z = _mm_setzero_si128();
+	__m128i k = _mm_set1_epi32(keep);
+	__m128i m = _mm_set1_epi8(0x0F);
+	__m128i v = _mm_cvtsi32_si128((int)tags);
+
+	/* one tag per byte, then per 32-bit lane */
+	__m128i b = _mm_unpacklo_epi8(_mm_and_si128(v, m),
+			_mm_and_si128(_mm_srli_epi16(v, 4), m));
+	__m128i w = _mm_unpacklo_epi8(b, z);
+
+	__m128i *gpr = (__m128i *)thread_ctx->vcpu.gpr;
+
+	_mm_storeu_si128(&gpr[0], _mm_or_si128(_mm_unpacklo_epi16(w, z),
+			_mm_and_si128(_mm_loadu_si128(&gpr[0]), k)));
+	_mm_storeu_si128(&gpr[1], _mm_or_si128(_mm_unpackhi_epi16(w, z),
+			_mm_and_si128(_mm_loadu_si128(&gpr[1]), k)));
+#else
+	uint32_t i;
+
+	for (i = 0; i < 8; i++)
+		VCPU_GPR_SET(thread_ctx, i, (VCPU_GPR(thread_ctx, i) & keep) |
+			((tags >> (i << 2)) & VCPU_MASK32));
+#endif
+	VCPU_GPR_SET(thread_ctx, GPR_ESP, esp);
+#endif
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * restore the tag values for all the
+ * 16-bit general purpose registers from
+ * the memory; the 16 bytes are read at
+ * once and spread 2 bits per register
+ *
+ * NOTE: special case for POPA instruction 
+ *
+ * @thread_ctx:	the thread context
+ * @src:	the source memory address	
+ */
+IDFT_INLINE void
+idft_inline_m2r_restore_opw(thread_ctx_t *thread_ctx, ADDRINT src)
+{
+	/* tagmap value; 16 bits, from any bit offset */
+	uint32_t tags = (*(uint32_t *)(bitmap + VIRT2BYTE(src)) >>
+			VIRT2BIT(src)) & 0xFFFF;
+
+	/* 2 bits per register -> 4 bits per register */
+	tags = (tags | (tags << 8)) & 0x00FF00FF;
+	tags = (tags | (tags << 4)) & 0x0F0F0F0F;
+	tags = (tags | (tags << 2)) & 0x33333333;
+
+	idft_inline_gpr_unpack(thread_ctx, tags, ~VCPU_MASK16);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * restore the tag values for all the
+ * 32-bit general purpose registers from
+ * the memory; the 32 bytes are read with
+ * one 64-bit tagmap access
+ *
+ * NOTE: special case for POPAD instruction 
+ *
+ * @thread_ctx:	the thread context
+ * @src:	the source memory address	
+ */
+IDFT_INLINE void
+idft_inline_m2r_restore_opl(thread_ctx_t *thread_ctx, ADDRINT src)
+{
+	idft_inline_gpr_unpack(thread_ctx,
+		(uint32_t)(*(uint64_t *)(bitmap + VIRT2BYTE(src)) >>
+			VIRT2BIT(src)), 0);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * save the tag values for all the 16-bit
+ * general purpose registers into the memory;
+ * the 16 bytes are written at once
+ *
+ * NOTE: special case for PUSHA instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	the destination memory address
+ */
+IDFT_INLINE void
+idft_inline_r2m_save_opw(thread_ctx_t *thread_ctx, ADDRINT dst)
+{
+	/* 4 bits per register -> 2 bits per register */
+	uint32_t tags = idft_inline_gpr_pack(thread_ctx) & 0x33333333;
+
+	tags = (tags | (tags >> 2)) & 0x0F0F0F0F;
+	tags = (tags | (tags >> 4)) & 0x00FF00FF;
+	tags = (tags | (tags >> 8)) & 0x0000FFFF;
+
+	*((uint32_t *)(bitmap + VIRT2BYTE(dst))) =
+		(*((uint32_t *)(bitmap + VIRT2BYTE(dst))) &
+		 ~(0xFFFFU << VIRT2BIT(dst))) | (tags << VIRT2BIT(dst));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * save the tag values for all the 32-bit
+ * general purpose registers into the memory;
+ * the 32 bytes are written with one 64-bit
+ * tagmap access
+ *
+ * NOTE: special case for PUSHAD instruction 
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	the destination memory address
+ */
+IDFT_INLINE void
+idft_inline_r2m_save_opl(thread_ctx_t *thread_ctx, ADDRINT dst)
+{
+	*((uint64_t *)(bitmap + VIRT2BYTE(dst))) =
+		(*((uint64_t *)(bitmap + VIRT2BYTE(dst))) &
+		 ~(0xFFFFFFFFULL << VIRT2BIT(dst))) |
+		((uint64_t)idft_inline_gpr_pack(thread_ctx) << VIRT2BIT(dst));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * leave, or mov esp, ebp; pop ebp
+ *
+ * @thread_ctx:	the thread context
+ * @ea:		the slot of EBP
+ */
+IDFT_INLINE void
+idft_inline_leave(thread_ctx_t *thread_ctx, ADDRINT ea)
+{
+	VCPU_GPR_SET(thread_ctx, GPR_ESP, VCPU_GPR(thread_ctx, GPR_EBP));
+
+	VCPU_GPR_SET(thread_ctx, GPR_EBP,
+		(*((uint16_t *)(bitmap + VIRT2BYTE(ea))) >> VIRT2BIT(ea)) &
+		VCPU_MASK32);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * register to register, as described by an argument pack
+ * (see libicedft_argpack.c); covers copies, unions, zero
+ * and sign extension, and clears (mul = 0)
+ *
+ * @thread_ctx:	the thread context
+ * @pack:	the argument pack
+ */
+IDFT_INLINE void
+idft_inline_argpack_r2r(thread_ctx_t *thread_ctx, const idft_argpack_t *pack)
+{
+	uint32_t v = ((VCPU_GPR(thread_ctx, pack->src) >> pack->sshift) &
+			pack->smask) * pack->mul;
+
+	VCPU_GPR_SET(thread_ctx, pack->dst,
+		(VCPU_GPR(thread_ctx, pack->dst) & ~(uint32_t)pack->dclr) |
+		(v << pack->dshift));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * memory to register, as described by an argument pack
+ *
+ * @thread_ctx:	the thread context
+ * @pack:	the argument pack
+ * @src:	the source memory address
+ */
+IDFT_INLINE void
+idft_inline_argpack_m2r(thread_ctx_t *thread_ctx, const idft_argpack_t *pack,
+		ADDRINT src)
+{
+	uint32_t v = ((*((uint16_t *)(bitmap + VIRT2BYTE(src))) >>
+			VIRT2BIT(src)) & pack->smask) * pack->mul;
+
+	VCPU_GPR_SET(thread_ctx, pack->dst,
+		(VCPU_GPR(thread_ctx, pack->dst) & ~(uint32_t)pack->dclr) |
+		(v << pack->dshift));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * register to memory, as described by an argument pack
+ *
+ * @thread_ctx:	the thread context
+ * @pack:	the argument pack
+ * @dst:	the destination memory address
+ */
+IDFT_INLINE void
+idft_inline_argpack_r2m(thread_ctx_t *thread_ctx, const idft_argpack_t *pack,
+		ADDRINT dst)
+{
+	uint32_t v = ((VCPU_GPR(thread_ctx, pack->src) >> pack->sshift) &
+			pack->smask) * pack->mul;
+
+	*((uint16_t *)(bitmap + VIRT2BYTE(dst))) =
+		(*((uint16_t *)(bitmap + VIRT2BYTE(dst))) &
+		 ~((uint16_t)pack->dclr << VIRT2BIT(dst))) |
+		((uint16_t)v << VIRT2BIT(dst));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * a coalesced group of loads and stores relative to one
+ * base register (see libicedft_coalesce.c); the tags of
+ * the whole window are read, updated and written once
+ *
+ * @thread_ctx:	the thread context
+ * @group:	the group
+ * @ea:		the address of its first access
+ */
+IDFT_INLINE void
+idft_inline_mem_group(thread_ctx_t *thread_ctx, const idft_memgroup_t *group,
+		ADDRINT ea)
+{
+	ADDRINT lo = ea + group->lo;
+	uint64_t old = *((uint64_t *)(bitmap + VIRT2BYTE(lo)));
+	uint64_t win = old >> VIRT2BIT(lo);
+	uint64_t mask, v;
+	const idft_argpack_t *pack;
+	uint32_t i;
+
+	/* in program order; loads see the stores before them */
+	for (i = 0; i < group->n; i++) {
+		pack = &group->ops[i];
+		if (group->stores & (1U << i)) {
+			v = ((VCPU_GPR(thread_ctx, pack->src) >> pack->sshift) &
+				pack->smask) * pack->mul;
+			win = (win & ~((uint64_t)pack->dclr << pack->dshift)) |
+				(v << pack->dshift);
+		}
+		else {
+			v = ((win >> pack->sshift) & pack->smask) * pack->mul;
+			VCPU_GPR_SET(thread_ctx, pack->dst,
+				(VCPU_GPR(thread_ctx, pack->dst) &
+				 ~(uint32_t)pack->dclr) |
+				((uint32_t)v << pack->dshift));
+		}
+	}
+
+	if (group->stores) {
+		mask = ((1ULL << group->span) - 1) << VIRT2BIT(lo);
+		*((uint64_t *)(bitmap + VIRT2BYTE(lo))) =
+			(old & ~mask) | ((win << VIRT2BIT(lo)) & mask);
+	}
+}
+
+/*
+ * evaluate an x86 condition code without branches
+ *
+ * @eflags:	the EFLAGS value
+ * @cc:		the condition code (the low nibble of the Jcc,
+ *		SETcc and CMOVcc opcodes; e.g., 0x4 for Z)
+ *
+ * returns: ~0 if the condition holds, 0 otherwise
+ */
+IDFT_INLINE uint32_t
+idft_inline_cc_mask(ADDRINT eflags, uint32_t cc)
+{
+	uint32_t cf = eflags & 1, pf = (eflags >> 2) & 1,
+		 zf = (eflags >> 6) & 1, sf = (eflags >> 7) & 1,
+		 of = (eflags >> 11) & 1;
+
+	/* the even codes, in order: O B Z BE S P L LE */
+	uint32_t even = of | (cf << 1) | (zf << 2) | ((cf | zf) << 3) |
+		(sf << 4) | (pf << 5) | ((sf ^ of) << 6) |
+		(((sf ^ of) | zf) << 7);
+
+	/* the odd codes negate them */
+	return 0U - (((even >> (cc >> 1)) & 1) ^ (cc & 1));
+}
+
+/*
+ * the tags of a 32-bit CMOVcc destination that are kept if the
+ * condition does not hold; with IDFT_X86_64 the write zero-extends
+ * the register either way (see idft_gen_reg_merge)
+ */
+#ifdef IDFT_X86_64
+#define IDFT_CMOV_KEEP	VCPU_MASK32
+#else
+#define IDFT_CMOV_KEEP	(~0U)
+#endif
+
+/*
+ * tag propagation (analysis function)
+ *
+ * cmovcc r32, r32; the tag is moved iff the condition
+ * holds, with a mask instead of a predicated call
+ *
+ * @thread_ctx:	the thread context
+ * @cc:		the condition code (see idft_inline_cc_mask)
+ * @eflags:	the EFLAGS value
+ * @dst:	the destination register
+ * @src:	the source register
+ */
+IDFT_INLINE void
+idft_inline_cmov_r2r_opl(thread_ctx_t *thread_ctx, uint32_t cc, ADDRINT eflags,
+		uint32_t dst, uint32_t src)
+{
+	uint32_t m = idft_inline_cc_mask(eflags, cc) & VCPU_MASK32;
+
+	VCPU_GPR_SET(thread_ctx, dst, (VCPU_GPR(thread_ctx, dst) & IDFT_CMOV_KEEP &
+		~m) | (VCPU_GPR(thread_ctx, src) & m));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * cmovcc r16, r16
+ *
+ * (arguments as in idft_inline_cmov_r2r_opl)
+ */
+IDFT_INLINE void
+idft_inline_cmov_r2r_opw(thread_ctx_t *thread_ctx, uint32_t cc, ADDRINT eflags,
+		uint32_t dst, uint32_t src)
+{
+	uint32_t m = idft_inline_cc_mask(eflags, cc) & VCPU_MASK16;
+
+	VCPU_GPR_SET(thread_ctx, dst, (VCPU_GPR(thread_ctx, dst) & ~m) |
+		(VCPU_GPR(thread_ctx, src) & m));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * cmovcc r32, m32
+ *
+ * NOTE: the source is read whether the condition holds
+ * or not, as the instruction itself does
+ *
+ * @thread_ctx:	the thread context
+ * @cc:		the condition code (see idft_inline_cc_mask)
+ * @eflags:	the EFLAGS value
+ * @dst:	the destination register
+ * @src:	the source memory address
+ */
+IDFT_INLINE void
+idft_inline_cmov_m2r_opl(thread_ctx_t *thread_ctx, uint32_t cc, ADDRINT eflags,
+		uint32_t dst, ADDRINT src)
+{
+	uint32_t m = idft_inline_cc_mask(eflags, cc) & VCPU_MASK32;
+
+	VCPU_GPR_SET(thread_ctx, dst, (VCPU_GPR(thread_ctx, dst) & IDFT_CMOV_KEEP &
+		~m) | ((*((uint16_t *)(bitmap + VIRT2BYTE(src))) >>
+		VIRT2BIT(src)) & m));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * cmovcc r16, m16
+ *
+ * (arguments as in idft_inline_cmov_m2r_opl)
+ */
+IDFT_INLINE void
+idft_inline_cmov_m2r_opw(thread_ctx_t *thread_ctx, uint32_t cc, ADDRINT eflags,
+		uint32_t dst, ADDRINT src)
+{
+	uint32_t m = idft_inline_cc_mask(eflags, cc) & VCPU_MASK16;
+
+	VCPU_GPR_SET(thread_ctx, dst, (VCPU_GPR(thread_ctx, dst) & ~m) |
+		((*((uint16_t *)(bitmap + VIRT2BYTE(src))) >> VIRT2BIT(src)) &
+		 m));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * cmovcc r64, r64 and cmovcc r64, m64 (IDFT_X86_64)
+ *
+ * (arguments as in idft_inline_cmov_r2r_opl and
+ * idft_inline_cmov_m2r_opl)
+ */
+IDFT_INLINE void
+idft_inline_cmov_r2r_opq(thread_ctx_t *thread_ctx, uint32_t cc, ADDRINT eflags,
+		uint32_t dst, uint32_t src)
+{
+	uint32_t m = idft_inline_cc_mask(eflags, cc) & VCPU_MASK64;
+
+	VCPU_GPR_SET(thread_ctx, dst, (VCPU_GPR(thread_ctx, dst) & ~m) |
+		(VCPU_GPR(thread_ctx, src) & m));
+}
+
+IDFT_INLINE void
+idft_inline_cmov_m2r_opq(thread_ctx_t *thread_ctx, uint32_t cc, ADDRINT eflags,
+		uint32_t dst, ADDRINT src)
+{
+	uint32_t m = idft_inline_cc_mask(eflags, cc) & VCPU_MASK64;
+
+	VCPU_GPR_SET(thread_ctx, dst, (VCPU_GPR(thread_ctx, dst) & ~m) |
+		((*((uint16_t *)(bitmap + VIRT2BYTE(src))) >> VIRT2BIT(src)) &
+		 m));
+}
+
+/*
+ * shadow prefetching (analysis function)
+ *
+ * fetch the tagmap lines of the accesses a block is about
+ * to make (see libicedft_prefetch.c); each address is a
+ * base register value, as of block entry, plus a
+ * displacement. A hint only; wrong guesses are harmless
+ *
+ * @a, b, c:	base register values
+ * @da, db, dc:	displacements (signed; sign-extended with
+ *		IDFT_X86_64)
+ */
+IDFT_INLINE void
+idft_inline_shadow_prefetch1(ADDRINT a, uint32_t da)
+{
+	IDFT_PREFETCH(bitmap + VIRT2BYTE((ADDRINT)(a + (int32_t)da)));
+}
+
+IDFT_INLINE void
+idft_inline_shadow_prefetch2(ADDRINT a, uint32_t da, ADDRINT b, uint32_t db)
+{
+	IDFT_PREFETCH(bitmap + VIRT2BYTE((ADDRINT)(a + (int32_t)da)));
+	IDFT_PREFETCH(bitmap + VIRT2BYTE((ADDRINT)(b + (int32_t)db)));
+}
+
+IDFT_INLINE void
+idft_inline_shadow_prefetch3(ADDRINT a, uint32_t da, ADDRINT b, uint32_t db,
+		ADDRINT c, uint32_t dc)
+{
+	IDFT_PREFETCH(bitmap + VIRT2BYTE((ADDRINT)(a + (int32_t)da)));
+	IDFT_PREFETCH(bitmap + VIRT2BYTE((ADDRINT)(b + (int32_t)db)));
+	IDFT_PREFETCH(bitmap + VIRT2BYTE((ADDRINT)(c + (int32_t)dc)));
+}
+
+/*
+ * the tags of the n <= 32 bytes at addr (mask: VCPU_MASK256 or
+ * less); one shadow load, 32-bit up to XMM width and 64-bit for
+ * YMM width, whatever the bit offset of addr
+ */
+IDFT_INLINE uint32_t
+idft_gen_vec_load(ADDRINT addr, uint32_t mask)
+{
+	if (mask == VCPU_MASK256)
+		return (uint32_t)(*(uint64_t *)(bitmap + VIRT2BYTE(addr)) >>
+				VIRT2BIT(addr));
+
+	return (*(uint32_t *)(bitmap + VIRT2BYTE(addr)) >> VIRT2BIT(addr)) &
+		mask;
+}
+
+/* the inverse of idft_gen_vec_load; one shadow read-modify-write */
+IDFT_INLINE void
+idft_gen_vec_store(ADDRINT addr, uint32_t mask, uint32_t tag)
+{
+	if (mask == VCPU_MASK256)
+		*((uint64_t *)(bitmap + VIRT2BYTE(addr))) =
+			(*((uint64_t *)(bitmap + VIRT2BYTE(addr))) &
+			 ~((uint64_t)VCPU_MASK256 << VIRT2BIT(addr))) |
+			((uint64_t)tag << VIRT2BIT(addr));
+	else
+		*((uint32_t *)(bitmap + VIRT2BYTE(addr))) =
+			(*((uint32_t *)(bitmap + VIRT2BYTE(addr))) &
+			 ~(mask << VIRT2BIT(addr))) |
+			((tag & mask) << VIRT2BIT(addr));
+}
+
+/*
+ * the tag of a 32-bit register that holds the byte mask of a
+ * vector register (PMOVMSKB); bit k of the mask comes from byte k
+ */
+IDFT_INLINE uint32_t
+idft_gen_vec_msk(uint32_t tag)
+{
+	tag |= tag >> 4;
+	tag |= tag >> 2;
+	tag |= tag >> 1;
+
+	return (tag & 0x01) | ((tag >> 7) & 0x02) | ((tag >> 14) & 0x04) |
+		((tag >> 21) & 0x08);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * legacy SSE moves; t[dst] = t[src] over 16 (opx), 8 (opq) or 4
+ * (opl) bytes. An XMM destination is zero-extended to 128 bits,
+ * and the upper half of its YMM register is left as is
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (XMM) or memory address
+ * @src:	source register index (XMM) or memory address
+ */
+IDFT_INLINE void
+idft_inline_xmm_r2r_xfer_opx(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	thread_ctx->vcpu.xmm[dst] = (thread_ctx->vcpu.xmm[dst] & ~VCPU_MASK128) |
+		(thread_ctx->vcpu.xmm[src] & VCPU_MASK128);
+}
+
+IDFT_INLINE void
+idft_inline_xmm_r2r_xfer_opq(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	thread_ctx->vcpu.xmm[dst] = (thread_ctx->vcpu.xmm[dst] & ~VCPU_MASK128) |
+		(thread_ctx->vcpu.xmm[src] & VCPU_MASK64);
+}
+
+IDFT_INLINE void
+idft_inline_xmm_m2r_xfer_opx(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+{
+	thread_ctx->vcpu.xmm[dst] = (thread_ctx->vcpu.xmm[dst] & ~VCPU_MASK128) |
+		idft_gen_vec_load(src, VCPU_MASK128);
+}
+
+IDFT_INLINE void
+idft_inline_xmm_m2r_xfer_opq(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+{
+	thread_ctx->vcpu.xmm[dst] = (thread_ctx->vcpu.xmm[dst] & ~VCPU_MASK128) |
+		idft_gen_vec_load(src, VCPU_MASK64);
+}
+
+IDFT_INLINE void
+idft_inline_xmm_m2r_xfer_opl(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+{
+	thread_ctx->vcpu.xmm[dst] = (thread_ctx->vcpu.xmm[dst] & ~VCPU_MASK128) |
+		idft_gen_vec_load(src, VCPU_MASK32);
+}
+
+IDFT_INLINE void
+idft_inline_xmm_r2m_xfer_opx(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
+{
+	idft_gen_vec_store(dst, VCPU_MASK128, thread_ctx->vcpu.xmm[src]);
+}
+
+IDFT_INLINE void
+idft_inline_xmm_r2m_xfer_opq(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
+{
+	idft_gen_vec_store(dst, VCPU_MASK64, thread_ctx->vcpu.xmm[src]);
+}
+
+IDFT_INLINE void
+idft_inline_xmm_r2m_xfer_opl(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
+{
+	idft_gen_vec_store(dst, VCPU_MASK32, thread_ctx->vcpu.xmm[src]);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * MOVD between a 32-bit register and an XMM register; the
+ * r2x direction zero-extends the XMM register (as above)
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (XMM for r2x, VCPU for x2r)
+ * @src:	source register index (VCPU for r2x, XMM for x2r)
+ */
+IDFT_INLINE void
+idft_inline_xmm_r2x_xfer_opl(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	thread_ctx->vcpu.xmm[dst] = (thread_ctx->vcpu.xmm[dst] & ~VCPU_MASK128) |
+		(VCPU_GPR(thread_ctx, src) & VCPU_MASK32);
+}
+
+IDFT_INLINE void
+idft_inline_xmm_x2r_xfer_opl(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	VCPU_GPR_SET(thread_ctx, dst, thread_ctx->vcpu.xmm[src] & VCPU_MASK32);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * PMOVMSKB; t[dst] = the byte mask of the XMM (opx) or YMM (opy)
+ * register src
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (XMM)
+ */
+IDFT_INLINE void
+idft_inline_xmm_x2r_mask_opx(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	VCPU_GPR_SET(thread_ctx, dst,
+		idft_gen_vec_msk(thread_ctx->vcpu.xmm[src] & VCPU_MASK128));
+}
+
+IDFT_INLINE void
+idft_inline_ymm_x2r_mask_opy(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	VCPU_GPR_SET(thread_ctx, dst,
+		idft_gen_vec_msk(thread_ctx->vcpu.xmm[src]));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * legacy SSE logic and compare operations (PAND, PXOR, PCMPEQB,
+ * ...); t[dst] |= t[src] over 16 bytes
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (XMM)
+ * @src:	source register index (XMM) or memory address
+ */
+IDFT_INLINE void
+idft_inline_xmm_r2r_binary_opx(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	thread_ctx->vcpu.xmm[dst] |= thread_ctx->vcpu.xmm[src] & VCPU_MASK128;
+}
+
+IDFT_INLINE void
+idft_inline_xmm_m2r_binary_opx(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+{
+	thread_ctx->vcpu.xmm[dst] |= idft_gen_vec_load(src, VCPU_MASK128);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * clear the tag of an XMM register (legacy SSE zero idioms;
+ * e.g., PXOR xmm0, xmm0) or of a whole YMM register (VEX ones)
+ *
+ * @thread_ctx:	the thread context
+ * @reg:	register index (XMM)
+ */
+IDFT_INLINE void
+idft_inline_xmm_clr_opx(thread_ctx_t *thread_ctx, uint32_t reg)
+{
+	thread_ctx->vcpu.xmm[reg] &= ~VCPU_MASK128;
+}
+
+IDFT_INLINE void
+idft_inline_ymm_clr_opy(thread_ctx_t *thread_ctx, uint32_t reg)
+{
+	thread_ctx->vcpu.xmm[reg] = 0;
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * VZEROUPPER and VZEROALL
+ *
+ * @thread_ctx:	the thread context
+ */
+IDFT_INLINE void
+idft_inline_ymm_clr_upper(thread_ctx_t *thread_ctx)
+{
+	uint32_t i;
+
+	for (i = 0; i < XMM_NUM; i++)
+		thread_ctx->vcpu.xmm[i] &= VCPU_MASK128;
+}
+
+IDFT_INLINE void
+idft_inline_ymm_clr_all(thread_ctx_t *thread_ctx)
+{
+	uint32_t i;
+
+	for (i = 0; i < XMM_NUM; i++)
+		thread_ctx->vcpu.xmm[i] = 0;
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * VEX-encoded moves; t[dst] = t[src] over 16 (opx) or 32 (opy)
+ * bytes. A 128-bit destination register clears the upper half
+ * of its YMM register
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (XMM) or memory address
+ * @src:	source register index (XMM) or memory address
+ */
+IDFT_INLINE void
+idft_inline_ymm_r2r_xfer_opx(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	thread_ctx->vcpu.xmm[dst] = thread_ctx->vcpu.xmm[src] & VCPU_MASK128;
+}
+
+IDFT_INLINE void
+idft_inline_ymm_r2r_xfer_opy(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	thread_ctx->vcpu.xmm[dst] = thread_ctx->vcpu.xmm[src];
+}
+
+IDFT_INLINE void
+idft_inline_ymm_m2r_xfer_opx(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+{
+	thread_ctx->vcpu.xmm[dst] = idft_gen_vec_load(src, VCPU_MASK128);
+}
+
+IDFT_INLINE void
+idft_inline_ymm_m2r_xfer_opy(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+{
+	thread_ctx->vcpu.xmm[dst] = idft_gen_vec_load(src, VCPU_MASK256);
+}
+
+IDFT_INLINE void
+idft_inline_ymm_r2m_xfer_opy(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
+{
+	idft_gen_vec_store(dst, VCPU_MASK256, thread_ctx->vcpu.xmm[src]);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * VEX-encoded logic and compare operations (VPAND, VPXOR,
+ * VPCMPEQB, ...); t[dst] = t[src1] | t[src2] over 16 (opx) or
+ * 32 (opy) bytes, with the upper half cleared for opx
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (XMM)
+ * @src1:	first source register index (XMM)
+ * @src2:	second source register index (XMM) or memory address
+ */
+IDFT_INLINE void
+idft_inline_ymm_rr2r_binary_opx(thread_ctx_t *thread_ctx, uint32_t dst,
+		uint32_t src1, uint32_t src2)
+{
+	thread_ctx->vcpu.xmm[dst] = (thread_ctx->vcpu.xmm[src1] |
+		thread_ctx->vcpu.xmm[src2]) & VCPU_MASK128;
+}
+
+IDFT_INLINE void
+idft_inline_ymm_rr2r_binary_opy(thread_ctx_t *thread_ctx, uint32_t dst,
+		uint32_t src1, uint32_t src2)
+{
+	thread_ctx->vcpu.xmm[dst] = thread_ctx->vcpu.xmm[src1] |
+		thread_ctx->vcpu.xmm[src2];
+}
+
+IDFT_INLINE void
+idft_inline_ymm_rm2r_binary_opx(thread_ctx_t *thread_ctx, uint32_t dst,
+		uint32_t src1, ADDRINT src2)
+{
+	thread_ctx->vcpu.xmm[dst] = (thread_ctx->vcpu.xmm[src1] &
+		VCPU_MASK128) | idft_gen_vec_load(src2, VCPU_MASK128);
+}
+
+IDFT_INLINE void
+idft_inline_ymm_rm2r_binary_opy(thread_ctx_t *thread_ctx, uint32_t dst,
+		uint32_t src1, ADDRINT src2)
+{
+	thread_ctx->vcpu.xmm[dst] = thread_ctx->vcpu.xmm[src1] |
+		idft_gen_vec_load(src2, VCPU_MASK256);
+}
+
+/*
+ * the routines above; X(out-of-line routine, inline name, flags)
+ * for each, with flags in addition to IDFT_HANDLER_INLINE
+ */
+#define IDFT_INLINE_HANDLERS(X)		\
+	X(_cwde, cwde, 0) \
+	X(_movsx_r2r_opwb_u, movsx_r2r_opwb_u, 0) \
+	X(_movsx_r2r_opwb_l, movsx_r2r_opwb_l, 0) \
+	X(_movsx_r2r_oplb_u, movsx_r2r_oplb_u, 0) \
+	X(_movsx_r2r_oplb_l, movsx_r2r_oplb_l, 0) \
+	X(_movsx_r2r_oplw, movsx_r2r_oplw, 0) \
+	X(_movsx_m2r_opwb, movsx_m2r_opwb, 0) \
+	X(_movsx_m2r_oplb, movsx_m2r_oplb, 0) \
+	X(_movsx_m2r_oplw, movsx_m2r_oplw, 0) \
+	X(_movzx_r2r_opwb_u, movzx_r2r_opwb_u, 0) \
+	X(_movzx_r2r_opwb_l, movzx_r2r_opwb_l, 0) \
+	X(_movzx_r2r_oplb_u, movzx_r2r_oplb_u, 0) \
+	X(_movzx_r2r_oplb_l, movzx_r2r_oplb_l, 0) \
+	X(_movzx_r2r_oplw, movzx_r2r_oplw, 0) \
+	X(_movzx_m2r_opwb, movzx_m2r_opwb, 0) \
+	X(_movzx_m2r_oplb, movzx_m2r_oplb, 0) \
+	X(_movzx_m2r_oplw, movzx_m2r_oplw, 0) \
+	X(_cmpxchg_r2r_opl_fast, cmpxchg_r2r_opl_fast, IDFT_HANDLER_PREDICATE) \
+	X(_cmpxchg_r2r_opl_slow, cmpxchg_r2r_opl_slow, 0) \
+	X(_cmpxchg_r2r_opw_fast, cmpxchg_r2r_opw_fast, IDFT_HANDLER_PREDICATE) \
+	X(_cmpxchg_r2r_opw_slow, cmpxchg_r2r_opw_slow, 0) \
+	X(_cmpxchg_m2r_opl_fast, cmpxchg_m2r_opl_fast, IDFT_HANDLER_PREDICATE) \
+	X(_cmpxchg_r2m_opl_slow, cmpxchg_r2m_opl_slow, 0) \
+	X(_cmpxchg_m2r_opw_fast, cmpxchg_m2r_opw_fast, IDFT_HANDLER_PREDICATE) \
+	X(_cmpxchg_r2m_opw_slow, cmpxchg_r2m_opw_slow, 0) \
+	X(_xchg_r2r_opb_ul, xchg_r2r_opb_ul, 0) \
+	X(_xchg_r2r_opb_lu, xchg_r2r_opb_lu, 0) \
+	X(_xchg_r2r_opb_u, xchg_r2r_opb_u, 0) \
+	X(_xchg_r2r_opb_l, xchg_r2r_opb_l, 0) \
+	X(_xchg_r2r_opw, xchg_r2r_opw, 0) \
+	X(_xchg_m2r_opb_u, xchg_m2r_opb_u, 0) \
+	X(_xchg_m2r_opb_l, xchg_m2r_opb_l, 0) \
+	X(_xchg_m2r_opw, xchg_m2r_opw, 0) \
+	X(_xchg_m2r_opl, xchg_m2r_opl, 0) \
+	X(_xadd_r2r_opb_ul, xadd_r2r_opb_ul, 0) \
+	X(_xadd_r2r_opb_lu, xadd_r2r_opb_lu, 0) \
+	X(_xadd_r2r_opb_u, xadd_r2r_opb_u, 0) \
+	X(_xadd_r2r_opb_l, xadd_r2r_opb_l, 0) \
+	X(_xadd_r2r_opw, xadd_r2r_opw, 0) \
+	X(_xadd_m2r_opb_u, xadd_m2r_opb_u, 0) \
+	X(_xadd_m2r_opb_l, xadd_m2r_opb_l, 0) \
+	X(_xadd_m2r_opw, xadd_m2r_opw, 0) \
+	X(_xadd_m2r_opl, xadd_m2r_opl, 0) \
+	X(_lea_r2r_opw, lea_r2r_opw, 0) \
+	X(_lea_r2r_opl, lea_r2r_opl, 0) \
+	X(r2r_ternary_opb_u, r2r_ternary_opb_u, 0) \
+	X(r2r_ternary_opb_l, r2r_ternary_opb_l, 0) \
+	X(r2r_ternary_opw, r2r_ternary_opw, 0) \
+	X(r2r_ternary_opl, r2r_ternary_opl, 0) \
+	X(m2r_ternary_opb, m2r_ternary_opb, 0) \
+	X(m2r_ternary_opw, m2r_ternary_opw, 0) \
+	X(m2r_ternary_opl, m2r_ternary_opl, 0) \
+	X(r2r_binary_opb_ul, r2r_binary_opb_ul, 0) \
+	X(r2r_binary_opb_lu, r2r_binary_opb_lu, 0) \
+	X(r2r_binary_opb_u, r2r_binary_opb_u, 0) \
+	X(r2r_binary_opb_l, r2r_binary_opb_l, 0) \
+	X(r2r_binary_opw, r2r_binary_opw, 0) \
+	X(r2r_binary_opl, r2r_binary_opl, 0) \
+	X(m2r_binary_opb_u, m2r_binary_opb_u, 0) \
+	X(m2r_binary_opb_l, m2r_binary_opb_l, 0) \
+	X(m2r_binary_opw, m2r_binary_opw, 0) \
+	X(m2r_binary_opl, m2r_binary_opl, 0) \
+	X(r2m_binary_opb_u, r2m_binary_opb_u, 0) \
+	X(r2m_binary_opb_l, r2m_binary_opb_l, 0) \
+	X(r2m_binary_opw, r2m_binary_opw, 0) \
+	X(r2m_binary_opl, r2m_binary_opl, 0) \
+	X(r_clrl4, r_clrl4, 0) \
+	X(r_clrl3, r_clrl3, 0) \
+	X(r_clrl2, r_clrl2, 0) \
+	X(r_clrl, r_clrl, 0) \
+	X(r_clrw, r_clrw, 0) \
+	X(r_clrb_u, r_clrb_u, 0) \
+	X(r_clrb_l, r_clrb_l, 0) \
+	X(r2r_xfer_opb_ul, r2r_xfer_opb_ul, 0) \
+	X(r2r_xfer_opb_lu, r2r_xfer_opb_lu, 0) \
+	X(r2r_xfer_opb_u, r2r_xfer_opb_u, 0) \
+	X(r2r_xfer_opb_l, r2r_xfer_opb_l, 0) \
+	X(r2r_xfer_opw, r2r_xfer_opw, 0) \
+	X(r2r_xfer_opl, r2r_xfer_opl, 0) \
+	X(m2r_xfer_opb_u, m2r_xfer_opb_u, 0) \
+	X(m2r_xfer_opb_l, m2r_xfer_opb_l, 0) \
+	X(m2r_xfer_opw, m2r_xfer_opw, 0) \
+	X(m2r_xfer_opl, m2r_xfer_opl, 0) \
+	X(r2m_xfer_opb_u, r2m_xfer_opb_u, 0) \
+	X(r2m_xfer_opb_l, r2m_xfer_opb_l, 0) \
+	X(r2m_xfer_opw, r2m_xfer_opw, 0) \
+	X(r2m_xfer_opl, r2m_xfer_opl, 0) \
+	X(m2m_xfer_opw, m2m_xfer_opw, 0) \
+	X(m2m_xfer_opb, m2m_xfer_opb, 0) \
+	X(m2m_xfer_opl, m2m_xfer_opl, 0) \
+	X(rep_predicate, rep_predicate, IDFT_HANDLER_PREDICATE) \
+	X(m2r_restore_opw, m2r_restore_opw, 0) \
+	X(m2r_restore_opl, m2r_restore_opl, 0) \
+	X(r2m_save_opw, r2m_save_opw, 0) \
+	X(r2m_save_opl, r2m_save_opl, 0) \
+	X(_leave, leave, 0) \
+	X(argpack_r2r, argpack_r2r, 0) \
+	X(argpack_m2r, argpack_m2r, 0) \
+	X(argpack_r2m, argpack_r2m, 0) \
+	X(_mem_group, mem_group, 0) \
+	X(shadow_prefetch1, shadow_prefetch1, 0) \
+	X(shadow_prefetch2, shadow_prefetch2, 0) \
+	X(shadow_prefetch3, shadow_prefetch3, 0) \
+	X(_cmov_r2r_opl, cmov_r2r_opl, 0) \
+	X(_cmov_r2r_opw, cmov_r2r_opw, 0) \
+	X(_cmov_m2r_opl, cmov_m2r_opl, 0) \
+	X(_cmov_m2r_opw, cmov_m2r_opw, 0) \
+	X(_cmpxchg_r2r_opl_bf, cmpxchg_r2r_opl_bf, 0) \
+	X(_cmpxchg_r2r_opw_bf, cmpxchg_r2r_opw_bf, 0) \
+	X(_cmpxchg_m2r_opl_bf, cmpxchg_m2r_opl_bf, 0) \
+	X(_cmpxchg_m2r_opw_bf, cmpxchg_m2r_opw_bf, 0) \
+	X(xmm_r2r_xfer_opx, xmm_r2r_xfer_opx, 0) \
+	X(xmm_r2r_xfer_opq, xmm_r2r_xfer_opq, 0) \
+	X(xmm_m2r_xfer_opx, xmm_m2r_xfer_opx, 0) \
+	X(xmm_m2r_xfer_opq, xmm_m2r_xfer_opq, 0) \
+	X(xmm_m2r_xfer_opl, xmm_m2r_xfer_opl, 0) \
+	X(xmm_r2m_xfer_opx, xmm_r2m_xfer_opx, 0) \
+	X(xmm_r2m_xfer_opq, xmm_r2m_xfer_opq, 0) \
+	X(xmm_r2m_xfer_opl, xmm_r2m_xfer_opl, 0) \
+	X(xmm_r2x_xfer_opl, xmm_r2x_xfer_opl, 0) \
+	X(xmm_x2r_xfer_opl, xmm_x2r_xfer_opl, 0) \
+	X(xmm_x2r_mask_opx, xmm_x2r_mask_opx, 0) \
+	X(ymm_x2r_mask_opy, ymm_x2r_mask_opy, 0) \
+	X(xmm_r2r_binary_opx, xmm_r2r_binary_opx, 0) \
+	X(xmm_m2r_binary_opx, xmm_m2r_binary_opx, 0) \
+	X(xmm_clr_opx, xmm_clr_opx, 0) \
+	X(ymm_clr_opy, ymm_clr_opy, 0) \
+	X(ymm_clr_upper, ymm_clr_upper, 0) \
+	X(ymm_clr_all, ymm_clr_all, 0) \
+	X(ymm_r2r_xfer_opx, ymm_r2r_xfer_opx, 0) \
+	X(ymm_r2r_xfer_opy, ymm_r2r_xfer_opy, 0) \
+	X(ymm_m2r_xfer_opx, ymm_m2r_xfer_opx, 0) \
+	X(ymm_m2r_xfer_opy, ymm_m2r_xfer_opy, 0) \
+	X(ymm_r2m_xfer_opy, ymm_r2m_xfer_opy, 0) \
+	X(ymm_rr2r_binary_opx, ymm_rr2r_binary_opx, 0) \
+	X(ymm_rr2r_binary_opy, ymm_rr2r_binary_opy, 0) \
+	X(ymm_rm2r_binary_opx, ymm_rm2r_binary_opx, 0) \
+	X(ymm_rm2r_binary_opy, ymm_rm2r_binary_opy, 0) \
+	X(_cmpxchg8b_m2r_bf, cmpxchg8b_m2r_bf, 0) \
+	X(_movsx_r2r_opql, movsx_r2r_opql, 0) \
+	X(_movsx_r2r_opqw, movsx_r2r_opqw, 0) \
+	X(_movsx_r2r_opqb_u, movsx_r2r_opqb_u, 0) \
+	X(_movsx_r2r_opqb_l, movsx_r2r_opqb_l, 0) \
+	X(_movsx_m2r_opql, movsx_m2r_opql, 0) \
+	X(_movsx_m2r_opqw, movsx_m2r_opqw, 0) \
+	X(_movsx_m2r_opqb, movsx_m2r_opqb, 0) \
+	X(_cqo, cqo, 0) \
+	X(_cmpxchg_r2r_opq_bf, cmpxchg_r2r_opq_bf, 0) \
+	X(_cmpxchg_m2r_opq_bf, cmpxchg_m2r_opq_bf, 0) \
+	X(_xchg_m2r_opq, xchg_m2r_opq, 0) \
+	X(_xadd_r2r_opq, xadd_r2r_opq, 0) \
+	X(_xadd_m2r_opq, xadd_m2r_opq, 0) \
+	X(_lea_r2r_opq, lea_r2r_opq, 0) \
+	X(m2r_ternary_opq, m2r_ternary_opq, 0) \
+	X(r2r_binary_opq, r2r_binary_opq, 0) \
+	X(m2r_binary_opq, m2r_binary_opq, 0) \
+	X(r2m_binary_opq, r2m_binary_opq, 0) \
+	X(r2r_xfer_opq, r2r_xfer_opq, 0) \
+	X(m2r_xfer_opq, m2r_xfer_opq, 0) \
+	X(r2m_xfer_opq, r2m_xfer_opq, 0) \
+	X(m2m_xfer_opq, m2m_xfer_opq, 0) \
+	X(_cmov_r2r_opq, cmov_r2r_opq, 0) \
+	X(_cmov_m2r_opq, cmov_m2r_opq, 0) \
+	X(_cmpxchg16b_m2r_bf, cmpxchg16b_m2r_bf, 0)
+
+#endif /* LIBICEDFT_INLINE_H */
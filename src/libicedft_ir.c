@@ -0,0 +1,1053 @@
+/*
+ * taint micro-op IR
+ *
+ * the analysis routines of libicedft_core.c are, for the most
+ * part, combinations of four primitives over register bytes
+ * and memory bytes: copy, union, clear and extend. A block is
+ * lowered by recording what ins_inspect asks for (see
+ * libicedft_rec.c) and lifting every recorded call into those
+ * primitives (micro-ops). Block-level passes then remove the
+ * work that cannot affect the result, and the survivors are
+ * mapped back to the analysis routines and handed to the
+ * executer. Calls that cannot be lifted stay as they are and
+ * act as barriers for the passes
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "libicedft_api.h"
+#include "libicedft_argpack.h"
+#include "libicedft_coalesce.h"
+#include "libicedft_core.h"
+#include "libicedft_idiom.h"
+#include "libicedft_ir.h"
+#include "libicedft_jit.h"
+#include "libicedft_prefetch.h"
+#include "libicedft_rec.h"
+#include "libicedft_tier.h"
+#include "libicedft_util.h"
+#include "branch_pred.h"
+
+
+#define U8	(VCPU_MASK8 << 1)		/* upper 8-bit lane */
+
+#define T_TC	0x01				/* takes the thread context */
+#define T_FIXED	0x02				/* implicit registers */
+
+/* the micro-op form of an analysis routine */
+typedef struct {
+	void		*fn;			/* analysis routine */
+	uint8_t		op;			/* UOP_* */
+	uint8_t		flags;			/* T_* */
+	uint8_t		dkind;			/* LOC_* */
+	uint8_t		dmask;			/* byte lanes or bytes */
+	uint8_t		skind;			/* LOC_* */
+	uint8_t		smask;			/* byte lanes or bytes */
+	uint8_t		regs;			/* registers (T_FIXED) */
+} ir_tmpl_t;
+
+#define R2R(fn, op, d, s)						\
+	{(void *)fn, op, T_TC, LOC_REG, d, LOC_REG, s, 0}
+#define M2R(fn, op, d, len)						\
+	{(void *)fn, op, T_TC, LOC_REG, d, LOC_MEM, len, 0}
+#define R2M(fn, op, len, s)						\
+	{(void *)fn, op, T_TC, LOC_MEM, len, LOC_REG, s, 0}
+#define M2M(fn, len)							\
+	{(void *)fn, UOP_COPY, 0, LOC_MEM, len, LOC_MEM, len, 0}
+#define CLR(fn, d)							\
+	{(void *)fn, UOP_CLEAR, T_TC, LOC_REG, d, LOC_NONE, 0, 0}
+#define CLRN(fn, regs)							\
+	{(void *)fn, UOP_CLEAR, T_TC | T_FIXED, LOC_REG, VCPU_MASK32,	\
+		LOC_NONE, 0, regs}
+
+/*
+ * lifting table; the first entry of a given shape is
+ * also the one selected when a micro-op is emitted
+ */
+static const ir_tmpl_t ir_tmpl[] = {
+	/* xfer */
+	R2R(r2r_xfer_opl, UOP_COPY, VCPU_MASK32, VCPU_MASK32),
+	R2R(r2r_xfer_opw, UOP_COPY, VCPU_MASK16, VCPU_MASK16),
+	R2R(r2r_xfer_opb_u, UOP_COPY, U8, U8),
+	R2R(r2r_xfer_opb_l, UOP_COPY, VCPU_MASK8, VCPU_MASK8),
+	R2R(r2r_xfer_opb_ul, UOP_COPY, U8, VCPU_MASK8),
+	R2R(r2r_xfer_opb_lu, UOP_COPY, VCPU_MASK8, U8),
+	M2R(m2r_xfer_opl, UOP_COPY, VCPU_MASK32, 4),
+	M2R(m2r_xfer_opw, UOP_COPY, VCPU_MASK16, 2),
+	M2R(m2r_xfer_opb_u, UOP_COPY, U8, 1),
+	M2R(m2r_xfer_opb_l, UOP_COPY, VCPU_MASK8, 1),
+	R2M(r2m_xfer_opl, UOP_COPY, 4, VCPU_MASK32),
+	R2M(r2m_xfer_opw, UOP_COPY, 2, VCPU_MASK16),
+	R2M(r2m_xfer_opb_u, UOP_COPY, 1, U8),
+	R2M(r2m_xfer_opb_l, UOP_COPY, 1, VCPU_MASK8),
+	M2M(m2m_xfer_opl, 4),
+	M2M(m2m_xfer_opw, 2),
+	M2M(m2m_xfer_opb, 1),
+
+	/* zero extension */
+	R2R(_movzx_r2r_oplw, UOP_COPY, VCPU_MASK32, VCPU_MASK16),
+	R2R(_movzx_r2r_oplb_u, UOP_COPY, VCPU_MASK32, U8),
+	R2R(_movzx_r2r_oplb_l, UOP_COPY, VCPU_MASK32, VCPU_MASK8),
+	R2R(_movzx_r2r_opwb_u, UOP_COPY, VCPU_MASK16, U8),
+	R2R(_movzx_r2r_opwb_l, UOP_COPY, VCPU_MASK16, VCPU_MASK8),
+	M2R(_movzx_m2r_oplw, UOP_COPY, VCPU_MASK32, 2),
+	M2R(_movzx_m2r_oplb, UOP_COPY, VCPU_MASK32, 1),
+	M2R(_movzx_m2r_opwb, UOP_COPY, VCPU_MASK16, 1),
+
+	/* sign extension */
+	R2R(_movsx_r2r_oplw, UOP_EXTEND, VCPU_MASK32, VCPU_MASK16),
+	R2R(_movsx_r2r_oplb_u, UOP_EXTEND, VCPU_MASK32, U8),
+	R2R(_movsx_r2r_oplb_l, UOP_EXTEND, VCPU_MASK32, VCPU_MASK8),
+	R2R(_movsx_r2r_opwb_u, UOP_EXTEND, VCPU_MASK16, U8),
+	R2R(_movsx_r2r_opwb_l, UOP_EXTEND, VCPU_MASK16, VCPU_MASK8),
+	M2R(_movsx_m2r_oplw, UOP_EXTEND, VCPU_MASK32, 2),
+	M2R(_movsx_m2r_oplb, UOP_EXTEND, VCPU_MASK32, 1),
+	M2R(_movsx_m2r_opwb, UOP_EXTEND, VCPU_MASK16, 1),
+
+	/* binary */
+	R2R(r2r_binary_opl, UOP_UNION, VCPU_MASK32, VCPU_MASK32),
+	R2R(r2r_binary_opw, UOP_UNION, VCPU_MASK16, VCPU_MASK16),
+	R2R(r2r_binary_opb_u, UOP_UNION, U8, U8),
+	R2R(r2r_binary_opb_l, UOP_UNION, VCPU_MASK8, VCPU_MASK8),
+	R2R(r2r_binary_opb_ul, UOP_UNION, U8, VCPU_MASK8),
+	R2R(r2r_binary_opb_lu, UOP_UNION, VCPU_MASK8, U8),
+	M2R(m2r_binary_opl, UOP_UNION, VCPU_MASK32, 4),
+	M2R(m2r_binary_opw, UOP_UNION, VCPU_MASK16, 2),
+	M2R(m2r_binary_opb_u, UOP_UNION, U8, 1),
+	M2R(m2r_binary_opb_l, UOP_UNION, VCPU_MASK8, 1),
+	R2M(r2m_binary_opl, UOP_UNION, 4, VCPU_MASK32),
+	R2M(r2m_binary_opw, UOP_UNION, 2, VCPU_MASK16),
+	R2M(r2m_binary_opb_u, UOP_UNION, 1, U8),
+	R2M(r2m_binary_opb_l, UOP_UNION, 1, VCPU_MASK8),
+
+	/* clear */
+	CLR(r_clrl, VCPU_MASK32),
+	CLR(r_clrw, VCPU_MASK16),
+	CLR(r_clrb_u, U8),
+	CLR(r_clrb_l, VCPU_MASK8),
+	CLRN(r_clrl2, (1 << GPR_EDX) | (1 << GPR_EAX)),
+	CLRN(r_clrl3, (1 << GPR_EDX) | (1 << GPR_ECX) | (1 << GPR_EAX)),
+	CLRN(r_clrl4, (1 << GPR_EBX) | (1 << GPR_EDX) | (1 << GPR_ECX) |
+			(1 << GPR_EAX)),
+
+#ifdef IDFT_X86_64
+	/* quad words; r_clrl clears the whole register (see IR_ZEXT) */
+	R2R(r2r_xfer_opq, UOP_COPY, VCPU_MASK64, VCPU_MASK64),
+	M2R(m2r_xfer_opq, UOP_COPY, VCPU_MASK64, 8),
+	R2M(r2m_xfer_opq, UOP_COPY, 8, VCPU_MASK64),
+	M2M(m2m_xfer_opq, 8),
+	R2R(r2r_binary_opq, UOP_UNION, VCPU_MASK64, VCPU_MASK64),
+	M2R(m2r_binary_opq, UOP_UNION, VCPU_MASK64, 8),
+	R2M(r2m_binary_opq, UOP_UNION, 8, VCPU_MASK64),
+	CLR(r_clrl, VCPU_MASK64),
+#endif
+};
+
+#define IR_TMPL_NUM	(sizeof(ir_tmpl) / sizeof(ir_tmpl[0]))
+
+
+/*
+ * look up the micro-op form of an analysis routine
+ *
+ * @fn:		the analysis routine
+ *
+ * returns: the template, or NULL if it cannot be lifted
+ */
+static const ir_tmpl_t *
+ir_tmpl_find(void *fn)
+{
+	uint32_t i;
+
+	for (i = 0; i < IR_TMPL_NUM; i++)
+		if (ir_tmpl[i].fn == fn)
+			return &ir_tmpl[i];
+
+	return NULL;
+}
+
+/*
+ * parse one lifted operand out of the recorded items
+ *
+ * @call:	the recorded call
+ * @pos:	current item; advanced past the operand
+ * @kind:	LOC_* expected
+ * @m:		byte lanes (LOC_REG) or bytes (LOC_MEM)
+ * @loc:	the operand
+ *
+ * returns: 0 on success, 1 if the items do not match
+ */
+static int
+ir_parse_loc(rec_call_t *call, uint32_t *pos, uint8_t kind, uint8_t m,
+		ir_loc_t *loc)
+{
+	uint32_t iarg;
+
+	memset(loc, 0, sizeof(*loc));
+	loc->kind = kind;
+
+	if (kind == LOC_NONE)
+		return 0;
+
+	if (*pos >= call->argc)
+		return 1;
+
+	iarg = call->argv[(*pos)++];
+
+	if (kind == LOC_REG) {
+		/* registers are always passed as VCPU indices */
+		if (iarg != IARG_UINT32 || *pos >= call->argc)
+			return 1;
+
+		loc->reg	= (uint8_t)call->argv[(*pos)++];
+		loc->mask	= m;
+
+		return (loc->reg > GPR_SCRATCH);
+	}
+
+	/* memory; keep whatever supplies the address */
+	loc->len	= m;
+	loc->ea		= iarg;
+
+	if (REC_IARG_HASVAL(iarg)) {
+		if (*pos >= call->argc)
+			return 1;
+		loc->eaval = call->argv[(*pos)++];
+	}
+
+	return 0;
+}
+
+/*
+ * append a micro-op
+ */
+static ir_uop_t *
+ir_append(ir_block_t *blk, uint8_t op, uint32_t rec, uint8_t pred)
+{
+	ir_uop_t *uop = &blk->uops[blk->nuops++];
+
+	memset(uop, 0, sizeof(*uop));
+
+	uop->op		= op;
+	uop->rec	= rec;
+	uop->pred	= pred;
+
+	return uop;
+}
+
+/*
+ * lift one recorded call
+ *
+ * @buf:	the record buffer
+ * @i:		the call
+ * @blk:	the block being lowered
+ *
+ * returns: 0 on success, 1 if the call is not liftable
+ */
+static int
+ir_lift(rec_buf_t *buf, uint32_t i, ir_block_t *blk)
+{
+	rec_call_t *call = &buf->calls[i];
+	const ir_tmpl_t *t;
+	ir_uop_t *uop;
+	ir_loc_t dst, src;
+	uint32_t pos = 0, r;
+	uint8_t pred;
+
+	/* If/Then pairs and late calls are left alone */
+	if ((call->how != REC_CALL && call->how != REC_PREDICATED) ||
+			call->ipoint != IDFT_IPOINT_BEFORE)
+		return 1;
+
+	if ((t = ir_tmpl_find(call->func)) == NULL)
+		return 1;
+
+	pred = (call->how == REC_PREDICATED);
+
+	if (t->flags & T_TC) {
+		if (call->argc == 0 || call->argv[0] != IARG_THREAD_CONTEXT)
+			return 1;
+		pos++;
+	}
+
+	/* implicit registers; one micro-op each */
+	if (t->flags & T_FIXED) {
+		if (pos != call->argc)
+			return 1;
+
+		for (r = 0; r < GPR_NUM; r++) {
+			if ((t->regs & (1 << r)) == 0)
+				continue;
+
+			uop = ir_append(blk, t->op, i, pred);
+			uop->dst.kind	= LOC_REG;
+			uop->dst.reg	= r;
+			uop->dst.mask	= t->dmask;
+		}
+
+		return 0;
+	}
+
+	if (ir_parse_loc(call, &pos, t->dkind, t->dmask, &dst) ||
+		ir_parse_loc(call, &pos, t->skind, t->smask, &src) ||
+		pos != call->argc)
+		return 1;
+
+	uop = ir_append(blk, t->op, i, pred);
+	uop->dst = dst;
+	uop->src = src;
+
+	return 0;
+}
+
+/*
+ * lower the recorded calls of a block into micro-ops
+ *
+ * @buf:	the record buffer
+ * @blk:	the block
+ * @exits:	the side exits of a trace, as the first call
+ *		after each one, in order (see ir_build)
+ * @nexits:	their count (at most IR_EXIT_MAX)
+ */
+void
+ir_lower(rec_buf_t *buf, ir_block_t *blk, const uint32_t *exits,
+		uint32_t nexits)
+{
+	uint32_t i, e = 0;
+
+	blk->nuops = 0;
+
+	for (i = 0; i < buf->ncalls; i++) {
+		/* one exit is enough between two calls */
+		if (e < nexits && exits[e] <= i) {
+			ir_append(blk, UOP_EXIT, i, 0);
+			while (e < nexits && exits[e] <= i)
+				e++;
+		}
+
+		if (ir_lift(buf, i, blk))
+			ir_append(blk, UOP_OPAQUE, i, 0);
+	}
+}
+
+/*
+ * the destination lanes of a micro-op that end up clean,
+ * if it executes
+ *
+ * @uop:	the micro-op (COPY, EXTEND or UNION)
+ * @sclean:	clean lanes of the source register (0 for memory)
+ *
+ * returns: clean lanes, in destination positions
+ */
+static uint8_t
+ir_lanes_clean(ir_uop_t *uop, uint8_t sclean)
+{
+	uint8_t sl[8], ns = 0, k = 0, i, out = 0, smask;
+
+	smask = (uop->src.kind == LOC_REG) ?
+		uop->src.mask : (uint8_t)((1 << uop->src.len) - 1);
+
+	for (i = 0; i < 8; i++)
+		if (smask & (1 << i))
+			sl[ns++] = i;
+
+	for (i = 0; i < 8; i++) {
+		if ((uop->dst.mask & (1 << i)) == 0)
+			continue;
+
+		if (k < ns) {
+			if (sclean & (1 << sl[k]))
+				out |= (1 << i);
+		}
+		else if (uop->op == UOP_EXTEND) {
+			if (sclean & (1 << sl[k % ns]))
+				out |= (1 << i);
+		}
+		/* zero extension */
+		else if (uop->op == UOP_COPY)
+			out |= (1 << i);
+
+		k++;
+	}
+
+	return out;
+}
+
+/* forget every copy relation involving a register */
+static void
+ir_kill_copies(uint8_t *copy, uint8_t reg)
+{
+	uint32_t r;
+
+	copy[reg] = IR_NOREG;
+
+	for (r = 0; r <= GPR_SCRATCH; r++)
+		if (copy[r] == reg)
+			copy[r] = IR_NOREG;
+}
+
+/* mark a micro-op eliminated */
+#define IR_KILL(uop)	do { (uop)->op = UOP_NOP; (uop)->changed = 1; } while (0)
+
+/*
+ * forward pass: copy propagation and clear folding
+ *
+ * tracks, per VCPU register, the lanes known to be clean
+ * and whether the register is a full copy of another one.
+ * Reads of a copy are redirected to the original (so that
+ * the copy itself may die), unions with a clean source are
+ * dropped, copies and extensions of a clean source become
+ * clears, and clears of clean lanes are dropped
+ *
+ * @blk:	the block
+ * @stats:	statistics
+ */
+static void
+ir_forward(ir_block_t *blk, idft_block_stats_t *stats)
+{
+	uint8_t clean[GPR_NUM + 1], copy[GPR_NUM + 1], nc, d, s, z;
+	uint32_t i;
+	ir_uop_t *uop;
+
+	memset(clean, 0, sizeof(clean));
+	memset(copy, IR_NOREG, sizeof(copy));
+
+	for (i = 0; i < blk->nuops; i++) {
+		uop = &blk->uops[i];
+
+		if (uop->op == UOP_NOP)
+			continue;
+
+		/* the rest runs only if the exit is not taken */
+		if (uop->op == UOP_EXIT)
+			continue;
+
+		/* barrier; anything may have changed */
+		if (uop->op == UOP_OPAQUE) {
+			memset(clean, 0, sizeof(clean));
+			memset(copy, IR_NOREG, sizeof(copy));
+			continue;
+		}
+
+		/* copy propagation */
+		if (uop->src.kind == LOC_REG && copy[uop->src.reg] != IR_NOREG) {
+			uop->src.reg	= copy[uop->src.reg];
+			uop->changed	= 1;
+			stats->copyprop++;
+		}
+
+		/* the lanes it zero-extends into */
+		z = IR_ZEXT(&uop->dst);
+
+		/* clear folding; source known clean */
+		if (uop->src.kind == LOC_REG &&
+			(uop->src.mask & ~clean[uop->src.reg]) == 0) {
+			if (uop->op == UOP_UNION) {
+				if ((z & ~clean[uop->dst.reg]) == 0) {
+					IR_KILL(uop);
+					stats->folded++;
+					continue;
+				}
+			}
+			else if (uop->dst.kind == LOC_REG) {
+				uop->op		= UOP_CLEAR;
+				uop->src.kind	= LOC_NONE;
+				uop->changed	= 1;
+
+				/* counted below if it clears clean lanes */
+				if ((uop->dst.mask | z) & ~clean[uop->dst.reg])
+					stats->folded++;
+			}
+		}
+
+		/* self copies and unions are no-ops */
+		if ((uop->op == UOP_COPY || uop->op == UOP_UNION) &&
+			uop->src.kind == LOC_REG && uop->dst.kind == LOC_REG &&
+			uop->src.reg == uop->dst.reg &&
+			uop->src.mask == uop->dst.mask &&
+			(z & ~clean[uop->dst.reg]) == 0) {
+			IR_KILL(uop);
+			stats->folded++;
+			continue;
+		}
+
+		if (uop->dst.kind != LOC_REG)
+			continue;
+
+		d = uop->dst.reg;
+
+		/* clearing clean lanes */
+		if (uop->op == UOP_CLEAR &&
+			((uop->dst.mask | z) & ~clean[d]) == 0) {
+			IR_KILL(uop);
+			stats->folded++;
+			continue;
+		}
+
+		/* the clean lanes of the destination, if it executes */
+		switch (uop->op) {
+			case UOP_CLEAR:
+				nc = clean[d] | uop->dst.mask | z;
+				break;
+			case UOP_UNION:
+				nc = (clean[d] & ~(uop->dst.mask &
+					~ir_lanes_clean(uop,
+					(uop->src.kind == LOC_REG) ?
+					clean[uop->src.reg] : 0))) | z;
+				break;
+			default:
+				nc = (clean[d] & ~uop->dst.mask) |
+					ir_lanes_clean(uop,
+					(uop->src.kind == LOC_REG) ?
+					clean[uop->src.reg] : 0) | z;
+				break;
+		}
+
+		/* predicated; either state is possible */
+		clean[d] = uop->pred ? (clean[d] & nc) : nc;
+
+		ir_kill_copies(copy, d);
+
+		/* a full copy of another register */
+		if (!uop->pred && uop->op == UOP_COPY &&
+			uop->src.kind == LOC_REG &&
+			uop->src.mask == IR_FULL &&
+			uop->dst.mask == IR_FULL) {
+			s = uop->src.reg;
+			if (s != d)
+				copy[d] = s;
+		}
+	}
+}
+
+/*
+ * backward pass: dead-tag elimination
+ *
+ * a micro-op whose destination register lanes are
+ * overwritten before they are read is removed. Every
+ * register is live at the end of the block, and at the
+ * side exits of a trace, except the scratch one (only
+ * ever used within one instruction); memory is always live
+ *
+ * @blk:	the block
+ * @stats:	statistics
+ */
+static void
+ir_backward(ir_block_t *blk, idft_block_stats_t *stats)
+{
+	uint8_t live[GPR_NUM + 1], z;
+	uint32_t i;
+	ir_uop_t *uop;
+
+	memset(live, IR_FULL, sizeof(live));
+	live[GPR_SCRATCH] = 0;
+
+	for (i = blk->nuops; i-- > 0; ) {
+		uop = &blk->uops[i];
+
+		if (uop->op == UOP_NOP)
+			continue;
+
+		/* everything may be read by the code after them */
+		if (uop->op == UOP_OPAQUE || uop->op == UOP_EXIT) {
+			memset(live, IR_FULL, sizeof(live));
+			continue;
+		}
+
+		if (uop->dst.kind == LOC_REG) {
+			z = IR_ZEXT(&uop->dst);
+
+			if (((uop->dst.mask | z) & live[uop->dst.reg]) == 0) {
+				IR_KILL(uop);
+				stats->dead++;
+				continue;
+			}
+
+			/* a definite overwrite (unions zero-extend too) */
+			if (!uop->pred)
+				live[uop->dst.reg] &= ~(z |
+					((uop->op != UOP_UNION) ?
+					 uop->dst.mask : 0));
+		}
+
+		if (uop->src.kind == LOC_REG)
+			live[uop->src.reg] |= uop->src.mask;
+	}
+}
+
+/*
+ * run the block-level passes
+ *
+ * @blk:	the block
+ * @stats:	statistics
+ */
+void
+ir_optimize(ir_block_t *blk, idft_block_stats_t *stats)
+{
+	ir_forward(blk, stats);
+	ir_backward(blk, stats);
+}
+
+/*
+ * select the analysis routine for a micro-op
+ *
+ * @uop:	the micro-op
+ *
+ * returns: the template, or NULL if there is none
+ */
+static const ir_tmpl_t *
+ir_select(ir_uop_t *uop)
+{
+	const ir_tmpl_t *t;
+	uint32_t i;
+	uint8_t dm, sm;
+
+	dm = (uop->dst.kind == LOC_MEM) ? uop->dst.len : uop->dst.mask;
+	sm = (uop->src.kind == LOC_MEM) ? uop->src.len : uop->src.mask;
+
+	for (i = 0; i < IR_TMPL_NUM; i++) {
+		t = &ir_tmpl[i];
+
+		if (t->op == uop->op && (t->flags & T_FIXED) == 0 &&
+			t->dkind == uop->dst.kind && t->dmask == dm &&
+			t->skind == uop->src.kind &&
+			(t->skind == LOC_NONE || t->smask == sm))
+			return t;
+	}
+
+	return NULL;
+}
+
+/* append the items of an operand */
+static uint32_t
+ir_emit_loc(ir_loc_t *loc, ADDRINT *argv, uint32_t argc)
+{
+	switch (loc->kind) {
+		case LOC_REG:
+			argv[argc++] = IARG_UINT32;
+			argv[argc++] = loc->reg;
+			break;
+		case LOC_MEM:
+			argv[argc++] = loc->ea;
+			if (REC_IARG_HASVAL(loc->ea))
+				argv[argc++] = loc->eaval;
+			break;
+		default:
+			break;
+	}
+
+	return argc;
+}
+
+/*
+ * compile the pending run of register micro-ops and
+ * insert the stub at the first instruction of the run
+ *
+ * @context:	the engine context
+ * @run:	the micro-ops
+ * @n:		their count
+ * @ins:	where to insert
+ * @stats:	statistics
+ *
+ * returns: 0 on success, 1 if the run was not compiled
+ */
+static int
+ir_emit_run(idft_context_t *context, ir_uop_t **run, uint32_t n,
+		idft_ins_t *ins, idft_block_stats_t *stats)
+{
+	ADDRINT argv[1] = {IARG_THREAD_CONTEXT};
+	jit_stub_t stub;
+
+	if ((stub = jit_compile(context, run, n)) == NULL)
+		return 1;
+
+	rec_insert(context, ins, REC_CALL, IDFT_IPOINT_BEFORE,
+			(void *)stub, 1, argv);
+
+	stats->calls_out++;
+	stats->jitted += n;
+
+	return 0;
+}
+
+/*
+ * emit one micro-op through its analysis routine
+ */
+static void
+ir_emit_uop(idft_context_t *context, rec_call_t *call, ir_uop_t *uop,
+		idft_block_stats_t *stats)
+{
+	ADDRINT argv[REC_ARG_MAX];
+	uint32_t argc = 0;
+	const ir_tmpl_t *t;
+
+	if ((context->opts & IDFT_OPT_ARGPACK) &&
+			argpack_emit(context, call, uop, stats) == 0)
+		return;
+
+	if (unlikely((t = ir_select(uop)) == NULL)) {
+		/* cannot happen; the passes keep shapes */
+		IDFT_LOG("ir: no routine for micro-op %u\n", uop->op);
+		return;
+	}
+
+	if (t->flags & T_TC)
+		argv[argc++] = IARG_THREAD_CONTEXT;
+	argc = ir_emit_loc(&uop->dst, argv, argc);
+	argc = ir_emit_loc(&uop->src, argv, argc);
+
+	rec_insert(context, call->ins, uop->pred ? REC_PREDICATED : REC_CALL,
+			IDFT_IPOINT_BEFORE, t->fn, argc, argv);
+	stats->calls_out++;
+}
+
+/*
+ * hand a block back to the executer; calls whose micro-ops
+ * were left untouched are replayed as recorded, the rest
+ * are re-selected from what survived.
+ *
+ * with IDFT_OPT_ARGPACK, calls are emitted through argument
+ * packs where possible (see libicedft_argpack.c), including
+ * untouched calls that consist of a single micro-op.
+ *
+ * with IDFT_OPT_JIT, consecutive register micro-ops are
+ * compiled into one native stub instead; the effects of a
+ * run only depend on the VCPU, so running all of them
+ * before its first instruction is equivalent (no other
+ * analysis call comes in between). Side exits end runs
+ *
+ * @context:	the engine context
+ * @buf:	the record buffer
+ * @blk:	the optimized block
+ * @stats:	statistics
+ */
+void
+ir_emit(idft_context_t *context, rec_buf_t *buf, ir_block_t *blk,
+		idft_block_stats_t *stats)
+{
+	uint32_t i = 0, j, k, touched, jit, nrun = 0, n;
+	ir_uop_t **run = NULL;
+	idft_ins_t *run_ins = NULL;
+	rec_call_t *call;
+
+	/* make room for the worst case up front */
+	jit = (context->opts & IDFT_OPT_JIT) && jit_available();
+	if (jit) {
+		for (k = 0, n = 0; k < blk->nuops; k++)
+			n += (blk->uops[k].op != UOP_NOP &&
+					JIT_UOP_OK(&blk->uops[k]));
+		if (n == 0 || jit_reserve(context, n) ||
+			(run = malloc(n * sizeof(ir_uop_t *))) == NULL)
+			jit = 0;
+	}
+
+	while (i < blk->nuops) {
+		/* nothing to insert; the run must not cross it */
+		if (blk->uops[i].op == UOP_EXIT) {
+			if (nrun && ir_emit_run(context, run, nrun, run_ins,
+					stats))
+				for (k = 0; k < nrun; k++)
+					ir_emit_uop(context,
+						&buf->calls[run[k]->rec],
+						run[k], stats);
+			nrun = 0;
+			i++;
+			continue;
+		}
+
+		call = &buf->calls[blk->uops[i].rec];
+
+		/* the micro-ops of this call */
+		for (j = i, touched = 0, n = 0, k = 0;
+			j < blk->nuops && blk->uops[j].rec == blk->uops[i].rec;
+			j++) {
+			touched |= blk->uops[j].changed;
+			if (blk->uops[j].op != UOP_NOP) {
+				n++;
+				k += JIT_UOP_OK(&blk->uops[j]);
+			}
+		}
+
+		/* all gone */
+		if (n == 0) {
+			i = j;
+			continue;
+		}
+
+		/* compilable; add to the run */
+		if (jit && k == n) {
+			if (nrun == 0)
+				run_ins = call->ins;
+			for (; i < j; i++)
+				if (blk->uops[i].op != UOP_NOP)
+					run[nrun++] = &blk->uops[i];
+			continue;
+		}
+
+		/* anything else ends the run */
+		if (nrun && ir_emit_run(context, run, nrun, run_ins, stats))
+			for (k = 0; k < nrun; k++)
+				ir_emit_uop(context, &buf->calls[run[k]->rec],
+						run[k], stats);
+		nrun = 0;
+
+		/* one micro-op; as cheap to emit as to replay */
+		if (!touched && n == 1 && (context->opts & IDFT_OPT_ARGPACK)) {
+			for (k = i; blk->uops[k].op == UOP_NOP; k++)
+				;
+			if (blk->uops[k].op != UOP_OPAQUE &&
+				argpack_emit(context, call, &blk->uops[k],
+					stats) == 0) {
+				i = j;
+				continue;
+			}
+		}
+
+		if (!touched) {
+			rec_replay(context, call);
+			stats->calls_out++;
+			i = j;
+			continue;
+		}
+
+		for (; i < j; i++)
+			if (blk->uops[i].op != UOP_NOP)
+				ir_emit_uop(context, call, &blk->uops[i], stats);
+	}
+
+	if (nrun && ir_emit_run(context, run, nrun, run_ins, stats))
+		for (k = 0; k < nrun; k++)
+			ir_emit_uop(context, &buf->calls[run[k]->rec], run[k],
+					stats);
+
+	free(run);
+}
+
+/*
+ * get (allocate on first use) the lowered block of a context
+ *
+ * @context:	the engine context
+ *
+ * returns: the block, or NULL on error
+ */
+static ir_block_t *
+ir_block_get(idft_context_t *context)
+{
+	if (unlikely(context->ir_block == NULL))
+		context->ir_block = calloc(1, sizeof(ir_block_t));
+
+	return (ir_block_t *)context->ir_block;
+}
+
+/*
+ * record, lower and optimize a block
+ *
+ * @ins:	the instructions of the block, in order
+ * @ins_num:	instruction count
+ * @ends:	for a trace, where each of its blocks but the
+ *		last ends (the index of the next instruction);
+ *		NULL for a single block
+ * @nends:	their count (at most IR_EXIT_MAX)
+ * @context:	the engine context
+ * @stats:	statistics
+ *
+ * returns: the optimized block (its calls are in the record
+ * buffer of the context), or NULL if it could not be lowered;
+ * nothing has been inserted in either case
+ */
+ir_block_t *
+ir_build(idft_ins_t *ins, uint32_t ins_num, const uint32_t *ends,
+		uint32_t nends, idft_context_t *context,
+		idft_block_stats_t *stats)
+{
+	uint32_t exits[IR_EXIT_MAX], i, e = 0;
+	ir_block_t *blk;
+	rec_buf_t *buf;
+
+	if (unlikely(nends > IR_EXIT_MAX) ||
+			(buf = rec_buf_get(context)) == NULL ||
+			(blk = ir_block_get(context)) == NULL)
+		return NULL;
+
+	rec_begin(context);
+	for (i = 0; i < ins_num; i++) {
+		ins_inspect(&ins[i], context);
+
+		/* the calls after this may not run */
+		for (; e < nends && ends[e] == i + 1; e++)
+			exits[e] = buf->ncalls;
+	}
+	rec_end(context);
+
+	/* did not fit */
+	if (unlikely(buf->overflow))
+		return NULL;
+
+	stats->calls_in = buf->ncalls;
+
+	ir_lower(buf, blk, exits, e);
+	stats->uops = blk->nuops;
+
+	ir_optimize(blk, stats);
+
+	if (context->opts & IDFT_OPT_IDIOM)
+		idiom_fuse(context, buf, blk, stats);
+
+	if (context->opts & IDFT_OPT_COALESCE)
+		coalesce_fuse(context, buf, blk, stats);
+
+	return blk;
+}
+
+/* add up statistics */
+static void
+ir_stats_sum(idft_block_stats_t *sum, const idft_block_stats_t *st)
+{
+	sum->ins	+= st->ins;
+	sum->calls_in	+= st->calls_in;
+	sum->calls_out	+= st->calls_out;
+	sum->uops	+= st->uops;
+	sum->dead	+= st->dead;
+	sum->copyprop	+= st->copyprop;
+	sum->folded	+= st->folded;
+	sum->jitted	+= st->jitted;
+	sum->fused	+= st->fused;
+	sum->packed	+= st->packed;
+	sum->coalesced	+= st->coalesced;
+	sum->prefetched	+= st->prefetched;
+}
+
+/*
+ * accumulate per-block statistics into the context
+ */
+void
+ir_stats_add(idft_context_t *context, idft_block_stats_t *st)
+{
+	ir_stats_sum(&context->stats, st);
+}
+
+/*
+ * instrument a block, or a trace (see ir_build)
+ *
+ * @ins:	the instructions, in order
+ * @ins_num:	instruction count
+ * @ends:	the ends of the blocks of a trace, or NULL
+ * @nends:	their count
+ * @context:	the engine context
+ * @stats:	statistics (out); may be NULL
+ */
+static void
+ir_inspect(idft_ins_t *ins, uint32_t ins_num, const uint32_t *ends,
+		uint32_t nends, idft_context_t *context,
+		idft_block_stats_t *stats)
+{
+	idft_block_stats_t st;
+	ir_block_t *blk;
+	uint32_t i;
+
+	memset(&st, 0, sizeof(st));
+	st.ins = ins_num;
+
+	/* not hot yet; counted, and instrumented plainly */
+	if ((context->opts & IDFT_OPT_TIER) &&
+			tier_cold(ins, ins_num, context))
+		goto done;
+
+	/* optimization off, or not lowered; plain instrumentation */
+	if ((context->opts & IDFT_OPT_IR) == 0 ||
+			(blk = ir_build(ins, ins_num, ends, nends, context,
+				&st)) == NULL) {
+		memset(&st, 0, sizeof(st));
+		st.ins = ins_num;
+		if (context->opts & IDFT_OPT_PREFETCH)
+			prefetch_emit(ins, ins_num, context, &st);
+		for (i = 0; i < ins_num; i++)
+			ins_inspect(&ins[i], context);
+		goto done;
+	}
+
+	/* first thing in the block */
+	if (context->opts & IDFT_OPT_PREFETCH)
+		prefetch_emit(ins, ins_num, context, &st);
+
+	ir_emit(context, (rec_buf_t *)context->rec_buf, blk, &st);
+
+	if (context->opts & IDFT_OPT_IR_LOG)
+		IDFT_LOG("%s: %u ins, %u uops, %u dead, %u copyprop, "
+			"%u folded, %u jitted, %u fused, %u coalesced, "
+			"%u -> %u calls (%u packed), %u prefetched\n",
+			(ends != NULL) ? "trace" : "bbl",
+			st.ins, st.uops, st.dead, st.copyprop,
+			st.folded, st.jitted, st.fused, st.coalesced,
+			st.calls_in, st.calls_out, st.packed, st.prefetched);
+
+done:
+	ir_stats_add(context, &st);
+
+	if (stats != NULL)
+		*stats = st;
+}
+
+/*
+ * instruction inspection at block granularity
+ *
+ * lower the instructions of a block into micro-ops,
+ * optimize them and insert what remains
+ *
+ * NOTE: the instructions must form a basic block; i.e.,
+ * they are executed in order, and all of them or none
+ *
+ * @ins:	the instructions of the block, in order
+ * @ins_num:	instruction count
+ * @context:	the engine context
+ * @stats:	per-block statistics (out); may be NULL
+ */
+void
+bbl_inspect(idft_ins_t *ins, uint32_t ins_num, idft_context_t *context,
+		idft_block_stats_t *stats)
+{
+	ir_inspect(ins, ins_num, NULL, 0, context, stats);
+}
+
+/*
+ * instruction inspection at trace granularity
+ *
+ * like bbl_inspect, over a superblock: the passes see
+ * all of its blocks at once, and only assume that every
+ * register is live at the exits between them
+ *
+ * NOTE: the trace must have a single entry (its first
+ * instruction); it may be left after any of its blocks
+ *
+ * @ins:	the instructions of the trace, in order
+ * @bbl_len:	the instruction count of each block
+ * @bbl_num:	block count
+ * @context:	the engine context
+ * @stats:	per-trace statistics (out); may be NULL
+ */
+void
+trace_inspect(idft_ins_t *ins, const uint32_t *bbl_len, uint32_t bbl_num,
+		idft_context_t *context, idft_block_stats_t *stats)
+{
+	uint32_t ends[IR_EXIT_MAX], i, n = 0;
+	idft_block_stats_t st;
+
+	if (stats != NULL)
+		memset(stats, 0, sizeof(*stats));
+
+	/* too many exits; block by block */
+	if (unlikely(bbl_num > IR_EXIT_MAX + 1)) {
+		for (i = 0; i < bbl_num; n += bbl_len[i++]) {
+			bbl_inspect(&ins[n], bbl_len[i], context, &st);
+			if (stats != NULL)
+				ir_stats_sum(stats, &st);
+		}
+		return;
+	}
+
+	for (i = 0; i + 1 < bbl_num; i++)
+		ends[i] = (n += bbl_len[i]);
+
+	ir_inspect(ins, n + ((bbl_num > 0) ? bbl_len[bbl_num - 1] : 0),
+			ends, (bbl_num > 0) ? bbl_num - 1 : 0, context, stats);
+}
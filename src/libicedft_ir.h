@@ -0,0 +1,95 @@
+#ifndef LIBICEDFT_IR_H
+#define LIBICEDFT_IR_H
+
+#include <stdint.h>
+#include "libicedft_types.h"
+#include "libicedft_rec.h"
+
+#define IR_EXIT_MAX	32			/* side exits per trace */
+#define IR_UOP_MAX	((REC_CALL_MAX << 2) + IR_EXIT_MAX)	/* micro-ops per block */
+#define IR_NOREG	0xFF			/* no register */
+
+/* micro-op kinds */
+enum {
+/* #define */ UOP_NOP	= 0,		/* eliminated */
+/* #define */ UOP_COPY	= 1,		/* t[dst] = t[src] */
+/* #define */ UOP_UNION	= 2,		/* t[dst] |= t[src] */
+/* #define */ UOP_CLEAR	= 3,		/* t[dst] = 0 */
+/* #define */ UOP_EXTEND	= 4,		/* t[dst] = t[src] (replicated) */
+/* #define */ UOP_OPAQUE	= 5,		/* anything else; a barrier */
+/* #define */ UOP_EXIT	= 6		/* side exit of a trace (no call) */
+};
+
+/* location kinds */
+enum {
+/* #define */ LOC_NONE	= 0,
+/* #define */ LOC_REG	= 1,		/* VCPU register bytes */
+/* #define */ LOC_MEM	= 2		/* memory bytes */
+};
+
+/*
+ * a micro-op operand
+ *
+ * register operands name the VCPU register and the byte
+ * lanes (i.e., the VCPU tag bits) involved; lanes are
+ * paired in order between a source and a destination,
+ * so {mask 0x2} <- {mask 0x1} moves the low byte to the
+ * upper 8-bit half. Destination lanes left over are
+ * cleared by UOP_COPY (zero extension) and filled by
+ * repeating the source lanes by UOP_EXTEND (sign
+ * extension). Memory operands keep the IARG_* that
+ * supplies their effective address
+ */
+typedef struct {
+	uint8_t		kind;			/* LOC_* */
+	uint8_t		reg;			/* VCPU index (LOC_REG) */
+	uint8_t		mask;			/* byte lanes (LOC_REG) */
+	uint8_t		len;			/* bytes (LOC_MEM) */
+	uint32_t	ea;			/* IARG_* kind (LOC_MEM) */
+	ADDRINT		eaval;			/* its value, if it takes one */
+} ir_loc_t;
+
+/*
+ * the lanes of a whole register, and those a register
+ * destination clears beyond its mask: with IDFT_X86_64,
+ * writing a 32-bit register zero-extends it (see
+ * idft_gen_reg_merge), whatever the micro-op, unions
+ * included
+ */
+#ifndef IDFT_X86_64
+#define IR_FULL		VCPU_MASK32
+#define IR_ZEXT(loc)	0
+#else
+#define IR_FULL		VCPU_MASK64
+#define IR_ZEXT(loc)							\
+	(((loc)->kind == LOC_REG && (loc)->mask == VCPU_MASK32) ?	\
+	 (uint8_t)(VCPU_MASK64 & ~VCPU_MASK32) : 0)
+#endif
+
+/* a micro-op */
+typedef struct {
+	uint8_t		op;			/* UOP_* */
+	uint8_t		pred;			/* predicated; may not run */
+	uint8_t		changed;		/* rewritten by a pass */
+	uint32_t	rec;			/* originating call */
+	ir_loc_t	dst;
+	ir_loc_t	src;
+} ir_uop_t;
+
+/* a lowered block */
+typedef struct {
+	uint32_t	nuops;
+	ir_uop_t	uops[IR_UOP_MAX];
+} ir_block_t;
+
+void	ir_lower(rec_buf_t *buf, ir_block_t *blk, const uint32_t *exits,
+		uint32_t nexits);
+void	ir_optimize(ir_block_t *blk, idft_block_stats_t *stats);
+void	ir_emit(idft_context_t *context, rec_buf_t *buf, ir_block_t *blk,
+		idft_block_stats_t *stats);
+ir_block_t	*ir_build(idft_ins_t *ins, uint32_t ins_num,
+		const uint32_t *ends, uint32_t nends, idft_context_t *context,
+		idft_block_stats_t *stats);
+void	ir_stats_add(idft_context_t *context, idft_block_stats_t *stats);
+
+#endif /* LIBICEDFT_IR_H */
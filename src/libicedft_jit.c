@@ -0,0 +1,375 @@
+/*
+ * x86 code generator for register micro-ops
+ *
+ * runs of register-only micro-ops (see libicedft_ir.c) are
+ * compiled into straight-line native stubs, with the VCPU
+ * offsets and lane masks encoded as immediates. A stub takes
+ * the thread context as its only argument, so the executer
+ * is handed one call target (and one argument) per run instead
+ * of one call per analysis routine.
+ *
+ * stubs live in a fixed-size executable code cache; when it
+ * fills up it is flushed as a whole, after the executer has
+ * been told (through its flush hook) to drop every block that
+ * may still call into it
+ */
+
+#ifdef __GNUC__
+#include <sys/mman.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "libicedft_jit.h"
+#include "libicedft_core.h"
+#include "libicedft_util.h"
+#include "branch_pred.h"
+
+#if defined(__i386__) || defined(_M_IX86)
+#define JIT_X86_32
+#elif defined(__x86_64__) || defined(_M_X64)
+#define JIT_X86_64
+#endif
+
+/* VCPU register offset within thread_ctx_t */
+#ifndef USE_PACKED_VCPU
+#define JIT_GPR_OFF(reg)						\
+	((uint32_t)(offsetof(thread_ctx_t, vcpu) +			\
+	offsetof(vcpu_ctx_t, gpr) + (reg) * sizeof(uint32_t)))
+#else
+#define JIT_GPR_OFF(reg)	((uint32_t)(reg))	/* unused */
+#endif
+
+
+/* emitters */
+#define E8(p, b)	(*(p)++ = (uint8_t)(b))
+#define E32(p, d)							\
+	do {								\
+		uint32_t _d = (uint32_t)(d);				\
+		memcpy((p), &_d, sizeof(_d));				\
+		(p) += sizeof(_d);					\
+	} while (0)
+
+/* mov eax, [ecx + disp32] */
+#define LOAD_EAX(p, off)	do { E8(p, 0x8B); E8(p, 0x81); E32(p, off); } while (0)
+/* mov [ecx + disp32], eax */
+#define STORE_EAX(p, off)	do { E8(p, 0x89); E8(p, 0x81); E32(p, off); } while (0)
+/* or [ecx + disp32], eax */
+#define OR_EAX(p, off)		do { E8(p, 0x09); E8(p, 0x81); E32(p, off); } while (0)
+/* and dword [ecx + disp32], imm32 */
+#define AND_MEM(p, off, imm)	do { E8(p, 0x81); E8(p, 0xA1); E32(p, off); E32(p, imm); } while (0)
+/* mov dword [ecx + disp32], imm32 */
+#define MOV_MEM(p, off, imm)	do { E8(p, 0xC7); E8(p, 0x81); E32(p, off); E32(p, imm); } while (0)
+/* and eax, imm8 */
+#define AND_EAX(p, imm)		do { E8(p, 0x83); E8(p, 0xE0); E8(p, imm); } while (0)
+/* shr eax, imm8 */
+#define SHR_EAX(p, imm)		do { E8(p, 0xC1); E8(p, 0xE8); E8(p, imm); } while (0)
+/* shl eax, imm8 */
+#define SHL_EAX(p, imm)		do { E8(p, 0xC1); E8(p, 0xE0); E8(p, imm); } while (0)
+/* mov edx, eax; shl edx, imm8; or eax, edx */
+#define REPL_EAX(p, imm)						\
+	do {								\
+		E8(p, 0x89); E8(p, 0xC2);				\
+		E8(p, 0xC1); E8(p, 0xE2); E8(p, imm);			\
+		E8(p, 0x09); E8(p, 0xD0);				\
+	} while (0)
+
+
+/*
+ * is there a code generator for this host; stubs address
+ * the VCPU registers as 32-bit words, hence none with
+ * USE_PACKED_VCPU
+ *
+ * returns: 1 if yes, 0 otherwise
+ */
+int
+jit_available(void)
+{
+#if (defined(JIT_X86_32) || defined(JIT_X86_64)) && !defined(USE_PACKED_VCPU)
+	return 1;
+#else
+	return 0;
+#endif
+}
+
+/* lowest lane of a mask and the number of lanes in it */
+static uint8_t
+jit_lane_first(uint8_t mask)
+{
+	uint8_t i = 0;
+
+	while (i < 8 && (mask & (1 << i)) == 0)
+		i++;
+
+	return i;
+}
+
+static uint8_t
+jit_lane_count(uint8_t mask)
+{
+	uint8_t n = 0;
+
+	for (; mask; mask >>= 1)
+		n += (mask & 1);
+
+	return n;
+}
+
+/*
+ * compile one micro-op
+ *
+ * NOTE: all the VCPU lane masks in use are contiguous
+ * (VCPU_MASK64, VCPU_MASK32, VCPU_MASK16, VCPU_MASK8 and
+ * its upper 8-bit counterpart), so moving lanes is a shift
+ *
+ * @p:		code pointer
+ * @uop:	the micro-op (JIT_UOP_OK)
+ *
+ * returns: the updated code pointer
+ */
+static uint8_t *
+jit_uop(uint8_t *p, ir_uop_t *uop)
+{
+	uint32_t doff = JIT_GPR_OFF(uop->dst.reg);
+	uint32_t soff;
+	uint8_t dmask = uop->dst.mask, smask, sl, dl, ns, nd;
+	uint8_t z = IR_ZEXT(&uop->dst);
+
+	/* t[dst] = 0 */
+	if (uop->op == UOP_CLEAR) {
+		if ((dmask | z) == IR_FULL)
+			MOV_MEM(p, doff, 0);
+		else
+			AND_MEM(p, doff, ~(uint32_t)dmask);
+		return p;
+	}
+
+	smask	= uop->src.mask;
+	soff	= JIT_GPR_OFF(uop->src.reg);
+
+	LOAD_EAX(p, soff);
+
+	/* lanes line up; no shifting */
+	if (uop->op != UOP_EXTEND && smask == dmask) {
+		if (smask != IR_FULL)
+			AND_EAX(p, smask);
+	}
+	else {
+		sl = jit_lane_first(smask);
+		dl = jit_lane_first(dmask);
+		ns = jit_lane_count(smask);
+		nd = jit_lane_count(dmask);
+
+		/* isolate the source lanes at lane 0 */
+		AND_EAX(p, smask);
+		if (sl)
+			SHR_EAX(p, sl);
+
+		/* sign extension; repeat the source lanes */
+		if (uop->op == UOP_EXTEND)
+			for (; ns < nd; ns <<= 1)
+				REPL_EAX(p, ns);
+
+		/* place them (the rest is zero extension) */
+		if (dl)
+			SHL_EAX(p, dl);
+		AND_EAX(p, dmask);
+	}
+
+	if (uop->op == UOP_UNION) {
+		/* zero extension */
+		if (z)
+			AND_MEM(p, doff, ~(uint32_t)z);
+		OR_EAX(p, doff);
+	}
+	else if ((dmask | z) == IR_FULL)
+		STORE_EAX(p, doff);
+	else {
+		AND_MEM(p, doff, ~(uint32_t)dmask);
+		OR_EAX(p, doff);
+	}
+
+	return p;
+}
+
+/*
+ * get (allocate on first use) the code cache of a context
+ */
+static jit_cache_t *
+jit_cache_get(idft_context_t *context)
+{
+	jit_cache_t *jc = (jit_cache_t *)context->jit;
+
+	if (likely(jc != NULL))
+		return jc;
+
+	if ((jc = calloc(1, sizeof(jit_cache_t))) == NULL)
+		return NULL;
+
+#ifdef __GNUC__
+	if (unlikely((jc->base = (uint8_t *)mmap(NULL,
+					JIT_CACHE_SZ,
+					PROT_READ | PROT_WRITE | PROT_EXEC,
+					MAP_PRIVATE | MAP_ANONYMOUS,
+					-1, 0)) == MAP_FAILED)) {
+#else
+	if (unlikely((jc->base = dr_nonheap_alloc(JIT_CACHE_SZ,
+					DR_MEMPROT_READ | DR_MEMPROT_WRITE |
+					DR_MEMPROT_EXEC)) == NULL)) {
+#endif
+		free(jc);
+		return NULL;
+	}
+
+	context->jit = jc;
+
+	return jc;
+}
+
+/*
+ * make room for the stubs of a block; must be called
+ * before compiling any of them, since flushing halfway
+ * would pull the earlier stubs from under the block
+ *
+ * @context:	the engine context
+ * @n:		micro-ops about to be compiled
+ *
+ * returns: 0 on success, 1 if there is no room
+ */
+int
+jit_reserve(idft_context_t *context, uint32_t n)
+{
+	jit_cache_t *jc;
+	size_t need = (size_t)n * (JIT_UOP_SZ + 32);
+
+	if (unlikely(need > JIT_CACHE_SZ ||
+			(jc = jit_cache_get(context)) == NULL))
+		return 1;
+
+	/* full; start over */
+	if (unlikely(jc->used + need > JIT_CACHE_SZ))
+		jit_flush(context);
+
+	return 0;
+}
+
+/*
+ * set the executer's invalidation hook
+ *
+ * @context:	the engine context
+ * @cb:		called before the code cache is flushed
+ * @arg:	its argument
+ *
+ * returns: 0 on success, 1 on error
+ */
+int
+jit_set_flush_cb(idft_context_t *context, void (*cb)(void *arg), void *arg)
+{
+	jit_cache_t *jc;
+
+	if ((jc = jit_cache_get(context)) == NULL)
+		return 1;
+
+	jc->flush_cb	= cb;
+	jc->flush_arg	= arg;
+
+	return 0;
+}
+
+/*
+ * compile a run of register micro-ops into one stub
+ *
+ * @context:	the engine context
+ * @uops:	the micro-ops, in order (all JIT_UOP_OK)
+ * @n:		their count
+ *
+ * returns: the stub, or NULL if it could not be compiled
+ */
+jit_stub_t
+jit_compile(idft_context_t *context, ir_uop_t **uops, uint32_t n)
+{
+#if defined(JIT_X86_32) || defined(JIT_X86_64)
+	jit_cache_t *jc;
+	uint8_t *start, *p;
+	size_t need = (size_t)n * JIT_UOP_SZ + 16;
+	uint32_t i;
+
+	/* see jit_reserve */
+	if (unlikely((jc = jit_cache_get(context)) == NULL ||
+			jc->used + need > JIT_CACHE_SZ))
+		return NULL;
+
+	start = p = jc->base + jc->used;
+
+#if defined(JIT_X86_32)
+	/* mov ecx, [esp + 4] */
+	E8(p, 0x8B); E8(p, 0x4C); E8(p, 0x24); E8(p, 0x04);
+#elif defined(_WIN64)
+	/* the argument is already in rcx */
+#else
+	/* mov rcx, rdi */
+	E8(p, 0x48); E8(p, 0x89); E8(p, 0xF9);
+#endif
+
+	for (i = 0; i < n; i++)
+		p = jit_uop(p, uops[i]);
+
+	/* ret */
+	E8(p, 0xC3);
+
+	/* keep stubs 16-byte aligned */
+	jc->used += ((size_t)(p - start) + 15) & ~(size_t)15;
+	jc->stubs++;
+
+	return (jit_stub_t)start;
+#else
+	return NULL;
+#endif
+}
+
+/*
+ * invalidate every stub; the executer's flush hook
+ * runs first, so that it can drop the code that may
+ * still call into the cache
+ *
+ * @context:	the engine context
+ */
+void
+jit_flush(idft_context_t *context)
+{
+	jit_cache_t *jc = (jit_cache_t *)context->jit;
+
+	if (jc == NULL)
+		return;
+
+	if (jc->flush_cb != NULL)
+		jc->flush_cb(jc->flush_arg);
+
+	jc->used	= 0;
+	jc->stubs	= 0;
+	jc->gen++;
+}
+
+/*
+ * release the code cache
+ *
+ * @context:	the engine context
+ */
+void
+jit_free(idft_context_t *context)
+{
+	jit_cache_t *jc = (jit_cache_t *)context->jit;
+
+	if (jc == NULL)
+		return;
+
+#ifdef __GNUC__
+	(void)munmap(jc->base, JIT_CACHE_SZ);
+#else
+	dr_nonheap_free(jc->base, JIT_CACHE_SZ);
+#endif
+	free(jc);
+
+	context->jit = NULL;
+}
@@ -0,0 +1,41 @@
+#ifndef LIBICEDFT_JIT_H
+#define LIBICEDFT_JIT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "libicedft_api.h"
+#include "libicedft_ir.h"
+
+#define JIT_CACHE_SZ	(1024 * 1024)		/* code cache size */
+#define JIT_UOP_SZ	64			/* max code per micro-op */
+
+/* a compiled run of register micro-ops */
+typedef void (*jit_stub_t)(thread_ctx_t *thread_ctx);
+
+/* code cache */
+typedef struct {
+	uint8_t		*base;			/* executable memory */
+	size_t		used;			/* bytes handed out */
+	uint32_t	gen;			/* bumped on every flush */
+	uint32_t	stubs;			/* live stubs */
+	void		(*flush_cb)(void *arg);	/* invalidation hook */
+	void		*flush_arg;
+} jit_cache_t;
+
+/* can a micro-op be compiled */
+#define JIT_UOP_OK(uop)							\
+	(!(uop)->pred && (uop)->dst.kind == LOC_REG &&			\
+	 ((uop)->op == UOP_CLEAR ||					\
+	  (((uop)->op == UOP_COPY || (uop)->op == UOP_UNION ||		\
+	    (uop)->op == UOP_EXTEND) && (uop)->src.kind == LOC_REG)))
+
+int		jit_available(void);
+int		jit_reserve(idft_context_t *context, uint32_t n);
+int		jit_set_flush_cb(idft_context_t *context,
+			void (*cb)(void *arg), void *arg);
+jit_stub_t	jit_compile(idft_context_t *context, ir_uop_t **uops,
+			uint32_t n);
+void		jit_flush(idft_context_t *context);
+void		jit_free(idft_context_t *context);
+
+#endif /* LIBICEDFT_JIT_H */
@@ -0,0 +1,869 @@
+/*
+ * persistent instrumentation plans
+ *
+ * what ins_inspect asks for depends only on the instruction;
+ * for the same module (i.e., the same build) and executer it is
+ * the same on every run. The plan of an instruction is the list
+ * of analysis calls ins_inspect inserted for it, with the
+ * routines replaced by stable handler ids (their index in
+ * plan_handlers below), keyed by the instruction's offset within
+ * its module.
+ *
+ * the executer names a plan file per module, along with a key
+ * (its build-id, or a hash of its contents) that must match for
+ * the file to be used. Loaded files are mapped as they are and
+ * searched in place, without any parsing; instructions that are
+ * not found there go through ins_inspect, and their plans are
+ * learned and written back on libdft_plan_save (or when the
+ * module is unloaded, or the engine shut down).
+ *
+ * instructions whose calls cannot be expressed (a routine
+ * without a handler id, say) are inspected every time, as are
+ * instructions outside any module with a plan file
+ */
+
+#ifdef __GNUC__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libicedft_api.h"
+#include "libicedft_core.h"
+#include "libicedft_plan.h"
+#include "libicedft_rec.h"
+#include "libicedft_shift.h"
+#include "libicedft_util.h"
+#include "tagmap.h"
+#include "branch_pred.h"
+
+
+#define EXE context->executer_api
+
+/*
+ * handler ids; APPEND ONLY. The index of a routine is what
+ * plan files store, so removing or reordering entries must
+ * come with a PLAN_VERSION bump
+ */
+static void *const plan_handlers[] = {
+	(void *)_cwde,
+	(void *)_movsx_r2r_opwb_u,
+	(void *)_movsx_r2r_opwb_l,
+	(void *)_movsx_r2r_oplb_u,
+	(void *)_movsx_r2r_oplb_l,
+	(void *)_movsx_r2r_oplw,
+	(void *)_movsx_m2r_opwb,
+	(void *)_movsx_m2r_oplb,
+	(void *)_movsx_m2r_oplw,
+	(void *)_movzx_r2r_opwb_u,
+	(void *)_movzx_r2r_opwb_l,
+	(void *)_movzx_r2r_oplb_u,
+	(void *)_movzx_r2r_oplb_l,
+	(void *)_movzx_r2r_oplw,
+	(void *)_movzx_m2r_opwb,
+	(void *)_movzx_m2r_oplb,
+	(void *)_movzx_m2r_oplw,
+	(void *)_cmpxchg_r2r_opl_fast,
+	(void *)_cmpxchg_r2r_opl_slow,
+	(void *)_cmpxchg_r2r_opw_fast,
+	(void *)_cmpxchg_r2r_opw_slow,
+	(void *)_cmpxchg_m2r_opl_fast,
+	(void *)_cmpxchg_r2m_opl_slow,
+	(void *)_cmpxchg_m2r_opw_fast,
+	(void *)_cmpxchg_r2m_opw_slow,
+	(void *)_xchg_r2r_opb_ul,
+	(void *)_xchg_r2r_opb_lu,
+	(void *)_xchg_r2r_opb_u,
+	(void *)_xchg_r2r_opb_l,
+	(void *)_xchg_r2r_opw,
+	(void *)_xchg_m2r_opb_u,
+	(void *)_xchg_m2r_opb_l,
+	(void *)_xchg_m2r_opw,
+	(void *)_xchg_m2r_opl,
+	(void *)_xadd_r2r_opb_ul,
+	(void *)_xadd_r2r_opb_lu,
+	(void *)_xadd_r2r_opb_u,
+	(void *)_xadd_r2r_opb_l,
+	(void *)_xadd_r2r_opw,
+	(void *)_xadd_m2r_opb_u,
+	(void *)_xadd_m2r_opb_l,
+	(void *)_xadd_m2r_opw,
+	(void *)_xadd_m2r_opl,
+	(void *)_lea_r2r_opw,
+	(void *)_lea_r2r_opl,
+	(void *)r2r_ternary_opb_u,
+	(void *)r2r_ternary_opb_l,
+	(void *)r2r_ternary_opw,
+	(void *)r2r_ternary_opl,
+	(void *)m2r_ternary_opb,
+	(void *)m2r_ternary_opw,
+	(void *)m2r_ternary_opl,
+	(void *)r2r_binary_opb_ul,
+	(void *)r2r_binary_opb_lu,
+	(void *)r2r_binary_opb_u,
+	(void *)r2r_binary_opb_l,
+	(void *)r2r_binary_opw,
+	(void *)r2r_binary_opl,
+	(void *)m2r_binary_opb_u,
+	(void *)m2r_binary_opb_l,
+	(void *)m2r_binary_opw,
+	(void *)m2r_binary_opl,
+	(void *)r2m_binary_opb_u,
+	(void *)r2m_binary_opb_l,
+	(void *)r2m_binary_opw,
+	(void *)r2m_binary_opl,
+	(void *)r_clrl4,
+	(void *)r_clrl3,
+	(void *)r_clrl2,
+	(void *)r_clrl,
+	(void *)r_clrw,
+	(void *)r_clrb_u,
+	(void *)r_clrb_l,
+	(void *)r2r_xfer_opb_ul,
+	(void *)r2r_xfer_opb_lu,
+	(void *)r2r_xfer_opb_u,
+	(void *)r2r_xfer_opb_l,
+	(void *)r2r_xfer_opw,
+	(void *)r2r_xfer_opl,
+	(void *)m2r_xfer_opb_u,
+	(void *)m2r_xfer_opb_l,
+	(void *)m2r_xfer_opw,
+	(void *)m2r_xfer_opl,
+	(void *)r2m_xfer_opbn,
+	(void *)r2m_xfer_opb_u,
+	(void *)r2m_xfer_opb_l,
+	(void *)r2m_xfer_opwn,
+	(void *)r2m_xfer_opw,
+	(void *)r2m_xfer_opln,
+	(void *)r2m_xfer_opl,
+	(void *)m2m_xfer_opw,
+	(void *)m2m_xfer_opb,
+	(void *)m2m_xfer_opl,
+	(void *)rep_predicate,
+	(void *)m2r_restore_opw,
+	(void *)m2r_restore_opl,
+	(void *)r2m_save_opw,
+	(void *)r2m_save_opl,
+	(void *)tagmap_clrb,
+	(void *)tagmap_clrw,
+	(void *)tagmap_clrl,
+	(void *)m2m_xfer_opbn,
+	(void *)m2m_xfer_opwn,
+	(void *)m2m_xfer_opln,
+	(void *)_cmov_r2r_opl,
+	(void *)_cmov_r2r_opw,
+	(void *)_cmov_m2r_opl,
+	(void *)_cmov_m2r_opw,
+	(void *)_cmpxchg_r2r_opl_bf,
+	(void *)_cmpxchg_r2r_opw_bf,
+	(void *)_cmpxchg_m2r_opl_bf,
+	(void *)_cmpxchg_m2r_opw_bf,
+	(void *)r2m_xfer_opbn_bf,
+	(void *)r2m_xfer_opwn_bf,
+	(void *)r2m_xfer_opln_bf,
+	(void *)xmm_r2r_xfer_opx,
+	(void *)xmm_r2r_xfer_opq,
+	(void *)xmm_m2r_xfer_opx,
+	(void *)xmm_m2r_xfer_opq,
+	(void *)xmm_m2r_xfer_opl,
+	(void *)xmm_r2m_xfer_opx,
+	(void *)xmm_r2m_xfer_opq,
+	(void *)xmm_r2m_xfer_opl,
+	(void *)xmm_r2x_xfer_opl,
+	(void *)xmm_x2r_xfer_opl,
+	(void *)xmm_x2r_mask_opx,
+	(void *)ymm_x2r_mask_opy,
+	(void *)xmm_r2r_binary_opx,
+	(void *)xmm_m2r_binary_opx,
+	(void *)xmm_clr_opx,
+	(void *)ymm_clr_opy,
+	(void *)ymm_clr_upper,
+	(void *)ymm_clr_all,
+	(void *)ymm_r2r_xfer_opx,
+	(void *)ymm_r2r_xfer_opy,
+	(void *)ymm_m2r_xfer_opx,
+	(void *)ymm_m2r_xfer_opy,
+	(void *)ymm_r2m_xfer_opy,
+	(void *)ymm_rr2r_binary_opx,
+	(void *)ymm_rr2r_binary_opy,
+	(void *)ymm_rm2r_binary_opx,
+	(void *)ymm_rm2r_binary_opy,
+	(void *)r_shift_opl,
+	(void *)r_shift_opw,
+	(void *)r_shift_opb_l,
+	(void *)r_shift_opb_u,
+	(void *)m_shift_opl,
+	(void *)m_shift_opw,
+	(void *)m_shift_opb,
+	(void *)r2r_shiftd_opl,
+	(void *)r2r_shiftd_opw,
+	(void *)r2m_shiftd_opl,
+	(void *)r2m_shiftd_opw,
+	(void *)r_bswap_opl,
+	(void *)m2r_movbe_opl,
+	(void *)m2r_movbe_opw,
+	(void *)r2m_movbe_opl,
+	(void *)r2m_movbe_opw,
+	(void *)_cmpxchg8b_m2r_bf,
+	(void *)_enter_opl,
+	(void *)_movsx_r2r_opqb_u,
+	(void *)_movsx_r2r_opqb_l,
+	(void *)_movsx_r2r_opqw,
+	(void *)_movsx_r2r_opql,
+	(void *)_movsx_m2r_opqb,
+	(void *)_movsx_m2r_opqw,
+	(void *)_movsx_m2r_opql,
+	(void *)_cqo,
+	(void *)_cmpxchg_r2r_opq_bf,
+	(void *)_cmpxchg_m2r_opq_bf,
+	(void *)_xchg_m2r_opq,
+	(void *)_xadd_r2r_opq,
+	(void *)_xadd_m2r_opq,
+	(void *)_lea_r2r_opq,
+	(void *)m2r_ternary_opq,
+	(void *)r2r_binary_opq,
+	(void *)m2r_binary_opq,
+	(void *)r2m_binary_opq,
+	(void *)r2r_xfer_opq,
+	(void *)m2r_xfer_opq,
+	(void *)r2m_xfer_opq,
+	(void *)r2m_xfer_opqn,
+	(void *)m2m_xfer_opq,
+	(void *)m2m_xfer_opqn,
+	(void *)_cmov_r2r_opq,
+	(void *)_cmov_m2r_opq,
+	(void *)tagmap_clrq,
+	(void *)tagmap_clrn,
+	(void *)r_shift_opq,
+	(void *)m_shift_opq,
+	(void *)r2r_shiftd_opq,
+	(void *)r2m_shiftd_opq,
+	(void *)r_bswap_opq,
+	(void *)m2r_movbe_opq,
+	(void *)r2m_movbe_opq,
+	(void *)_cmpxchg16b_m2r_bf,
+	(void *)_enter_opq,
+};
+
+#define PLAN_HANDLERS	(sizeof(plan_handlers) / sizeof(plan_handlers[0]))
+
+/* learned instruction hash */
+#define PLAN_HASH(off, sz)	(((off) * 0x9E3779B1U) & ((sz) - 1))
+
+
+/*
+ * look up the handler id of an analysis routine
+ *
+ * returns: the id, or -1 if it has none
+ */
+static int
+plan_handler_id(void *func)
+{
+	uint32_t i;
+
+	for (i = 0; i < PLAN_HANDLERS; i++)
+		if (plan_handlers[i] == func)
+			return (int)i;
+
+	return -1;
+}
+
+/*
+ * find the module an address belongs to
+ */
+static plan_mod_t *
+plan_mod_find(plan_t *p, ADDRINT addr)
+{
+	uint32_t i;
+
+	for (i = 0; i < p->nmods; i++)
+		if (addr >= p->mods[i].lo && addr <= p->mods[i].hi)
+			return &p->mods[i];
+
+	return NULL;
+}
+
+/*
+ * look up the plan of an instruction; the loaded
+ * file first (binary search), then what was learned
+ *
+ * @m:		the module
+ * @off:	the instruction offset
+ * @calls:	where its calls are (out)
+ *
+ * returns: the plan, or NULL if there is none
+ */
+static const plan_ins_t *
+plan_lookup(plan_mod_t *m, uint32_t off, const plan_call_t **calls)
+{
+	uint32_t lo = 0, hi = m->nins, mid, h;
+
+	while (lo < hi) {
+		mid = lo + ((hi - lo) >> 1);
+
+		if (m->ins[mid].off == off) {
+			*calls = m->calls;
+			return &m->ins[mid];
+		}
+
+		if (m->ins[mid].off < off)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (m->lhash == NULL)
+		return NULL;
+
+	for (h = PLAN_HASH(off, m->lhash_sz); m->lhash[h] != 0;
+			h = (h + 1) & (m->lhash_sz - 1))
+		if (m->lins[m->lhash[h] - 1].off == off) {
+			*calls = m->lcalls;
+			return &m->lins[m->lhash[h] - 1];
+		}
+
+	return NULL;
+}
+
+/*
+ * make room for one more learned instruction, and n calls
+ *
+ * returns: 0 on success, 1 on error
+ */
+static int
+plan_learn_grow(plan_mod_t *m, uint32_t n)
+{
+	uint32_t *hash, sz, i, h;
+	plan_ins_t *ins;
+	plan_call_t *calls;
+
+	/* at most half full */
+	if (m->nlins + 1 > (m->lhash_sz >> 1)) {
+		sz = (m->lhash_sz == 0) ? PLAN_HASH_MIN : m->lhash_sz << 1;
+
+		if ((hash = calloc(sz, sizeof(uint32_t))) == NULL)
+			return 1;
+		if ((ins = realloc(m->lins, (sz >> 1) *
+				sizeof(plan_ins_t))) == NULL) {
+			free(hash);
+			return 1;
+		}
+
+		for (i = 0; i < m->nlins; i++) {
+			for (h = PLAN_HASH(ins[i].off, sz); hash[h] != 0;
+					h = (h + 1) & (sz - 1))
+				;
+			hash[h] = i + 1;
+		}
+
+		free(m->lhash);
+		m->lhash	= hash;
+		m->lhash_sz	= sz;
+		m->lins		= ins;
+	}
+
+	if (m->nlcalls + n > m->lcalls_sz) {
+		sz = (m->lcalls_sz == 0) ? PLAN_HASH_MIN : m->lcalls_sz << 1;
+		while (sz < m->nlcalls + n)
+			sz <<= 1;
+
+		if ((calls = realloc(m->lcalls, sz *
+				sizeof(plan_call_t))) == NULL)
+			return 1;
+
+		m->lcalls	= calls;
+		m->lcalls_sz	= sz;
+	}
+
+	return 0;
+}
+
+/*
+ * learn the plan of an instruction from the calls
+ * ins_inspect asked for
+ *
+ * @m:		the module
+ * @off:	the instruction offset
+ * @rc:		the recorded calls
+ * @n:		their count
+ */
+static void
+plan_learn(plan_mod_t *m, uint32_t off, const rec_call_t *rc, uint32_t n)
+{
+	plan_call_t *pc;
+	uint32_t i, k, h;
+	int id;
+
+	if (plan_learn_grow(m, n))
+		return;
+
+	for (i = 0; i < n; i++) {
+		/* cannot be expressed; inspected every time */
+		if ((id = plan_handler_id(rc[i].func)) < 0)
+			return;
+
+		pc		= &m->lcalls[m->nlcalls + i];
+		memset(pc, 0, sizeof(*pc));
+		pc->id		= (uint16_t)id;
+		pc->how		= (uint8_t)rc[i].how;
+		pc->ipoint	= (uint8_t)rc[i].ipoint;
+		pc->argc	= rc[i].argc;
+
+		/* items are stored with 32 bits; so are all constants */
+		for (k = 0; k < rc[i].argc; k++) {
+			if (rc[i].argv[k] != (uint32_t)rc[i].argv[k])
+				return;
+			pc->argv[k] = (uint32_t)rc[i].argv[k];
+		}
+	}
+
+	m->lins[m->nlins].off	= off;
+	m->lins[m->nlins].first	= m->nlcalls;
+	m->lins[m->nlins].n	= n;
+
+	for (h = PLAN_HASH(off, m->lhash_sz); m->lhash[h] != 0;
+			h = (h + 1) & (m->lhash_sz - 1))
+		;
+	m->lhash[h] = ++m->nlins;
+	m->nlcalls += n;
+}
+
+/*
+ * instrument an instruction from its plan, or inspect it
+ * and learn the plan
+ *
+ * NOTE: called by ins_inspect, after the filters; the calls
+ * are issued through the current api, so that bbl_inspect
+ * records them as if ins_inspect had
+ *
+ * @ins:	the instruction
+ * @context:	the engine context
+ *
+ * returns: 1 if the instruction was instrumented, 0 if
+ * ins_inspect must go on as usual
+ */
+int
+plan_inspect(idft_ins_t *ins, idft_context_t *context)
+{
+	plan_t *p = (plan_t *)context->plans;
+	const plan_ins_t *pi;
+	const plan_call_t *pc;
+	plan_mod_t *m;
+	rec_buf_t *buf;
+	void *filter;
+	ADDRINT argv[REC_ARG_MAX];
+	uint32_t off, i, k, n0, ov0;
+
+	if (p->busy || (m = plan_mod_find(p,
+			(ADDRINT)EXE->INS_Address(ins, context))) == NULL)
+		return 0;
+
+	/* the options changed since; its plans do not hold */
+	if (unlikely((context->opts & PLAN_OPTS) != m->opts))
+		return 0;
+
+	off = (ADDRINT)EXE->INS_Address(ins, context) - m->lo;
+
+	/* known */
+	if ((pi = plan_lookup(m, off, &pc)) != NULL) {
+		for (i = pi->first; i < pi->first + pi->n; i++) {
+			for (k = 0; k < pc[i].argc; k++)
+				argv[k] = pc[i].argv[k];
+			rec_issue(context, ins, pc[i].how, pc[i].ipoint,
+				plan_handlers[pc[i].id], pc[i].argc, argv);
+		}
+		return 1;
+	}
+
+	if ((buf = rec_buf_get(context)) == NULL)
+		return 0;
+
+	/* the filters have been applied already */
+	filter		= context->filter;
+	context->filter	= NULL;
+	p->busy		= 1;
+
+	/* bbl_inspect is recording; take what was added */
+	if (context->real_api != NULL) {
+		n0	= buf->ncalls;
+		ov0	= buf->overflow;
+
+		ins_inspect(ins, context);
+
+		if (buf->overflow == ov0)
+			plan_learn(m, off, &buf->calls[n0], buf->ncalls - n0);
+	}
+	else {
+		rec_begin(context);
+		ins_inspect(ins, context);
+		rec_end(context);
+
+		for (i = 0; i < buf->ncalls; i++)
+			rec_replay(context, &buf->calls[i]);
+
+		if (buf->overflow == 0)
+			plan_learn(m, off, buf->calls, buf->ncalls);
+	}
+
+	p->busy		= 0;
+	context->filter	= filter;
+
+	return 1;
+}
+
+/*
+ * map a plan file; a missing, stale (another key,
+ * or other options) or damaged file is ignored
+ * (everything is learned anew)
+ */
+static void
+plan_map(plan_mod_t *m)
+{
+	const plan_hdr_t *hdr;
+	const plan_ins_t *ins;
+	const plan_call_t *calls;
+	size_t len, rest;
+	void *map;
+	uint32_t i;
+#ifdef __GNUC__
+	struct stat st;
+	int fd;
+
+	if ((fd = open(m->path, O_RDONLY)) < 0)
+		return;
+	if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(plan_hdr_t)) {
+		(void)close(fd);
+		return;
+	}
+	len = (size_t)st.st_size;
+	map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+	(void)close(fd);
+	if (map == MAP_FAILED)
+		return;
+#else
+	FILE *fp;
+	long sz;
+
+	if ((fp = fopen(m->path, "rb")) == NULL)
+		return;
+	if (fseek(fp, 0, SEEK_END) != 0 || (sz = ftell(fp)) <
+			(long)sizeof(plan_hdr_t) || fseek(fp, 0, SEEK_SET) != 0 ||
+			(map = malloc((size_t)sz)) == NULL) {
+		(void)fclose(fp);
+		return;
+	}
+	len = (size_t)sz;
+	if (fread(map, 1, len, fp) != len) {
+		free(map);
+		(void)fclose(fp);
+		return;
+	}
+	(void)fclose(fp);
+#endif
+
+	hdr	= (const plan_hdr_t *)map;
+
+	if (hdr->magic != PLAN_MAGIC || hdr->version != PLAN_VERSION ||
+		hdr->nhandlers > PLAN_HANDLERS || hdr->opts != m->opts ||
+		strncmp(hdr->key, m->key, PLAN_KEY_MAX) != 0)
+		goto stale;
+
+	/* bound the counts before multiplying; size_t may be 32-bit */
+	rest = len - sizeof(plan_hdr_t);
+	if (hdr->nins > rest / sizeof(plan_ins_t))
+		goto stale;
+	rest -= (size_t)hdr->nins * sizeof(plan_ins_t);
+	if (hdr->ncalls > rest / sizeof(plan_call_t) ||
+			rest != (size_t)hdr->ncalls * sizeof(plan_call_t))
+		goto stale;
+
+	ins	= (const plan_ins_t *)(hdr + 1);
+	calls	= (const plan_call_t *)(ins + hdr->nins);
+
+	/* trust, but verify what is used without checks later */
+	for (i = 0; i < hdr->nins; i++)
+		if (ins[i].first > hdr->ncalls ||
+			ins[i].n > hdr->ncalls - ins[i].first ||
+			(i > 0 && ins[i].off <= ins[i - 1].off))
+			goto stale;
+	for (i = 0; i < hdr->ncalls; i++)
+		if (calls[i].id >= hdr->nhandlers ||
+				calls[i].argc > REC_ARG_MAX)
+			goto stale;
+
+	m->map		= map;
+	m->maplen	= len;
+	m->ins		= ins;
+	m->calls	= calls;
+	m->nins		= hdr->nins;
+
+	return;
+
+stale:
+	IDFT_LOG("plan: ignoring %s\n", m->path);
+#ifdef __GNUC__
+	(void)munmap(map, len);
+#else
+	free(map);
+#endif
+}
+
+/* unmap a plan file */
+static void
+plan_unmap(plan_mod_t *m)
+{
+	if (m->map == NULL)
+		return;
+#ifdef __GNUC__
+	(void)munmap(m->map, m->maplen);
+#else
+	free(m->map);
+#endif
+	m->map		= NULL;
+	m->ins		= NULL;
+	m->calls	= NULL;
+	m->nins		= 0;
+}
+
+/* order learned instructions by offset */
+static int
+plan_ins_cmp(const void *a, const void *b)
+{
+	const plan_ins_t *x = (const plan_ins_t *)a;
+	const plan_ins_t *y = (const plan_ins_t *)b;
+
+	return (x->off > y->off) - (x->off < y->off);
+}
+
+/* write n calls of a plan */
+static int
+plan_write_calls(FILE *fp, const plan_call_t *calls, uint32_t n)
+{
+	return n != 0 && fwrite(calls, sizeof(plan_call_t), n, fp) != n;
+}
+
+/*
+ * write the plans of a module back; the loaded ones
+ * merged with the learned ones, as a new file that
+ * replaces the old one
+ *
+ * returns: 0 on success, 1 on error
+ */
+static int
+plan_write(plan_mod_t *m)
+{
+	plan_hdr_t hdr;
+	plan_ins_t *lins, e;
+	FILE *fp;
+	char *tmp;
+	uint32_t i = 0, j = 0, first = 0;
+	int err = 0;
+
+	if (m->nlins == 0)
+		return 0;
+
+	if ((tmp = malloc(strlen(m->path) + 5)) == NULL)
+		return 1;
+	sprintf(tmp, "%s.tmp", m->path);
+
+	if ((lins = malloc(m->nlins * sizeof(plan_ins_t))) == NULL) {
+		free(tmp);
+		return 1;
+	}
+	memcpy(lins, m->lins, m->nlins * sizeof(plan_ins_t));
+	qsort(lins, m->nlins, sizeof(plan_ins_t), plan_ins_cmp);
+
+	if ((fp = fopen(tmp, "wb")) == NULL) {
+		free(lins);
+		free(tmp);
+		return 1;
+	}
+
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.magic	= PLAN_MAGIC;
+	hdr.version	= PLAN_VERSION;
+	hdr.nhandlers	= PLAN_HANDLERS;
+	hdr.nins	= m->nins + m->nlins;
+	hdr.ncalls	= m->nlcalls;
+	hdr.opts	= m->opts;
+	for (i = 0; i < m->nins; i++)
+		hdr.ncalls += m->ins[i].n;
+	memcpy(hdr.key, m->key, PLAN_KEY_MAX);
+	err |= fwrite(&hdr, sizeof(hdr), 1, fp) != 1;
+
+	/* instructions; merged by offset, calls renumbered */
+	i = 0;
+	while (!err && (i < m->nins || j < m->nlins)) {
+		e = (j == m->nlins || (i < m->nins &&
+				m->ins[i].off < lins[j].off)) ?
+			m->ins[i++] : lins[j++];
+		e.first	= first;
+		first	+= e.n;
+		err |= fwrite(&e, sizeof(e), 1, fp) != 1;
+	}
+
+	/* calls, in the same order */
+	for (i = 0, j = 0; !err && (i < m->nins || j < m->nlins);)
+		if (j == m->nlins || (i < m->nins &&
+				m->ins[i].off < lins[j].off)) {
+			err |= plan_write_calls(fp, &m->calls[m->ins[i].first],
+					m->ins[i].n);
+			i++;
+		}
+		else {
+			err |= plan_write_calls(fp, &m->lcalls[lins[j].first],
+					lins[j].n);
+			j++;
+		}
+
+	err |= fclose(fp) != 0;
+	err = err || first != hdr.ncalls || rename(tmp, m->path) != 0;
+
+	if (err)
+		(void)remove(tmp);
+
+	free(lins);
+	free(tmp);
+
+	return err;
+}
+
+/*
+ * release a module; its learned plans are lost
+ */
+static void
+plan_mod_free(plan_mod_t *m)
+{
+	plan_unmap(m);
+	free(m->lins);
+	free(m->lhash);
+	free(m->lcalls);
+	free(m->path);
+}
+
+/*
+ * save the plans of every module and drop them
+ * (libdft_die)
+ */
+void
+plan_free(idft_context_t *context)
+{
+	plan_t *p = (plan_t *)context->plans;
+	uint32_t i;
+
+	if (p == NULL)
+		return;
+
+	for (i = 0; i < p->nmods; i++) {
+		(void)plan_write(&p->mods[i]);
+		plan_mod_free(&p->mods[i]);
+	}
+
+	free(p->mods);
+	free(p);
+	context->plans = NULL;
+}
+
+/*
+ * register a module with a plan file
+ *
+ * @context:	the engine context
+ * @path:	the plan file; need not exist
+ * @key:	the module build-id (or a hash of it); plans
+ *		stored under a different key are discarded
+ * @lo:		the first byte of the module
+ * @hi:		its last byte
+ *
+ * returns: 0 on success, 1 on error (or if the executer
+ * does not provide INS_Address)
+ */
+int
+libdft_plan_load(idft_context_t *context, const char *path, const char *key,
+		ADDRINT lo, ADDRINT hi)
+{
+	plan_t *p = (plan_t *)context->plans;
+	plan_mod_t *m;
+
+	if (unlikely(EXE->INS_Address == NULL || path == NULL ||
+			key == NULL || strlen(key) >= PLAN_KEY_MAX || lo > hi))
+		return 1;
+
+	if (p == NULL) {
+		if ((p = calloc(1, sizeof(plan_t))) == NULL)
+			return 1;
+		context->plans = p;
+	}
+
+	if ((m = realloc(p->mods, (p->nmods + 1) *
+			sizeof(plan_mod_t))) == NULL)
+		return 1;
+	p->mods = m;
+
+	m = &p->mods[p->nmods];
+	memset(m, 0, sizeof(*m));
+
+	if ((m->path = malloc(strlen(path) + 1)) == NULL)
+		return 1;
+	strcpy(m->path, path);
+	strncpy(m->key, key, PLAN_KEY_MAX - 1);
+	m->opts	= context->opts & PLAN_OPTS;
+	m->lo	= lo;
+	m->hi	= hi;
+
+	plan_map(m);
+	p->nmods++;
+
+	return 0;
+}
+
+/*
+ * write what was learned to the plan files
+ *
+ * @context:	the engine context
+ *
+ * returns: 0 on success, 1 if a file could not be written
+ */
+int
+libdft_plan_save(idft_context_t *context)
+{
+	plan_t *p = (plan_t *)context->plans;
+	uint32_t i;
+	int err = 0;
+
+	if (p == NULL)
+		return 0;
+
+	for (i = 0; i < p->nmods; i++)
+		err |= plan_write(&p->mods[i]);
+
+	return err;
+}
+
+/*
+ * save, and forget, the plans of a module that is gone
+ *
+ * @context:	the engine context
+ * @lo:		its first byte
+ */
+void
+libdft_plan_unload(idft_context_t *context, ADDRINT lo)
+{
+	plan_t *p = (plan_t *)context->plans;
+	uint32_t i;
+
+	if (p == NULL)
+		return;
+
+	for (i = 0; i < p->nmods; i++)
+		if (p->mods[i].lo == lo) {
+			(void)plan_write(&p->mods[i]);
+			plan_mod_free(&p->mods[i]);
+			p->mods[i] = p->mods[--p->nmods];
+			return;
+		}
+}
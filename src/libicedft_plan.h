@@ -0,0 +1,82 @@
+#ifndef LIBICEDFT_PLAN_H
+#define LIBICEDFT_PLAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "libicedft_api.h"
+#include "libicedft_rec.h"
+
+#define PLAN_MAGIC	0x4E4C5044		/* "DPLN" */
+#define PLAN_VERSION	2			/* bump on any layout change */
+#define PLAN_KEY_MAX	64			/* module key, NUL included */
+#define PLAN_HASH_MIN	1024			/* initial learned slots */
+
+/* the options ins_inspect depends on; plans made under others are stale */
+#define PLAN_OPTS	IDFT_OPT_BRANCHFREE
+
+/*
+ * plan file layout: the header, nins instructions
+ * sorted by offset, then ncalls calls
+ */
+typedef struct {
+	uint32_t	magic;			/* PLAN_MAGIC */
+	uint32_t	version;		/* PLAN_VERSION */
+	uint32_t	nhandlers;		/* handler ids known to the writer */
+	uint32_t	nins;
+	uint32_t	ncalls;
+	uint32_t	opts;			/* context->opts & PLAN_OPTS */
+	char		key[PLAN_KEY_MAX];	/* module build-id or hash */
+} plan_hdr_t;
+
+/* the plan of an instruction */
+typedef struct {
+	uint32_t	off;			/* offset within the module */
+	uint32_t	first;			/* its first call */
+	uint32_t	n;			/* call count; may be 0 */
+} plan_ins_t;
+
+/* an analysis call; the routine by handler id */
+typedef struct {
+	uint16_t	id;			/* index in plan_handlers */
+	uint8_t		how;			/* REC_* */
+	uint8_t		ipoint;			/* IDFT_IPOINT_* */
+	uint32_t	argc;
+	uint32_t	argv[REC_ARG_MAX];	/* IARG_* items; 32-bit constants only */
+} plan_call_t;
+
+/* the plans of a module */
+typedef struct {
+	char		*path;			/* plan file */
+	char		key[PLAN_KEY_MAX];
+	uint32_t	opts;			/* as of libdft_plan_load */
+	ADDRINT		lo;			/* first byte */
+	ADDRINT		hi;			/* last byte */
+
+	/* loaded; read-only */
+	void		*map;
+	size_t		maplen;
+	const plan_ins_t	*ins;
+	const plan_call_t	*calls;
+	uint32_t	nins;
+
+	/* learned during this run */
+	plan_ins_t	*lins;
+	uint32_t	nlins;
+	uint32_t	*lhash;			/* lins index + 1; 0 if free */
+	uint32_t	lhash_sz;		/* a power of 2 */
+	plan_call_t	*lcalls;
+	uint32_t	nlcalls;
+	uint32_t	lcalls_sz;
+} plan_mod_t;
+
+/* the plan caches of a context */
+typedef struct {
+	plan_mod_t	*mods;
+	uint32_t	nmods;
+	uint32_t	busy;			/* inside plan_inspect */
+} plan_t;
+
+int	plan_inspect(idft_ins_t *ins, idft_context_t *context);
+void	plan_free(idft_context_t *context);
+
+#endif /* LIBICEDFT_PLAN_H */
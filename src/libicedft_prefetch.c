@@ -0,0 +1,118 @@
+/*
+ * shadow prefetching
+ *
+ * the tags of a memory access live 1/8 of the address space
+ * away from it (see tagmap.c), so heap accesses that hit the
+ * cache natively often miss in the tagmap, and the analysis
+ * routine stalls on it. With IDFT_OPT_PREFETCH, bbl_inspect
+ * inserts one call at the entry of every block that
+ * prefetches the tagmap lines of (up to PREFETCH_MAX of) its
+ * later accesses, so that the misses overlap with the
+ * instructions, and analysis calls, before them.
+ *
+ * the addresses are the values of the base registers at block
+ * entry plus the displacements (see INS_MemoryDisplacement;
+ * 0 if the executer cannot tell). A base register may change
+ * before the access; prefetches are hints, so the guess is
+ * wasted at worst. Accesses with an index register, relative
+ * to ESP or EBP (the stack is mostly cached), or made by the
+ * first instruction (its routine runs right after) are
+ * skipped, and so are those that share a tagmap line (same
+ * base, same 1 << PREFETCH_SHIFT displacement bucket)
+ */
+
+#include <stddef.h>
+
+#include "libicedft_api.h"
+#include "libicedft_core.h"
+#include "libicedft_filter.h"
+#include "libicedft_prefetch.h"
+#include "libicedft_rec.h"
+#include "branch_pred.h"
+
+
+#define EXE context->executer_api
+
+static void * const prefetch_fn[PREFETCH_MAX + 1] = {
+	NULL,
+	(void *)shadow_prefetch1,
+	(void *)shadow_prefetch2,
+	(void *)shadow_prefetch3,
+};
+
+/* is an instruction left alone by the filters */
+static int
+prefetch_included(idft_ins_t *ins, idft_context_t *context)
+{
+	if (context->filter == NULL || EXE->INS_Address == NULL)
+		return 1;
+
+	return filter_lookup((filter_t *)context->filter,
+		(ADDRINT)EXE->INS_Address(ins, context)) == IDFT_FILTER_INCLUDE;
+}
+
+/*
+ * insert the prefetch call of a block
+ *
+ * @ins:	the instructions of the block, in order
+ * @ins_num:	instruction count
+ * @context:	the engine context
+ * @stats:	statistics
+ */
+void
+prefetch_emit(idft_ins_t *ins, uint32_t ins_num, idft_context_t *context,
+		idft_block_stats_t *stats)
+{
+	idft_reg_t base[PREFETCH_MAX], reg;
+	int32_t disp[PREFETCH_MAX], d;
+	ADDRINT argv[REC_ARG_MAX];
+	uint32_t argc = 0, i, k, n = 0;
+
+	for (i = 1; i < ins_num && n < PREFETCH_MAX; i++) {
+		if (EXE->INS_MemoryOperandCount(&ins[i], context) == 0)
+			continue;
+
+		reg = EXE->INS_MemoryBaseReg(&ins[i], context);
+		if (reg == EXE->REG_INVALID(&ins[i], context) ||
+			reg == EXE->REG_ESP(&ins[i], context) ||
+			reg == EXE->REG_EBP(&ins[i], context) ||
+			EXE->INS_MemoryIndexReg(&ins[i], context) !=
+				EXE->REG_INVALID(&ins[i], context))
+			continue;
+
+		if (!prefetch_included(&ins[i], context))
+			continue;
+
+		d = (EXE->INS_MemoryDisplacement != NULL) ?
+			(int32_t)EXE->INS_MemoryDisplacement(&ins[i], context) :
+			0;
+
+		/* one per tagmap line */
+		for (k = 0; k < n; k++)
+			if (base[k] == reg &&
+				(d >> PREFETCH_SHIFT) ==
+					(disp[k] >> PREFETCH_SHIFT))
+				break;
+		if (k < n)
+			continue;
+
+		base[n]	= reg;
+		disp[n]	= d;
+		n++;
+	}
+
+	if (n == 0 || !prefetch_included(&ins[0], context))
+		return;
+
+	for (k = 0; k < n; k++) {
+		argv[argc++] = IARG_REG_VALUE;
+		argv[argc++] = base[k];
+		argv[argc++] = IARG_UINT32;
+		argv[argc++] = (uint32_t)disp[k];
+	}
+
+	rec_insert(context, &ins[0], REC_CALL, IDFT_IPOINT_BEFORE,
+			prefetch_fn[n], argc, argv);
+	stats->calls_out++;
+	stats->prefetched += n;
+}
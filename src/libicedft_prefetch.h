@@ -0,0 +1,13 @@
+#ifndef LIBICEDFT_PREFETCH_H
+#define LIBICEDFT_PREFETCH_H
+
+#include <stdint.h>
+#include "libicedft_api.h"
+
+#define PREFETCH_MAX	3			/* addresses per block (shadow_prefetch3) */
+#define PREFETCH_SHIFT	9			/* memory bytes per 64-byte tagmap line */
+
+void	prefetch_emit(idft_ins_t *ins, uint32_t ins_num, idft_context_t *context,
+		idft_block_stats_t *stats);
+
+#endif /* LIBICEDFT_PREFETCH_H */
@@ -0,0 +1,737 @@
+/*
+ * precomputed taint programs
+ *
+ * executers that cannot insert native calls cheaply (e.g.,
+ * emulators) may instead ask for a per-block taint program:
+ * the optimized micro-ops of a block (see libicedft_ir.c)
+ * encoded as compact bytecode, which a threaded interpreter
+ * runs against the thread context in one go. Memory operands
+ * refer to effective address slots, which the executer fills
+ * in before running the program; calls that cannot be lifted
+ * are kept as P_CALL, as long as their arguments are constants
+ * or effective addresses.
+ *
+ * blocks with predicated or If/Then calls (CMOVcc, SETcc,
+ * string instructions, CMPXCHG) have no program; they must be
+ * instrumented the usual way
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "libicedft_api.h"
+#include "libicedft_core.h"
+#include "libicedft_ir.h"
+#include "libicedft_prog.h"
+#include "libicedft_rec.h"
+#include "libicedft_ring.h"
+#include "tagmap.h"
+#include "branch_pred.h"
+
+
+/* tagmap */
+extern uint8_t	*bitmap;
+
+/* VCPU register tags */
+#define RTAG(r)		VCPU_GPR(thread_ctx, (r))
+#define RTAG_SET(r, v)	VCPU_GPR_SET(thread_ctx, (r), (v))
+
+/* mask of n low bits */
+#define LEN_MASK(n)	((1U << (n)) - 1)
+
+/* the tag bits of n bytes at addr */
+#define MEM_TAG(addr, n)						\
+	((*((uint16_t *)(bitmap + VIRT2BYTE(addr))) >> VIRT2BIT(addr)) &	\
+	LEN_MASK(n))
+
+/* overwrite the tag bits of n bytes at addr */
+#define MEM_SET(addr, n, v)						\
+	(*((uint16_t *)(bitmap + VIRT2BYTE(addr))) =			\
+	(*((uint16_t *)(bitmap + VIRT2BYTE(addr))) &			\
+	~(LEN_MASK(n) << VIRT2BIT(addr))) | ((v) << VIRT2BIT(addr)))
+
+/* merge into the tag bits of n bytes at addr */
+#define MEM_OR(addr, v)							\
+	(*((uint16_t *)(bitmap + VIRT2BYTE(addr))) |= ((v) << VIRT2BIT(addr)))
+
+/*
+ * P_CALL signatures; UINT32 arguments are passed in ADDRINT
+ * slots too, as the executer itself would
+ */
+typedef void (*p_call0_t)(thread_ctx_t *);
+typedef void (*p_call1_t)(thread_ctx_t *, ADDRINT);
+typedef void (*p_call2_t)(thread_ctx_t *, ADDRINT, ADDRINT);
+typedef void (*p_call3_t)(thread_ctx_t *, ADDRINT, ADDRINT, ADDRINT);
+typedef void (*p_call4_t)(thread_ctx_t *, ADDRINT, ADDRINT, ADDRINT,
+		ADDRINT);
+
+/* program under construction */
+typedef struct {
+	idft_ins_t		*ins;		/* the block */
+	uint8_t			*code;
+	uint32_t		len;
+	uint32_t		nslots;
+	uint32_t		npool;
+	uint32_t		nfns;
+	idft_prog_slot_t	slots[PROG_TBL_MAX];
+	ADDRINT			pool[PROG_TBL_MAX];
+	void			*fns[PROG_TBL_MAX];
+} prog_asm_t;
+
+
+/* number of lanes in a mask */
+static uint8_t
+prog_lanes(uint8_t mask)
+{
+	uint8_t n = 0;
+
+	for (; mask; mask >>= 1)
+		n += (mask & 1);
+
+	return n;
+}
+
+/* first lane of a mask */
+static uint8_t
+prog_first(uint8_t mask)
+{
+	uint8_t i = 0;
+
+	while (i < 7 && (mask & (1 << i)) == 0)
+		i++;
+
+	return i;
+}
+
+/*
+ * get the slot of an effective address
+ *
+ * @pa:		the program under construction
+ * @ins:	the instruction
+ * @iarg:	IARG_MEMORYREAD_EA or IARG_MEMORYWRITE_EA
+ *
+ * returns: the slot, or -1 if it cannot be expressed
+ */
+static int
+prog_slot(prog_asm_t *pa, idft_ins_t *ins, uint32_t iarg)
+{
+	uint32_t i, idx, write;
+
+	if (iarg != IARG_MEMORYREAD_EA && iarg != IARG_MEMORYWRITE_EA)
+		return -1;
+
+	idx	= (uint32_t)(ins - pa->ins);
+	write	= (iarg == IARG_MEMORYWRITE_EA);
+
+	for (i = 0; i < pa->nslots; i++)
+		if (pa->slots[i].ins == idx && pa->slots[i].write == write)
+			return (int)i;
+
+	if (pa->nslots == PROG_TBL_MAX)
+		return -1;
+
+	pa->slots[pa->nslots].ins	= idx;
+	pa->slots[pa->nslots].write	= write;
+
+	return (int)pa->nslots++;
+}
+
+/* get the index of a constant, or -1 */
+static int
+prog_const(prog_asm_t *pa, ADDRINT val)
+{
+	uint32_t i;
+
+	for (i = 0; i < pa->npool; i++)
+		if (pa->pool[i] == val)
+			return (int)i;
+
+	if (pa->npool == PROG_TBL_MAX)
+		return -1;
+
+	pa->pool[pa->npool] = val;
+
+	return (int)pa->npool++;
+}
+
+/* get the index of a routine, or -1 */
+static int
+prog_fn(prog_asm_t *pa, void *fn)
+{
+	uint32_t i;
+
+	for (i = 0; i < pa->nfns; i++)
+		if (pa->fns[i] == fn)
+			return (int)i;
+
+	if (pa->nfns == PROG_TBL_MAX)
+		return -1;
+
+	pa->fns[pa->nfns] = fn;
+
+	return (int)pa->nfns++;
+}
+
+/*
+ * encode an opaque call
+ *
+ * returns: 0 on success, 1 if it cannot be expressed
+ */
+static int
+prog_asm_call(prog_asm_t *pa, rec_call_t *call)
+{
+	uint8_t *p = pa->code + pa->len;
+	uint32_t i, argc = 0;
+	int fn, idx;
+
+	/* only plain calls taking the thread context first */
+	if (call->how != REC_CALL || call->ipoint != IDFT_IPOINT_BEFORE ||
+		call->argc == 0 || call->argv[0] != IARG_THREAD_CONTEXT ||
+		(fn = prog_fn(pa, call->func)) < 0)
+		return 1;
+
+	*p++ = P_CALL;
+	*p++ = (uint8_t)fn;
+	p++;
+
+	for (i = 1; i < call->argc; i++, argc++) {
+		if (argc == PROG_ARG_MAX)
+			return 1;
+
+		switch (call->argv[i]) {
+			case IARG_UINT32:
+			case IARG_ADDRINT:
+				if (++i == call->argc ||
+					(idx = prog_const(pa,
+						call->argv[i])) < 0)
+					return 1;
+				*p++ = PA_CONST;
+				*p++ = (uint8_t)idx;
+				break;
+			case IARG_MEMORYREAD_EA:
+			case IARG_MEMORYWRITE_EA:
+				if ((idx = prog_slot(pa, call->ins,
+						call->argv[i])) < 0)
+					return 1;
+				*p++ = PA_SLOT;
+				*p++ = (uint8_t)idx;
+				break;
+			/* runtime values the program has no access to */
+			default:
+				return 1;
+		}
+	}
+
+	pa->code[pa->len + 2] = (uint8_t)argc;
+	pa->len = (uint32_t)(p - pa->code);
+
+	return 0;
+}
+
+/*
+ * encode a micro-op
+ *
+ * returns: 0 on success, 1 if it cannot be expressed
+ */
+static int
+prog_asm_uop(prog_asm_t *pa, rec_buf_t *buf, ir_uop_t *uop)
+{
+	rec_call_t *call = &buf->calls[uop->rec];
+	uint8_t *p = pa->code + pa->len;
+	uint8_t dn, sn, base, z = IR_ZEXT(&uop->dst);
+	int ds = 0, ss = 0;
+
+	/* no predicate to evaluate */
+	if (uop->pred)
+		return 1;
+
+	if (uop->op == UOP_OPAQUE)
+		return prog_asm_call(pa, call);
+
+	if (uop->dst.kind == LOC_MEM &&
+		(ds = prog_slot(pa, call->ins, uop->dst.ea)) < 0)
+		return 1;
+	if (uop->src.kind == LOC_MEM &&
+		(ss = prog_slot(pa, call->ins, uop->src.ea)) < 0)
+		return 1;
+
+	switch (uop->op) {
+		case UOP_CLEAR:
+			*p++ = P_CLR;
+			*p++ = uop->dst.reg;
+			*p++ = uop->dst.mask | z;
+			break;
+		case UOP_COPY:
+		case UOP_UNION:
+		case UOP_EXTEND:
+			/* base opcode of the family; COPY, UNION, EXT */
+			base = (uop->op == UOP_COPY) ? 0 :
+				(uop->op == UOP_UNION) ? 1 : 2;
+
+			/* memory to memory */
+			if (uop->dst.kind == LOC_MEM &&
+				uop->src.kind == LOC_MEM) {
+				if (uop->op != UOP_COPY)
+					return 1;
+				*p++ = P_MM_COPY;
+				*p++ = (uint8_t)ds;
+				*p++ = (uint8_t)ss;
+				*p++ = uop->dst.len;
+				break;
+			}
+
+			/* register to memory */
+			if (uop->dst.kind == LOC_MEM) {
+				if (uop->op == UOP_EXTEND)
+					return 1;
+				sn = prog_lanes(uop->src.mask);
+				*p++ = P_RM_COPY + base;
+				*p++ = (uint8_t)ds;
+				*p++ = uop->src.reg;
+				*p++ = uop->src.mask;
+				*p++ = PROG_SH(prog_first(uop->src.mask), 0,
+						sn, uop->dst.len);
+				break;
+			}
+
+			dn = prog_lanes(uop->dst.mask);
+
+			/* zero extension; unions clear it first */
+			if (z && uop->op == UOP_UNION) {
+				*p++ = P_CLR;
+				*p++ = uop->dst.reg;
+				*p++ = z;
+				z = 0;
+			}
+
+			/* memory to register */
+			if (uop->src.kind == LOC_MEM) {
+				*p++ = P_MR_COPY + base;
+				*p++ = uop->dst.reg;
+				*p++ = uop->dst.mask | z;
+				*p++ = (uint8_t)ss;
+				*p++ = PROG_SH(0, prog_first(uop->dst.mask),
+						uop->src.len, dn);
+				break;
+			}
+
+			/* register to register; whole registers */
+			if (uop->op != UOP_EXTEND &&
+				uop->dst.mask == IR_FULL &&
+				uop->src.mask == IR_FULL) {
+				*p++ = (uop->op == UOP_COPY) ? P_MOV : P_OR;
+				*p++ = uop->dst.reg;
+				*p++ = uop->src.reg;
+				break;
+			}
+
+			sn = prog_lanes(uop->src.mask);
+			*p++ = P_RR_COPY + base;
+			*p++ = uop->dst.reg;
+			*p++ = uop->dst.mask | z;
+			*p++ = uop->src.reg;
+			*p++ = uop->src.mask;
+			*p++ = PROG_SH(prog_first(uop->src.mask),
+					prog_first(uop->dst.mask), sn, dn);
+			break;
+		default:
+			return 1;
+	}
+
+	pa->len = (uint32_t)(p - pa->code);
+
+	return 0;
+}
+
+/*
+ * build the taint program of a block
+ *
+ * @ins:	the instructions of the block, in order
+ * @ins_num:	instruction count
+ * @context:	the engine context
+ *
+ * returns: the program (free with libdft_prog_free), or
+ * NULL if the block cannot be expressed as one
+ */
+idft_prog_t *
+libdft_prog_build(idft_ins_t *ins, uint32_t ins_num, idft_context_t *context)
+{
+	idft_block_stats_t st;
+	idft_prog_t *prog = NULL;
+	prog_asm_t *pa;
+	ir_block_t *blk;
+	rec_buf_t *buf;
+	uint8_t *mem;
+	uint32_t i;
+
+	memset(&st, 0, sizeof(st));
+
+	if ((blk = ir_build(ins, ins_num, NULL, 0, context, &st)) == NULL)
+		return NULL;
+
+	buf = (rec_buf_t *)context->rec_buf;
+
+	if ((pa = calloc(1, sizeof(prog_asm_t))) == NULL)
+		return NULL;
+
+	/* 3 + 2 * PROG_ARG_MAX bytes per micro-op at most */
+	if ((pa->code = malloc(blk->nuops * (3 + 2 * PROG_ARG_MAX) + 1)) ==
+			NULL)
+		goto done;
+
+	pa->ins = ins;
+
+	for (i = 0; i < blk->nuops; i++)
+		if (blk->uops[i].op != UOP_NOP &&
+			prog_asm_uop(pa, buf, &blk->uops[i]))
+			goto done;
+
+	pa->code[pa->len++] = P_END;
+
+	/* one allocation; header, tables, code */
+	if ((mem = malloc(sizeof(idft_prog_t) +
+			pa->nslots * sizeof(idft_prog_slot_t) +
+			pa->npool * sizeof(ADDRINT) +
+			pa->nfns * sizeof(void *) + pa->len)) == NULL)
+		goto done;
+
+	prog = (idft_prog_t *)mem;
+	memset(prog, 0, sizeof(idft_prog_t));
+	mem += sizeof(idft_prog_t);
+
+	prog->ins_num	= ins_num;
+	prog->len	= pa->len;
+	prog->nslots	= pa->nslots;
+	prog->npool	= pa->npool;
+	prog->nfns	= pa->nfns;
+
+	prog->fns = (void **)mem;
+	memcpy(prog->fns, pa->fns, pa->nfns * sizeof(void *));
+	mem += pa->nfns * sizeof(void *);
+
+	prog->slots = (idft_prog_slot_t *)mem;
+	memcpy(prog->slots, pa->slots, pa->nslots * sizeof(idft_prog_slot_t));
+	mem += pa->nslots * sizeof(idft_prog_slot_t);
+
+	prog->pool = (ADDRINT *)mem;
+	memcpy(prog->pool, pa->pool, pa->npool * sizeof(ADDRINT));
+	mem += pa->npool * sizeof(ADDRINT);
+
+	prog->code = mem;
+	memcpy(prog->code, pa->code, pa->len);
+
+done:
+	free(pa->code);
+	free(pa);
+
+	return prog;
+}
+
+/*
+ * release a program that is not cached
+ */
+void
+libdft_prog_free(idft_prog_t *prog)
+{
+	free(prog);
+}
+
+/*
+ * the effective address slots of a program
+ *
+ * @prog:	the program
+ * @nslots:	slot count (out)
+ *
+ * returns: the slots
+ */
+const idft_prog_slot_t *
+libdft_prog_slots(const idft_prog_t *prog, uint32_t *nslots)
+{
+	*nslots = prog->nslots;
+
+	return prog->slots;
+}
+
+/* cache bucket of a key */
+#define PROG_HASH(key)	(((key) ^ ((key) >> 12)) & (PROG_HASH_SZ - 1))
+
+/*
+ * look up a cached program
+ *
+ * @context:	the engine context
+ * @key:	the executer's key (e.g., the block address)
+ *
+ * returns: the program, or NULL if there is none
+ */
+idft_prog_t *
+libdft_prog_lookup(idft_context_t *context, ADDRINT key)
+{
+	idft_prog_t **tbl = (idft_prog_t **)context->prog_cache;
+	idft_prog_t *prog;
+
+	if (unlikely(tbl == NULL))
+		return NULL;
+
+	for (prog = tbl[PROG_HASH(key)]; prog != NULL; prog = prog->next)
+		if (prog->key == key)
+			return (prog->len == 0) ? NULL : prog;
+
+	return NULL;
+}
+
+/*
+ * get the program of a block, building and caching it
+ * on first use; blocks without a program are remembered
+ * too, so they are not lowered again
+ *
+ * @context:	the engine context
+ * @key:	the executer's key (e.g., the block address)
+ * @ins:	the instructions of the block, in order
+ * @ins_num:	instruction count
+ *
+ * returns: the program, or NULL if the block has none
+ */
+idft_prog_t *
+libdft_prog_get(idft_context_t *context, ADDRINT key, idft_ins_t *ins,
+		uint32_t ins_num)
+{
+	idft_prog_t **tbl = (idft_prog_t **)context->prog_cache;
+	idft_prog_t *prog;
+
+	if (unlikely(tbl == NULL)) {
+		if ((tbl = calloc(PROG_HASH_SZ, sizeof(idft_prog_t *))) ==
+				NULL)
+			return NULL;
+		context->prog_cache = tbl;
+	}
+
+	for (prog = tbl[PROG_HASH(key)]; prog != NULL; prog = prog->next)
+		if (prog->key == key)
+			return (prog->len == 0) ? NULL : prog;
+
+	/* no program; cache a placeholder */
+	if ((prog = libdft_prog_build(ins, ins_num, context)) == NULL &&
+		(prog = calloc(1, sizeof(idft_prog_t))) == NULL)
+		return NULL;
+
+	prog->key		= key;
+	prog->next		= tbl[PROG_HASH(key)];
+	tbl[PROG_HASH(key)]	= prog;
+
+	return (prog->len == 0) ? NULL : prog;
+}
+
+/*
+ * drop the cached program of a block
+ *
+ * @context:	the engine context
+ * @key:	the executer's key
+ */
+void
+libdft_prog_invalidate(idft_context_t *context, ADDRINT key)
+{
+	idft_prog_t **tbl = (idft_prog_t **)context->prog_cache;
+	idft_prog_t **pp, *prog;
+
+	if (tbl == NULL)
+		return;
+
+	/* queued records may refer to it */
+	ring_sync(context);
+
+	for (pp = &tbl[PROG_HASH(key)]; (prog = *pp) != NULL; )
+		if (prog->key == key) {
+			*pp = prog->next;
+			free(prog);
+		}
+		else
+			pp = &prog->next;
+}
+
+/*
+ * drop every cached program
+ *
+ * @context:	the engine context
+ */
+void
+libdft_prog_flush(idft_context_t *context)
+{
+	idft_prog_t **tbl = (idft_prog_t **)context->prog_cache;
+	idft_prog_t *prog, *next;
+	uint32_t i;
+
+	if (tbl == NULL)
+		return;
+
+	/* queued records may refer to them */
+	ring_sync(context);
+
+	for (i = 0; i < PROG_HASH_SZ; i++) {
+		for (prog = tbl[i]; prog != NULL; prog = next) {
+			next = prog->next;
+			free(prog);
+		}
+		tbl[i] = NULL;
+	}
+}
+
+/*
+ * release the program cache
+ */
+void
+prog_cache_free(idft_context_t *context)
+{
+	libdft_prog_flush(context);
+
+	free(context->prog_cache);
+	context->prog_cache = NULL;
+}
+
+/* sign extension; repeat the source lanes */
+static inline uint32_t
+prog_ext(uint32_t v, uint8_t sh)
+{
+	uint32_t n;
+
+	for (n = PROG_NS(sh); n < (uint32_t)PROG_ND(sh); n <<= 1)
+		v |= v << n;
+
+	return v;
+}
+
+/*
+ * run a taint program (threaded interpreter)
+ *
+ * @prog:	the program
+ * @thread_ctx:	the thread context
+ * @ea:		the effective address of every slot
+ */
+void
+libdft_prog_run(const idft_prog_t *prog, thread_ctx_t *thread_ctx,
+		const ADDRINT *ea)
+{
+	const uint8_t *pc = prog->code;
+	ADDRINT a[PROG_ARG_MAX];
+	uint32_t v, i;
+
+#ifdef __GNUC__
+	/* computed goto; one indirect jump per opcode */
+	static void *const vm_ops[P_NUM] = {
+		&&l_end, &&l_clr, &&l_mov, &&l_or,
+		&&l_rr_copy, &&l_rr_union, &&l_rr_ext,
+		&&l_mr_copy, &&l_mr_union, &&l_mr_ext,
+		&&l_rm_copy, &&l_rm_union, &&l_mm_copy, &&l_call
+	};
+#define VM_CASE(op, label)	label:
+#define VM_NEXT(n)	do { pc += (n); goto *vm_ops[*pc]; } while (0)
+
+	goto *vm_ops[*pc];
+#else
+#define VM_CASE(op, label)	case op:
+#define VM_NEXT(n)	do { pc += (n); goto vm_top; } while (0)
+
+vm_top:
+	switch (*pc) {
+#endif
+	VM_CASE(P_CLR, l_clr)
+		RTAG_SET(pc[1], RTAG(pc[1]) & ~(uint32_t)pc[2]);
+		VM_NEXT(3);
+
+	VM_CASE(P_MOV, l_mov)
+		RTAG_SET(pc[1], RTAG(pc[2]));
+		VM_NEXT(3);
+
+	VM_CASE(P_OR, l_or)
+		RTAG_SET(pc[1], RTAG(pc[1]) | RTAG(pc[2]));
+		VM_NEXT(3);
+
+	VM_CASE(P_RR_COPY, l_rr_copy)
+		v = ((RTAG(pc[3]) & pc[4]) >> PROG_SL(pc[5]) <<
+				PROG_DL(pc[5])) & pc[2];
+		RTAG_SET(pc[1], (RTAG(pc[1]) & ~(uint32_t)pc[2]) | v);
+		VM_NEXT(6);
+
+	VM_CASE(P_RR_UNION, l_rr_union)
+		v = ((RTAG(pc[3]) & pc[4]) >> PROG_SL(pc[5]) <<
+				PROG_DL(pc[5])) & pc[2];
+		RTAG_SET(pc[1], RTAG(pc[1]) | v);
+		VM_NEXT(6);
+
+	VM_CASE(P_RR_EXT, l_rr_ext)
+		v = prog_ext((RTAG(pc[3]) & pc[4]) >> PROG_SL(pc[5]), pc[5]);
+		v = (v << PROG_DL(pc[5])) & pc[2];
+		RTAG_SET(pc[1], (RTAG(pc[1]) & ~(uint32_t)pc[2]) | v);
+		VM_NEXT(6);
+
+	VM_CASE(P_MR_COPY, l_mr_copy)
+		v = (MEM_TAG(ea[pc[3]], PROG_NS(pc[4])) << PROG_DL(pc[4])) &
+			pc[2];
+		RTAG_SET(pc[1], (RTAG(pc[1]) & ~(uint32_t)pc[2]) | v);
+		VM_NEXT(5);
+
+	VM_CASE(P_MR_UNION, l_mr_union)
+		v = (MEM_TAG(ea[pc[3]], PROG_NS(pc[4])) << PROG_DL(pc[4])) &
+			pc[2];
+		RTAG_SET(pc[1], RTAG(pc[1]) | v);
+		VM_NEXT(5);
+
+	VM_CASE(P_MR_EXT, l_mr_ext)
+		v = prog_ext(MEM_TAG(ea[pc[3]], PROG_NS(pc[4])), pc[4]);
+		v = (v << PROG_DL(pc[4])) & pc[2];
+		RTAG_SET(pc[1], (RTAG(pc[1]) & ~(uint32_t)pc[2]) | v);
+		VM_NEXT(5);
+
+	VM_CASE(P_RM_COPY, l_rm_copy)
+		v = (RTAG(pc[2]) & pc[3]) >> PROG_SL(pc[4]);
+		MEM_SET(ea[pc[1]], PROG_ND(pc[4]), v);
+		VM_NEXT(5);
+
+	VM_CASE(P_RM_UNION, l_rm_union)
+		v = (RTAG(pc[2]) & pc[3]) >> PROG_SL(pc[4]);
+		MEM_OR(ea[pc[1]], v);
+		VM_NEXT(5);
+
+	VM_CASE(P_MM_COPY, l_mm_copy)
+		v = MEM_TAG(ea[pc[2]], pc[3]);
+		MEM_SET(ea[pc[1]], pc[3], v);
+		VM_NEXT(4);
+
+	VM_CASE(P_CALL, l_call)
+		for (i = 0; i < pc[2]; i++)
+			a[i] = (pc[3 + 2 * i] == PA_SLOT) ?
+				ea[pc[4 + 2 * i]] : prog->pool[pc[4 + 2 * i]];
+
+		switch (pc[2]) {
+			case 0:
+				((p_call0_t)prog->fns[pc[1]])(thread_ctx);
+				break;
+			case 1:
+				((p_call1_t)prog->fns[pc[1]])(thread_ctx,
+						a[0]);
+				break;
+			case 2:
+				((p_call2_t)prog->fns[pc[1]])(thread_ctx,
+						a[0], a[1]);
+				break;
+			case 3:
+				((p_call3_t)prog->fns[pc[1]])(thread_ctx,
+						a[0], a[1], a[2]);
+				break;
+			default:
+				((p_call4_t)prog->fns[pc[1]])(thread_ctx,
+						a[0], a[1], a[2], a[3]);
+				break;
+		}
+		VM_NEXT(3 + 2 * pc[2]);
+
+	VM_CASE(P_END, l_end)
+#ifndef __GNUC__
+	default:
+		break;
+	}
+#endif
+	return;
+
+#undef VM_CASE
+#undef VM_NEXT
+}
@@ -0,0 +1,69 @@
+#ifndef LIBICEDFT_PROG_H
+#define LIBICEDFT_PROG_H
+
+#include <stdint.h>
+#include "libicedft_api.h"
+
+#define PROG_HASH_SZ	4096			/* cache buckets */
+#define PROG_TBL_MAX	255			/* slots, constants, routines */
+#define PROG_ARG_MAX	4			/* P_CALL arguments */
+
+/*
+ * taint program opcodes; operands follow as bytes
+ *
+ * lane descriptors (sh) pack the first source lane, the
+ * first destination lane, and the source and destination
+ * lane (or byte) counts, which are powers of 2 (1 to 8);
+ * see PROG_SH
+ */
+enum {
+/* #define */ P_END	= 0,	/* */
+/* #define */ P_CLR	= 1,	/* reg, mask */
+/* #define */ P_MOV	= 2,	/* dst, src (whole registers) */
+/* #define */ P_OR	= 3,	/* dst, src (whole registers) */
+/* #define */ P_RR_COPY	= 4,	/* dst, dmask, src, smask, sh */
+/* #define */ P_RR_UNION	= 5,	/* dst, dmask, src, smask, sh */
+/* #define */ P_RR_EXT	= 6,	/* dst, dmask, src, smask, sh */
+/* #define */ P_MR_COPY	= 7,	/* dst, dmask, slot, sh */
+/* #define */ P_MR_UNION	= 8,	/* dst, dmask, slot, sh */
+/* #define */ P_MR_EXT	= 9,	/* dst, dmask, slot, sh */
+/* #define */ P_RM_COPY	= 10,	/* slot, src, smask, sh */
+/* #define */ P_RM_UNION	= 11,	/* slot, src, smask, sh */
+/* #define */ P_MM_COPY	= 12,	/* dslot, sslot, len */
+/* #define */ P_CALL	= 13,	/* routine, argc, {kind, index} x argc */
+/* #define */ P_NUM	= 14
+};
+
+/* P_CALL argument kinds */
+enum {
+/* #define */ PA_CONST	= 0,	/* constant pool index */
+/* #define */ PA_SLOT	= 1	/* effective address slot */
+};
+
+#define PROG_LOG2(n)	(((n) >= 8) ? 3 : ((n) >= 4) ? 2 : ((n) >= 2) ? 1 : 0)
+#define PROG_SH(sl, dl, ns, nd)						\
+	((uint8_t)((sl) | ((dl) << 2) | (PROG_LOG2(ns) << 4) |		\
+	 (PROG_LOG2(nd) << 6)))
+#define PROG_SL(sh)	((sh) & 0x03)
+#define PROG_DL(sh)	(((sh) >> 2) & 0x03)
+#define PROG_NS(sh)	(1U << (((sh) >> 4) & 0x03))
+#define PROG_ND(sh)	(1U << (((sh) >> 6) & 0x03))
+
+/* a taint program */
+struct idft_prog {
+	struct idft_prog	*next;		/* cache chain */
+	ADDRINT			key;		/* cache key */
+	uint32_t		ins_num;	/* instructions covered */
+	uint32_t		len;		/* code bytes; 0: no program */
+	uint32_t		nslots;		/* effective address slots */
+	uint32_t		npool;		/* constants */
+	uint32_t		nfns;		/* routines */
+	idft_prog_slot_t	*slots;
+	ADDRINT			*pool;
+	void			**fns;
+	uint8_t			*code;
+};
+
+void	prog_cache_free(idft_context_t *context);
+
+#endif /* LIBICEDFT_PROG_H */
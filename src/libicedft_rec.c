@@ -0,0 +1,252 @@
+/*
+ * analysis call recorder
+ *
+ * ins_inspect talks to the executer only through the
+ * executer api; while recording, the Insert* entries of
+ * that api are replaced by the proxies below, so that the
+ * calls ins_inspect asks for are captured (in order) instead
+ * of being inserted. They can later be re-issued verbatim
+ * with rec_replay, or rewritten first (see libicedft_ir.c)
+ */
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libicedft_rec.h"
+#include "libicedft_util.h"
+#include "branch_pred.h"
+
+
+/*
+ * capture one call into the record buffer
+ *
+ * @ins:	the instruction
+ * @context:	the engine context
+ * @how:	REC_* (which Insert* was used)
+ * @ipoint:	IDFT_IPOINT_*
+ * @func:	analysis routine
+ * @argc:	variadic item count
+ * @ap:		the variadic items
+ */
+static void
+rec_capture(idft_ins_t *ins, idft_context_t *context, uint32_t how,
+		uint32_t ipoint, void *func, uint32_t argc, va_list ap)
+{
+	rec_buf_t *buf = (rec_buf_t *)context->rec_buf;
+	rec_call_t *call;
+	uint32_t i;
+
+	/* full; keep count so that the caller can fall back */
+	if (unlikely(buf->ncalls == REC_CALL_MAX || argc > REC_ARG_MAX)) {
+		buf->overflow++;
+		return;
+	}
+
+	call = &buf->calls[buf->ncalls++];
+
+	call->ins	= ins;
+	call->how	= how;
+	call->ipoint	= ipoint;
+	call->func	= func;
+	call->argc	= argc;
+
+	/* kinds are passed as int; values with the type of their kind */
+	for (i = 0; i < argc; i++) {
+		call->argv[i] = va_arg(ap, uint32_t);
+
+		if (REC_IARG_HASVAL(call->argv[i]) && i + 1 < argc) {
+			call->argv[i + 1] = (call->argv[i] == IARG_UINT32) ?
+				va_arg(ap, uint32_t) : va_arg(ap, ADDRINT);
+			i++;
+		}
+	}
+}
+
+/* Insert* proxies; one per REC_* */
+#define REC_PROXY(name, how)						\
+static uint32_t								\
+name(idft_ins_t *ins, void *ctx, uint32_t action, void *func,		\
+		uint32_t arg_count, ...)				\
+{									\
+	va_list ap;							\
+									\
+	va_start(ap, arg_count);					\
+	rec_capture(ins, (idft_context_t *)ctx, how, action, func,	\
+			arg_count, ap);					\
+	va_end(ap);							\
+									\
+	return 0;							\
+}
+
+REC_PROXY(rec_insert_call, REC_CALL)
+REC_PROXY(rec_insert_predicated, REC_PREDICATED)
+REC_PROXY(rec_insert_if, REC_IF)
+REC_PROXY(rec_insert_then, REC_THEN)
+REC_PROXY(rec_insert_if_predicated, REC_IF_PREDICATED)
+REC_PROXY(rec_insert_then_predicated, REC_THEN_PREDICATED)
+
+/*
+ * get (allocate on first use) the record buffer of a context
+ *
+ * @context:	the engine context
+ *
+ * returns: the record buffer, or NULL on error
+ */
+rec_buf_t *
+rec_buf_get(idft_context_t *context)
+{
+	if (unlikely(context->rec_buf == NULL))
+		context->rec_buf = calloc(1, sizeof(rec_buf_t));
+
+	return (rec_buf_t *)context->rec_buf;
+}
+
+/*
+ * start recording; every Insert* issued through
+ * context->executer_api is captured until rec_end
+ *
+ * @context:	the engine context
+ */
+void
+rec_begin(idft_context_t *context)
+{
+	rec_buf_t *buf = (rec_buf_t *)context->rec_buf;
+
+	buf->ncalls	= 0;
+	buf->overflow	= 0;
+
+	/* recording does not nest */
+	if (context->real_api != NULL)
+		return;
+
+	context->real_api	= context->executer_api;
+	context->rec_api	= *context->executer_api;
+
+	context->rec_api.INS_InsertCall = rec_insert_call;
+	context->rec_api.INS_InsertPredicatedCall = rec_insert_predicated;
+	context->rec_api.INS_InsertIfCall = rec_insert_if;
+	context->rec_api.INS_InsertThenCall = rec_insert_then;
+	context->rec_api.INS_InsertIfPredicatedCall =
+		rec_insert_if_predicated;
+	context->rec_api.INS_InsertThenPredicatedCall =
+		rec_insert_then_predicated;
+
+	context->executer_api	= &context->rec_api;
+}
+
+/*
+ * stop recording and restore the executer api
+ *
+ * @context:	the engine context
+ */
+void
+rec_end(idft_context_t *context)
+{
+	if (context->real_api == NULL)
+		return;
+
+	context->executer_api	= context->real_api;
+	context->real_api	= NULL;
+}
+
+/*
+ * insert a call through a given api
+ */
+static uint32_t
+rec_insert_api(idft_executer_api_t *api, idft_context_t *context,
+		idft_ins_t *ins, uint32_t how, uint32_t ipoint, void *func,
+		uint32_t argc, const ADDRINT *argv)
+{
+	f_f_t insert;
+	ADDRINT a[REC_ARG_MAX];
+
+	switch (how) {
+		case REC_PREDICATED:
+			insert = api->INS_InsertPredicatedCall;
+			break;
+		case REC_IF:
+			insert = api->INS_InsertIfCall;
+			break;
+		case REC_THEN:
+			insert = api->INS_InsertThenCall;
+			break;
+		case REC_IF_PREDICATED:
+			insert = api->INS_InsertIfPredicatedCall;
+			break;
+		case REC_THEN_PREDICATED:
+			insert = api->INS_InsertThenPredicatedCall;
+			break;
+		case REC_CALL:
+		default:
+			insert = api->INS_InsertCall;
+			break;
+	}
+
+	/*
+	 * the executer consumes exactly argc items; any
+	 * trailing ones are ignored by va_arg semantics,
+	 * so pass the whole (zero padded) array; every
+	 * item takes a full ADDRINT slot, which the
+	 * executer reads back as int or ADDRINT alike
+	 */
+	memset(a, 0, sizeof(a));
+	memcpy(a, argv, argc * sizeof(ADDRINT));
+
+	return insert(ins, context, ipoint, func, argc,
+			a[0], a[1], a[2], a[3], a[4], a[5],
+			a[6], a[7], a[8], a[9], a[10], a[11]);
+}
+
+/*
+ * insert a call through the executer's own api
+ *
+ * @context:	the engine context
+ * @ins:	the instruction
+ * @how:	REC_*
+ * @ipoint:	IDFT_IPOINT_*
+ * @func:	analysis routine
+ * @argc:	variadic item count (up to REC_ARG_MAX)
+ * @argv:	variadic items
+ *
+ * returns: whatever the executer returns
+ */
+uint32_t
+rec_insert(idft_context_t *context, idft_ins_t *ins, uint32_t how,
+		uint32_t ipoint, void *func, uint32_t argc,
+		const ADDRINT *argv)
+{
+	return rec_insert_api((context->real_api != NULL) ?
+			context->real_api : context->executer_api,
+			context, ins, how, ipoint, func, argc, argv);
+}
+
+/*
+ * issue a call the way ins_inspect does; i.e., through
+ * the current api, so that it is captured while recording
+ *
+ * (arguments as in rec_insert)
+ */
+uint32_t
+rec_issue(idft_context_t *context, idft_ins_t *ins, uint32_t how,
+		uint32_t ipoint, void *func, uint32_t argc,
+		const ADDRINT *argv)
+{
+	return rec_insert_api(context->executer_api, context, ins, how,
+			ipoint, func, argc, argv);
+}
+
+/*
+ * re-issue a recorded call verbatim
+ *
+ * @context:	the engine context
+ * @call:	the recorded call
+ *
+ * returns: whatever the executer returns
+ */
+uint32_t
+rec_replay(idft_context_t *context, rec_call_t *call)
+{
+	return rec_insert(context, call->ins, call->how, call->ipoint,
+			call->func, call->argc, call->argv);
+}
@@ -0,0 +1,58 @@
+#ifndef LIBICEDFT_REC_H
+#define LIBICEDFT_REC_H
+
+#include <stdint.h>
+#include "libicedft_types.h"
+
+#define REC_ARG_MAX	12			/* variadic items per call */
+#define REC_CALL_MAX	1024			/* recorded calls per block */
+
+/* how a recorded call was requested from the executer */
+enum {
+/* #define */ REC_CALL		= 0,	/* INS_InsertCall */
+/* #define */ REC_PREDICATED	= 1,	/* INS_InsertPredicatedCall */
+/* #define */ REC_IF		= 2,	/* INS_InsertIfCall */
+/* #define */ REC_THEN		= 3,	/* INS_InsertThenCall */
+/* #define */ REC_IF_PREDICATED	= 4,	/* INS_InsertIfPredicatedCall */
+/* #define */ REC_THEN_PREDICATED = 5	/* INS_InsertThenPredicatedCall */
+};
+
+/*
+ * a recorded analysis call; argv holds the variadic
+ * items exactly as ins_inspect passed them (IARG_*
+ * kinds followed by their values, where they take one),
+ * each widened to ADDRINT
+ */
+typedef struct {
+	idft_ins_t	*ins;			/* instruction */
+	uint32_t	how;			/* REC_* */
+	uint32_t	ipoint;			/* IDFT_IPOINT_* */
+	void		*func;			/* analysis routine */
+	uint32_t	argc;			/* variadic item count */
+	ADDRINT		argv[REC_ARG_MAX];	/* variadic items */
+} rec_call_t;
+
+/* record buffer */
+typedef struct {
+	uint32_t	ncalls;			/* recorded calls */
+	uint32_t	overflow;		/* calls that did not fit */
+	rec_call_t	calls[REC_CALL_MAX];
+} rec_buf_t;
+
+/* number of values that follow an IARG_* kind */
+#define REC_IARG_HASVAL(kind)						\
+	((kind) == IARG_UINT32 || (kind) == IARG_ADDRINT ||		\
+	 (kind) == IARG_REG_VALUE)
+
+rec_buf_t	*rec_buf_get(idft_context_t *context);
+void		rec_begin(idft_context_t *context);
+void		rec_end(idft_context_t *context);
+uint32_t	rec_replay(idft_context_t *context, rec_call_t *call);
+uint32_t	rec_insert(idft_context_t *context, idft_ins_t *ins,
+			uint32_t how, uint32_t ipoint, void *func,
+			uint32_t argc, const ADDRINT *argv);
+uint32_t	rec_issue(idft_context_t *context, idft_ins_t *ins,
+			uint32_t how, uint32_t ipoint, void *func,
+			uint32_t argc, const ADDRINT *argv);
+
+#endif /* LIBICEDFT_REC_H */
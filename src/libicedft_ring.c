@@ -0,0 +1,229 @@
+/*
+ * decoupled analysis; per-thread event rings
+ *
+ * instead of running the program of a block (libdft_prog_run)
+ * on the application thread, the executer can append it, with
+ * the effective addresses of its slots, to the thread's ring
+ * (libdft_ring_push) and leave the propagation to one or more
+ * analysis threads (libdft_ring_poll). Each ring has a single
+ * producer (its thread) and, at any time, a single consumer:
+ * an analysis thread claims a ring before replaying it, and
+ * skips the rings that are already claimed.
+ *
+ * the tags are only current up to the last replayed record; a
+ * thread must drain its ring (libdft_ring_drain) before anything
+ * reads them or propagates inline: syscalls, sinks, and blocks
+ * without a program. A full ring stalls its producer, which
+ * helps replaying meanwhile, so progress does not depend on the
+ * analysis threads being scheduled.
+ *
+ * rings belong to the slots of the thread pool (libicedft_thread.c),
+ * and stay with them until libdft_die; thread contexts not started
+ * with libdft_thread_start run inline. The analysis threads find the
+ * rings on a list that only grows, so they never take the registry
+ * lock: the ring of a finished thread is empty (libdft_thread_fini
+ * drains it), and the next thread of its slot is its new producer
+ */
+
+#include <sched.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "libicedft_api.h"
+#include "libicedft_prog.h"
+#include "libicedft_ring.h"
+#include "libicedft_thread.h"
+#include "branch_pred.h"
+
+
+/* the ring of a slot (allocate on first use, by its producer) */
+static ring_t *
+ring_get(idft_context_t *context, thread_slot_t *s)
+{
+	ring_t *r = (ring_t *)s->ring;
+
+	if (likely(r != NULL))
+		return r;
+
+	/* first touch; on the node of the producer */
+	if (unlikely((r = mmap(NULL, sizeof(ring_t), PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED))
+		return NULL;
+
+	r->owner = &s->ctx;
+
+	/* for libdft_ring_poll, ring_sync and ring_free */
+	r->next = __atomic_load_n((ring_t **)&context->rings, __ATOMIC_RELAXED);
+	while (!__atomic_compare_exchange_n((ring_t **)&context->rings,
+			&r->next, r, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+		;
+
+	__atomic_store_n((ring_t **)&s->ring, r, __ATOMIC_RELEASE);
+
+	return r;
+}
+
+/*
+ * replay the records of a ring; the caller has claimed it
+ *
+ * @r:		the ring
+ * @thread_ctx:	the context of its producer
+ * @budget:	most records to replay
+ *
+ * returns: the number of records replayed
+ */
+static uint32_t
+ring_replay(ring_t *r, thread_ctx_t *thread_ctx, uint32_t budget)
+{
+	ADDRINT ea[PROG_TBL_MAX];
+	ADDRINT head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+	ADDRINT tail = r->tail;
+	const idft_prog_t *prog;
+	uint32_t i, nslots, n = 0;
+
+	for (; tail != head && n < budget; n++) {
+		prog = (const idft_prog_t *)(uintptr_t)r->words[tail & RING_MASK];
+		(void)libdft_prog_slots(prog, &nslots);
+
+		for (i = 0; i < nslots; i++)
+			ea[i] = r->words[(tail + 1 + i) & RING_MASK];
+
+		libdft_prog_run(prog, thread_ctx, ea);
+
+		/* hand the space back record by record */
+		tail += 1 + nslots;
+		__atomic_store_n(&r->tail, tail, __ATOMIC_RELEASE);
+	}
+
+	return n;
+}
+
+/* claim a ring and replay it; 0 if another consumer has it */
+static uint32_t
+ring_try(ring_t *r, thread_ctx_t *thread_ctx, uint32_t budget)
+{
+	uint32_t n;
+
+	if (__atomic_test_and_set(&r->busy, __ATOMIC_ACQUIRE))
+		return 0;
+
+	n = ring_replay(r, thread_ctx, budget);
+
+	__atomic_clear(&r->busy, __ATOMIC_RELEASE);
+
+	return n;
+}
+
+/*
+ * append a block's program to the ring of a thread; called
+ * by the thread itself, instead of libdft_prog_run
+ *
+ * @context:	the engine context
+ * @thread_ctx:	the context of the thread (libdft_thread_start)
+ * @prog:	the program (libdft_prog_get)
+ * @ea:		ea[slot] as for libdft_prog_run
+ */
+void
+libdft_ring_push(idft_context_t *context, thread_ctx_t *thread_ctx,
+		const idft_prog_t *prog, const ADDRINT *ea)
+{
+	thread_slot_t *s = THREAD_SLOT(thread_ctx);
+	ring_t *r;
+	ADDRINT head;
+	uint32_t i, nslots;
+
+	/* not pooled, or no ring; nothing is queued either */
+	if (unlikely(s == NULL || (r = ring_get(context, s)) == NULL)) {
+		libdft_prog_run(prog, thread_ctx, ea);
+		return;
+	}
+
+	(void)libdft_prog_slots(prog, &nslots);
+	head = r->head;
+
+	/* backpressure; help the consumers while full */
+	while (unlikely(head + 1 + nslots -
+			__atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) > RING_WORDS))
+		if (ring_try(r, thread_ctx, RING_BATCH) == 0)
+			sched_yield();
+
+	r->words[head & RING_MASK] = (ADDRINT)(uintptr_t)prog;
+	for (i = 0; i < nslots; i++)
+		r->words[(head + 1 + i) & RING_MASK] = ea[i];
+
+	__atomic_store_n(&r->head, head + 1 + nslots, __ATOMIC_RELEASE);
+}
+
+/*
+ * wait until every record appended to the ring of a thread
+ * (so far) is replayed; the thread's tags are current after
+ *
+ * @thread_ctx:	the context of the thread (libdft_thread_start)
+ */
+void
+libdft_ring_drain(thread_ctx_t *thread_ctx)
+{
+	thread_slot_t *s = THREAD_SLOT(thread_ctx);
+	ring_t *r;
+	ADDRINT head;
+
+	/* not pooled; it runs inline */
+	if (s == NULL ||
+		(r = (ring_t *)__atomic_load_n(&s->ring,
+			__ATOMIC_ACQUIRE)) == NULL)
+		return;
+
+	head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+
+	/* replay them here, unless an analysis thread is already */
+	while (__atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) != head)
+		if (ring_try(r, thread_ctx, UINT32_MAX) == 0)
+			sched_yield();
+}
+
+/*
+ * replay pending records of every thread; called in a loop by
+ * each analysis thread
+ *
+ * @context:	the engine context
+ * @budget:	most records to replay
+ *
+ * returns: the number of records replayed (0 when idle)
+ */
+uint32_t
+libdft_ring_poll(idft_context_t *context, uint32_t budget)
+{
+	ring_t *r = __atomic_load_n((ring_t **)&context->rings,
+			__ATOMIC_ACQUIRE);
+	uint32_t n = 0;
+
+	for (; r != NULL && n < budget; r = r->next)
+		if (__atomic_load_n(&r->tail, __ATOMIC_RELAXED) !=
+				__atomic_load_n(&r->head, __ATOMIC_RELAXED))
+			n += ring_try(r, r->owner, budget - n);
+
+	return n;
+}
+
+/* drain every ring; before programs are freed */
+void
+ring_sync(idft_context_t *context)
+{
+	ring_t *r = __atomic_load_n((ring_t **)&context->rings,
+			__ATOMIC_ACQUIRE);
+
+	for (; r != NULL; r = r->next)
+		libdft_ring_drain(r->owner);
+}
+
+/* release the rings; before the thread pool */
+void
+ring_free(idft_context_t *context)
+{
+	ring_t *r;
+
+	while ((r = (ring_t *)context->rings) != NULL) {
+		context->rings = r->next;
+		munmap(r, sizeof(ring_t));
+	}
+}
@@ -0,0 +1,29 @@
+#ifndef LIBICEDFT_RING_H
+#define LIBICEDFT_RING_H
+
+#include <stdint.h>
+#include "libicedft_api.h"
+
+#define RING_LINE	64			/* cache line */
+#define RING_WORDS	(16 * 1024)		/* per thread; a power of 2 */
+#define RING_MASK	(RING_WORDS - 1)
+#define RING_BATCH	64			/* records replayed while pushing */
+
+/*
+ * the event ring of a thread (single producer, single consumer);
+ * a record is a program followed by one effective address per
+ * slot, and may wrap around the end of words
+ */
+typedef struct ring {
+	ADDRINT		head __attribute__((aligned(RING_LINE)));	/* producer */
+	ADDRINT		tail __attribute__((aligned(RING_LINE)));	/* consumer */
+	uint8_t		busy __attribute__((aligned(RING_LINE)));	/* consumer claim */
+	struct ring	*next;			/* all rings of a context */
+	thread_ctx_t	*owner;			/* the context of its slot */
+	ADDRINT		words[RING_WORDS] __attribute__((aligned(RING_LINE)));
+} ring_t;
+
+void	ring_sync(idft_context_t *context);
+void	ring_free(idft_context_t *context);
+
+#endif /* LIBICEDFT_RING_H */
@@ -0,0 +1,849 @@
+/*
+ * shifts, rotates and byte swaps
+ *
+ * with one tag bit per byte, a shift or a rotate by a given count
+ * is a fixed permutation (and merge) of the 4 tag bits of its
+ * operand. shift_init precomputes all of them, per operation,
+ * width and count, as 64-bit entries of 16 nibbles: nibble t is
+ * the tag of the result when the tag of the operand is t. The
+ * analysis routines below are one table load and one shift,
+ * whether the count is an immediate or comes from CL (they are
+ * handed the row of the operation, and index it with the count):
+ *
+ *	SHL/SAL, SHR, SAR	t[dst] = map(t[dst])
+ *	ROL, ROR, RCL, RCR	(the carry flag is not tagged)
+ *	SHLD, SHRD		t[dst] = map(t[dst]) | map'(t[src])
+ *	BSWAP, MOVBE		byte reversal; a constant map
+ *
+ * a result byte is tagged if any of the bits it is made of is;
+ * the undefined results of 16-bit SHLD/SHRD by more than 16 are
+ * tagged with everything
+ *
+ * the 8 tag bits of 64-bit operands (IDFT_X86_64) would take 256
+ * entries per count; their maps (shift_qtbl) are per operand byte
+ * instead: byte i of an entry holds the result bytes that byte i
+ * of the operand feeds, and the result is the union of those of
+ * the tagged bytes
+ */
+
+#include <stddef.h>
+
+#include "libicedft_api.h"
+#include "libicedft_core.h"
+#include "libicedft_inline.h"
+#include "libicedft_shift.h"
+#include "libicedft_x64.h"
+#include "branch_pred.h"
+
+
+#define EXE context->executer_api
+
+#define SHIFT_CNT	32			/* counts; modulo 32 */
+#define SHIFT_CNT_MASK	(SHIFT_CNT - 1)
+#define SHIFT_UNDEF	-2			/* shift_bit; undefined */
+#define SHIFT_QCNT	64			/* 64-bit counts; modulo 64 */
+#define SHIFT_QCNT_MASK	(SHIFT_QCNT - 1)
+
+/* the tag of a result; e is a shift_tbl (or constant) entry */
+#define SHIFT_MAP(e, t)	((uint32_t)((e) >> ((t) << 2)) & VCPU_MASK32)
+
+/* byte reversal of 4 (BSWAP) and 2 (MOVBE) bytes */
+#define SHIFT_BSWAP32	0xF7B3D591E6A2C480ULL
+#define SHIFT_BSWAP16	0x3120ULL
+#define SHIFT_BSWAP64	0x0102040810204080ULL	/* a shift_qtbl entry */
+
+/* the maps; a row per operation and width (SHIFT_ROW), indexed by count */
+#define SHIFT_ROWS	SHIFT_ROW(2, 0, 0)
+#define SHIFT_NOROW	SHIFT_ROWS		/* shift_row; no effect */
+
+static uint64_t shift_tbl[SHIFT_ROWS][SHIFT_CNT];
+
+/* likewise, for 64-bit operands; the rows are SHIFT_QROW */
+static uint64_t shift_qtbl[SHIFT_QROW(2, 0)][SHIFT_QCNT];
+
+
+/*
+ * the operand bit that bit b of the result comes from
+ *
+ * @kind:	SHIFT_*
+ * @w:		width in bits
+ * @c:		count (modulo 32, or 64)
+ * @b:		result bit
+ *
+ * returns: the bit of dst (0 to w - 1) or src (w to 2w - 1; the
+ * double shifts), -1 if it is a constant (or the carry flag), or
+ * SHIFT_UNDEF
+ */
+static int
+shift_bit(uint32_t kind, int w, int c, int b)
+{
+	int p;
+
+	/* no operation */
+	if (c == 0)
+		return b;
+
+	switch (kind) {
+		case SHIFT_SHL:
+			return (b >= c) ? b - c : -1;
+		case SHIFT_SHR:
+			return (b + c < w) ? b + c : -1;
+		case SHIFT_SAR:
+			return (b + c < w) ? b + c : w - 1;
+		case SHIFT_ROL:
+			return (b + w - c % w) % w;
+		case SHIFT_ROR:
+			return (b + c) % w;
+		/* w + 1 bits; CF is bit w */
+		case SHIFT_RCL:
+			p = (b + w + 1 - c % (w + 1)) % (w + 1);
+			return (p == w) ? -1 : p;
+		case SHIFT_RCR:
+			p = (b + c) % (w + 1);
+			return (p == w) ? -1 : p;
+		/* dst:src shifted left; src:dst shifted right */
+		case SHIFT_SHLD:
+			if (c > w)
+				return SHIFT_UNDEF;
+			return (b >= c) ? b - c : 2 * w + b - c;
+		case SHIFT_SHRD:
+			if (c > w)
+				return SHIFT_UNDEF;
+			return b + c;
+		default:
+			return -1;
+	}
+}
+
+/*
+ * the map entries of an operation
+ *
+ * @d:		the entry for the tag of dst (out)
+ * @s:		the entry for the tag of src (out; double shifts)
+ */
+static void
+shift_entry(uint32_t kind, int w, int c, uint64_t *d, uint64_t *s)
+{
+	/* byte i of the result; the bytes of dst (bits 0-3) and src (4-7) */
+	uint32_t dep[4] = {0, 0, 0, 0};
+	uint32_t all = (1U << (w >> 3)) - 1;
+	uint32_t t, i, od, os;
+	int b, p;
+
+	for (b = 0; b < w; b++) {
+		p = shift_bit(kind, w, c, b);
+
+		if (p == SHIFT_UNDEF)
+			dep[b >> 3] |= all | (all << 4);
+		else if (p >= w)
+			dep[b >> 3] |= 1U << (((p - w) >> 3) + 4);
+		else if (p >= 0)
+			dep[b >> 3] |= 1U << (p >> 3);
+	}
+
+	*d = *s = 0;
+
+	for (t = 0; t <= VCPU_MASK32; t++) {
+		for (od = os = 0, i = 0; i < 4; i++) {
+			od |= ((dep[i] & t) != 0) << i;
+			os |= (((dep[i] >> 4) & t) != 0) << i;
+		}
+
+		*d |= (uint64_t)od << (t << 2);
+		*s |= (uint64_t)os << (t << 2);
+	}
+}
+
+/*
+ * the shift_qtbl entries of an operation
+ *
+ * @d:		the entry for dst (out)
+ * @s:		the entry for src (out; double shifts)
+ */
+static void
+shift_qentry(uint32_t kind, int c, uint64_t *d, uint64_t *s)
+{
+	int b, p;
+
+	*d = *s = 0;
+
+	/* c < 64; SHIFT_UNDEF is not possible */
+	for (b = 0; b < 64; b++) {
+		p = shift_bit(kind, 64, c, b);
+
+		if (p >= 64)
+			*s |= 1ULL << (((p - 64) >> 3) * 8 + (b >> 3));
+		else if (p >= 0)
+			*d |= 1ULL << ((p >> 3) * 8 + (b >> 3));
+	}
+}
+
+/* the tag of a 64-bit result; e is a shift_qtbl entry */
+static inline uint32_t
+shift_qmap(uint64_t e, uint32_t t)
+{
+	uint32_t r = 0, i;
+
+	for (i = 0; i < 8; i++)
+		r |= (uint32_t)(e >> (i << 3)) & (0U - ((t >> i) & 1));
+
+	return r & VCPU_MASK64;
+}
+
+/*
+ * precompute the maps; called by libdft_init
+ */
+void
+shift_init(void)
+{
+	static const int width[SHIFT_WIDTHS] = {8, 16, 32};
+	uint64_t d, s, any_d, any_s;
+	uint32_t w, kind;
+	int c;
+
+	for (w = 0; w < SHIFT_WIDTHS; w++)
+		for (kind = 0; kind < SHIFT_KINDS; kind++) {
+			/* src side; filled with the dst one */
+			if (kind == SHIFT_SHLD + 1 || kind == SHIFT_SHRD + 1)
+				continue;
+
+			for (any_d = any_s = 0, c = 0; c < SHIFT_CNT; c++) {
+				shift_entry(kind, width[w], c, &d, &s);
+				shift_tbl[SHIFT_ROW(0, w, kind)][c] = d;
+				any_d |= d;
+
+				if (kind == SHIFT_SHLD || kind == SHIFT_SHRD) {
+					shift_tbl[SHIFT_ROW(0, w, kind + 1)][c] = s;
+					any_s |= s;
+				}
+			}
+
+			for (c = 0; c < SHIFT_CNT; c++) {
+				shift_tbl[SHIFT_ROW(1, w, kind)][c] = any_d;
+
+				if (kind == SHIFT_SHLD || kind == SHIFT_SHRD)
+					shift_tbl[SHIFT_ROW(1, w, kind + 1)][c] = any_s;
+			}
+		}
+
+	/* 64-bit */
+	for (kind = 0; kind < SHIFT_KINDS; kind++) {
+		if (kind == SHIFT_SHLD + 1 || kind == SHIFT_SHRD + 1)
+			continue;
+
+		for (any_d = any_s = 0, c = 0; c < SHIFT_QCNT; c++) {
+			shift_qentry(kind, c, &d, &s);
+			shift_qtbl[SHIFT_QROW(0, kind)][c] = d;
+			shift_qtbl[SHIFT_QROW(0, kind + 1)][c] = s;
+			any_d |= d;
+			any_s |= s;
+		}
+
+		for (c = 0; c < SHIFT_QCNT; c++) {
+			shift_qtbl[SHIFT_QROW(1, kind)][c] = any_d;
+
+			if (kind == SHIFT_SHLD || kind == SHIFT_SHRD)
+				shift_qtbl[SHIFT_QROW(1, kind + 1)][c] = any_s;
+		}
+	}
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * shifts and rotates of a register (opl, opw, opb_l, opb_u) or
+ * memory location (m_*); t[dst] = map[cnt](t[dst])
+ *
+ * @thread_ctx:	the thread context
+ * @reg:	register index (VCPU)
+ * @dst:	destination memory address
+ * @row:	the row of the operation (shift_tbl, or shift_qtbl for opq)
+ * @cnt:	the count (CL or the immediate)
+ */
+void
+r_shift_opl(thread_ctx_t *thread_ctx, uint32_t reg, uint32_t row, uint32_t cnt)
+{
+	VCPU_GPR_SET(thread_ctx, reg,
+		SHIFT_MAP(shift_tbl[row][cnt & SHIFT_CNT_MASK],
+			VCPU_GPR(thread_ctx, reg) & VCPU_MASK32));
+}
+
+void
+r_shift_opw(thread_ctx_t *thread_ctx, uint32_t reg, uint32_t row, uint32_t cnt)
+{
+	uint32_t tag = VCPU_GPR(thread_ctx, reg);
+
+	VCPU_GPR_SET(thread_ctx, reg, (tag & ~VCPU_MASK16) |
+		SHIFT_MAP(shift_tbl[row][cnt & SHIFT_CNT_MASK],
+			tag & VCPU_MASK16));
+}
+
+void
+r_shift_opb_l(thread_ctx_t *thread_ctx, uint32_t reg, uint32_t row,
+		uint32_t cnt)
+{
+	uint32_t tag = VCPU_GPR(thread_ctx, reg);
+
+	VCPU_GPR_SET(thread_ctx, reg, (tag & ~VCPU_MASK8) |
+		SHIFT_MAP(shift_tbl[row][cnt & SHIFT_CNT_MASK],
+			tag & VCPU_MASK8));
+}
+
+void
+r_shift_opb_u(thread_ctx_t *thread_ctx, uint32_t reg, uint32_t row,
+		uint32_t cnt)
+{
+	uint32_t tag = VCPU_GPR(thread_ctx, reg);
+
+	VCPU_GPR_SET(thread_ctx, reg, (tag & ~(VCPU_MASK8 << 1)) |
+		(SHIFT_MAP(shift_tbl[row][cnt & SHIFT_CNT_MASK],
+			(tag >> 1) & VCPU_MASK8) << 1));
+}
+
+void
+m_shift_opl(ADDRINT dst, uint32_t row, uint32_t cnt)
+{
+	idft_gen_vec_store(dst, VCPU_MASK32,
+		SHIFT_MAP(shift_tbl[row][cnt & SHIFT_CNT_MASK],
+			idft_gen_vec_load(dst, VCPU_MASK32)));
+}
+
+void
+m_shift_opw(ADDRINT dst, uint32_t row, uint32_t cnt)
+{
+	idft_gen_vec_store(dst, VCPU_MASK16,
+		SHIFT_MAP(shift_tbl[row][cnt & SHIFT_CNT_MASK],
+			idft_gen_vec_load(dst, VCPU_MASK16)));
+}
+
+void
+m_shift_opb(ADDRINT dst, uint32_t row, uint32_t cnt)
+{
+	idft_gen_vec_store(dst, VCPU_MASK8,
+		SHIFT_MAP(shift_tbl[row][cnt & SHIFT_CNT_MASK],
+			idft_gen_vec_load(dst, VCPU_MASK8)));
+}
+
+void
+r_shift_opq(thread_ctx_t *thread_ctx, uint32_t reg, uint32_t row, uint32_t cnt)
+{
+	VCPU_GPR_SET(thread_ctx, reg,
+		shift_qmap(shift_qtbl[row][cnt & SHIFT_QCNT_MASK],
+			VCPU_GPR(thread_ctx, reg)));
+}
+
+void
+m_shift_opq(ADDRINT dst, uint32_t row, uint32_t cnt)
+{
+	idft_gen_vec_store(dst, VCPU_MASK64,
+		shift_qmap(shift_qtbl[row][cnt & SHIFT_QCNT_MASK],
+			idft_gen_vec_load(dst, VCPU_MASK64)));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * SHLD and SHRD; t[dst] = map[cnt](t[dst]) | map'[cnt](t[src]),
+ * where map' (the src side) is the row that follows
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU) or memory address
+ * @src:	source register index (VCPU)
+ * @row:	the row of the operation (shift_tbl, or shift_qtbl for opq)
+ * @cnt:	the count (CL or the immediate)
+ */
+void
+r2r_shiftd_opl(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src,
+		uint32_t row, uint32_t cnt)
+{
+	const uint64_t *m = &shift_tbl[row][cnt & SHIFT_CNT_MASK];
+
+	VCPU_GPR_SET(thread_ctx, dst,
+		SHIFT_MAP(m[0], VCPU_GPR(thread_ctx, dst) & VCPU_MASK32) |
+		SHIFT_MAP(m[SHIFT_CNT], VCPU_GPR(thread_ctx, src) & VCPU_MASK32));
+}
+
+void
+r2r_shiftd_opw(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src,
+		uint32_t row, uint32_t cnt)
+{
+	const uint64_t *m = &shift_tbl[row][cnt & SHIFT_CNT_MASK];
+	uint32_t tag = VCPU_GPR(thread_ctx, dst);
+
+	VCPU_GPR_SET(thread_ctx, dst, (tag & ~VCPU_MASK16) |
+		SHIFT_MAP(m[0], tag & VCPU_MASK16) |
+		SHIFT_MAP(m[SHIFT_CNT], VCPU_GPR(thread_ctx, src) & VCPU_MASK16));
+}
+
+void
+r2m_shiftd_opl(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src,
+		uint32_t row, uint32_t cnt)
+{
+	const uint64_t *m = &shift_tbl[row][cnt & SHIFT_CNT_MASK];
+
+	idft_gen_vec_store(dst, VCPU_MASK32,
+		SHIFT_MAP(m[0], idft_gen_vec_load(dst, VCPU_MASK32)) |
+		SHIFT_MAP(m[SHIFT_CNT], VCPU_GPR(thread_ctx, src) & VCPU_MASK32));
+}
+
+void
+r2m_shiftd_opw(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src,
+		uint32_t row, uint32_t cnt)
+{
+	const uint64_t *m = &shift_tbl[row][cnt & SHIFT_CNT_MASK];
+
+	idft_gen_vec_store(dst, VCPU_MASK16,
+		SHIFT_MAP(m[0], idft_gen_vec_load(dst, VCPU_MASK16)) |
+		SHIFT_MAP(m[SHIFT_CNT], VCPU_GPR(thread_ctx, src) & VCPU_MASK16));
+}
+
+void
+r2r_shiftd_opq(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src,
+		uint32_t row, uint32_t cnt)
+{
+	const uint64_t *m = &shift_qtbl[row][cnt & SHIFT_QCNT_MASK];
+
+	VCPU_GPR_SET(thread_ctx, dst,
+		shift_qmap(m[0], VCPU_GPR(thread_ctx, dst)) |
+		shift_qmap(m[SHIFT_QCNT], VCPU_GPR(thread_ctx, src)));
+}
+
+void
+r2m_shiftd_opq(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src,
+		uint32_t row, uint32_t cnt)
+{
+	const uint64_t *m = &shift_qtbl[row][cnt & SHIFT_QCNT_MASK];
+
+	idft_gen_vec_store(dst, VCPU_MASK64,
+		shift_qmap(m[0], idft_gen_vec_load(dst, VCPU_MASK64)) |
+		shift_qmap(m[SHIFT_QCNT], VCPU_GPR(thread_ctx, src)));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * BSWAP (of a 32 or 64-bit register) and MOVBE; the tag is reversed
+ *
+ * @thread_ctx:	the thread context
+ * @reg:	register index (VCPU)
+ * @dst:	destination register index (VCPU) or memory address
+ * @src:	source register index (VCPU) or memory address
+ */
+void
+r_bswap_opl(thread_ctx_t *thread_ctx, uint32_t reg)
+{
+	VCPU_GPR_SET(thread_ctx, reg,
+		SHIFT_MAP(SHIFT_BSWAP32, VCPU_GPR(thread_ctx, reg) & VCPU_MASK32));
+}
+
+void
+m2r_movbe_opl(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+{
+	VCPU_GPR_SET(thread_ctx, dst,
+		SHIFT_MAP(SHIFT_BSWAP32, idft_gen_vec_load(src, VCPU_MASK32)));
+}
+
+void
+m2r_movbe_opw(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+{
+	VCPU_GPR_SET(thread_ctx, dst,
+		(VCPU_GPR(thread_ctx, dst) & ~VCPU_MASK16) |
+		SHIFT_MAP(SHIFT_BSWAP16, idft_gen_vec_load(src, VCPU_MASK16)));
+}
+
+void
+r2m_movbe_opl(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
+{
+	idft_gen_vec_store(dst, VCPU_MASK32,
+		SHIFT_MAP(SHIFT_BSWAP32, VCPU_GPR(thread_ctx, src) & VCPU_MASK32));
+}
+
+void
+r2m_movbe_opw(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
+{
+	idft_gen_vec_store(dst, VCPU_MASK16,
+		SHIFT_MAP(SHIFT_BSWAP16, VCPU_GPR(thread_ctx, src) & VCPU_MASK16));
+}
+
+void
+r_bswap_opq(thread_ctx_t *thread_ctx, uint32_t reg)
+{
+	VCPU_GPR_SET(thread_ctx, reg,
+		shift_qmap(SHIFT_BSWAP64, VCPU_GPR(thread_ctx, reg)));
+}
+
+void
+m2r_movbe_opq(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+{
+	VCPU_GPR_SET(thread_ctx, dst,
+		shift_qmap(SHIFT_BSWAP64, idft_gen_vec_load(src, VCPU_MASK64)));
+}
+
+void
+r2m_movbe_opq(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
+{
+	idft_gen_vec_store(dst, VCPU_MASK64,
+		shift_qmap(SHIFT_BSWAP64, VCPU_GPR(thread_ctx, src)));
+}
+
+/*
+ * the row of an operation, and its count argument
+ *
+ * @kind:	SHIFT_*
+ * @w:		SHIFT_W* (SHIFT_W64 for the rows of shift_qtbl)
+ * @n:		the count operand
+ * @argt:	IARG_REG_VALUE (CL) or IARG_UINT32 (out)
+ * @argv:	the register or the count (out)
+ *
+ * returns: the row, or SHIFT_NOROW if the operation has no effect
+ * on the tags
+ */
+static uint32_t
+shift_row(idft_ins_t *ins, idft_context_t *context, uint32_t kind, uint32_t w,
+		uint32_t n, uint32_t *argt, uint32_t *argv)
+{
+	uint32_t row, cnt;
+	const uint64_t *m;
+
+	row = (w == SHIFT_W64) ? SHIFT_QROW(0, kind) : SHIFT_ROW(0, w, kind);
+
+	/* CL */
+	if (EXE->INS_OperandIsReg(ins, context, n)) {
+		*argt = IARG_REG_VALUE;
+		*argv = (uint32_t)EXE->INS_OperandReg(ins, context, n);
+		return row;
+	}
+
+	*argt = IARG_UINT32;
+	*argv = 0;
+
+	/* an immediate that the executer cannot tell */
+	if (EXE->INS_OperandImmediate == NULL)
+		return (w == SHIFT_W64) ? SHIFT_QROW(1, kind) :
+			SHIFT_ROW(1, w, kind);
+
+	cnt = (uint32_t)EXE->INS_OperandImmediate(ins, context, n);
+
+	if (w == SHIFT_W64) {
+		cnt &= SHIFT_QCNT_MASK;
+		m = shift_qtbl[row];
+	}
+	else {
+		cnt &= SHIFT_CNT_MASK;
+		m = shift_tbl[row];
+	}
+
+	/* the identity (e.g., by 0, or ROL by the width) */
+	if (m[cnt] == m[0] &&
+			(cnt == 0 || (kind != SHIFT_SHLD && kind != SHIFT_SHRD)))
+		return SHIFT_NOROW;
+
+	*argv = cnt;
+	return row;
+}
+
+/* SHL, SHR, ..., RCR; dst (op. 0) by count (op. 1) */
+static void
+shift_single(idft_ins_t *ins, idft_context_t *context, uint32_t kind)
+{
+	uint32_t row, argt, argv;
+	idft_reg_t reg;
+	void *func;
+
+	/* register operand */
+	if (EXE->INS_OperandIsReg(ins, context, 0)) {
+		reg = EXE->INS_OperandReg(ins, context, 0);
+
+		if (x64_gr64(ins, context, reg)) {
+			row = shift_row(ins, context, kind, SHIFT_W64, 1, &argt,
+					&argv);
+			func = (void *)r_shift_opq;
+			reg = REG64_INDX(ins, context, reg);
+		}
+		else if (EXE->REG_is_gr32(ins, context, reg)) {
+			row = shift_row(ins, context, kind, SHIFT_W32, 1, &argt,
+					&argv);
+			func = (void *)r_shift_opl;
+			reg = REG32_INDX(ins, context, reg);
+		}
+		else if (EXE->REG_is_gr16(ins, context, reg)) {
+			row = shift_row(ins, context, kind, SHIFT_W16, 1, &argt,
+					&argv);
+			func = (void *)r_shift_opw;
+			reg = REG16_INDX(ins, context, reg);
+		}
+		else if (EXE->REG_is_gr8(ins, context, reg)) {
+			row = shift_row(ins, context, kind, SHIFT_W8, 1, &argt,
+					&argv);
+			func = EXE->REG_is_Upper8(ins, context, reg) ?
+				(void *)r_shift_opb_u : (void *)r_shift_opb_l;
+			reg = REG8_INDX(ins, context, reg);
+		}
+		else
+			return;
+
+		if (row != SHIFT_NOROW)
+			EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+				func,
+				7,
+				IARG_THREAD_CONTEXT,
+				IARG_UINT32,
+				(uint32_t)reg,
+				IARG_UINT32,
+				row,
+				argt,
+				argv
+				);
+	}
+	/* memory operand */
+	else if (EXE->INS_OperandIsMemory(ins, context, 0)) {
+		switch (EXE->INS_MemoryWriteSize(ins, context)) {
+			case BIT2BYTE(MEM_QUAD_LEN):
+				row = shift_row(ins, context, kind, SHIFT_W64, 1,
+						&argt, &argv);
+				func = (void *)m_shift_opq;
+				break;
+			case BIT2BYTE(MEM_LONG_LEN):
+				row = shift_row(ins, context, kind, SHIFT_W32, 1,
+						&argt, &argv);
+				func = (void *)m_shift_opl;
+				break;
+			case BIT2BYTE(MEM_WORD_LEN):
+				row = shift_row(ins, context, kind, SHIFT_W16, 1,
+						&argt, &argv);
+				func = (void *)m_shift_opw;
+				break;
+			case BIT2BYTE(MEM_BYTE_LEN):
+				row = shift_row(ins, context, kind, SHIFT_W8, 1,
+						&argt, &argv);
+				func = (void *)m_shift_opb;
+				break;
+			default:
+				return;
+		}
+
+		if (row != SHIFT_NOROW)
+			EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+				func,
+				5,
+				IARG_MEMORYWRITE_EA,
+				IARG_UINT32,
+				row,
+				argt,
+				argv
+				);
+	}
+}
+
+/* SHLD, SHRD; dst (op. 0) by count (op. 2), filled from src (op. 1) */
+static void
+shift_double(idft_ins_t *ins, idft_context_t *context, uint32_t kind)
+{
+	uint32_t row, argt, argv, w;
+	idft_reg_t reg_dst, reg_src;
+	void *func;
+
+	if (!EXE->INS_OperandIsReg(ins, context, 1))
+		return;
+
+	reg_src = EXE->INS_OperandReg(ins, context, 1);
+
+	if (x64_gr64(ins, context, reg_src)) {
+		w = SHIFT_W64;
+		reg_src = REG64_INDX(ins, context, reg_src);
+	}
+	else if (EXE->REG_is_gr32(ins, context, reg_src)) {
+		w = SHIFT_W32;
+		reg_src = REG32_INDX(ins, context, reg_src);
+	}
+	else {
+		w = SHIFT_W16;
+		reg_src = REG16_INDX(ins, context, reg_src);
+	}
+
+	if ((row = shift_row(ins, context, kind, w, 2, &argt, &argv)) ==
+			SHIFT_NOROW)
+		return;
+
+	/* register operand */
+	if (EXE->INS_OperandIsReg(ins, context, 0)) {
+		reg_dst = EXE->INS_OperandReg(ins, context, 0);
+
+		if (w == SHIFT_W64) {
+			reg_dst = REG64_INDX(ins, context, reg_dst);
+			func = (void *)r2r_shiftd_opq;
+		}
+		else if (w == SHIFT_W32) {
+			reg_dst = REG32_INDX(ins, context, reg_dst);
+			func = (void *)r2r_shiftd_opl;
+		}
+		else {
+			reg_dst = REG16_INDX(ins, context, reg_dst);
+			func = (void *)r2r_shiftd_opw;
+		}
+
+		EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+			func,
+			9,
+			IARG_THREAD_CONTEXT,
+			IARG_UINT32,
+			(uint32_t)reg_dst,
+			IARG_UINT32,
+			(uint32_t)reg_src,
+			IARG_UINT32,
+			row,
+			argt,
+			argv
+			);
+	}
+	/* memory operand */
+	else if (EXE->INS_OperandIsMemory(ins, context, 0))
+		EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+			(w == SHIFT_W64) ? (void *)r2m_shiftd_opq :
+			(w == SHIFT_W32) ? (void *)r2m_shiftd_opl :
+				(void *)r2m_shiftd_opw,
+			8,
+			IARG_THREAD_CONTEXT,
+			IARG_MEMORYWRITE_EA,
+			IARG_UINT32,
+			(uint32_t)reg_src,
+			IARG_UINT32,
+			row,
+			argt,
+			argv
+			);
+}
+
+/* MOVBE; a load or a store */
+static void
+shift_movbe(idft_ins_t *ins, idft_context_t *context)
+{
+	idft_reg_t reg;
+	int w32;
+
+	/* load */
+	if (EXE->INS_OperandIsReg(ins, context, 0)) {
+		reg = EXE->INS_OperandReg(ins, context, 0);
+		w32 = EXE->REG_is_gr32(ins, context, reg);
+
+		if (x64_gr64(ins, context, reg)) {
+			EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+				m2r_movbe_opq,
+				4,
+				IARG_THREAD_CONTEXT,
+				IARG_UINT32,
+				(uint32_t)REG64_INDX(ins, context, reg),
+				IARG_MEMORYREAD_EA
+				);
+			return;
+		}
+
+		EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+			w32 ? (void *)m2r_movbe_opl : (void *)m2r_movbe_opw,
+			4,
+			IARG_THREAD_CONTEXT,
+			IARG_UINT32,
+			(uint32_t)(w32 ? REG32_INDX(ins, context, reg) :
+				REG16_INDX(ins, context, reg)),
+			IARG_MEMORYREAD_EA
+			);
+	}
+	/* store */
+	else if (EXE->INS_OperandIsReg(ins, context, 1)) {
+		reg = EXE->INS_OperandReg(ins, context, 1);
+		w32 = EXE->REG_is_gr32(ins, context, reg);
+
+		if (x64_gr64(ins, context, reg)) {
+			EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+				r2m_movbe_opq,
+				4,
+				IARG_THREAD_CONTEXT,
+				IARG_MEMORYWRITE_EA,
+				IARG_UINT32,
+				(uint32_t)REG64_INDX(ins, context, reg)
+				);
+			return;
+		}
+
+		EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+			w32 ? (void *)r2m_movbe_opl : (void *)r2m_movbe_opw,
+			4,
+			IARG_THREAD_CONTEXT,
+			IARG_MEMORYWRITE_EA,
+			IARG_UINT32,
+			(uint32_t)(w32 ? REG32_INDX(ins, context, reg) :
+				REG16_INDX(ins, context, reg))
+			);
+	}
+}
+
+/*
+ * instrument a shift, rotate or byte swap (see above)
+ *
+ * @ins:	the instruction
+ * @context:	the engine context
+ * @opcode:	its class
+ */
+void
+shift_inspect(idft_ins_t *ins, idft_context_t *context, uint32_t opcode)
+{
+	idft_reg_t reg;
+
+	switch (opcode) {
+		case XED_ICLASS_SHL:
+			shift_single(ins, context, SHIFT_SHL);
+			break;
+		case XED_ICLASS_SHR:
+			shift_single(ins, context, SHIFT_SHR);
+			break;
+		case XED_ICLASS_SAR:
+			shift_single(ins, context, SHIFT_SAR);
+			break;
+		case XED_ICLASS_ROL:
+			shift_single(ins, context, SHIFT_ROL);
+			break;
+		case XED_ICLASS_ROR:
+			shift_single(ins, context, SHIFT_ROR);
+			break;
+		case XED_ICLASS_RCL:
+			shift_single(ins, context, SHIFT_RCL);
+			break;
+		case XED_ICLASS_RCR:
+			shift_single(ins, context, SHIFT_RCR);
+			break;
+		case XED_ICLASS_SHLD:
+			shift_double(ins, context, SHIFT_SHLD);
+			break;
+		case XED_ICLASS_SHRD:
+			shift_double(ins, context, SHIFT_SHRD);
+			break;
+		/* the result of BSWAP r16 is undefined; left as is */
+		case XED_ICLASS_BSWAP:
+			reg = EXE->INS_OperandReg(ins, context, 0);
+
+			if (x64_gr64(ins, context, reg))
+				EXE->INS_InsertCall(ins, context,
+					IDFT_IPOINT_BEFORE,
+					r_bswap_opq,
+					3,
+					IARG_THREAD_CONTEXT,
+					IARG_UINT32,
+					(uint32_t)REG64_INDX(ins, context, reg)
+					);
+			else if (likely(EXE->REG_is_gr32(ins, context, reg)))
+				EXE->INS_InsertCall(ins, context,
+					IDFT_IPOINT_BEFORE,
+					r_bswap_opl,
+					3,
+					IARG_THREAD_CONTEXT,
+					IARG_UINT32,
+					(uint32_t)REG32_INDX(ins, context, reg)
+					);
+			break;
+		case XED_ICLASS_MOVBE:
+			shift_movbe(ins, context);
+			break;
+		default:
+			break;
+	}
+}
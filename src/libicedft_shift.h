@@ -0,0 +1,65 @@
+#ifndef LIBICEDFT_SHIFT_H
+#define LIBICEDFT_SHIFT_H
+
+#include <stdint.h>
+#include "libicedft_api.h"
+
+enum {
+/* #define */ SHIFT_SHL	= 0,		/* SHL/SAL */
+/* #define */ SHIFT_SHR	= 1,
+/* #define */ SHIFT_SAR	= 2,
+/* #define */ SHIFT_ROL	= 3,
+/* #define */ SHIFT_ROR	= 4,
+/* #define */ SHIFT_RCL	= 5,
+/* #define */ SHIFT_RCR	= 6,
+/* #define */ SHIFT_SHLD	= 7,		/* the dst side; SHIFT_SHLD + 1 is src */
+/* #define */ SHIFT_SHRD	= 9,		/* likewise */
+/* #define */ SHIFT_KINDS	= 11
+};
+
+enum {
+/* #define */ SHIFT_W8	= 0,
+/* #define */ SHIFT_W16	= 1,
+/* #define */ SHIFT_W32	= 2,
+/* #define */ SHIFT_WIDTHS	= 3,
+/* #define */ SHIFT_W64	= 3		/* in shift_qtbl */
+};
+
+/*
+ * the row argument of the analysis routines. The rows with any
+ * set are for counts that are not known when instrumenting
+ * (immediates, if the executer cannot tell them; see
+ * INS_OperandImmediate); every count maps to the union of all
+ */
+#define SHIFT_ROW(any, w, kind)	\
+	(((any) * SHIFT_WIDTHS + (w)) * SHIFT_KINDS + (kind))
+#define SHIFT_QROW(any, kind)	((any) * SHIFT_KINDS + (kind))
+
+void	shift_init(void);
+void	shift_inspect(idft_ins_t *ins, idft_context_t *context, uint32_t opcode);
+
+void	r_shift_opl(thread_ctx_t *thread_ctx, uint32_t reg, uint32_t row, uint32_t cnt);
+void	r_shift_opw(thread_ctx_t *thread_ctx, uint32_t reg, uint32_t row, uint32_t cnt);
+void	r_shift_opb_l(thread_ctx_t *thread_ctx, uint32_t reg, uint32_t row, uint32_t cnt);
+void	r_shift_opb_u(thread_ctx_t *thread_ctx, uint32_t reg, uint32_t row, uint32_t cnt);
+void	m_shift_opl(ADDRINT dst, uint32_t row, uint32_t cnt);
+void	m_shift_opw(ADDRINT dst, uint32_t row, uint32_t cnt);
+void	m_shift_opb(ADDRINT dst, uint32_t row, uint32_t cnt);
+void	r2r_shiftd_opl(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src, uint32_t row, uint32_t cnt);
+void	r2r_shiftd_opw(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src, uint32_t row, uint32_t cnt);
+void	r2m_shiftd_opl(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src, uint32_t row, uint32_t cnt);
+void	r2m_shiftd_opw(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src, uint32_t row, uint32_t cnt);
+void	r_bswap_opl(thread_ctx_t *thread_ctx, uint32_t reg);
+void	m2r_movbe_opl(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src);
+void	m2r_movbe_opw(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src);
+void	r2m_movbe_opl(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src);
+void	r2m_movbe_opw(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src);
+void	r_shift_opq(thread_ctx_t *thread_ctx, uint32_t reg, uint32_t row, uint32_t cnt);
+void	m_shift_opq(ADDRINT dst, uint32_t row, uint32_t cnt);
+void	r2r_shiftd_opq(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src, uint32_t row, uint32_t cnt);
+void	r2m_shiftd_opq(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src, uint32_t row, uint32_t cnt);
+void	r_bswap_opq(thread_ctx_t *thread_ctx, uint32_t reg);
+void	m2r_movbe_opq(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src);
+void	r2m_movbe_opq(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src);
+
+#endif /* LIBICEDFT_SHIFT_H */
@@ -0,0 +1,468 @@
+/*
+ * SSE/AVX instrumentation
+ *
+ * the XMM/YMM registers are shadowed in vcpu_ctx_t, one bit per
+ * byte (see xmm). ins_inspect hands the instructions it has no
+ * case for to simd_inspect, which covers what vectorized string
+ * and memory routines (memcpy, strlen, memchr, ...) are made of:
+ *
+ *	moves		MOVDQA, MOVDQU, MOVAPS, ..., MOVD, MOVQ
+ *	logic/compare	PAND, POR, PXOR, PCMPEQB, PMINUB, ...
+ *	zero idioms	PXOR xmm0, xmm0, VPCMPEQB ymm1, ymm2, ymm2, ...
+ *	masks		PMOVMSKB
+ *
+ * and their VEX forms (but VMOVD/VMOVQ). Every handler is one
+ * 16-bit (XMM) or 32-bit (YMM) shadow load or store, so a copy
+ * loop costs the same per iteration as its scalar counterpart
+ * does per word.
+ *
+ * any other instruction that writes an XMM/YMM register (shuffles,
+ * unpacks, inserts, MOVSS, VMOVD, arithmetic, ...) clears its tag
+ * instead (see simd_clr), so that the register does not keep the
+ * tag of a value it no longer holds; tests and compares that only
+ * read theirs (PTEST, COMISS, PCMPISTRI, ...) are left alone.
+ *
+ * legacy SSE writes leave the upper half of a YMM register as
+ * is, VEX.128 writes clear it; MMX forms (and executers that do
+ * not map XMM registers; see REG_XMM_INDX) are not instrumented
+ */
+
+#include <stddef.h>
+
+#include "libicedft_api.h"
+#include "libicedft_core.h"
+#include "libicedft_simd.h"
+
+
+#define EXE context->executer_api
+
+enum {
+/* #define */ SIMD_NONE	= 0,		/* not covered */
+/* #define */ SIMD_MOV	= 1,		/* t[dst] = t[src] */
+/* #define */ SIMD_LOGIC	= 2,		/* t[dst] = t[src1] | t[src2] */
+/* #define */ SIMD_ZERO	= 3,		/* SIMD_LOGIC; cleared if src1 == src2 */
+/* #define */ SIMD_TEST	= 4		/* reads its XMM/YMM operands only */
+};
+
+
+/*
+ * classify a vector instruction
+ *
+ * @opcode:	the instruction class
+ * @vex:	set if VEX-encoded (out)
+ *
+ * returns: SIMD_*
+ */
+static uint32_t
+simd_kind(uint32_t opcode, uint32_t *vex)
+{
+	*vex = 0;
+
+	switch (opcode) {
+		case XED_ICLASS_VMOVDQA:
+		case XED_ICLASS_VMOVDQU:
+		case XED_ICLASS_VMOVAPS:
+		case XED_ICLASS_VMOVUPS:
+		case XED_ICLASS_VMOVAPD:
+		case XED_ICLASS_VMOVUPD:
+		case XED_ICLASS_VLDDQU:
+		case XED_ICLASS_VMOVNTDQ:
+		case XED_ICLASS_VMOVNTDQA:
+		case XED_ICLASS_VMOVNTPS:
+		case XED_ICLASS_VMOVNTPD:
+			*vex = 1;
+			/* fall through */
+		case XED_ICLASS_MOVDQA:
+		case XED_ICLASS_MOVDQU:
+		case XED_ICLASS_MOVAPS:
+		case XED_ICLASS_MOVUPS:
+		case XED_ICLASS_MOVAPD:
+		case XED_ICLASS_MOVUPD:
+		case XED_ICLASS_LDDQU:
+		case XED_ICLASS_MOVNTDQ:
+		case XED_ICLASS_MOVNTDQA:
+		case XED_ICLASS_MOVNTPS:
+		case XED_ICLASS_MOVNTPD:
+			return SIMD_MOV;
+
+		case XED_ICLASS_VPAND:
+		case XED_ICLASS_VPOR:
+		case XED_ICLASS_VANDPS:
+		case XED_ICLASS_VANDPD:
+		case XED_ICLASS_VORPS:
+		case XED_ICLASS_VORPD:
+		case XED_ICLASS_VPMINUB:
+		case XED_ICLASS_VPMAXUB:
+			*vex = 1;
+			/* fall through */
+		case XED_ICLASS_PAND:
+		case XED_ICLASS_POR:
+		case XED_ICLASS_ANDPS:
+		case XED_ICLASS_ANDPD:
+		case XED_ICLASS_ORPS:
+		case XED_ICLASS_ORPD:
+		case XED_ICLASS_PMINUB:
+		case XED_ICLASS_PMAXUB:
+			return SIMD_LOGIC;
+
+		case XED_ICLASS_VPXOR:
+		case XED_ICLASS_VXORPS:
+		case XED_ICLASS_VXORPD:
+		case XED_ICLASS_VPANDN:
+		case XED_ICLASS_VANDNPS:
+		case XED_ICLASS_VANDNPD:
+		case XED_ICLASS_VPCMPEQB:
+		case XED_ICLASS_VPCMPEQW:
+		case XED_ICLASS_VPCMPEQD:
+		case XED_ICLASS_VPSUBB:
+			*vex = 1;
+			/* fall through */
+		case XED_ICLASS_PXOR:
+		case XED_ICLASS_XORPS:
+		case XED_ICLASS_XORPD:
+		case XED_ICLASS_PANDN:
+		case XED_ICLASS_ANDNPS:
+		case XED_ICLASS_ANDNPD:
+		case XED_ICLASS_PCMPEQB:
+		case XED_ICLASS_PCMPEQW:
+		case XED_ICLASS_PCMPEQD:
+		case XED_ICLASS_PSUBB:
+			return SIMD_ZERO;
+
+		case XED_ICLASS_PTEST:
+		case XED_ICLASS_VPTEST:
+		case XED_ICLASS_VTESTPS:
+		case XED_ICLASS_VTESTPD:
+		case XED_ICLASS_COMISS:
+		case XED_ICLASS_COMISD:
+		case XED_ICLASS_UCOMISS:
+		case XED_ICLASS_UCOMISD:
+		case XED_ICLASS_VCOMISS:
+		case XED_ICLASS_VCOMISD:
+		case XED_ICLASS_VUCOMISS:
+		case XED_ICLASS_VUCOMISD:
+		case XED_ICLASS_PCMPESTRI:
+		case XED_ICLASS_PCMPESTRM:
+		case XED_ICLASS_PCMPISTRI:
+		case XED_ICLASS_PCMPISTRM:
+		case XED_ICLASS_VPCMPESTRI:
+		case XED_ICLASS_VPCMPESTRM:
+		case XED_ICLASS_VPCMPISTRI:
+		case XED_ICLASS_VPCMPISTRM:
+		case XED_ICLASS_MASKMOVDQU:
+		case XED_ICLASS_VMASKMOVDQU:
+			return SIMD_TEST;
+
+		default:
+			return SIMD_NONE;
+	}
+}
+
+/*
+ * the XMM index of a register operand
+ *
+ * @n:		the operand (from 0)
+ *
+ * returns: the index, or XMM_NUM if it is not an XMM/YMM register
+ */
+static uint32_t
+simd_xmm(idft_ins_t *ins, idft_context_t *context, uint32_t n)
+{
+	uint32_t indx;
+
+	if (!EXE->INS_OperandIsReg(ins, context, n))
+		return XMM_NUM;
+
+	indx = (uint32_t)EXE->REG_XMM_INDX(ins, context,
+			EXE->INS_OperandReg(ins, context, n));
+
+	return (indx < XMM_NUM) ? indx : XMM_NUM;
+}
+
+/* is operand n a YMM register (or 256-bit memory) */
+static int
+simd_wide(idft_ins_t *ins, idft_context_t *context, uint32_t n)
+{
+	return EXE->INS_OperandWidth(ins, context, n) == MEM_YMM_LEN;
+}
+
+/* instrument with t[dst] = f(t[src]) for register indices dst, src */
+static void
+simd_r2r(idft_ins_t *ins, idft_context_t *context, void *func, uint32_t dst,
+		uint32_t src)
+{
+	EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+		func,
+		5,
+		IARG_THREAD_CONTEXT,
+		IARG_UINT32,
+		dst,
+		IARG_UINT32,
+		src
+		);
+}
+
+/* instrument with t[reg] = f(t[mem]) (or the reverse, if write) */
+static void
+simd_mem(idft_ins_t *ins, idft_context_t *context, void *func, uint32_t reg,
+		int write)
+{
+	if (write)
+		EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+			func,
+			4,
+			IARG_THREAD_CONTEXT,
+			IARG_MEMORYWRITE_EA,
+			IARG_UINT32,
+			reg
+			);
+	else
+		EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+			func,
+			4,
+			IARG_THREAD_CONTEXT,
+			IARG_UINT32,
+			reg,
+			IARG_MEMORYREAD_EA
+			);
+}
+
+/*
+ * clear the tag of an XMM/YMM destination (operand 0), if
+ * there is one; for what the other cases do not propagate.
+ * A YMM one is cleared whole, an XMM one keeps the upper
+ * half (VEX.128 forms zero it; it is left as is)
+ */
+static void
+simd_clr(idft_ins_t *ins, idft_context_t *context)
+{
+	uint32_t dst = simd_xmm(ins, context, 0);
+
+	if (dst == XMM_NUM)
+		return;
+
+	EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+		simd_wide(ins, context, 0) ? (void *)ymm_clr_opy :
+		(void *)xmm_clr_opx,
+		3,
+		IARG_THREAD_CONTEXT,
+		IARG_UINT32,
+		dst
+		);
+}
+
+/*
+ * MOVD/MOVQ; between XMM registers, 32-bit registers
+ * and memory (the forms to MMX registers are left alone)
+ *
+ * @q:		1 for MOVQ, 0 for MOVD
+ */
+static void
+simd_movd(idft_ins_t *ins, idft_context_t *context, int q)
+{
+	uint32_t dst = simd_xmm(ins, context, 0);
+	uint32_t src = simd_xmm(ins, context, 1);
+	idft_reg_t reg;
+
+	/* to an XMM register */
+	if (dst < XMM_NUM) {
+		if (src < XMM_NUM) {
+			if (q)
+				simd_r2r(ins, context,
+					(void *)xmm_r2r_xfer_opq, dst, src);
+		}
+		else if (EXE->INS_OperandIsMemory(ins, context, 1))
+			simd_mem(ins, context, q ? (void *)xmm_m2r_xfer_opq :
+				(void *)xmm_m2r_xfer_opl, dst, 0);
+		else if (EXE->REG_is_gr32(ins, context,
+				(reg = EXE->INS_OperandReg(ins, context, 1))))
+			simd_r2r(ins, context, (void *)xmm_r2x_xfer_opl, dst,
+				REG32_INDX(ins, context, reg));
+		/* MOVD xmm, r64 and MOVQ xmm, mm */
+		else
+			simd_clr(ins, context);
+	}
+	/* from an XMM register */
+	else if (src < XMM_NUM) {
+		if (EXE->INS_OperandIsMemory(ins, context, 0))
+			simd_mem(ins, context, q ? (void *)xmm_r2m_xfer_opq :
+				(void *)xmm_r2m_xfer_opl, src, 1);
+		else if (EXE->REG_is_gr32(ins, context,
+				(reg = EXE->INS_OperandReg(ins, context, 0))))
+			simd_r2r(ins, context, (void *)xmm_x2r_xfer_opl,
+				REG32_INDX(ins, context, reg), src);
+	}
+}
+
+/* the moves of simd_kind */
+static void
+simd_mov(idft_ins_t *ins, idft_context_t *context, uint32_t vex)
+{
+	uint32_t dst = simd_xmm(ins, context, 0);
+	uint32_t src = simd_xmm(ins, context, 1);
+
+	/* store */
+	if (dst == XMM_NUM) {
+		if (src < XMM_NUM && EXE->INS_OperandIsMemory(ins, context, 0))
+			simd_mem(ins, context, simd_wide(ins, context, 1) ?
+				(void *)ymm_r2m_xfer_opy :
+				(void *)xmm_r2m_xfer_opx, src, 1);
+	}
+	/* both operands are registers */
+	else if (src < XMM_NUM)
+		simd_r2r(ins, context,
+			!vex ? (void *)xmm_r2r_xfer_opx :
+			simd_wide(ins, context, 0) ? (void *)ymm_r2r_xfer_opy :
+			(void *)ymm_r2r_xfer_opx, dst, src);
+	/* load */
+	else if (EXE->INS_OperandIsMemory(ins, context, 1))
+		simd_mem(ins, context,
+			!vex ? (void *)xmm_m2r_xfer_opx :
+			simd_wide(ins, context, 0) ? (void *)ymm_m2r_xfer_opy :
+			(void *)ymm_m2r_xfer_opx, dst, 0);
+}
+
+/*
+ * the logic and compare operations of simd_kind; dst op= src
+ * (legacy) or dst = src1 op src2 (VEX)
+ *
+ * @zero:	src1 == src2 clears dst
+ */
+static void
+simd_logic(idft_ins_t *ins, idft_context_t *context, uint32_t vex, int zero)
+{
+	uint32_t dst = simd_xmm(ins, context, 0);
+	uint32_t src1, src2;
+	int wide;
+
+	if (dst == XMM_NUM)
+		return;
+
+	/* legacy; 2 operands */
+	if (!vex) {
+		if ((src2 = simd_xmm(ins, context, 1)) < XMM_NUM) {
+			if (zero && src2 == dst)
+				EXE->INS_InsertCall(ins, context,
+					IDFT_IPOINT_BEFORE,
+					xmm_clr_opx,
+					3,
+					IARG_THREAD_CONTEXT,
+					IARG_UINT32,
+					dst
+					);
+			else
+				simd_r2r(ins, context,
+					(void *)xmm_r2r_binary_opx, dst, src2);
+		}
+		else if (EXE->INS_OperandIsMemory(ins, context, 1))
+			simd_mem(ins, context, (void *)xmm_m2r_binary_opx,
+				dst, 0);
+
+		return;
+	}
+
+	/* VEX; 3 operands */
+	if ((src1 = simd_xmm(ins, context, 1)) == XMM_NUM)
+		return;
+
+	wide = simd_wide(ins, context, 0);
+
+	if ((src2 = simd_xmm(ins, context, 2)) < XMM_NUM) {
+		if (zero && src1 == src2)
+			EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+				ymm_clr_opy,
+				3,
+				IARG_THREAD_CONTEXT,
+				IARG_UINT32,
+				dst
+				);
+		else
+			EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+				wide ? (void *)ymm_rr2r_binary_opy :
+				(void *)ymm_rr2r_binary_opx,
+				7,
+				IARG_THREAD_CONTEXT,
+				IARG_UINT32,
+				dst,
+				IARG_UINT32,
+				src1,
+				IARG_UINT32,
+				src2
+				);
+	}
+	else if (EXE->INS_OperandIsMemory(ins, context, 2))
+		EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+			wide ? (void *)ymm_rm2r_binary_opy :
+			(void *)ymm_rm2r_binary_opx,
+			6,
+			IARG_THREAD_CONTEXT,
+			IARG_UINT32,
+			dst,
+			IARG_UINT32,
+			src1,
+			IARG_MEMORYREAD_EA
+			);
+}
+
+/*
+ * instrument a vector instruction (see above)
+ *
+ * @ins:	the instruction
+ * @context:	the engine context
+ * @opcode:	its class
+ */
+void
+simd_inspect(idft_ins_t *ins, idft_context_t *context, uint32_t opcode)
+{
+	uint32_t kind, vex, src;
+	idft_reg_t reg;
+
+	/* no XMM registers */
+	if (EXE->REG_XMM_INDX == NULL)
+		return;
+
+	switch (opcode) {
+		case XED_ICLASS_VZEROUPPER:
+			EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+				ymm_clr_upper,
+				1,
+				IARG_THREAD_CONTEXT
+				);
+			break;
+		case XED_ICLASS_VZEROALL:
+			EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+				ymm_clr_all,
+				1,
+				IARG_THREAD_CONTEXT
+				);
+			break;
+		case XED_ICLASS_PMOVMSKB:
+		case XED_ICLASS_VPMOVMSKB:
+			reg = EXE->INS_OperandReg(ins, context, 0);
+			if ((src = simd_xmm(ins, context, 1)) == XMM_NUM ||
+					!EXE->REG_is_gr32(ins, context, reg))
+				break;
+
+			simd_r2r(ins, context, simd_wide(ins, context, 1) ?
+				(void *)ymm_x2r_mask_opy :
+				(void *)xmm_x2r_mask_opx,
+				REG32_INDX(ins, context, reg), src);
+			break;
+		case XED_ICLASS_MOVD:
+		case XED_ICLASS_MOVQ:
+			simd_movd(ins, context, opcode == XED_ICLASS_MOVQ);
+			break;
+		default:
+			kind = simd_kind(opcode, &vex);
+
+			if (kind == SIMD_MOV)
+				simd_mov(ins, context, vex);
+			else if (kind == SIMD_LOGIC || kind == SIMD_ZERO)
+				simd_logic(ins, context, vex,
+					kind == SIMD_ZERO);
+			/* the rest; shuffles, inserts, scalar moves, ... */
+			else if (kind == SIMD_NONE)
+				simd_clr(ins, context);
+			break;
+	}
+}
@@ -0,0 +1,9 @@
+#ifndef LIBICEDFT_SIMD_H
+#define LIBICEDFT_SIMD_H
+
+#include <stdint.h>
+#include "libicedft_api.h"
+
+void	simd_inspect(idft_ins_t *ins, idft_context_t *context, uint32_t opcode);
+
+#endif /* LIBICEDFT_SIMD_H */
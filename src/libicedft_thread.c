@@ -0,0 +1,290 @@
+/*
+ * thread context pool and registry
+ *
+ * libdft_thread_start hands out thread contexts from slots that
+ * are cache-line aligned and padded (see thread_slot_t), so the
+ * VCPUs of two threads never false-share a line. Slots are carved
+ * from slabs allocated per NUMA node, preferring (mbind) the node
+ * of the thread that needs them; libdft_thread_fini returns a slot
+ * to the free list of its node, where the next thread started on
+ * that node picks it up, so short-lived threads do not churn the
+ * allocator. Without NUMA support (or where the node cannot be
+ * told), there is one node and the pages are placed on first touch.
+ *
+ * started contexts are registered under the executer's thread id;
+ * the registry is shared by all threads and serialized with a
+ * spinlock (start and fini are rare, the analysis routines never
+ * take it)
+ */
+
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "libicedft_api.h"
+#include "libicedft_thread.h"
+#include "branch_pred.h"
+
+
+#define THREAD_HASH(tid)	(((tid) * 0x9E3779B1U) >> 24 & (THREAD_HASH_SZ - 1))
+#define THREAD_MPOL_PREFERRED	1		/* mbind(2); <numaif.h> */
+
+
+/* the pool of a context (allocate on first use, by any thread) */
+static thread_pool_t *
+thread_pool(idft_context_t *context)
+{
+	void *p = __atomic_load_n(&context->threads, __ATOMIC_ACQUIRE);
+	void *q = NULL;
+
+	if (likely(p != NULL))
+		return (thread_pool_t *)p;
+
+	if ((p = calloc(1, sizeof(thread_pool_t))) == NULL)
+		return NULL;
+
+	/* lost the race */
+	if (!__atomic_compare_exchange_n(&context->threads, &q, p, 0,
+			__ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+		free(p);
+		p = q;
+	}
+
+	return (thread_pool_t *)p;
+}
+
+static inline void
+thread_lock(thread_pool_t *p)
+{
+	while (__atomic_test_and_set(&p->lock, __ATOMIC_ACQUIRE))
+		sched_yield();
+}
+
+static inline void
+thread_unlock(thread_pool_t *p)
+{
+	__atomic_clear(&p->lock, __ATOMIC_RELEASE);
+}
+
+/* the NUMA node of the calling thread; 0 if unknown */
+static uint32_t
+thread_node(void)
+{
+#ifdef SYS_getcpu
+	unsigned int cpu, node;
+
+	if (syscall(SYS_getcpu, &cpu, &node, NULL) == 0)
+		return node;
+#endif
+	return 0;
+}
+
+/*
+ * carve a slab into free slots of a node
+ *
+ * @p:		the pool (locked)
+ * @node:	the NUMA node
+ *
+ * returns: 0 on success, 1 on error
+ */
+static int
+thread_slab(thread_pool_t *p, uint32_t node)
+{
+	thread_slab_t *slab;
+	thread_slot_t *s;
+	uint32_t i, n = node % THREAD_NODES;
+#ifdef SYS_mbind
+	unsigned long mask;
+#endif
+
+	if (unlikely((slab = mmap(NULL, THREAD_SLAB_SZ,
+			PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+			-1, 0)) == MAP_FAILED))
+		return 1;
+
+#ifdef SYS_mbind
+	/* before the first touch; best effort */
+	if (node < sizeof(mask) * 8) {
+		mask = 1UL << node;
+		(void)syscall(SYS_mbind, slab, THREAD_SLAB_SZ,
+			THREAD_MPOL_PREFERRED, &mask, sizeof(mask) * 8 + 1, 0);
+	}
+#endif
+
+	slab->next	= p->slabs;
+	p->slabs	= slab;
+
+	/* in address order */
+	s = (thread_slot_t *)(slab + 1);
+	for (i = (THREAD_SLAB_SZ - sizeof(*slab)) / sizeof(*s); i > 0; i--) {
+		s[i - 1].node	= node;
+		s[i - 1].next	= p->free[n];
+		p->free[n]	= &s[i - 1];
+	}
+
+	return 0;
+}
+
+/*
+ * start a thread; its context is zeroed, 64-byte aligned and
+ * allocated on the NUMA node of the calling thread
+ *
+ * @context:	the engine context
+ * @tid:	the executer's thread id
+ *
+ * returns: the context (the registered one, if tid already is),
+ * or NULL on error
+ */
+thread_ctx_t *
+libdft_thread_start(idft_context_t *context, uint32_t tid)
+{
+	thread_pool_t *p = thread_pool(context);
+	uint32_t h = THREAD_HASH(tid), node = thread_node();
+	thread_slot_t *s;
+
+	if (unlikely(p == NULL))
+		return NULL;
+
+	thread_lock(p);
+
+	for (s = p->hash[h]; s != NULL; s = s->next)
+		if (s->tid == tid)
+			break;
+
+	if (s == NULL && (p->free[node % THREAD_NODES] != NULL ||
+			thread_slab(p, node) == 0)) {
+		s			= p->free[node % THREAD_NODES];
+		p->free[node % THREAD_NODES] = s->next;
+
+		memset(&s->ctx, 0, sizeof(s->ctx));
+		THREAD_CTX_STALE(&s->ctx);
+		s->ctx.slot	= &s->ctx;
+
+		s->tid		= tid;
+		s->next		= p->hash[h];
+		p->hash[h]	= s;
+		p->nthreads++;
+	}
+
+	thread_unlock(p);
+
+	return (s == NULL) ? NULL : &s->ctx;
+}
+
+/*
+ * stop a thread; its ring is drained, and its context is
+ * unregistered and recycled
+ *
+ * @context:	the engine context
+ * @thread_ctx:	the context (libdft_thread_start)
+ */
+void
+libdft_thread_fini(idft_context_t *context, thread_ctx_t *thread_ctx)
+{
+	thread_pool_t *p = (thread_pool_t *)context->threads;
+	thread_slot_t *s, **pp;
+
+	if (unlikely(p == NULL || thread_ctx == NULL ||
+			(s = THREAD_SLOT(thread_ctx)) == NULL))
+		return;
+
+	/* its pending records; the ring stays with the slot */
+	libdft_ring_drain(thread_ctx);
+
+	thread_lock(p);
+
+	for (pp = &p->hash[THREAD_HASH(s->tid)]; *pp != NULL;
+			pp = &(*pp)->next)
+		if (*pp == s) {
+			*pp	= s->next;
+			s->next	= p->free[s->node % THREAD_NODES];
+			p->free[s->node % THREAD_NODES] = s;
+			p->nthreads--;
+			break;
+		}
+
+	thread_unlock(p);
+}
+
+/*
+ * look up a thread
+ *
+ * @context:	the engine context
+ * @tid:	the executer's thread id
+ *
+ * returns: its context, or NULL if it is not started
+ */
+thread_ctx_t *
+libdft_thread_get(idft_context_t *context, uint32_t tid)
+{
+	thread_pool_t *p = (thread_pool_t *)context->threads;
+	thread_slot_t *s;
+
+	if (p == NULL)
+		return NULL;
+
+	thread_lock(p);
+
+	for (s = p->hash[THREAD_HASH(tid)]; s != NULL; s = s->next)
+		if (s->tid == tid)
+			break;
+
+	thread_unlock(p);
+
+	return (s == NULL) ? NULL : &s->ctx;
+}
+
+/*
+ * visit every started thread
+ *
+ * @context:	the engine context
+ * @cb:		called with each thread id and context, with the
+ *		registry locked; it must not call libdft_thread_*
+ * @arg:	handed to cb
+ *
+ * returns: the number of threads visited
+ */
+uint32_t
+libdft_thread_foreach(idft_context_t *context,
+		void (*cb)(void *arg, uint32_t tid, thread_ctx_t *thread_ctx),
+		void *arg)
+{
+	thread_pool_t *p = (thread_pool_t *)context->threads;
+	thread_slot_t *s;
+	uint32_t h, n = 0;
+
+	if (p == NULL)
+		return 0;
+
+	thread_lock(p);
+
+	for (h = 0; h < THREAD_HASH_SZ; h++)
+		for (s = p->hash[h]; s != NULL; s = s->next, n++)
+			cb(arg, s->tid, &s->ctx);
+
+	thread_unlock(p);
+
+	return n;
+}
+
+/* release the slabs; the contexts handed out are gone */
+void
+thread_pool_free(idft_context_t *context)
+{
+	thread_pool_t *p = (thread_pool_t *)context->threads;
+	thread_slab_t *slab;
+
+	if (p == NULL)
+		return;
+
+	while ((slab = p->slabs) != NULL) {
+		p->slabs = slab->next;
+		munmap(slab, THREAD_SLAB_SZ);
+	}
+
+	free(p);
+	context->threads = NULL;
+}
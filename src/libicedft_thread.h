@@ -0,0 +1,42 @@
+#ifndef LIBICEDFT_THREAD_H
+#define LIBICEDFT_THREAD_H
+
+#include <stdint.h>
+#include "libicedft_api.h"
+
+#define THREAD_LINE	64			/* cache line */
+#define THREAD_SLAB_SZ	(64 * 1024)		/* bytes per slab */
+#define THREAD_NODES	64			/* NUMA nodes with their own slots */
+#define THREAD_HASH_SZ	256			/* registry chains; a power of 2 */
+
+/* a thread context and its pool bookkeeping; never shares a line */
+typedef struct thread_slot {
+	thread_ctx_t	ctx;			/* first; the slot is the context */
+	struct thread_slot	*next;		/* free list or registry chain */
+	uint32_t	tid;			/* registered as */
+	uint32_t	node;			/* of its slab */
+	void		*ring;			/* event ring (ring_t, see libicedft_ring.c) */
+} __attribute__((aligned(THREAD_LINE))) thread_slot_t;
+
+/* the slot of a context, or NULL if it is not one (see thread_ctx_t) */
+#define THREAD_SLOT(thread_ctx)						\
+	(((thread_ctx)->slot == (void *)(thread_ctx)) ?			\
+	 (thread_slot_t *)(thread_ctx) : NULL)
+
+/* slots are carved from slabs (mmap'ed, bound to a node), kept until libdft_die */
+typedef struct thread_slab {
+	struct thread_slab	*next;
+} __attribute__((aligned(THREAD_LINE))) thread_slab_t;
+
+/* the thread contexts of an engine context */
+typedef struct {
+	uint8_t		lock;			/* start, fini, get, foreach */
+	uint32_t	nthreads;		/* registered */
+	thread_slot_t	*free[THREAD_NODES];	/* recycled slots, per node */
+	thread_slot_t	*hash[THREAD_HASH_SZ];	/* the registry, by tid */
+	thread_slab_t	*slabs;
+} thread_pool_t;
+
+void	thread_pool_free(idft_context_t *context);
+
+#endif /* LIBICEDFT_THREAD_H */
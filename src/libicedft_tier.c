@@ -0,0 +1,205 @@
+/*
+ * tiered instrumentation
+ *
+ * optimizing a block (see libicedft_ir.c) costs more at
+ * instrumentation time than instrumenting it plainly, and
+ * most blocks run only a handful of times. With IDFT_OPT_TIER,
+ * the first time a block (or trace) is seen it is instrumented
+ * with ins_inspect, plus one call at its entry that counts its
+ * runs. Once the count reaches the threshold, the block is
+ * marked hot and the executer is asked to drop its code
+ * (RemoveInstrumentationInRange); the next time it runs,
+ * bbl_inspect (or trace_inspect) finds it hot and applies
+ * every optimization enabled.
+ *
+ * counters are keyed by the address of the first instruction,
+ * kept until libdft_die (so re-instrumented code stays hot)
+ * and updated without locks; a lost update only delays the
+ * promotion
+ */
+
+#include <stdlib.h>
+
+#include "libicedft_api.h"
+#include "libicedft_core.h"
+#include "libicedft_filter.h"
+#include "libicedft_rec.h"
+#include "libicedft_tier.h"
+#include "branch_pred.h"
+
+
+#define EXE context->executer_api
+
+/* the counters of a context (allocate on first use) */
+static tier_t *
+tier_get(idft_context_t *context)
+{
+	tier_t *t = (tier_t *)context->tier;
+
+	if (unlikely(t == NULL)) {
+		if ((t = calloc(1, sizeof(tier_t))) == NULL)
+			return NULL;
+		t->threshold	= TIER_THRESHOLD;
+		context->tier	= t;
+	}
+
+	return t;
+}
+
+/*
+ * look up (create) the counter of a block
+ *
+ * @t:		the counters
+ * @lo:		the address of its first instruction
+ * @context:	the engine context
+ *
+ * returns: the counter, or NULL on error
+ */
+static tier_ent_t *
+tier_lookup(tier_t *t, ADDRINT lo, idft_context_t *context)
+{
+	uint32_t h = (uint32_t)((lo * 0x9E3779B1U) >> 16) & (TIER_HASH_SZ - 1);
+	tier_chunk_t *c;
+	tier_ent_t *ent;
+
+	for (ent = t->hash[h]; ent != NULL; ent = ent->next)
+		if (ent->lo == lo)
+			return ent;
+
+	if (t->chunks == NULL || t->chunks->n == TIER_CHUNK) {
+		if ((c = calloc(1, sizeof(tier_chunk_t))) == NULL)
+			return NULL;
+		c->next		= t->chunks;
+		t->chunks	= c;
+	}
+
+	ent		= &t->chunks->ents[t->chunks->n++];
+	ent->lo		= lo;
+	ent->hi		= lo;
+	ent->left	= (int32_t)t->threshold;
+	ent->context	= context;
+	ent->next	= t->hash[h];
+	t->hash[h]	= ent;
+
+	return ent;
+}
+
+/*
+ * count a run of a cold block (analysis function)
+ *
+ * @ent:	its counter
+ */
+void
+tier_count(tier_ent_t *ent)
+{
+	idft_context_t *context;
+
+	if (likely(--ent->left > 0) || ent->hot)
+		return;
+
+	context		= ent->context;
+	ent->hot	= 1;
+
+	/* this run completes as it is */
+	EXE->RemoveInstrumentationInRange(ent->lo, ent->hi, context);
+}
+
+/*
+ * instrument a block that has not become hot yet
+ *
+ * @ins:	the instructions of the block (or trace), in order
+ * @ins_num:	instruction count
+ * @context:	the engine context
+ *
+ * returns: 1 if the block was instrumented (cold), 0 if the
+ * caller must instrument it (hot, or tiering not possible)
+ */
+int
+tier_cold(idft_ins_t *ins, uint32_t ins_num, idft_context_t *context)
+{
+	ADDRINT argv[2];
+	uint32_t i;
+	tier_ent_t *ent;
+	tier_t *t;
+	ADDRINT lo;
+
+	/* the executer cannot tell, or cannot re-instrument */
+	if (EXE->INS_Address == NULL ||
+			EXE->RemoveInstrumentationInRange == NULL ||
+			ins_num == 0)
+		return 0;
+
+	lo = (ADDRINT)EXE->INS_Address(&ins[0], context);
+
+	/* not to be instrumented anyway (see filter_skip) */
+	if (context->filter != NULL &&
+			filter_lookup((filter_t *)context->filter, lo) !=
+				IDFT_FILTER_INCLUDE)
+		return 0;
+
+	if ((t = tier_get(context)) == NULL ||
+			(ent = tier_lookup(t, lo, context)) == NULL ||
+			ent->hot)
+		return 0;
+
+	/* IARG_ADDRINT carries a pointer on 32-bit hosts only */
+	if (unlikely((uintptr_t)(ADDRINT)(uintptr_t)ent != (uintptr_t)ent))
+		return 0;
+
+	ent->hi = (ADDRINT)EXE->INS_Address(&ins[ins_num - 1], context);
+
+	argv[0] = IARG_ADDRINT;
+	argv[1] = (ADDRINT)(uintptr_t)ent;
+	rec_insert(context, &ins[0], REC_CALL, IDFT_IPOINT_BEFORE,
+			(void *)tier_count, 2, argv);
+
+	for (i = 0; i < ins_num; i++)
+		ins_inspect(&ins[i], context);
+
+	return 1;
+}
+
+/*
+ * set the promotion threshold of the blocks seen from now on
+ *
+ * @context:	the engine context
+ * @threshold:	runs before a block is optimized
+ *
+ * returns: the previous threshold
+ */
+uint32_t
+libdft_tier_set_threshold(idft_context_t *context, uint32_t threshold)
+{
+	tier_t *t = tier_get(context);
+	uint32_t old;
+
+	if (t == NULL)
+		return TIER_THRESHOLD;
+
+	old		= t->threshold;
+	t->threshold	= (threshold > 0) ? threshold : 1;
+
+	return old;
+}
+
+/*
+ * release the counters of a context; only when no
+ * instrumented code can run anymore (libdft_die)
+ */
+void
+tier_free(idft_context_t *context)
+{
+	tier_t *t = (tier_t *)context->tier;
+	tier_chunk_t *c;
+
+	if (t == NULL)
+		return;
+
+	while ((c = t->chunks) != NULL) {
+		t->chunks = c->next;
+		free(c);
+	}
+
+	free(t);
+	context->tier = NULL;
+}
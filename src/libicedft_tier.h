@@ -0,0 +1,39 @@
+#ifndef LIBICEDFT_TIER_H
+#define LIBICEDFT_TIER_H
+
+#include <stdint.h>
+#include "libicedft_api.h"
+
+#define TIER_THRESHOLD	1024			/* default; runs before optimizing */
+#define TIER_HASH_SZ	65536			/* hash chains; a power of 2 */
+#define TIER_CHUNK	1024			/* counters per allocation */
+
+/* the counter of a block (or trace) */
+typedef struct tier_ent {
+	ADDRINT		lo;			/* first instruction */
+	ADDRINT		hi;			/* last instruction */
+	int32_t		left;			/* runs before promotion */
+	uint32_t	hot;			/* promoted */
+	idft_context_t	*context;
+	struct tier_ent	*next;			/* hash chain */
+} tier_ent_t;
+
+/* counters never move; they are allocated in chunks */
+typedef struct tier_chunk {
+	struct tier_chunk	*next;
+	uint32_t	n;
+	tier_ent_t	ents[TIER_CHUNK];
+} tier_chunk_t;
+
+/* the counters of a context */
+typedef struct {
+	tier_ent_t	*hash[TIER_HASH_SZ];
+	tier_chunk_t	*chunks;
+	uint32_t	threshold;
+} tier_t;
+
+int	tier_cold(idft_ins_t *ins, uint32_t ins_num, idft_context_t *context);
+void	tier_count(tier_ent_t *ent);
+void	tier_free(idft_context_t *context);
+
+#endif /* LIBICEDFT_TIER_H */
@@ -5,7 +5,13 @@
 #include <stdint.h>
 #include "libicedft_opcode.h"
 
+//the width of the guest registers; IDFT_X86_64 builds the engine for
+//64-bit (x86-64) code, the default is 32-bit (x86) code
+#ifdef IDFT_X86_64
+#define IDFT_REG_TYPE uint64_t
+#else
 #define IDFT_REG_TYPE uint32_t 
+#endif
 
 //the type represent number type which has the same length with vcpu register
 #define idft_reg_t IDFT_REG_TYPE
@@ -52,6 +58,10 @@ typedef char* (*f_0_r_s_t)(idft_ins_t*, void * );
 
 typedef uint32_t (*f_f_t)(idft_ins_t*, void *,  uint32_t action, void* func,  uint32_t  arg_count, ... );
 
+typedef uint32_t (*f_r_t)(ADDRINT lo, ADDRINT hi, void * );
+
+typedef ADDRINT (*f_a_t)(idft_ins_t*, void * );
+
 
 
 
@@ -260,6 +270,9 @@ typedef struct idft_executer_api
   //param 2: idft_context_t context
   //param 3: Executer reg 
   //return: the reg index in vcpu (see vcpu_ctx_t comments) 
+  //with IDFT_X86_64, the REX registers map too: R8D..R15D (R8W..R15W,
+  //R8B..R15B) to 8..15, and SPL, BPL, SIL, DIL are the lower 8-bit
+  //registers of 3, 2, 1, 0
   f_1_t REG32_INDX;
 
   //Executer 16bit reg to vcpu reg map
@@ -322,16 +335,215 @@ typedef struct idft_executer_api
   //get executer esp reg id
   f_0_t REG_ESP;
 
+  //get instruction's address
+  //param 1: pointer to a instruction
+  //param 2: idft_context_t context
+  //return: the instruction address
+  //optional; may be NULL, in which case the filters (see libdft_filter_range) are ignored
+  f_a_t INS_Address;
+
+  //get the displacement of the instruction's memory operand
+  //param 1: pointer to a instruction
+  //param 2: idft_context_t context
+  //return: the displacement (signed), or 0 if there is none
+  //optional; may be NULL, in which case memory accesses are not coalesced (IDFT_OPT_COALESCE)
+  f_0_t INS_MemoryDisplacement;
+
+  //get the segment override prefix of the instruction's memory operand
+  //param 1: pointer to a instruction
+  //param 2: idft_context_t context
+  //return: the executer segment reg id, or REG_INVALID if there is no override
+  //optional; may be NULL, in which case memory accesses are not coalesced (IDFT_OPT_COALESCE)
+  f_0_t INS_SegmentRegPrefix;
+
+  //drop the instrumentation of the code in an address range; it is instrumented
+  //again (bbl_inspect/trace_inspect) the next time it runs
+  //param 1: first address
+  //param 2: last address
+  //param 3: idft_context_t context
+  //return: 0 on success
+  //called from analysis routines; the code that is running completes as it is
+  //optional; may be NULL, in which case blocks are not tiered (IDFT_OPT_TIER)
+  f_r_t RemoveInstrumentationInRange;
+
+  //Executer xmm/ymm reg to vcpu xmm index map
+  //param 1: pointer to a instruction , which can be NULL
+  //param 2: idft_context_t context
+  //param 3: Executer reg
+  //return: the index in vcpu xmm (0 for XMM0/YMM0 ...), or XMM_NUM if reg is not a xmm/ymm reg
+  //optional; may be NULL, in which case SSE/AVX instructions are not instrumented
+  f_1_t REG_XMM_INDX;
+
+  //get the value of an immediate operand
+  //param 1: pointer to a instruction
+  //param 2: idft_context_t context
+  //param 3: the operand (from 0)
+  //return: the immediate
+  //optional; may be NULL, in which case shifts and rotates by an immediate are
+  //propagated as if the count could be any, and the frames of ENTER are not cleared
+  f_1_t INS_OperandImmediate;
+
+  //check the register is 64 bit
+  //param 1: pointer to a instruction
+  //param 2: idft_context_t context
+  //param 3: the executer reg id
+  //return: 0： no , 1:yes
+  //optional; may be NULL (32-bit code). With IDFT_X86_64 it must be
+  //provided, along with REG64_INDX
+  f_1_t REG_is_gr64;
+
+  //Executer 64bit reg to vcpu reg map
+  //param 1: pointer to a instruction , which can is ignore
+  //param 2: idft_context_t context
+  //param 3: Executer reg
+  //return: the reg index in vcpu (RAX to 7, ..., R8 to 8, ...; see vcpu_ctx_t comments)
+  //optional; see REG_is_gr64
+  f_1_t REG64_INDX;
+
+  //get executer RAX reg id
+  //param 1: pointer to a instruction , which can is ignore
+  //param 2: idft_context_t context
+  //return: the executer RAX reg id
+  //optional; see REG_is_gr64 (for 64-bit CMPXCHG)
+  f_0_t REG_RAX;
+
+  //get executer RDX reg id
+  //param 1: pointer to a instruction , which can is ignore
+  //param 2: idft_context_t context
+  //return: the executer RDX reg id
+  //optional; see REG_is_gr64 (for CMPXCHG16B, along with REG_RAX)
+  f_0_t REG_RDX;
+
 
 }idft_executer_api_t;
 
 
+//a precomputed taint program (see libicedft_prog.c)
+typedef struct idft_prog idft_prog_t;
+
+//an effective address slot of a taint program; before running
+//the program the executer stores in ea[slot] the memory read
+//(or write) address of instruction ins of the block
+typedef struct idft_prog_slot
+{
+  uint32_t ins;        //instruction index within the block
+  uint32_t write;      //0: IARG_MEMORYREAD_EA, 1: IARG_MEMORYWRITE_EA
+
+}idft_prog_slot_t;
+
+
+//a precompiled argument pack (see libicedft_argpack.c); the
+//operands of one micro-op, for the argpack_* analysis routines
+typedef struct idft_argpack
+{
+  uint8_t dst;         //destination VCPU index (register destinations)
+  uint8_t src;         //source VCPU index (register sources)
+  uint8_t sshift;      //lowest source lane
+  uint8_t smask;       //source lanes (or memory bits), moved to lane 0
+  uint8_t dshift;      //lowest destination lane
+  uint8_t dclr;        //destination lanes (or memory bits) cleared first
+  uint8_t mul;         //source lane replication; 1 (copy), 0 (clear) or more (sign extension)
+  uint8_t pad;
+
+}idft_argpack_t;
+
+
+//a coalesced group of memory accesses (see libicedft_coalesce.c);
+//accesses relative to one base register, in program order, over a
+//window of at most 56 bytes. Every access is an argument pack whose
+//memory side is the window byte sshift (loads) or dshift (stores)
+typedef struct idft_memgroup
+{
+  int32_t lo;          //window start, relative to the address of the first access
+  uint8_t span;        //window bytes
+  uint8_t n;           //accesses
+  uint8_t stores;      //bit i set if access i writes memory
+  uint8_t pad;
+  idft_argpack_t ops[8];  //the accesses
+
+}idft_memgroup_t;
+
+
+//per-block lowering statistics (see bbl_inspect)
+typedef struct idft_block_stats
+{
+  uint32_t ins;        //instructions lowered
+  uint32_t calls_in;   //analysis calls requested by ins_inspect
+  uint32_t calls_out;  //analysis calls actually inserted
+  uint32_t uops;       //micro-ops lowered from the requested calls
+  uint32_t dead;       //micro-ops removed by dead-tag elimination
+  uint32_t copyprop;   //operands rewritten by copy propagation
+  uint32_t folded;     //micro-ops removed or simplified by clear folding
+  uint32_t jitted;     //micro-ops compiled into native stubs
+  uint32_t fused;      //micro-ops folded into stack idiom routines
+  uint32_t packed;     //analysis calls inserted with argument packs
+  uint32_t coalesced;  //memory micro-ops merged into coalesced groups
+  uint32_t prefetched; //tagmap lines prefetched at block entry
+
+}idft_block_stats_t;
+
+
+//analysis routine metadata (see libdft_handler_info)
+typedef struct idft_handler_info
+{
+  void* func;          //the out-of-line routine
+  const char* name;    //its idft_inline_<name> version (libicedft_inline.h)
+  uint32_t flags;      //IDFT_HANDLER_*
+
+}idft_handler_info_t;
+
+
 typedef struct idft_context 
 {
   idft_executer_api_t*  executer_api;
   
   void* executer_context;
 
+  //the executer's own api while ins_inspect is being recorded (see libicedft_rec.c)
+  idft_executer_api_t*  real_api;
+
+  //the recording proxy installed in executer_api while recording
+  idft_executer_api_t  rec_api;
+
+  //the record buffer (rec_buf_t)
+  void* rec_buf;
+
+  //the lowered block (ir_block_t, see libicedft_ir.c)
+  void* ir_block;
+
+  //the native stub cache (jit_cache_t, see libicedft_jit.c)
+  void* jit;
+
+  //taint programs by key (see libicedft_prog.c)
+  void* prog_cache;
+
+  //instrumentation filters (filter_t, see libicedft_filter.c)
+  void* filter;
+
+  //interned argument packs (argpack_tbl_t, see libicedft_argpack.c)
+  void* argpacks;
+
+  //persistent instrumentation plans (plan_t, see libicedft_plan.c)
+  void* plans;
+
+  //interned memory access groups (coalesce_tbl_t, see libicedft_coalesce.c)
+  void* memgroups;
+
+  //block execution counters (tier_t, see libicedft_tier.c)
+  void* tier;
+
+  //thread context pool and registry (thread_pool_t, see libicedft_thread.c)
+  void* threads;
+
+  //per-thread event rings (ring_t, see libicedft_ring.c)
+  void* rings;
+
+  //engine options (IDFT_OPT_*)
+  uint32_t opts;
+
+  //cumulative bbl_inspect statistics
+  idft_block_stats_t stats;
+
 }idft_context_t;
 
 
@@ -0,0 +1,875 @@
+/*
+ * 64-bit (x86-64) instrumentation
+ *
+ * with IDFT_X86_64 the VCPU holds 16 GPRs of 8 tag bits each (see
+ * vcpu_ctx_t), and ins_inspect hands every instruction to
+ * x64_inspect first. It covers the forms with a 64-bit register
+ * or a quad word operand:
+ *
+ *	ALU, moves		ADD, ..., SUB, MOV, MOVNTI, BSF, BSR, CMOVcc,
+ *				LEA
+ *	extensions		MOVSXD, MOVSX/MOVZX to r64, CDQE, CQO
+ *	exchanges		XCHG, XADD, CMPXCHG, CMPXCHG16B (branch-free
+ *				only)
+ *	multiplication		MUL, IMUL, DIV, IDIV
+ *	stack			PUSH, POP, PUSHFQ, CALL, LEAVE
+ *	strings			LODSQ, STOSQ, MOVSQ
+ *
+ * and leaves the rest to the 32-bit cases, which hold for 64-bit
+ * code as well: the executer maps the REX registers (R8D, SIL,
+ * ...; see REG32_INDX), and 32-bit writes zero-extend (see
+ * idft_gen_reg_merge and IDFT_CMOV_KEEP). Shifts, BSWAP and MOVBE
+ * are in libicedft_shift.c, ENTER in enter_inspect. Any other
+ * instruction with a 64-bit operand has its destination cleared
+ * (see x64_unknown)
+ */
+
+#include <stddef.h>
+
+#include "libicedft_api.h"
+#include "libicedft_core.h"
+#include "libicedft_x64.h"
+#include "libicedft_util.h"
+#include "tagmap.h"
+#include "branch_pred.h"
+
+
+#define EXE context->executer_api
+
+/* the VCPU index of a 64-bit register operand */
+#define X64_INDX(reg)	REG64_INDX(ins, context, (reg))
+
+
+/*
+ * the VCPU index of a GPR of any width (LEA addresses)
+ *
+ * returns: the index, or GPR_SCRATCH if reg is not a GPR
+ * (REG_INVALID, RIP, ...)
+ */
+static uint32_t
+x64_indx(idft_ins_t *ins, idft_context_t *context, idft_reg_t reg)
+{
+	if (reg == EXE->REG_INVALID(ins, context))
+		return GPR_SCRATCH;
+	if (x64_gr64(ins, context, reg))
+		return X64_INDX(reg);
+	if (EXE->REG_is_gr32(ins, context, reg))
+		return REG32_INDX(ins, context, reg);
+	if (EXE->REG_is_gr16(ins, context, reg))
+		return REG16_INDX(ins, context, reg);
+
+	return GPR_SCRATCH;
+}
+
+/* operand n is a 64-bit register */
+static int
+x64_reg(idft_ins_t *ins, idft_context_t *context, uint32_t n)
+{
+	return EXE->INS_OperandIsReg(ins, context, n) &&
+		x64_gr64(ins, context, EXE->INS_OperandReg(ins, context, n));
+}
+
+/* func(thread_ctx, reg) */
+static void
+x64_r(idft_ins_t *ins, idft_context_t *context, void *func, uint32_t reg)
+{
+	EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+		func,
+		3,
+		IARG_THREAD_CONTEXT,
+		IARG_UINT32,
+		reg
+		);
+}
+
+/* func(thread_ctx, dst, src); both are VCPU indexes */
+static void
+x64_r2r(idft_ins_t *ins, idft_context_t *context, void *func, uint32_t dst,
+		uint32_t src)
+{
+	EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+		func,
+		5,
+		IARG_THREAD_CONTEXT,
+		IARG_UINT32,
+		dst,
+		IARG_UINT32,
+		src
+		);
+}
+
+/*
+ * func(thread_ctx, reg, ea)
+ *
+ * @ea:		IARG_MEMORYREAD_EA or IARG_MEMORYWRITE_EA
+ */
+static void
+x64_m2r(idft_ins_t *ins, idft_context_t *context, void *func, uint32_t reg,
+		uint32_t ea)
+{
+	EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+		func,
+		4,
+		IARG_THREAD_CONTEXT,
+		IARG_UINT32,
+		reg,
+		ea
+		);
+}
+
+/* func(thread_ctx, write ea, src) */
+static void
+x64_r2m(idft_ins_t *ins, idft_context_t *context, void *func, uint32_t src)
+{
+	EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+		func,
+		4,
+		IARG_THREAD_CONTEXT,
+		IARG_MEMORYWRITE_EA,
+		IARG_UINT32,
+		src
+		);
+}
+
+/* func(write ea[, read ea]); tagmap_clrq, m2m_xfer_opq */
+static void
+x64_m(idft_ins_t *ins, idft_context_t *context, void *func, int read)
+{
+	if (read)
+		EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+			func,
+			2,
+			IARG_MEMORYWRITE_EA,
+			IARG_MEMORYREAD_EA
+			);
+	else
+		EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+			func,
+			1,
+			IARG_MEMORYWRITE_EA
+			);
+}
+
+/*
+ * dst op= src (or dst = src) of 64-bit operands; ADD, ..., MOV
+ *
+ * @r2r:	the handler of two registers
+ * @m2r:	likewise, of a memory source
+ * @r2m:	likewise, of a memory destination (NULL if none)
+ *
+ * returns: 1 if instrumented, 0 if the operands are not 64-bit
+ */
+static int
+x64_rm(idft_ins_t *ins, idft_context_t *context, void *r2r, void *m2r,
+		void *r2m)
+{
+	/* both operands are registers */
+	if (EXE->INS_MemoryOperandCount(ins, context) == 0) {
+		if (!x64_reg(ins, context, 0))
+			return 0;
+
+		x64_r2r(ins, context, r2r,
+			X64_INDX(EXE->INS_OperandReg(ins, context, 0)),
+			X64_INDX(EXE->INS_OperandReg(ins, context, 1)));
+	}
+	/* 2nd operand is memory */
+	else if (EXE->INS_OperandIsMemory(ins, context, 1)) {
+		if (!x64_reg(ins, context, 0))
+			return 0;
+
+		x64_m2r(ins, context, m2r,
+			X64_INDX(EXE->INS_OperandReg(ins, context, 0)),
+			IARG_MEMORYREAD_EA);
+	}
+	/* 1st operand is memory */
+	else {
+		if (r2m == NULL || !x64_reg(ins, context, 1))
+			return 0;
+
+		x64_r2m(ins, context, r2m,
+			X64_INDX(EXE->INS_OperandReg(ins, context, 1)));
+	}
+
+	return 1;
+}
+
+/*
+ * dst (op. 0) is set to a constant (an immediate or a segment
+ * register); cleared
+ */
+static int
+x64_clr(idft_ins_t *ins, idft_context_t *context)
+{
+	if (EXE->INS_OperandIsMemory(ins, context, 0)) {
+		if (EXE->INS_OperandWidth(ins, context, 0) != MEM_QUAD_LEN)
+			return 0;
+
+		x64_m(ins, context, (void *)tagmap_clrq, 0);
+	}
+	else if (x64_reg(ins, context, 0))
+		x64_r(ins, context, (void *)r_clrl,
+			X64_INDX(EXE->INS_OperandReg(ins, context, 0)));
+	else
+		return 0;
+
+	return 1;
+}
+
+/* ADC, ADD, AND, OR, XOR, SBB, SUB */
+static int
+x64_binary(idft_ins_t *ins, idft_context_t *context, uint32_t opcode)
+{
+	idft_reg_t reg;
+
+	/* 2nd operand is immediate; do nothing (see ins_inspect) */
+	if (EXE->INS_OperandIsImmediate(ins, context, 1))
+		return 0;
+
+	/* the clear register idiom; XOR, SUB, SBB of the same register */
+	if ((opcode == XED_ICLASS_XOR || opcode == XED_ICLASS_SUB ||
+			opcode == XED_ICLASS_SBB) &&
+			EXE->INS_MemoryOperandCount(ins, context) == 0 &&
+			x64_reg(ins, context, 0) &&
+			(reg = EXE->INS_OperandReg(ins, context, 0)) ==
+			EXE->INS_OperandReg(ins, context, 1)) {
+		x64_r(ins, context, (void *)r_clrl, X64_INDX(reg));
+		return 1;
+	}
+
+	return x64_rm(ins, context, (void *)r2r_binary_opq,
+			(void *)m2r_binary_opq, (void *)r2m_binary_opq);
+}
+
+/* LEA; t[dst] = t[base] | t[index], of any address and dst width */
+static int
+x64_lea(idft_ins_t *ins, idft_context_t *context)
+{
+	idft_reg_t reg = EXE->INS_OperandReg(ins, context, 0);
+	uint32_t dst, base, indx;
+	void *clr, *xfer, *lea;
+
+	base = x64_indx(ins, context, EXE->INS_MemoryBaseReg(ins, context));
+	indx = x64_indx(ins, context, EXE->INS_MemoryIndexReg(ins, context));
+
+	if (x64_gr64(ins, context, reg)) {
+		dst	= X64_INDX(reg);
+		clr	= (void *)r_clrl;
+		xfer	= (void *)r2r_xfer_opq;
+		lea	= (void *)_lea_r2r_opq;
+	}
+	else if (EXE->REG_is_gr32(ins, context, reg)) {
+		dst	= REG32_INDX(ins, context, reg);
+		clr	= (void *)r_clrl;
+		xfer	= (void *)r2r_xfer_opl;
+		lea	= (void *)_lea_r2r_opl;
+	}
+	else {
+		dst	= REG16_INDX(ins, context, reg);
+		clr	= (void *)r_clrw;
+		xfer	= (void *)r2r_xfer_opw;
+		lea	= (void *)_lea_r2r_opw;
+	}
+
+	/* no base or index register (or RIP-relative); clear */
+	if (base == GPR_SCRATCH && indx == GPR_SCRATCH)
+		x64_r(ins, context, clr, dst);
+	/* one of them */
+	else if (base == GPR_SCRATCH || indx == GPR_SCRATCH)
+		x64_r2r(ins, context, xfer, dst,
+			(base == GPR_SCRATCH) ? indx : base);
+	/* both */
+	else
+		EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+			lea,
+			7,
+			IARG_THREAD_CONTEXT,
+			IARG_UINT32,
+			dst,
+			IARG_UINT32,
+			base,
+			IARG_UINT32,
+			indx
+			);
+
+	return 1;
+}
+
+/* MOVSXD, MOVSX, MOVZX to a 64-bit register */
+static int
+x64_ext(idft_ins_t *ins, idft_context_t *context, int sx)
+{
+	idft_reg_t reg;
+	uint32_t dst;
+	void *func;
+
+	if (!x64_reg(ins, context, 0))
+		return 0;
+
+	dst = X64_INDX(EXE->INS_OperandReg(ins, context, 0));
+
+	/* memory operand */
+	if (EXE->INS_OperandIsMemory(ins, context, 1)) {
+		switch (EXE->INS_OperandWidth(ins, context, 1)) {
+			/* MOVSXD */
+			case MEM_LONG_LEN:
+				func = (void *)_movsx_m2r_opql;
+				break;
+			case MEM_WORD_LEN:
+				func = sx ? (void *)_movsx_m2r_opqw :
+					(void *)_movzx_m2r_oplw;
+				break;
+			default:
+				func = sx ? (void *)_movsx_m2r_opqb :
+					(void *)_movzx_m2r_oplb;
+				break;
+		}
+
+		x64_m2r(ins, context, func, dst, IARG_MEMORYREAD_EA);
+		return 1;
+	}
+
+	/* register operand; the zero-extending handlers are whole-register */
+	reg = EXE->INS_OperandReg(ins, context, 1);
+
+	if (EXE->REG_is_gr32(ins, context, reg))
+		x64_r2r(ins, context, (void *)_movsx_r2r_opql, dst,
+			REG32_INDX(ins, context, reg));
+	else if (EXE->REG_is_gr16(ins, context, reg))
+		x64_r2r(ins, context, sx ? (void *)_movsx_r2r_opqw :
+			(void *)_movzx_r2r_oplw, dst,
+			REG16_INDX(ins, context, reg));
+	else if (EXE->REG_is_Upper8(ins, context, reg))
+		x64_r2r(ins, context, sx ? (void *)_movsx_r2r_opqb_u :
+			(void *)_movzx_r2r_oplb_u, dst,
+			REG8_INDX(ins, context, reg));
+	else
+		x64_r2r(ins, context, sx ? (void *)_movsx_r2r_opqb_l :
+			(void *)_movzx_r2r_oplb_l, dst,
+			REG8_INDX(ins, context, reg));
+
+	return 1;
+}
+
+/* CMOVcc; evaluated by the handler (see ins_inspect) */
+static int
+x64_cmov(idft_ins_t *ins, idft_context_t *context, uint32_t opcode)
+{
+	uint32_t dst;
+
+	if (!x64_reg(ins, context, 0))
+		return 0;
+
+	dst = X64_INDX(EXE->INS_OperandReg(ins, context, 0));
+
+	/* both operands are registers */
+	if (EXE->INS_MemoryOperandCount(ins, context) == 0)
+		EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+			_cmov_r2r_opq,
+			9,
+			IARG_THREAD_CONTEXT,
+			IARG_UINT32,
+			cmov_cc(opcode),
+			IARG_REG_VALUE,
+			EXE->REG_EFLAGS(ins, context),
+			IARG_UINT32,
+			dst,
+			IARG_UINT32,
+			X64_INDX(EXE->INS_OperandReg(ins, context, 1))
+			);
+	/* 2nd operand is memory */
+	else
+		EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+			_cmov_m2r_opq,
+			8,
+			IARG_THREAD_CONTEXT,
+			IARG_UINT32,
+			cmov_cc(opcode),
+			IARG_REG_VALUE,
+			EXE->REG_EFLAGS(ins, context),
+			IARG_UINT32,
+			dst,
+			IARG_MEMORYREAD_EA
+			);
+
+	return 1;
+}
+
+/* XCHG, XADD; the register operand is op. 0 unless op. 0 is memory */
+static int
+x64_xchg(idft_ins_t *ins, idft_context_t *context, uint32_t opcode)
+{
+	uint32_t dst, src;
+
+	/* both operands are registers */
+	if (EXE->INS_MemoryOperandCount(ins, context) == 0) {
+		if (!x64_reg(ins, context, 0))
+			return 0;
+
+		dst = X64_INDX(EXE->INS_OperandReg(ins, context, 0));
+		src = X64_INDX(EXE->INS_OperandReg(ins, context, 1));
+
+		if (opcode == XED_ICLASS_XADD)
+			x64_r2r(ins, context, (void *)_xadd_r2r_opq, dst, src);
+		/* through the scratch register */
+		else {
+			x64_r2r(ins, context, (void *)r2r_xfer_opq,
+				GPR_SCRATCH, dst);
+			x64_r2r(ins, context, (void *)r2r_xfer_opq, dst, src);
+			x64_r2r(ins, context, (void *)r2r_xfer_opq,
+				src, GPR_SCRATCH);
+		}
+	}
+	/* 2nd operand is memory (XCHG) */
+	else if (EXE->INS_OperandIsMemory(ins, context, 1)) {
+		if (!x64_reg(ins, context, 0))
+			return 0;
+
+		x64_m2r(ins, context, (void *)_xchg_m2r_opq,
+			X64_INDX(EXE->INS_OperandReg(ins, context, 0)),
+			IARG_MEMORYREAD_EA);
+	}
+	/* 1st operand is memory */
+	else {
+		if (!x64_reg(ins, context, 1))
+			return 0;
+
+		x64_m2r(ins, context, (opcode == XED_ICLASS_XADD) ?
+			(void *)_xadd_m2r_opq : (void *)_xchg_m2r_opq,
+			X64_INDX(EXE->INS_OperandReg(ins, context, 1)),
+			IARG_MEMORYWRITE_EA);
+	}
+
+	return 1;
+}
+
+/*
+ * CMPXCHG; the branch-free handlers, whatever the options (the
+ * executer's RAX is needed; see REG_RAX). Without it, the outcome
+ * is not known, and both are propagated: t[RAX] |= t[dst] and
+ * t[dst] |= t[src]
+ */
+static int
+x64_cmpxchg(idft_ins_t *ins, idft_context_t *context)
+{
+	idft_reg_t reg;
+	uint32_t src;
+
+	if (!x64_reg(ins, context, 1))
+		return 0;
+
+	src = X64_INDX(EXE->INS_OperandReg(ins, context, 1));
+
+	if (unlikely(EXE->REG_RAX == NULL)) {
+		/* both operands are registers */
+		if (EXE->INS_MemoryOperandCount(ins, context) == 0) {
+			reg = EXE->INS_OperandReg(ins, context, 0);
+
+			x64_r2r(ins, context, (void *)r2r_binary_opq, GPR_EAX,
+				X64_INDX(reg));
+			x64_r2r(ins, context, (void *)r2r_binary_opq,
+				X64_INDX(reg), src);
+		}
+		/* 1st operand is memory */
+		else {
+			x64_m2r(ins, context, (void *)m2r_binary_opq, GPR_EAX,
+				IARG_MEMORYWRITE_EA);
+			x64_r2m(ins, context, (void *)r2m_binary_opq, src);
+		}
+
+		return 1;
+	}
+
+	/* both operands are registers */
+	if (EXE->INS_MemoryOperandCount(ins, context) == 0) {
+		reg = EXE->INS_OperandReg(ins, context, 0);
+
+		EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+			_cmpxchg_r2r_opq_bf,
+			9,
+			IARG_THREAD_CONTEXT,
+			IARG_REG_VALUE,
+			EXE->REG_RAX(ins, context),
+			IARG_UINT32,
+			X64_INDX(reg),
+			IARG_REG_VALUE,
+			reg,
+			IARG_UINT32,
+			src
+			);
+	}
+	/* 1st operand is memory */
+	else
+		EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+			_cmpxchg_m2r_opq_bf,
+			6,
+			IARG_THREAD_CONTEXT,
+			IARG_REG_VALUE,
+			EXE->REG_RAX(ins, context),
+			IARG_MEMORYWRITE_EA,
+			IARG_UINT32,
+			src
+			);
+
+	return 1;
+}
+
+/*
+ * CMPXCHG16B; the branch-free handler (see x64_cmpxchg), which
+ * needs RDX as well. Without them, RDX:RAX and m128 are cleared
+ */
+static void
+x64_cmpxchg16b(idft_ins_t *ins, idft_context_t *context)
+{
+	if (unlikely(EXE->REG_RAX == NULL || EXE->REG_RDX == NULL)) {
+		EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+			r_clrl2,
+			1,
+			IARG_THREAD_CONTEXT
+			);
+		EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+			tagmap_clrn,
+			3,
+			IARG_MEMORYWRITE_EA,
+			IARG_UINT32,
+			16
+			);
+		return;
+	}
+
+	EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+		_cmpxchg16b_m2r_bf,
+		6,
+		IARG_THREAD_CONTEXT,
+		IARG_REG_VALUE,
+		EXE->REG_RAX(ins, context),
+		IARG_REG_VALUE,
+		EXE->REG_RDX(ins, context),
+		IARG_MEMORYWRITE_EA
+		);
+}
+
+/*
+ * MUL, DIV, IDIV and one-operand IMUL; t[RDX]:t[RAX] |= t[src];
+ * r2r_ternary_opl ORs the whole source register
+ */
+static int
+x64_ternary(idft_ins_t *ins, idft_context_t *context)
+{
+	/* memory operand */
+	if (EXE->INS_OperandIsMemory(ins, context, 0)) {
+		if (EXE->INS_OperandWidth(ins, context, 0) != MEM_QUAD_LEN)
+			return 0;
+
+		EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+			m2r_ternary_opq,
+			2,
+			IARG_THREAD_CONTEXT,
+			IARG_MEMORYREAD_EA
+			);
+	}
+	/* register operand */
+	else if (x64_reg(ins, context, 0))
+		x64_r(ins, context, (void *)r2r_ternary_opl,
+			X64_INDX(EXE->INS_OperandReg(ins, context, 0)));
+	else
+		return 0;
+
+	return 1;
+}
+
+/* PUSH and POP of quad words; mov equivalents */
+static int
+x64_stack(idft_ins_t *ins, idft_context_t *context, uint32_t opcode)
+{
+	/* pop to a register */
+	if (opcode == XED_ICLASS_POP && EXE->INS_OperandIsReg(ins, context, 0)) {
+		if (!x64_reg(ins, context, 0))
+			return 0;
+
+		x64_m2r(ins, context, (void *)m2r_xfer_opq,
+			X64_INDX(EXE->INS_OperandReg(ins, context, 0)),
+			IARG_MEMORYREAD_EA);
+		return 1;
+	}
+
+	if (EXE->INS_MemoryWriteSize(ins, context) != BIT2BYTE(MEM_QUAD_LEN))
+		return 0;
+
+	/* pop to, or push of, a memory operand */
+	if (EXE->INS_OperandIsMemory(ins, context, 0))
+		x64_m(ins, context, (void *)m2m_xfer_opq, 1);
+	/* push of a register */
+	else if (x64_reg(ins, context, 0))
+		x64_r2m(ins, context, (void *)r2m_xfer_opq,
+			X64_INDX(EXE->INS_OperandReg(ins, context, 0)));
+	/* push of an immediate or a segment register; clean */
+	else
+		x64_m(ins, context, (void *)tagmap_clrq, 0);
+
+	return 1;
+}
+
+/* LODSQ, STOSQ, MOVSQ (see ins_inspect for rep) */
+static void
+x64_string(idft_ins_t *ins, idft_context_t *context, uint32_t opcode)
+{
+	/* lodsq; similar to a mov between a memory location and RAX */
+	if (opcode == XED_ICLASS_LODSQ) {
+		EXE->INS_InsertPredicatedCall(ins, context, IDFT_IPOINT_BEFORE,
+			m2r_xfer_opq,
+			4,
+			IARG_THREAD_CONTEXT,
+			IARG_UINT32,
+			GPR_EAX,
+			IARG_MEMORYREAD_EA
+			);
+		return;
+	}
+
+	/* no rep prefix */
+	if (!EXE->INS_RepPrefix(ins, context)) {
+		if (opcode == XED_ICLASS_STOSQ)
+			x64_r2m(ins, context, (void *)r2m_xfer_opq, GPR_EAX);
+		else
+			EXE->INS_InsertPredicatedCall(ins, context,
+				IDFT_IPOINT_BEFORE,
+				m2m_xfer_opq,
+				2,
+				IARG_MEMORYWRITE_EA,
+				IARG_MEMORYREAD_EA
+				);
+		return;
+	}
+
+	/* the whole string at once */
+	EXE->INS_InsertIfPredicatedCall(ins, context, IDFT_IPOINT_BEFORE,
+		rep_predicate,
+		1,
+		IARG_FIRST_REP_ITERATION
+		);
+
+	if (opcode == XED_ICLASS_STOSQ)
+		EXE->INS_InsertThenPredicatedCall(ins, context,
+			IDFT_IPOINT_BEFORE,
+			r2m_xfer_opqn,
+			6,
+			IARG_THREAD_CONTEXT,
+			IARG_MEMORYWRITE_EA,
+			IARG_REG_VALUE,
+			EXE->INS_RepCountRegister(ins, context),
+			IARG_REG_VALUE,
+			EXE->REG_EFLAGS(ins, context)
+			);
+	else
+		EXE->INS_InsertThenPredicatedCall(ins, context,
+			IDFT_IPOINT_BEFORE,
+			m2m_xfer_opqn,
+			6,
+			IARG_MEMORYWRITE_EA,
+			IARG_MEMORYREAD_EA,
+			IARG_REG_VALUE,
+			EXE->INS_RepCountRegister(ins, context),
+			IARG_REG_VALUE,
+			EXE->REG_EFLAGS(ins, context)
+			);
+}
+
+/*
+ * an instruction not covered above, with a 64-bit operand; the
+ * 32-bit cases would take its registers for 32-bit ones (see
+ * REG32_INDX). Its destination, a 64-bit register or a quad word
+ * written, is cleared, and the class logged once
+ *
+ * returns: 1 if done with, 0 if no operand is 64-bit
+ */
+static int
+x64_unknown(idft_ins_t *ins, idft_context_t *context, uint32_t opcode)
+{
+	/* the classes logged already */
+	static uint8_t logged[XED_ICLASS_LAST];
+
+	/* destination register */
+	if (x64_reg(ins, context, 0))
+		x64_r(ins, context, (void *)r_clrl,
+			X64_INDX(EXE->INS_OperandReg(ins, context, 0)));
+	/* destination memory, of a 64-bit register */
+	else if (x64_reg(ins, context, 1) &&
+			EXE->INS_OperandIsMemory(ins, context, 0)) {
+		if (EXE->INS_MemoryWriteSize(ins, context) ==
+				BIT2BYTE(MEM_QUAD_LEN))
+			x64_m(ins, context, (void *)tagmap_clrq, 0);
+	}
+	/* 8, 16 or 32-bit operands, or a 64-bit source (e.g., to XMM) */
+	else
+		return 0;
+
+	if (unlikely(!logged[opcode])) {
+		logged[opcode] = 1;
+		IDFT_LOG("x64: unhandled 64-bit operand: %s\n",
+			EXE->INS_Disassemble(ins, context));
+	}
+
+	return 1;
+}
+
+/*
+ * instrument the 64-bit forms of an instruction (see above)
+ *
+ * @ins:	the instruction
+ * @context:	the engine context
+ * @opcode:	its class
+ *
+ * returns: 1 if done with (instrumented, or not covered), 0 if
+ * ins_inspect should go on with it
+ */
+int
+x64_inspect(idft_ins_t *ins, idft_context_t *context, uint32_t opcode)
+{
+	switch (opcode) {
+		case XED_ICLASS_ADC:
+		case XED_ICLASS_ADD:
+		case XED_ICLASS_AND:
+		case XED_ICLASS_OR:
+		case XED_ICLASS_XOR:
+		case XED_ICLASS_SBB:
+		case XED_ICLASS_SUB:
+			return x64_binary(ins, context, opcode);
+		case XED_ICLASS_BSF:
+		case XED_ICLASS_BSR:
+		case XED_ICLASS_MOV:
+		case XED_ICLASS_MOVNTI:
+			/* immediate or segment register source */
+			if (EXE->INS_OperandIsImmediate(ins, context, 1) ||
+				(EXE->INS_OperandIsReg(ins, context, 1) &&
+				EXE->REG_is_seg(ins, context,
+					EXE->INS_OperandReg(ins, context, 1))))
+				return x64_clr(ins, context);
+
+			return x64_rm(ins, context, (void *)r2r_xfer_opq,
+					(void *)m2r_xfer_opq,
+					(void *)r2m_xfer_opq);
+		case XED_ICLASS_CMOVB:
+		case XED_ICLASS_CMOVBE:
+		case XED_ICLASS_CMOVL:
+		case XED_ICLASS_CMOVLE:
+		case XED_ICLASS_CMOVNB:
+		case XED_ICLASS_CMOVNBE:
+		case XED_ICLASS_CMOVNL:
+		case XED_ICLASS_CMOVNLE:
+		case XED_ICLASS_CMOVNO:
+		case XED_ICLASS_CMOVNP:
+		case XED_ICLASS_CMOVNS:
+		case XED_ICLASS_CMOVNZ:
+		case XED_ICLASS_CMOVO:
+		case XED_ICLASS_CMOVP:
+		case XED_ICLASS_CMOVS:
+		case XED_ICLASS_CMOVZ:
+			return x64_cmov(ins, context, opcode);
+		case XED_ICLASS_LEA:
+			return x64_lea(ins, context);
+		case XED_ICLASS_MOVSXD:
+		case XED_ICLASS_MOVSX:
+			return x64_ext(ins, context, 1);
+		case XED_ICLASS_MOVZX:
+			return x64_ext(ins, context, 0);
+		/* cdqe; sign extension of EAX */
+		case XED_ICLASS_CDQE:
+			x64_r2r(ins, context, (void *)_movsx_r2r_opql, GPR_EAX,
+				GPR_EAX);
+			return 1;
+		case XED_ICLASS_CQO:
+			EXE->INS_InsertCall(ins, context, IDFT_IPOINT_BEFORE,
+				_cqo,
+				1,
+				IARG_THREAD_CONTEXT
+				);
+			return 1;
+		case XED_ICLASS_XCHG:
+		case XED_ICLASS_XADD:
+			return x64_xchg(ins, context, opcode);
+		case XED_ICLASS_CMPXCHG:
+			return x64_cmpxchg(ins, context);
+		case XED_ICLASS_DIV:
+		case XED_ICLASS_IDIV:
+		case XED_ICLASS_MUL:
+			return x64_ternary(ins, context);
+		case XED_ICLASS_IMUL:
+			/* one-operand form */
+			if (EXE->INS_OperandIsImplicit(ins, context, 1))
+				return x64_ternary(ins, context);
+
+			/* two/three-operands form; immediate, do nothing */
+			if (EXE->INS_OperandIsImmediate(ins, context, 1))
+				return 0;
+
+			return x64_rm(ins, context, (void *)r2r_binary_opq,
+					(void *)m2r_binary_opq, NULL);
+		case XED_ICLASS_PUSH:
+		case XED_ICLASS_POP:
+			return x64_stack(ins, context, opcode);
+		/* the return address, or the flags */
+		case XED_ICLASS_CALL_NEAR:
+		case XED_ICLASS_PUSHFQ:
+			if (EXE->INS_MemoryWriteSize(ins, context) !=
+					BIT2BYTE(MEM_QUAD_LEN))
+				return 0;
+
+			x64_m(ins, context, (void *)tagmap_clrq, 0);
+			return 1;
+		/* leave; a mov from RBP to RSP, and a pop of RBP */
+		case XED_ICLASS_LEAVE:
+			if (!x64_gr64(ins, context, EXE->REG_ESP(ins, context)))
+				return 0;
+
+			x64_r2r(ins, context, (void *)r2r_xfer_opq, GPR_ESP,
+				GPR_EBP);
+			x64_m2r(ins, context, (void *)m2r_xfer_opq, GPR_EBP,
+				IARG_MEMORYREAD_EA);
+			return 1;
+		case XED_ICLASS_LODSQ:
+		case XED_ICLASS_STOSQ:
+		case XED_ICLASS_MOVSQ:
+			x64_string(ins, context, opcode);
+			return 1;
+		case XED_ICLASS_CMPXCHG16B:
+			x64_cmpxchg16b(ins, context);
+			return 1;
+		/*
+		 * operands read, or changed in place; the tags stay as
+		 * they are
+		 */
+		case XED_ICLASS_BT:
+		case XED_ICLASS_BTC:
+		case XED_ICLASS_BTR:
+		case XED_ICLASS_BTS:
+		case XED_ICLASS_CMP:
+		case XED_ICLASS_CMPSQ:
+		case XED_ICLASS_DEC:
+		case XED_ICLASS_INC:
+		case XED_ICLASS_JMP:
+		case XED_ICLASS_NEG:
+		case XED_ICLASS_NOP:
+		case XED_ICLASS_NOT:
+		case XED_ICLASS_RET_NEAR:
+		case XED_ICLASS_SCASQ:
+		case XED_ICLASS_TEST:
+			return 1;
+		/* enter_inspect */
+		case XED_ICLASS_ENTER:
+		/* libicedft_shift.c */
+		case XED_ICLASS_RCL:
+		case XED_ICLASS_RCR:
+		case XED_ICLASS_ROL:
+		case XED_ICLASS_ROR:
+		case XED_ICLASS_SHL:
+		case XED_ICLASS_SAR:
+		case XED_ICLASS_SHR:
+		case XED_ICLASS_SHLD:
+		case XED_ICLASS_SHRD:
+		case XED_ICLASS_BSWAP:
+		case XED_ICLASS_MOVBE:
+			return 0;
+		default:
+			return x64_unknown(ins, context, opcode);
+	}
+}
@@ -0,0 +1,24 @@
+#ifndef LIBICEDFT_X64_H
+#define LIBICEDFT_X64_H
+
+#include <stdint.h>
+#include "libicedft_api.h"
+
+int	x64_inspect(idft_ins_t *ins, idft_context_t *context, uint32_t opcode);
+
+/* non-zero if reg is a 64-bit GPR (IDFT_X86_64 only; see REG_is_gr64) */
+static inline int
+x64_gr64(idft_ins_t *ins, idft_context_t *context, idft_reg_t reg)
+{
+#ifdef IDFT_X86_64
+	return context->executer_api->REG_is_gr64 != NULL &&
+		context->executer_api->REG_is_gr64(ins, context, reg);
+#else
+	(void)ins;
+	(void)context;
+	(void)reg;
+	return 0;
+#endif
+}
+
+#endif /* LIBICEDFT_X64_H */
@@ -44,6 +44,7 @@
 #endif
 
 #include <stdint.h>
+#include <string.h>
 
 #include "tagmap.h"
 #include "branch_pred.h"
@@ -53,6 +54,9 @@
 #define	MAP_HUGETLB	0x40000	/* architecture specific */
 #endif
 #define MAP_FLAGS	MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB
+#elif defined(IDFT_X86_64)
+/* a sparse reservation (see BITMAP_SZ) */
+#define MAP_FLAGS	MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE
 #else
 #define MAP_FLAGS	MAP_PRIVATE | MAP_ANONYMOUS
 #endif
@@ -70,6 +74,72 @@
  */
 uint8_t *bitmap = NULL;
 
+/*
+ * taint liveness
+ *
+ * taint becomes live the first time something is tagged through
+ * the tagmap API (tagmap_set*, tagmap_filln), when the bitmap is
+ * handed out for direct writes (libdft_tag_bitmap), or when a
+ * guard finds a tagged VCPU; the analysis routines merely move it
+ * around. It becomes dead again with tagmap_clear_all().
+ * tagmap_epoch counts the transitions, hence it is odd while taint
+ * is live (tagmap_is_live()); per-thread summaries (see
+ * thread_ctx_live) remember the epoch they were computed at. While
+ * taint is dead, and the VCPU of a thread is clean, the thread can
+ * run uninstrumented code (see guard_inspect).
+ *
+ * the executer is told about every transition, and only about
+ * transitions, through tagmap_set_live_cb(); concurrent setters
+ * race on tagmap_epoch with a compare-exchange, so exactly one of
+ * them reports. The hook runs before the first tag is written
+ */
+uint32_t tagmap_epoch = 0;
+
+static void	(*live_cb)(void *arg, uint32_t live) = NULL;
+static void	*live_arg = NULL;
+
+/* make taint live; optimized branch */
+#define TAGMAP_LIVE()							\
+	do {								\
+		if (unlikely(!tagmap_is_live()))			\
+			tagmap_live_set(1);				\
+	} while (0)
+
+/*
+ * set the liveness indicator, notifying the executer
+ * if it changed
+ *
+ * @live:	1 if taint may be present, 0 otherwise
+ */
+void
+tagmap_live_set(uint32_t live)
+{
+	uint32_t epoch = __atomic_load_n(&tagmap_epoch, __ATOMIC_RELAXED);
+
+	/* the thread that makes the transition reports it */
+	do {
+		if ((epoch & 1) == live)
+			return;
+	} while (!__atomic_compare_exchange_n(&tagmap_epoch, &epoch,
+			epoch + 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+	if (live_cb != NULL)
+		live_cb(live_arg, live);
+}
+
+/*
+ * register the liveness transition hook
+ *
+ * @cb:		called with the new state on every transition
+ * @arg:	its first argument
+ */
+void
+tagmap_set_live_cb(void (*cb)(void *arg, uint32_t live), void *arg)
+{
+	live_cb		= cb;
+	live_arg	= arg;
+}
+
 
 /*
  * initialize the tagmap; allocate space
@@ -119,6 +189,10 @@ tagmap_free(void)
 	#else
 		dr_global_free(dr_get_current_drcontext(), bitmap, BITMAP_SZ);
 	#endif
+
+	tagmap_epoch	= 0;
+	live_cb		= NULL;
+	live_arg	= NULL;
 }
 
 /*
@@ -129,6 +203,8 @@ tagmap_free(void)
 void 
 tagmap_setb(size_t addr)
 {
+	TAGMAP_LIVE();
+
 	/* assert the bit that corresponds to the given address */
 	bitmap[VIRT2BYTE(addr)] |= (BYTE_MASK << VIRT2BIT(addr));
 
@@ -171,6 +247,8 @@ tagmap_getb(size_t addr)
 void 
 tagmap_setw(size_t addr)
 {
+	TAGMAP_LIVE();
+
 	/*
 	 * assert the bits that correspond to the addresses of the word
 	 *
@@ -221,6 +299,8 @@ tagmap_getw(size_t addr)
 void 
 tagmap_setl(size_t addr)
 {
+	TAGMAP_LIVE();
+
 	/*
 	 * assert the bits that correspond to the addresses of the long word
 	 *
@@ -271,6 +351,8 @@ tagmap_getl(size_t addr)
 void
 tagmap_setq(size_t addr)
 {
+	TAGMAP_LIVE();
+
 	/*
 	 * assert the bits that correspond to the addresses of the quad word
 	 *
@@ -575,6 +657,8 @@ tagmap_setn(size_t addr, size_t num)
 	/* alignment offset */
 	int alg_off;
 
+	TAGMAP_LIVE();
+
 	/* fast path for small writes (i.e., ~8 bytes) */
 	if (num <= ALIGN_OFF_MAX) {
 		switch (num) {
@@ -1032,3 +1116,200 @@ tagmap_clrn(size_t addr, size_t num)
 		}
 	}
 }
+
+/*
+ * read the tags of (up to) 56 bytes, starting at addr
+ */
+static inline uint64_t
+tagmap_getbits(size_t addr)
+{
+	return *((uint64_t *)(bitmap + VIRT2BYTE(addr))) >> VIRT2BIT(addr);
+}
+
+/*
+ * write the tags of num (up to 56) bytes, starting at addr
+ */
+static inline void
+tagmap_putbits(size_t addr, uint64_t tags, size_t num)
+{
+	uint64_t mask = ((1ULL << num) - 1) << VIRT2BIT(addr);
+
+	*((uint64_t *)(bitmap + VIRT2BYTE(addr))) =
+		(*((uint64_t *)(bitmap + VIRT2BYTE(addr))) & ~mask) |
+		((tags << VIRT2BIT(addr)) & mask);
+}
+
+/*
+ * copy the tags of num bytes from src to dst; the
+ * regions may overlap (i.e., as with memmove(3))
+ *
+ * @dst:	the first destination byte
+ * @src:	the first source byte
+ * @num:	the number of bytes
+ */
+void
+tagmap_cpn(size_t dst, size_t src, size_t num)
+{
+	size_t head, body, off, c;
+
+	if (unlikely(num == 0 || dst == src))
+		return;
+
+	/* same bit offset; the bulk is a plain byte copy */
+	if (VIRT2BIT(dst) == VIRT2BIT(src) && num >= ASSERT_FAST) {
+		head	= (8 - VIRT2BIT(dst)) & 7;
+		body	= (num - head) & ~(size_t)7;
+
+		/* the edges cannot clobber the other region's body */
+		if (dst < src && head)
+			tagmap_putbits(dst, tagmap_getbits(src), head);
+		else if (dst > src && num - head - body)
+			tagmap_putbits(dst + head + body,
+				tagmap_getbits(src + head + body),
+				num - head - body);
+
+		memmove(bitmap + VIRT2BYTE(dst + head),
+			bitmap + VIRT2BYTE(src + head), VIRT2BYTE(body));
+
+		if (dst < src && num - head - body)
+			tagmap_putbits(dst + head + body,
+				tagmap_getbits(src + head + body),
+				num - head - body);
+		else if (dst > src && head)
+			tagmap_putbits(dst, tagmap_getbits(src), head);
+
+		return;
+	}
+
+	/* 56 bytes at a time, away from the overlap */
+	if (dst < src)
+		for (off = 0; off < num; off += c) {
+			c = (num - off < 56) ? num - off : 56;
+			tagmap_putbits(dst + off, tagmap_getbits(src + off), c);
+		}
+	else
+		for (off = num; off > 0;) {
+			c = (off < 56) ? off : 56;
+			off -= c;
+			tagmap_putbits(dst + off, tagmap_getbits(src + off), c);
+		}
+}
+
+/*
+ * propagate the tags of a string move (REP MOVS)
+ *
+ * the elements are copied one at a time, in the order of
+ * EFLAGS.DF; when the destination overlaps the part of the
+ * source that is read later, what is read is what was just
+ * written, and the destination ends up repeating the first
+ * p bytes read (p is the distance between the two)
+ *
+ * @dst:	the lowest destination byte
+ * @src:	the lowest source byte
+ * @num:	the number of bytes (a multiple of size)
+ * @size:	the element size (1, 2, 4 or 8)
+ * @down:	1 if EFLAGS.DF is set (descending addresses)
+ */
+void
+tagmap_movsn(size_t dst, size_t src, size_t num, size_t size, int down)
+{
+	size_t p = down ? src - dst : dst - src, filled, c, off;
+
+	/* nothing that is read later gets written first */
+	if (p == 0 || p >= num) {
+		tagmap_cpn(dst, src, num);
+		return;
+	}
+
+	/* overlap within an element; one element at a time */
+	if (unlikely(p < size)) {
+		if (!down)
+			for (off = 0; off < num; off += size)
+				tagmap_putbits(dst + off,
+					tagmap_getbits(src + off), size);
+		else
+			for (off = num; off > 0;) {
+				off -= size;
+				tagmap_putbits(dst + off,
+					tagmap_getbits(src + off), size);
+			}
+		return;
+	}
+
+	/* the first p bytes, then the filled part doubles */
+	if (!down) {
+		tagmap_cpn(dst, src, p);
+		for (filled = p; filled < num; filled += c) {
+			c = (num - filled < filled) ? num - filled : filled;
+			tagmap_cpn(dst + filled, dst, c);
+		}
+	}
+	else {
+		tagmap_cpn(dst + num - p, src + num - p, p);
+		for (filled = p; filled < num; filled += c) {
+			c = (num - filled < filled) ? num - filled : filled;
+			tagmap_cpn(dst + num - filled - c, dst + num - c, c);
+		}
+	}
+}
+
+/*
+ * tag (fill 1) or untag (fill 0) an arbitrary number of bytes on
+ * the virtual address space; unlike tagmap_setn and tagmap_clrn,
+ * the same stores are done for both, so that callers that pick one
+ * from a tag need not branch on it
+ *
+ * @addr:	the virtual address
+ * @num:	the number of bytes
+ * @fill:	1 to tag, 0 to untag
+ */
+void
+tagmap_filln(size_t addr, size_t num, uint32_t fill)
+{
+	uint64_t tags = 0ULL - (uint64_t)(fill & 1);
+	size_t head, body;
+
+	/* tagging makes taint live; rarely taken (a tagged source is) */
+	if (unlikely(fill & ~tagmap_epoch & 1))
+		tagmap_live_set(1);
+
+	if (unlikely(num == 0))
+		return;
+
+	if (num <= 56) {
+		tagmap_putbits(addr, tags, num);
+		return;
+	}
+
+	/* up to the first byte boundary, whole bytes, then the rest */
+	head	= (8 - VIRT2BIT(addr)) & 7;
+	body	= (num - head) & ~(size_t)7;
+
+	tagmap_putbits(addr, tags, head);
+	memset(bitmap + VIRT2BYTE(addr + head), (int)(tags & 0xFF),
+		VIRT2BYTE(body));
+	tagmap_putbits(addr + head + body, tags, num - head - body);
+}
+
+/*
+ * untag the whole virtual address space; taint
+ * becomes dead (unless the bitmap cannot be cleared)
+ */
+void
+tagmap_clear_all(void)
+{
+#if defined(__linux__) && defined(MADV_DONTNEED)
+	/* private anonymous pages read back as zero; no need to touch them */
+	if (madvise(bitmap, BITMAP_SZ, MADV_DONTNEED) != 0)
+#endif
+#ifndef IDFT_X86_64
+		memset(bitmap, 0, BITMAP_SZ);
+#else
+		/* a memset would back all 16 TB; map fresh zero pages over it */
+		if (mmap(bitmap, BITMAP_SZ, PROT_READ | PROT_WRITE,
+				MAP_FLAGS | MAP_FIXED, -1, 0) == MAP_FAILED)
+			return;
+#endif
+
+	tagmap_live_set(0);
+}
@@ -61,7 +61,15 @@
  * 256 MB, or 128 MB respectively).
  */
 /* #define BITMAP_SZ	384*1024*1024 */
+#ifndef IDFT_X86_64
 #define BITMAP_SZ	512*1024*1024
+#else
+/*
+ * x86-64; the 47-bit user address space takes 16 TB,
+ * reserved but only backed where it is touched
+ */
+#define BITMAP_SZ	((size_t)1 << 44)
+#endif
 
 #define BYTE_MASK	0x01U		/* byte mask; 1 bit */
 #define WORD_MASK	0x0003U		/* word mask; 2 sequential bits */
@@ -93,19 +101,32 @@ void	tagmap_setl(size_t);
 void	tagmap_clrb(size_t);
 void	tagmap_clrw(size_t);
 void	tagmap_clrl(size_t);
+void	tagmap_setq(size_t);
+void	tagmap_clrq(size_t);
 void	tagmap_clear_all(void);
 void	tagmap_taint_all(void);
 void	tagmap_setn(size_t, size_t);
 void	tagmap_clrn(size_t, size_t);
+void	tagmap_filln(size_t, size_t, uint32_t);
+void	tagmap_cpn(size_t, size_t, size_t);
+void	tagmap_movsn(size_t, size_t, size_t, size_t, int);
 
 /* implementation-specific tagmap API */
 size_t	tagmap_getb(size_t);
 size_t	tagmap_getw(size_t);
 size_t	tagmap_getl(size_t);
+size_t	tagmap_getq(size_t);
 size_t  tagmap_issetn(size_t, size_t);
 
 
+/* taint liveness; tagmap_epoch is odd while taint is live */
+#define tagmap_is_live()	(tagmap_epoch & 1)
+
+void	tagmap_live_set(uint32_t);
+void	tagmap_set_live_cb(void (*)(void *, uint32_t), void *);
+
 extern uint8_t *bitmap;
+extern uint32_t tagmap_epoch;
 
 
 #endif /* LIBDFT_TAGMAP_H */
@@ -0,0 +1,154 @@
+/*
+ * CMOVcc tag propagation
+ *
+ * the tag moves iff the condition holds; the condition is
+ * evaluated from EFLAGS without branches (idft_inline_cc_mask),
+ * so every code is checked against every combination of the
+ * flags it may read
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libicedft_api.h"
+#include "libicedft_core.h"
+#include "tagmap.h"
+
+
+#define ADDR	0x5000
+
+#define CF	0x0001
+#define PF	0x0004
+#define ZF	0x0040
+#define SF	0x0080
+#define OF	0x0800
+
+/* tags; the destination and the source */
+#define T_DST	0x3
+#define T_SRC	0xC
+
+static const char *const cc_name[16] = {
+	"o", "no", "b", "nb", "z", "nz", "be", "nbe",
+	"s", "ns", "p", "np", "l", "nl", "le", "nle"
+};
+
+static int failed;
+
+/* the condition, as the manual puts it */
+static int
+cc_holds(uint32_t cc, ADDRINT eflags)
+{
+	int cf = (eflags & CF) != 0, pf = (eflags & PF) != 0,
+	    zf = (eflags & ZF) != 0, sf = (eflags & SF) != 0,
+	    of = (eflags & OF) != 0, r;
+
+	switch (cc >> 1) {
+		case 0:	r = of;			break;
+		case 1:	r = cf;			break;
+		case 2:	r = zf;			break;
+		case 3:	r = cf || zf;		break;
+		case 4:	r = sf;			break;
+		case 5:	r = pf;			break;
+		case 6:	r = sf != of;		break;
+		default: r = zf || sf != of;	break;
+	}
+
+	return (cc & 1) ? !r : r;
+}
+
+static void
+check(const char *what, uint32_t cc, ADDRINT eflags, uint32_t got,
+		uint32_t want)
+{
+	if (got == want)
+		return;
+
+	printf("cmov%s %s, eflags %#x: got %#x, want %#x\n", cc_name[cc],
+			what, (unsigned)eflags, got, want);
+	failed++;
+}
+
+/* all the forms, for one code and one EFLAGS value */
+static void
+cmov(uint32_t cc, ADDRINT eflags)
+{
+	thread_ctx_t tc;
+	int taken = cc_holds(cc, eflags);
+
+	memset(&tc, 0, sizeof(tc));
+
+	VCPU_GPR_SET(&tc, GPR_EAX, T_DST);
+	VCPU_GPR_SET(&tc, GPR_EBX, T_SRC);
+	_cmov_r2r_opl(&tc, cc, eflags, GPR_EAX, GPR_EBX);
+	check("r32, r32", cc, eflags, VCPU_GPR(&tc, GPR_EAX),
+			taken ? T_SRC : T_DST);
+
+	/* the upper word is left alone either way */
+	VCPU_GPR_SET(&tc, GPR_EAX, T_DST);
+	_cmov_r2r_opw(&tc, cc, eflags, GPR_EAX, GPR_EBX);
+	check("r16, r16", cc, eflags, VCPU_GPR(&tc, GPR_EAX),
+			taken ? (T_SRC & VCPU_MASK16) | (T_DST & ~VCPU_MASK16) :
+			T_DST);
+
+	/* the source; bytes 2 and 3 are tagged */
+	tagmap_clrn(ADDR, 8);
+	tagmap_setb(ADDR + 2);
+	tagmap_setb(ADDR + 3);
+
+	VCPU_GPR_SET(&tc, GPR_EAX, T_DST);
+	_cmov_m2r_opl(&tc, cc, eflags, GPR_EAX, ADDR);
+	check("r32, m32", cc, eflags, VCPU_GPR(&tc, GPR_EAX),
+			taken ? T_SRC : T_DST);
+
+	VCPU_GPR_SET(&tc, GPR_EAX, T_DST);
+	_cmov_m2r_opw(&tc, cc, eflags, GPR_EAX, ADDR);
+	check("r16, m16", cc, eflags, VCPU_GPR(&tc, GPR_EAX),
+			taken ? 0 : T_DST);
+
+#ifdef IDFT_X86_64
+	/* a 32-bit write zero-extends, taken or not */
+	VCPU_GPR_SET(&tc, GPR_EAX, 0xF0 | T_DST);
+	_cmov_r2r_opl(&tc, cc, eflags, GPR_EAX, GPR_EBX);
+	check("r32, r32 (upper)", cc, eflags, VCPU_GPR(&tc, GPR_EAX),
+			taken ? T_SRC : T_DST);
+
+	VCPU_GPR_SET(&tc, GPR_EAX, 0xF0 | T_DST);
+	VCPU_GPR_SET(&tc, GPR_EBX, 0x50 | T_SRC);
+	_cmov_r2r_opq(&tc, cc, eflags, GPR_EAX, GPR_EBX);
+	check("r64, r64", cc, eflags, VCPU_GPR(&tc, GPR_EAX),
+			taken ? 0x50 | T_SRC : 0xF0 | T_DST);
+
+	VCPU_GPR_SET(&tc, GPR_EAX, 0xF0 | T_DST);
+	_cmov_m2r_opq(&tc, cc, eflags, GPR_EAX, ADDR);
+	check("r64, m64", cc, eflags, VCPU_GPR(&tc, GPR_EAX),
+			taken ? T_SRC : 0xF0 | T_DST);
+#endif
+}
+
+int
+main(void)
+{
+	static const ADDRINT flags[] = { CF, PF, ZF, SF, OF };
+	ADDRINT eflags;
+	uint32_t cc, k, i;
+
+	if (tagmap_alloc() != 0) {
+		puts("tagmap_alloc failed");
+		return 1;
+	}
+
+	for (cc = 0; cc < 16; cc++)
+		for (k = 0; k < (1U << 5); k++) {
+			/* and an unrelated bit (IF), which must not matter */
+			for (eflags = 0x0200, i = 0; i < 5; i++)
+				if (k & (1U << i))
+					eflags |= flags[i];
+
+			cmov(cc, eflags);
+		}
+
+	tagmap_clrn(ADDR, 8);
+	tagmap_free();
+
+	return failed != 0;
+}
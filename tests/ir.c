@@ -0,0 +1,403 @@
+/*
+ * block-level passes and stubs against the analysis routines
+ *
+ * random blocks of liftable calls are run twice from the same
+ * tags: once call by call, through the analysis routines, and
+ * once as the micro-ops that survive ir_optimize, through
+ * argument packs and, where there is a code generator, JIT
+ * stubs. Every register is live at the end of a block, so the
+ * VCPU and the tags of memory must come out the same
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libicedft_api.h"
+#include "libicedft_argpack.h"
+#include "libicedft_core.h"
+#include "libicedft_ir.h"
+#include "libicedft_jit.h"
+#include "libicedft_rec.h"
+#include "tagmap.h"
+
+
+#define BLOCKS	2000			/* random blocks */
+#define CALLS	24			/* calls per block, at most */
+#define MEM	0x10000			/* tagged memory */
+#define MEM_SZ	64
+
+/* call shapes */
+enum { S_R2R, S_M2R, S_R2M, S_M2M, S_CLR, S_CLRN };
+
+typedef void (*r2r_t)(thread_ctx_t *, uint32_t, uint32_t);
+typedef void (*m2r_t)(thread_ctx_t *, uint32_t, ADDRINT);
+typedef void (*r2m_t)(thread_ctx_t *, ADDRINT, uint32_t);
+typedef void (*m2m_t)(ADDRINT, ADDRINT);
+typedef void (*clr_t)(thread_ctx_t *, uint32_t);
+typedef void (*clrn_t)(thread_ctx_t *);
+
+static const struct {
+	void		*fn;
+	uint8_t		shape;
+	uint8_t		len;			/* bytes of the memory operand */
+} calls[] = {
+	{ (void *)r2r_xfer_opl, S_R2R, 0 },
+	{ (void *)r2r_xfer_opw, S_R2R, 0 },
+	{ (void *)r2r_xfer_opb_u, S_R2R, 0 },
+	{ (void *)r2r_xfer_opb_l, S_R2R, 0 },
+	{ (void *)r2r_xfer_opb_ul, S_R2R, 0 },
+	{ (void *)r2r_xfer_opb_lu, S_R2R, 0 },
+	{ (void *)m2r_xfer_opl, S_M2R, 4 },
+	{ (void *)m2r_xfer_opw, S_M2R, 2 },
+	{ (void *)m2r_xfer_opb_u, S_M2R, 1 },
+	{ (void *)m2r_xfer_opb_l, S_M2R, 1 },
+	{ (void *)r2m_xfer_opl, S_R2M, 4 },
+	{ (void *)r2m_xfer_opw, S_R2M, 2 },
+	{ (void *)r2m_xfer_opb_u, S_R2M, 1 },
+	{ (void *)r2m_xfer_opb_l, S_R2M, 1 },
+	{ (void *)m2m_xfer_opl, S_M2M, 4 },
+	{ (void *)m2m_xfer_opw, S_M2M, 2 },
+	{ (void *)m2m_xfer_opb, S_M2M, 1 },
+	{ (void *)_movzx_r2r_oplw, S_R2R, 0 },
+	{ (void *)_movzx_r2r_oplb_u, S_R2R, 0 },
+	{ (void *)_movzx_r2r_oplb_l, S_R2R, 0 },
+	{ (void *)_movzx_r2r_opwb_u, S_R2R, 0 },
+	{ (void *)_movzx_r2r_opwb_l, S_R2R, 0 },
+	{ (void *)_movzx_m2r_oplw, S_M2R, 2 },
+	{ (void *)_movzx_m2r_oplb, S_M2R, 1 },
+	{ (void *)_movzx_m2r_opwb, S_M2R, 1 },
+	{ (void *)_movsx_r2r_oplw, S_R2R, 0 },
+	{ (void *)_movsx_r2r_oplb_u, S_R2R, 0 },
+	{ (void *)_movsx_r2r_oplb_l, S_R2R, 0 },
+	{ (void *)_movsx_r2r_opwb_u, S_R2R, 0 },
+	{ (void *)_movsx_r2r_opwb_l, S_R2R, 0 },
+	{ (void *)_movsx_m2r_oplw, S_M2R, 2 },
+	{ (void *)_movsx_m2r_oplb, S_M2R, 1 },
+	{ (void *)_movsx_m2r_opwb, S_M2R, 1 },
+	{ (void *)r2r_binary_opl, S_R2R, 0 },
+	{ (void *)r2r_binary_opw, S_R2R, 0 },
+	{ (void *)r2r_binary_opb_u, S_R2R, 0 },
+	{ (void *)r2r_binary_opb_l, S_R2R, 0 },
+	{ (void *)r2r_binary_opb_ul, S_R2R, 0 },
+	{ (void *)r2r_binary_opb_lu, S_R2R, 0 },
+	{ (void *)m2r_binary_opl, S_M2R, 4 },
+	{ (void *)m2r_binary_opw, S_M2R, 2 },
+	{ (void *)m2r_binary_opb_u, S_M2R, 1 },
+	{ (void *)m2r_binary_opb_l, S_M2R, 1 },
+	{ (void *)r2m_binary_opl, S_R2M, 4 },
+	{ (void *)r2m_binary_opw, S_R2M, 2 },
+	{ (void *)r2m_binary_opb_u, S_R2M, 1 },
+	{ (void *)r2m_binary_opb_l, S_R2M, 1 },
+	{ (void *)r_clrl, S_CLR, 0 },
+	{ (void *)r_clrw, S_CLR, 0 },
+	{ (void *)r_clrb_u, S_CLR, 0 },
+	{ (void *)r_clrb_l, S_CLR, 0 },
+	{ (void *)r_clrl2, S_CLRN, 0 },
+	{ (void *)r_clrl3, S_CLRN, 0 },
+	{ (void *)r_clrl4, S_CLRN, 0 },
+#ifdef IDFT_X86_64
+	{ (void *)r2r_xfer_opq, S_R2R, 0 },
+	{ (void *)m2r_xfer_opq, S_M2R, 8 },
+	{ (void *)r2m_xfer_opq, S_R2M, 8 },
+	{ (void *)m2m_xfer_opq, S_M2M, 8 },
+	{ (void *)r2r_binary_opq, S_R2R, 0 },
+	{ (void *)m2r_binary_opq, S_M2R, 8 },
+	{ (void *)r2m_binary_opq, S_R2M, 8 },
+#endif
+};
+
+#define NCALLS	(sizeof(calls) / sizeof(calls[0]))
+
+static int failed;
+static uint32_t seed = 0x2545F491U;
+static idft_context_t ctx;
+static rec_buf_t buf;
+static ir_block_t blk;
+
+static uint32_t
+rnd(uint32_t n)
+{
+	seed = seed * 1103515245U + 12345U;
+
+	return (seed >> 8) % n;
+}
+
+/* a random register; the first ones more often, so that they meet */
+static uint32_t
+rnd_reg(void)
+{
+	return rnd(2) ? rnd(4) : rnd(GPR_NUM);
+}
+
+/* a random address, aligned to the operand */
+static ADDRINT
+rnd_ea(uint32_t len)
+{
+	return MEM + (rnd(MEM_SZ - 8) & ~(ADDRINT)(len - 1));
+}
+
+/* record a random call */
+static void
+gen_call(rec_call_t *call)
+{
+	uint32_t k = rnd(NCALLS), argc = 0;
+
+	memset(call, 0, sizeof(*call));
+	call->how	= REC_CALL;
+	call->ipoint	= IDFT_IPOINT_BEFORE;
+	call->func	= calls[k].fn;
+
+	if (calls[k].shape != S_M2M)
+		call->argv[argc++] = IARG_THREAD_CONTEXT;
+
+	switch (calls[k].shape) {
+		case S_R2R:
+			call->argv[argc++] = IARG_UINT32;
+			call->argv[argc++] = rnd_reg();
+			call->argv[argc++] = IARG_UINT32;
+			call->argv[argc++] = rnd_reg();
+			break;
+		case S_M2R:
+			call->argv[argc++] = IARG_UINT32;
+			call->argv[argc++] = rnd_reg();
+			call->argv[argc++] = IARG_ADDRINT;
+			call->argv[argc++] = rnd_ea(calls[k].len);
+			break;
+		case S_R2M:
+			call->argv[argc++] = IARG_ADDRINT;
+			call->argv[argc++] = rnd_ea(calls[k].len);
+			call->argv[argc++] = IARG_UINT32;
+			call->argv[argc++] = rnd_reg();
+			break;
+		case S_M2M:
+			call->argv[argc++] = IARG_ADDRINT;
+			call->argv[argc++] = rnd_ea(calls[k].len);
+			call->argv[argc++] = IARG_ADDRINT;
+			call->argv[argc++] = rnd_ea(calls[k].len);
+			break;
+		case S_CLR:
+			call->argv[argc++] = IARG_UINT32;
+			call->argv[argc++] = rnd_reg();
+			break;
+		default:
+			break;
+	}
+
+	call->argc = argc;
+}
+
+/* run a recorded call through its analysis routine */
+static void
+run_call(thread_ctx_t *tc, rec_call_t *call)
+{
+	ADDRINT *a = call->argv;
+	uint32_t k;
+
+	for (k = 0; calls[k].fn != call->func; k++)
+		;
+
+	switch (calls[k].shape) {
+		case S_R2R:
+			((r2r_t)call->func)(tc, (uint32_t)a[2], (uint32_t)a[4]);
+			break;
+		case S_M2R:
+			((m2r_t)call->func)(tc, (uint32_t)a[2], a[4]);
+			break;
+		case S_R2M:
+			((r2m_t)call->func)(tc, a[2], (uint32_t)a[4]);
+			break;
+		case S_M2M:
+			((m2m_t)call->func)(a[1], a[3]);
+			break;
+		case S_CLR:
+			((clr_t)call->func)(tc, (uint32_t)a[2]);
+			break;
+		default:
+			((clrn_t)call->func)(tc);
+			break;
+	}
+}
+
+/* run a micro-op through its argument pack */
+static void
+run_pack(thread_ctx_t *tc, ir_uop_t *uop)
+{
+	idft_argpack_t pack;
+	void *fn;
+
+	if (uop->dst.kind == LOC_MEM && uop->src.kind == LOC_MEM) {
+		switch (uop->dst.len) {
+			case 1:
+				m2m_xfer_opb(uop->dst.eaval, uop->src.eaval);
+				break;
+			case 2:
+				m2m_xfer_opw(uop->dst.eaval, uop->src.eaval);
+				break;
+			case 4:
+				m2m_xfer_opl(uop->dst.eaval, uop->src.eaval);
+				break;
+			default:
+				m2m_xfer_opq(uop->dst.eaval, uop->src.eaval);
+				break;
+		}
+		return;
+	}
+
+	if ((fn = argpack_make(uop, &pack)) == (void *)argpack_r2r)
+		argpack_r2r(tc, &pack);
+	else if (fn == (void *)argpack_m2r)
+		argpack_m2r(tc, &pack, uop->src.eaval);
+	else if (fn == (void *)argpack_r2m)
+		argpack_r2m(tc, &pack, uop->dst.eaval);
+	else {
+		printf("micro-op %u: no pack\n", uop->op);
+		failed++;
+	}
+}
+
+/* run the micro-ops of a block; runs of register ones as stubs */
+static void
+run_uops(thread_ctx_t *tc, int jit)
+{
+	ir_uop_t *run[IR_UOP_MAX];
+	jit_stub_t stub;
+	uint32_t i, n = 0;
+
+	for (i = 0; i <= blk.nuops; i++) {
+		if (i < blk.nuops && blk.uops[i].op == UOP_NOP)
+			continue;
+
+		if (i < blk.nuops && jit && JIT_UOP_OK(&blk.uops[i])) {
+			run[n++] = &blk.uops[i];
+			continue;
+		}
+
+		if (n > 0) {
+			if (jit_reserve(&ctx, n) != 0 ||
+				(stub = jit_compile(&ctx, run, n)) == NULL) {
+				puts("jit_compile failed");
+				failed++;
+				return;
+			}
+			stub(tc);
+			n = 0;
+		}
+
+		if (i < blk.nuops)
+			run_pack(tc, &blk.uops[i]);
+	}
+}
+
+/* random tags, within the width of each register */
+static void
+gen_state(thread_ctx_t *tc)
+{
+	uint32_t r;
+
+	memset(tc, 0, sizeof(*tc));
+	for (r = 0; r < GPR_NUM; r++)
+		VCPU_GPR_SET(tc, r, rnd(2) ? rnd(IR_FULL + 1) : 0);
+
+	for (r = 0; r < MEM_SZ; r++)
+		if (rnd(2))
+			tagmap_setb(MEM + r);
+		else
+			tagmap_clrb(MEM + r);
+}
+
+/* the tags of memory, one byte per byte */
+static void
+mem_save(uint8_t *m)
+{
+	uint32_t r;
+
+	for (r = 0; r < MEM_SZ; r++)
+		m[r] = (uint8_t)tagmap_getb(MEM + r);
+}
+
+static void
+mem_load(const uint8_t *m)
+{
+	uint32_t r;
+
+	for (r = 0; r < MEM_SZ; r++)
+		if (m[r])
+			tagmap_setb(MEM + r);
+		else
+			tagmap_clrb(MEM + r);
+}
+
+static void
+compare(const char *what, uint32_t b, thread_ctx_t *want, uint8_t *mwant,
+		thread_ctx_t *got)
+{
+	uint8_t mgot[MEM_SZ];
+	uint32_t r;
+
+	mem_save(mgot);
+
+	for (r = 0; r < GPR_NUM; r++)
+		if (VCPU_GPR(want, r) != VCPU_GPR(got, r)) {
+			printf("%s: block %u, reg %u: got %#x, want %#x\n",
+				what, b, r, (unsigned)VCPU_GPR(got, r),
+				(unsigned)VCPU_GPR(want, r));
+			failed++;
+			return;
+		}
+
+	if (memcmp(mwant, mgot, MEM_SZ) != 0) {
+		printf("%s: block %u, memory tags differ\n", what, b);
+		failed++;
+	}
+}
+
+int
+main(void)
+{
+	thread_ctx_t init, want, got;
+	idft_block_stats_t st;
+	uint8_t minit[MEM_SZ], mwant[MEM_SZ];
+	uint32_t b, i, n;
+
+	if (tagmap_alloc() != 0) {
+		puts("tagmap_alloc failed");
+		return 1;
+	}
+
+	for (b = 0; b < BLOCKS && failed == 0; b++) {
+		n = 1 + rnd(CALLS);
+		buf.ncalls = n;
+		for (i = 0; i < n; i++)
+			gen_call(&buf.calls[i]);
+
+		gen_state(&init);
+		mem_save(minit);
+
+		/* call by call */
+		want = init;
+		for (i = 0; i < n; i++)
+			run_call(&want, &buf.calls[i]);
+		mem_save(mwant);
+
+		memset(&st, 0, sizeof(st));
+		ir_lower(&buf, &blk, NULL, 0);
+		ir_optimize(&blk, &st);
+
+		got = init;
+		mem_load(minit);
+		run_uops(&got, 0);
+		compare("argpack", b, &want, mwant, &got);
+
+		if (jit_available()) {
+			got = init;
+			mem_load(minit);
+			run_uops(&got, 1);
+			compare("jit", b, &want, mwant, &got);
+		}
+	}
+
+	jit_free(&ctx);
+	tagmap_free();
+
+	return failed != 0;
+}
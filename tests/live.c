@@ -0,0 +1,103 @@
+/*
+ * taint liveness transitions
+ *
+ * the liveness hook fires once per transition, whichever
+ * entry point makes taint live, and never while it stays so
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libicedft_api.h"
+#include "libicedft_core.h"
+#include "tagmap.h"
+
+
+static int failed;
+static uint32_t nlive, ndead;
+
+static void
+live_cb(void *arg, uint32_t live)
+{
+	(void)arg;
+
+	if (live)
+		nlive++;
+	else
+		ndead++;
+}
+
+static void
+check(const char *what, uint32_t live, uint32_t dead)
+{
+	if (nlive == live && ndead == dead)
+		return;
+
+	printf("%s: got %u/%u transitions, want %u/%u\n", what, nlive,
+			ndead, live, dead);
+	failed++;
+}
+
+int
+main(void)
+{
+	thread_ctx_t tc;
+
+	if (tagmap_alloc() != 0) {
+		puts("tagmap_alloc failed");
+		return 1;
+	}
+
+	libdft_taint_set_cb(live_cb, NULL);
+	memset(&tc, 0, sizeof(tc));
+	THREAD_CTX_STALE(&tc);
+
+	/* untagging and moving tags does not make taint live */
+	tagmap_clrl(0x1000);
+	tagmap_filln(0x1000, 64, 0);
+	tagmap_cpn(0x2000, 0x1000, 64);
+	check("clear", 0, 0);
+	if (taint_guard(&tc) != 0) {
+		puts("guard: tripped while dead");
+		failed++;
+	}
+
+	/* the first tag is an edge; the next ones are not */
+	tagmap_setl(0x1000);
+	check("setl", 1, 0);
+	tagmap_setb(0x1008);
+	tagmap_setn(0x1010, 100);
+	tagmap_filln(0x1100, 8, 1);
+	taint_guard_trip();
+	taint_guard_trip();
+	check("live", 1, 0);
+
+	libdft_taint_clear(&tc);
+	check("taint_clear", 1, 1);
+	libdft_taint_clear(NULL);
+	check("taint_clear (dead)", 1, 1);
+
+	tagmap_filln(0x1100, 8, 1);
+	check("filln", 2, 1);
+	libdft_taint_clear(NULL);
+
+	/* a tagged VCPU trips the guard, once */
+	VCPU_GPR_SET(&tc, GPR_EAX, 1);
+	THREAD_CTX_STALE(&tc);
+	if (taint_guard(&tc) == 0) {
+		puts("guard: not tripped by a tagged VCPU");
+		failed++;
+	}
+	taint_guard_trip();
+	taint_guard_trip();
+	check("guard trip", 3, 2);
+
+	/* direct writes cannot be seen */
+	libdft_taint_clear(&tc);
+	(void)libdft_tag_bitmap();
+	check("tag_bitmap", 4, 3);
+
+	tagmap_free();
+
+	return failed != 0;
+}
@@ -0,0 +1,121 @@
+/*
+ * REP MOVS tag propagation
+ *
+ * the string is copied one element at a time, forwards or, with
+ * EFLAGS.DF = 1, backwards from the last elements; when dst and
+ * src overlap, an element may be read after it was written, and
+ * the tags must follow what the copy does to the data
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libicedft_api.h"
+#include "libicedft_core.h"
+#include "tagmap.h"
+
+
+#define BASE	0x4000
+#define WIN	512			/* tags checked around BASE */
+#define SRC	(BASE + WIN / 2)
+#define COUNT	12			/* elements, at most */
+#define DELTA	40			/* dst - src, at most */
+#define DF	0x0400
+
+typedef void (*movs_t)(ADDRINT, ADDRINT, ADDRINT, ADDRINT);
+
+static int failed;
+static uint32_t seed = 0x2545F491U;
+
+static uint32_t
+rnd(uint32_t n)
+{
+	seed = seed * 1103515245U + 12345U;
+
+	return (seed >> 8) % n;
+}
+
+/*
+ * run a REP MOVS over random tags, and the same copy on a
+ * byte per tag, element by element
+ *
+ * @name:	the variant
+ * @fn:		its handler
+ * @size:	element size
+ * @dst:	destination (the last element, if DF)
+ * @count:	elements
+ * @eflags:	0 or DF
+ */
+static void
+movs(const char *name, movs_t fn, size_t size, ADDRINT dst, ADDRINT count,
+		ADDRINT eflags)
+{
+	uint8_t want[WIN], elem[8];
+	ADDRINT d = dst - BASE, s = SRC - BASE, k;
+	size_t i;
+
+	for (i = 0; i < WIN; i++) {
+		want[i] = (uint8_t)rnd(2);
+		if (want[i])
+			tagmap_setb(BASE + i);
+		else
+			tagmap_clrb(BASE + i);
+	}
+
+	fn(dst, SRC, count, eflags);
+
+	for (k = 0; k < count; k++) {
+		memcpy(elem, &want[s], size);
+		memcpy(&want[d], elem, size);
+		d = eflags ? d - size : d + size;
+		s = eflags ? s - size : s + size;
+	}
+
+	for (i = 0; i < WIN; i++)
+		if ((tagmap_getb(BASE + i) != 0) != want[i]) {
+			printf("%s DF=%d dst %+d count %u: byte %+d is %s\n",
+				name, eflags != 0, (int)(dst - SRC),
+				(unsigned)count, (int)(BASE + i - SRC),
+				want[i] ? "clean" : "tagged");
+			failed++;
+			return;
+		}
+}
+
+int
+main(void)
+{
+	static const struct {
+		const char	*name;
+		movs_t		fn;
+		size_t		size;
+	} variants[] = {
+		{ "opbn", m2m_xfer_opbn, 1 },
+		{ "opwn", m2m_xfer_opwn, 2 },
+		{ "opln", m2m_xfer_opln, 4 },
+#ifdef IDFT_X86_64
+		{ "opqn", m2m_xfer_opqn, 8 },
+#endif
+	};
+	ADDRINT eflags[] = { 0, DF };
+	size_t v, e;
+	int delta;
+	ADDRINT count;
+
+	if (tagmap_alloc() != 0) {
+		puts("tagmap_alloc failed");
+		return 1;
+	}
+
+	for (v = 0; v < sizeof(variants) / sizeof(variants[0]); v++)
+		for (e = 0; e < sizeof(eflags) / sizeof(eflags[0]); e++)
+			for (delta = -DELTA; delta <= DELTA; delta++)
+				for (count = 0; count <= COUNT; count++)
+					movs(variants[v].name, variants[v].fn,
+						variants[v].size, SRC + delta,
+						count, eflags[e]);
+
+	tagmap_free();
+
+	return failed != 0;
+}
@@ -0,0 +1,255 @@
+/*
+ * instrumentation plans
+ *
+ * the calls learned for a module are written to its plan file
+ * and issued from it, unchanged, the next time the module is
+ * loaded; a truncated or corrupted file is ignored, and its
+ * instructions are inspected anew
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libicedft_api.h"
+#include "libicedft_core.h"
+#include "libicedft_plan.h"
+
+
+#define PATH	"plan.test"
+#define KEY	"test"
+#define LO	0x1000
+#define HI	0x1FFF
+#define LOG_MAX	16
+
+static int failed;
+static void *log_fn[LOG_MAX];
+static uint32_t nlog;
+
+/* the executer; an instruction is its opcode and address */
+static uint32_t
+fake_opcode(idft_ins_t *ins, void *context)
+{
+	(void)context;
+
+	return ins->ins_indx;
+}
+
+static ADDRINT
+fake_address(idft_ins_t *ins, void *context)
+{
+	(void)context;
+
+	return (ADDRINT)(uintptr_t)ins->ins_content;
+}
+
+static idft_reg_t
+fake_operand(idft_ins_t *ins, void *context, idft_reg_t n)
+{
+	(void)ins;
+	(void)context;
+	(void)n;
+
+	return 0;
+}
+
+static uint32_t
+fake_insert(idft_ins_t *ins, void *context, uint32_t action, void *func,
+		uint32_t argc, ...)
+{
+	(void)ins;
+	(void)context;
+	(void)action;
+	(void)argc;
+
+	if (nlog < LOG_MAX)
+		log_fn[nlog++] = func;
+
+	return 0;
+}
+
+/* inspect the instruction at off; the calls issued, in log_fn */
+static uint32_t
+inspect(idft_context_t *context, uint32_t opcode, uint32_t off)
+{
+	idft_ins_t ins;
+
+	ins.ins_indx	= (xed_iclass_enum_t)opcode;
+	ins.ins_content	= (void *)(uintptr_t)(LO + off);
+
+	nlog = 0;
+	ins_inspect(&ins, context);
+
+	return nlog;
+}
+
+/* the whole file, as written */
+static char *
+slurp(size_t *len)
+{
+	FILE *fp;
+	char *buf;
+	long sz;
+
+	if ((fp = fopen(PATH, "rb")) == NULL)
+		return NULL;
+	if (fseek(fp, 0, SEEK_END) != 0 || (sz = ftell(fp)) < 0 ||
+			fseek(fp, 0, SEEK_SET) != 0 ||
+			(buf = malloc((size_t)sz + 1)) == NULL) {
+		(void)fclose(fp);
+		return NULL;
+	}
+	*len = fread(buf, 1, (size_t)sz, fp);
+	(void)fclose(fp);
+
+	return buf;
+}
+
+static void
+spill(const char *buf, size_t len)
+{
+	FILE *fp;
+
+	if ((fp = fopen(PATH, "wb")) == NULL ||
+			fwrite(buf, 1, len, fp) != len) {
+		puts("cannot write " PATH);
+		failed++;
+	}
+	if (fp != NULL)
+		(void)fclose(fp);
+}
+
+/*
+ * load a (damaged) copy of the file, and check that it is
+ * ignored: the instruction at +0, now a NOP, issues no calls
+ * unless they come from the file
+ */
+static void
+rejected(idft_context_t *context, const char *what, const char *buf,
+		size_t len)
+{
+	spill(buf, len);
+
+	if (libdft_plan_load(context, PATH, KEY, LO, HI) != 0) {
+		printf("%s: libdft_plan_load failed\n", what);
+		failed++;
+		return;
+	}
+
+	if (inspect(context, XED_ICLASS_NOP, 0) != 0) {
+		printf("%s: planned from a bad file\n", what);
+		failed++;
+	}
+
+	libdft_plan_unload(context, LO);
+}
+
+int
+main(void)
+{
+	idft_executer_api_t api;
+	idft_context_t *context;
+	plan_hdr_t *hdr;
+	plan_ins_t *ins;
+	plan_call_t *calls;
+	void *want[LOG_MAX];
+	uint32_t nwant;
+	char *good, *bad;
+	size_t len;
+
+	memset(&api, 0, sizeof(api));
+	api.INS_Opcode		= fake_opcode;
+	api.INS_Address		= fake_address;
+	api.INS_OperandIsReg	= fake_operand;
+	api.INS_OperandIsMemory	= fake_operand;
+	api.INS_OperandIsImmediate = fake_operand;
+	api.INS_InsertCall	= fake_insert;
+
+	if (libdft_init(&api, NULL, &context) != 0) {
+		puts("libdft_init failed");
+		return 1;
+	}
+
+	(void)remove(PATH);
+
+	/* learn CPUID at +0 and RDTSC at +8, and save */
+	if (libdft_plan_load(context, PATH, KEY, LO, HI) != 0) {
+		puts("libdft_plan_load failed");
+		return 1;
+	}
+	nwant = inspect(context, XED_ICLASS_CPUID, 0);
+	memcpy(want, log_fn, sizeof(want));
+	(void)inspect(context, XED_ICLASS_RDTSC, 8);
+
+	if (nwant == 0) {
+		puts("CPUID: no calls");
+		failed++;
+	}
+	if (libdft_plan_save(context) != 0) {
+		puts("libdft_plan_save failed");
+		failed++;
+	}
+	libdft_plan_unload(context, LO);
+
+	/* the round trip; whatever the instruction is now */
+	if (libdft_plan_load(context, PATH, KEY, LO, HI) != 0) {
+		puts("libdft_plan_load failed");
+		return 1;
+	}
+	if (inspect(context, XED_ICLASS_NOP, 0) != nwant ||
+			memcmp(log_fn, want, nwant * sizeof(void *)) != 0) {
+		printf("round trip: %u calls, want %u\n", nlog, nwant);
+		failed++;
+	}
+	if (inspect(context, XED_ICLASS_NOP, 4) != 0) {
+		puts("round trip: planned an unknown instruction");
+		failed++;
+	}
+	libdft_plan_unload(context, LO);
+
+	if ((good = slurp(&len)) == NULL || len < sizeof(plan_hdr_t) +
+			2 * sizeof(plan_ins_t) + sizeof(plan_call_t)) {
+		puts("cannot read " PATH);
+		return 1;
+	}
+	if ((bad = malloc(len)) == NULL)
+		return 1;
+
+	hdr	= (plan_hdr_t *)bad;
+	ins	= (plan_ins_t *)(hdr + 1);
+	calls	= (plan_call_t *)(ins + ((plan_hdr_t *)good)->nins);
+
+	/* truncated */
+	rejected(context, "header only", good, sizeof(plan_hdr_t));
+	rejected(context, "short header", good, sizeof(plan_hdr_t) - 1);
+	rejected(context, "one byte short", good, len - 1);
+	rejected(context, "one call short", good, len - sizeof(plan_call_t));
+
+	/* corrupted */
+#define CORRUPT(what, stmt) do {					\
+	memcpy(bad, good, len);						\
+	stmt;								\
+	rejected(context, what, bad, len);				\
+} while (0)
+
+	CORRUPT("magic", hdr->magic ^= 1);
+	CORRUPT("version", hdr->version++);
+	CORRUPT("key", hdr->key[0] ^= 1);
+	CORRUPT("options", hdr->opts ^= PLAN_OPTS);
+	CORRUPT("nhandlers", hdr->nhandlers = 0xFFFFFFFF);
+	CORRUPT("nins", hdr->nins = 0x80000000);
+	CORRUPT("ncalls", hdr->ncalls = 0xFFFFFFFF);
+	CORRUPT("first", ins[0].first = 0xFFFFFFFF);
+	CORRUPT("count", ins[0].n = 0xFFFFFFFF);
+	CORRUPT("order", ins[1].off = ins[0].off);
+	CORRUPT("handler", calls[0].id = 0xFFFF);
+	CORRUPT("argc", calls[0].argc = REC_ARG_MAX + 1);
+
+	free(bad);
+	free(good);
+	(void)remove(PATH);
+
+	libdft_die(context);
+
+	return failed != 0;
+}
@@ -0,0 +1,158 @@
+/*
+ * PUSHA/POPA tag propagation
+ *
+ * the 8 registers are saved (and restored) with one shadow
+ * access; slot i of the frame, from its lowest address, holds
+ * register i (EDI first, EAX last). POPA does not restore
+ * ESP, and its 16-bit form leaves the upper words alone
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libicedft_api.h"
+#include "libicedft_core.h"
+#include "tagmap.h"
+
+
+#define BASE	0x6000
+#define WIN	64			/* tags checked from BASE */
+#define FRAME	16			/* offset of the frame in it */
+
+static int failed;
+static uint32_t seed = 0x2545F491U;
+
+static uint32_t
+rnd(uint32_t n)
+{
+	seed = seed * 1103515245U + 12345U;
+
+	return (seed >> 8) % n;
+}
+
+static void
+check(const char *what, uint32_t align, uint32_t i, size_t got, size_t want)
+{
+	if (got == want)
+		return;
+
+	printf("%s +%u: %u: got %zx, want %zx\n", what, align, i, got, want);
+	failed++;
+}
+
+/* random tags; the registers (32-bit ones) and the window */
+static void
+randomize(thread_ctx_t *tc, uint8_t *mem)
+{
+	uint32_t i;
+
+	memset(tc, 0, sizeof(*tc));
+	for (i = 0; i < GPR_NUM; i++)
+		VCPU_GPR_SET(tc, i, rnd(VCPU_MASK32 + 1));
+
+	for (i = 0; i < WIN; i++) {
+		mem[i] = (uint8_t)rnd(2);
+		if (mem[i])
+			tagmap_setb(BASE + i);
+		else
+			tagmap_clrb(BASE + i);
+	}
+}
+
+/* the tags of a slot, one bit per byte */
+static uint32_t
+slot(const uint8_t *mem, uint32_t off, uint32_t len)
+{
+	uint32_t t = 0, i;
+
+	for (i = 0; i < len; i++)
+		t |= (uint32_t)mem[off + i] << i;
+
+	return t;
+}
+
+/*
+ * PUSHA(D) at dst = BASE + FRAME + align
+ *
+ * @len:	the slot size; 2 or 4
+ */
+static void
+save(uint32_t align, uint32_t len)
+{
+	const char *what = (len == 4) ? "pushad" : "pusha";
+	thread_ctx_t tc;
+	uint8_t mem[WIN];
+	uint32_t dst = FRAME + align, i, want;
+
+	randomize(&tc, mem);
+
+	if (len == 4)
+		r2m_save_opl(&tc, BASE + dst);
+	else
+		r2m_save_opw(&tc, BASE + dst);
+
+	for (i = 0; i < WIN; i++) {
+		want = mem[i];
+
+		/* inside the frame; the byte of its register */
+		if (i >= dst && i < dst + 8 * len)
+			want = (VCPU_GPR(&tc, (i - dst) / len) >>
+				((i - dst) % len)) & 1;
+
+		check(what, align, i, tagmap_getb(BASE + i) != 0, want);
+	}
+}
+
+/* POPA(D) from src = BASE + FRAME + align */
+static void
+restore(uint32_t align, uint32_t len)
+{
+	const char *what = (len == 4) ? "popad" : "popa";
+	thread_ctx_t tc, old;
+	uint8_t mem[WIN];
+	uint32_t src = FRAME + align, i, want;
+
+	randomize(&tc, mem);
+	old = tc;
+
+	if (len == 4)
+		m2r_restore_opl(&tc, BASE + src);
+	else
+		m2r_restore_opw(&tc, BASE + src);
+
+	for (i = 0; i < GPR_NUM; i++) {
+		if (i >= 8 || i == GPR_ESP)
+			want = VCPU_GPR(&old, i);
+		else if (len == 4)
+			want = slot(mem, src + i * 4, 4);
+		else
+			want = (VCPU_GPR(&old, i) & ~VCPU_MASK16) |
+				slot(mem, src + i * 2, 2);
+
+		check(what, align, i, VCPU_GPR(&tc, i), want);
+	}
+}
+
+int
+main(void)
+{
+	uint32_t align, n;
+
+	if (tagmap_alloc() != 0) {
+		puts("tagmap_alloc failed");
+		return 1;
+	}
+
+	for (n = 0; n < 16; n++)
+		for (align = 0; align < 8; align++) {
+			save(align, 4);
+			save(align, 2);
+			restore(align, 4);
+			restore(align, 2);
+		}
+
+	tagmap_clrn(BASE, WIN);
+	tagmap_free();
+
+	return failed != 0;
+}
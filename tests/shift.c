@@ -0,0 +1,208 @@
+/*
+ * shift and rotate tag propagation
+ *
+ * a result byte is tagged if any of the bits it is made of is;
+ * the maps are checked by hand at the counts where bits cross
+ * the most bytes (0, 1, 31, and 63, which 32-bit operations
+ * take modulo 32)
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libicedft_api.h"
+#include "libicedft_core.h"
+#include "libicedft_shift.h"
+#include "tagmap.h"
+
+
+#define ADDR	0x1000
+
+static int failed;
+
+static void
+check(const char *what, uint32_t cnt, size_t got, size_t want)
+{
+	if (got == want)
+		return;
+
+	printf("%s by %u: got %zx, want %zx\n", what, cnt, got, want);
+	failed++;
+}
+
+/* a register shift of tag t */
+static uint32_t
+r_shift(void (*fn)(thread_ctx_t *, uint32_t, uint32_t, uint32_t),
+		uint32_t row, uint32_t cnt, uint32_t t)
+{
+	thread_ctx_t tc;
+
+	memset(&tc, 0, sizeof(tc));
+	VCPU_GPR_SET(&tc, GPR_EAX, t);
+	fn(&tc, GPR_EAX, row, cnt);
+
+	return VCPU_GPR(&tc, GPR_EAX);
+}
+
+/* a double shift of tags d (dst) and s (src) */
+static uint32_t
+r2r_shiftd(void (*fn)(thread_ctx_t *, uint32_t, uint32_t, uint32_t,
+		uint32_t), uint32_t row, uint32_t cnt, uint32_t d, uint32_t s)
+{
+	thread_ctx_t tc;
+
+	memset(&tc, 0, sizeof(tc));
+	VCPU_GPR_SET(&tc, GPR_EAX, d);
+	VCPU_GPR_SET(&tc, GPR_EBX, s);
+	fn(&tc, GPR_EAX, GPR_EBX, row, cnt);
+
+	return VCPU_GPR(&tc, GPR_EAX);
+}
+
+static void
+test_rotate(void)
+{
+	uint32_t rol = SHIFT_ROW(0, SHIFT_W32, SHIFT_ROL);
+	uint32_t ror = SHIFT_ROW(0, SHIFT_W32, SHIFT_ROR);
+	uint32_t rolw = SHIFT_ROW(0, SHIFT_W16, SHIFT_ROL);
+	uint32_t rclb = SHIFT_ROW(0, SHIFT_W8, SHIFT_RCL);
+
+	check("rol opl", 0, r_shift(r_shift_opl, rol, 0, 0x1), 0x1);
+	check("rol opl", 1, r_shift(r_shift_opl, rol, 1, 0x1), 0x3);
+	check("rol opl", 1, r_shift(r_shift_opl, rol, 1, 0x8), 0x9);
+	check("rol opl", 31, r_shift(r_shift_opl, rol, 31, 0x1), 0x9);
+	check("rol opl", 63, r_shift(r_shift_opl, rol, 63, 0x1), 0x9);
+	check("rol opl", 8, r_shift(r_shift_opl, rol, 8, 0x9), 0x3);
+
+	check("ror opl", 0, r_shift(r_shift_opl, ror, 0, 0x4), 0x4);
+	check("ror opl", 1, r_shift(r_shift_opl, ror, 1, 0x1), 0x9);
+	check("ror opl", 31, r_shift(r_shift_opl, ror, 31, 0x1), 0x3);
+	check("ror opl", 63, r_shift(r_shift_opl, ror, 63, 0x8), 0x9);
+
+	/* the upper word stays as is */
+	check("rol opw", 1, r_shift(r_shift_opw, rolw, 1, 0x5), 0x7);
+	check("rol opw", 31, r_shift(r_shift_opw, rolw, 31, 0x9), 0xB);
+
+	/* through the (untagged) carry; AL stays AL */
+	check("rcl opb_l", 1, r_shift(r_shift_opb_l, rclb, 1, 0x3), 0x3);
+	check("rcl opb_u", 1, r_shift(r_shift_opb_u, rclb, 1, 0x2), 0x2);
+	check("rcl opb_l", 1, r_shift(r_shift_opb_l, rclb, 1, 0x2), 0x2);
+}
+
+static void
+test_shift(void)
+{
+	uint32_t shl = SHIFT_ROW(0, SHIFT_W32, SHIFT_SHL);
+	uint32_t shr = SHIFT_ROW(0, SHIFT_W32, SHIFT_SHR);
+	uint32_t sar = SHIFT_ROW(0, SHIFT_W32, SHIFT_SAR);
+	uint32_t any = SHIFT_ROW(1, SHIFT_W32, SHIFT_SHL);
+
+	check("shl opl", 1, r_shift(r_shift_opl, shl, 1, 0x8), 0x8);
+	check("shl opl", 31, r_shift(r_shift_opl, shl, 31, 0x1), 0x8);
+	check("shl opl", 31, r_shift(r_shift_opl, shl, 31, 0x6), 0x0);
+	check("shr opl", 31, r_shift(r_shift_opl, shr, 31, 0x8), 0x1);
+	check("shr opl", 63, r_shift(r_shift_opl, shr, 63, 0x1), 0x0);
+	check("sar opl", 31, r_shift(r_shift_opl, sar, 31, 0x8), 0xF);
+	check("sar opl", 1, r_shift(r_shift_opl, sar, 1, 0x1), 0x1);
+
+	/* a count that is not known; any of them */
+	check("shl opl (any)", 0, r_shift(r_shift_opl, any, 0, 0x1), 0xF);
+
+	/* memory */
+	tagmap_clrl(ADDR);
+	tagmap_setb(ADDR);
+	m_shift_opl(ADDR, shl, 31);
+	check("shl m32", 31, tagmap_getl(ADDR) >> VIRT2BIT(ADDR), 0x8);
+	tagmap_clrl(ADDR);
+}
+
+static void
+test_shiftd(void)
+{
+	uint32_t shld = SHIFT_ROW(0, SHIFT_W32, SHIFT_SHLD);
+	uint32_t shrd = SHIFT_ROW(0, SHIFT_W32, SHIFT_SHRD);
+	uint32_t shldw = SHIFT_ROW(0, SHIFT_W16, SHIFT_SHLD);
+
+	check("shld opl dst", 0,
+		r2r_shiftd(r2r_shiftd_opl, shld, 0, 0x1, 0xF), 0x1);
+	check("shld opl dst", 1,
+		r2r_shiftd(r2r_shiftd_opl, shld, 1, 0x1, 0x0), 0x3);
+	check("shld opl src", 1,
+		r2r_shiftd(r2r_shiftd_opl, shld, 1, 0x0, 0x8), 0x1);
+	check("shld opl dst", 31,
+		r2r_shiftd(r2r_shiftd_opl, shld, 31, 0x1, 0x0), 0x8);
+	check("shld opl src", 31,
+		r2r_shiftd(r2r_shiftd_opl, shld, 31, 0x0, 0x8), 0xC);
+	check("shld opl src", 63,
+		r2r_shiftd(r2r_shiftd_opl, shld, 63, 0x0, 0x1), 0x1);
+
+	check("shrd opl dst", 1,
+		r2r_shiftd(r2r_shiftd_opl, shrd, 1, 0x2, 0x0), 0x3);
+	check("shrd opl src", 1,
+		r2r_shiftd(r2r_shiftd_opl, shrd, 1, 0x0, 0x1), 0x8);
+	check("shrd opl dst", 31,
+		r2r_shiftd(r2r_shiftd_opl, shrd, 31, 0x9, 0x0), 0x1);
+	check("shrd opl src", 31,
+		r2r_shiftd(r2r_shiftd_opl, shrd, 31, 0x0, 0x9), 0xB);
+
+	/* 16-bit, by more than 16; undefined, so everything */
+	check("shld opw", 31,
+		r2r_shiftd(r2r_shiftd_opw, shldw, 31, 0x0, 0x1), 0x3);
+	check("shld opw", 31,
+		r2r_shiftd(r2r_shiftd_opw, shldw, 31, 0x4, 0x0), 0x4);
+}
+
+#ifdef IDFT_X86_64
+static void
+test_opq(void)
+{
+	uint32_t rol = SHIFT_QROW(0, SHIFT_ROL);
+	uint32_t ror = SHIFT_QROW(0, SHIFT_ROR);
+	uint32_t shld = SHIFT_QROW(0, SHIFT_SHLD);
+	uint32_t shrd = SHIFT_QROW(0, SHIFT_SHRD);
+
+	check("rol opq", 0, r_shift(r_shift_opq, rol, 0, 0x01), 0x01);
+	check("rol opq", 1, r_shift(r_shift_opq, rol, 1, 0x80), 0x81);
+	check("rol opq", 31, r_shift(r_shift_opq, rol, 31, 0x01), 0x18);
+	check("rol opq", 63, r_shift(r_shift_opq, rol, 63, 0x01), 0x81);
+	check("ror opq", 31, r_shift(r_shift_opq, ror, 31, 0x01), 0x30);
+	check("ror opq", 63, r_shift(r_shift_opq, ror, 63, 0x80), 0x81);
+
+	check("shld opq dst", 31,
+		r2r_shiftd(r2r_shiftd_opq, shld, 31, 0x01, 0x00), 0x18);
+	check("shld opq src", 31,
+		r2r_shiftd(r2r_shiftd_opq, shld, 31, 0x00, 0x80), 0x0C);
+	check("shld opq dst", 63,
+		r2r_shiftd(r2r_shiftd_opq, shld, 63, 0x01, 0x00), 0x80);
+	check("shld opq src", 63,
+		r2r_shiftd(r2r_shiftd_opq, shld, 63, 0x00, 0x80), 0xC0);
+	check("shrd opq dst", 63,
+		r2r_shiftd(r2r_shiftd_opq, shrd, 63, 0x80, 0x00), 0x01);
+	check("shrd opq src", 63,
+		r2r_shiftd(r2r_shiftd_opq, shrd, 63, 0x00, 0x01), 0x03);
+	check("shrd opq src", 1,
+		r2r_shiftd(r2r_shiftd_opq, shrd, 1, 0x00, 0x01), 0x80);
+}
+#endif
+
+int
+main(void)
+{
+	if (tagmap_alloc() != 0) {
+		puts("tagmap_alloc failed");
+		return 1;
+	}
+
+	shift_init();
+
+	test_rotate();
+	test_shift();
+	test_shiftd();
+#ifdef IDFT_X86_64
+	test_opq();
+#endif
+
+	tagmap_free();
+
+	return failed != 0;
+}
@@ -0,0 +1,82 @@
+/*
+ * REP STOS tag propagation
+ *
+ * with EFLAGS.DF = 1, dst is the last element and the string
+ * covers [dst - count * size + size, dst + size); the plain and
+ * the branch-free variants must tag exactly those bytes
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libicedft_api.h"
+#include "libicedft_core.h"
+#include "tagmap.h"
+
+
+#define DST	0x3000
+#define COUNT	3
+#define DF	0x0400
+
+typedef void (*stos_t)(thread_ctx_t *, ADDRINT, ADDRINT, ADDRINT);
+
+static int failed;
+
+/*
+ * run a REP STOS with EAX tagged over a clean window, and
+ * check the tags of the window
+ *
+ * @name:	the variant
+ * @fn:		its handler
+ * @size:	element size
+ * @eflags:	0 or DF
+ */
+static void
+stos(const char *name, stos_t fn, size_t size, ADDRINT eflags)
+{
+	thread_ctx_t tc;
+	size_t lo, hi, addr;
+
+	memset(&tc, 0, sizeof(tc));
+	VCPU_GPR_SET(&tc, GPR_EAX, VCPU_MASK32);
+	tagmap_clrn(DST - 64, 128);
+
+	fn(&tc, DST, COUNT, eflags);
+
+	lo = eflags ? DST - COUNT * size + size : DST;
+	hi = lo + COUNT * size;
+
+	for (addr = DST - 64; addr < DST + 64; addr++)
+		if ((tagmap_getb(addr) != 0) != (addr >= lo && addr < hi)) {
+			printf("%s DF=%d: byte %#zx is %s\n", name,
+					eflags != 0, addr,
+					tagmap_getb(addr) ? "tagged" : "clean");
+			failed++;
+			break;
+		}
+}
+
+int
+main(void)
+{
+	ADDRINT eflags[] = { 0, DF };
+	size_t i;
+
+	if (tagmap_alloc() != 0) {
+		puts("tagmap_alloc failed");
+		return 1;
+	}
+
+	for (i = 0; i < sizeof(eflags) / sizeof(eflags[0]); i++) {
+		stos("opbn", r2m_xfer_opbn, 1, eflags[i]);
+		stos("opwn", r2m_xfer_opwn, 2, eflags[i]);
+		stos("opln", r2m_xfer_opln, 4, eflags[i]);
+		stos("opbn_bf", r2m_xfer_opbn_bf, 1, eflags[i]);
+		stos("opwn_bf", r2m_xfer_opwn_bf, 2, eflags[i]);
+		stos("opln_bf", r2m_xfer_opln_bf, 4, eflags[i]);
+	}
+
+	tagmap_free();
+
+	return failed != 0;
+}
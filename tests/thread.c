@@ -0,0 +1,163 @@
+/*
+ * thread context pool and registry
+ *
+ * contexts started concurrently are distinct, zeroed, and on
+ * cache lines of their own; the registry finds each under its
+ * thread id until it is finished, and a recycled slot comes
+ * back zeroed
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "libicedft_api.h"
+#include "libicedft_core.h"
+
+
+#define NTHREADS	8		/* starting threads */
+#define PER_THREAD	64		/* contexts each starts */
+#define NCTX		(NTHREADS * PER_THREAD)
+#define LINE		64
+
+static int failed;
+static idft_context_t *context;
+static thread_ctx_t *ctx[NCTX];		/* by tid */
+static uint32_t seen[NCTX];
+
+static void
+fail(const char *what, uint32_t tid)
+{
+	printf("%s: tid %u\n", what, tid);
+	__atomic_add_fetch(&failed, 1, __ATOMIC_RELAXED);
+}
+
+/* start the contexts of tids first, first + NTHREADS, ... */
+static void *
+starter(void *arg)
+{
+	uint32_t tid, i;
+
+	for (i = 0; i < PER_THREAD; i++) {
+		tid = (uint32_t)(uintptr_t)arg + i * NTHREADS;
+
+		if ((ctx[tid] = libdft_thread_start(context, tid)) == NULL)
+			fail("libdft_thread_start failed", tid);
+	}
+
+	return NULL;
+}
+
+static void
+visit(void *arg, uint32_t tid, thread_ctx_t *thread_ctx)
+{
+	(void)arg;
+
+	if (tid >= NCTX || ctx[tid] != thread_ctx)
+		fail("foreach: a stranger", tid);
+	else
+		seen[tid]++;
+}
+
+/* two contexts never share a line */
+static void
+check_layout(void)
+{
+	uintptr_t a, b;
+	uint32_t i, j;
+
+	for (i = 0; i < NCTX; i++) {
+		if (ctx[i] == NULL)
+			continue;
+
+		a = (uintptr_t)ctx[i];
+		if (a % LINE != 0)
+			fail("not line aligned", i);
+
+		for (j = 0; j < i; j++) {
+			b = (uintptr_t)ctx[j];
+			if (b != 0 && (a < b ? b - a : a - b) <
+					(sizeof(thread_ctx_t) + LINE - 1) /
+					LINE * LINE)
+				fail("sharing a line", i);
+		}
+	}
+}
+
+int
+main(void)
+{
+	static const uint8_t zero[sizeof(thread_ctx_t)];
+	idft_executer_api_t api;
+	pthread_t th[NTHREADS];
+	thread_ctx_t *tc;
+	uint32_t i;
+
+	memset(&api, 0, sizeof(api));
+	if (libdft_init(&api, NULL, &context) != 0) {
+		puts("libdft_init failed");
+		return 1;
+	}
+
+	for (i = 0; i < NTHREADS; i++)
+		if (pthread_create(&th[i], NULL, starter,
+				(void *)(uintptr_t)i) != 0) {
+			puts("pthread_create failed");
+			return 1;
+		}
+	for (i = 0; i < NTHREADS; i++)
+		(void)pthread_join(th[i], NULL);
+
+	check_layout();
+
+	for (i = 0; i < NCTX; i++) {
+		if (ctx[i] == NULL)
+			continue;
+
+		/* zeroed, but for what the pool keeps there */
+		tc = ctx[i];
+		if (memcmp(&tc->vcpu, zero, sizeof(tc->vcpu)) != 0)
+			fail("VCPU not zeroed", i);
+		if (libdft_thread_get(context, i) != tc)
+			fail("libdft_thread_get", i);
+		if (libdft_thread_start(context, i) != tc)
+			fail("started twice", i);
+	}
+
+	if (libdft_thread_foreach(context, visit, NULL) != NCTX)
+		fail("foreach: count", NCTX);
+	for (i = 0; i < NCTX; i++)
+		if (seen[i] != 1)
+			fail("foreach: not visited once", i);
+
+	/* finish the odd ones */
+	for (i = 1; i < NCTX; i += 2) {
+		VCPU_GPR_SET(ctx[i], GPR_EAX, VCPU_MASK32);
+		libdft_thread_fini(context, ctx[i]);
+
+		if (libdft_thread_get(context, i) != NULL)
+			fail("found after libdft_thread_fini", i);
+	}
+	if (libdft_thread_foreach(context, visit, NULL) != NCTX / 2)
+		fail("foreach: count after fini", NCTX / 2);
+
+	/* and start them again, under other ids */
+	for (i = 1; i < NCTX; i += 2) {
+		if ((tc = libdft_thread_start(context, NCTX + i)) == NULL) {
+			fail("libdft_thread_start failed", NCTX + i);
+			continue;
+		}
+		if (VCPU_GPR(tc, GPR_EAX) != 0)
+			fail("recycled, but not zeroed", NCTX + i);
+	}
+
+	/* not from the pool; ignored */
+	tc = ctx[0];
+	libdft_thread_fini(context, (thread_ctx_t *)zero);
+	if (libdft_thread_get(context, 0) != tc)
+		fail("a stranger finished a thread", 0);
+
+	libdft_die(context);
+
+	return failed != 0;
+}
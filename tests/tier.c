@@ -0,0 +1,201 @@
+/*
+ * tiered instrumentation
+ *
+ * a cold block is instrumented plainly, with a counter at its
+ * entry; the run that reaches the threshold asks the executer,
+ * exactly once, to drop the code of the whole block, and the
+ * block is left to the caller (optimized) from then on
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "libicedft_api.h"
+#include "libicedft_core.h"
+#include "libicedft_tier.h"
+
+
+#define LO		0x1000
+#define NINS		3			/* instructions in the block */
+#define STEP		4			/* bytes per instruction */
+#define THRESHOLD	3
+
+static int failed;
+static tier_ent_t *counter;			/* passed to tier_count */
+static uint32_t ncounters;
+static uint32_t nremoved;
+static ADDRINT removed_lo, removed_hi;
+
+static void
+check(const char *what, int ok)
+{
+	if (ok)
+		return;
+
+	printf("%s\n", what);
+	failed++;
+}
+
+/* the executer; an instruction is its opcode and address */
+static uint32_t
+fake_opcode(idft_ins_t *ins, void *context)
+{
+	(void)context;
+
+	return ins->ins_indx;
+}
+
+static ADDRINT
+fake_address(idft_ins_t *ins, void *context)
+{
+	(void)context;
+
+	return (ADDRINT)(uintptr_t)ins->ins_content;
+}
+
+static idft_reg_t
+fake_operand(idft_ins_t *ins, void *context, idft_reg_t n)
+{
+	(void)ins;
+	(void)context;
+	(void)n;
+
+	return 0;
+}
+
+static uint32_t
+fake_insert(idft_ins_t *ins, void *context, uint32_t action, void *func,
+		uint32_t argc, ...)
+{
+	va_list ap;
+
+	(void)ins;
+	(void)context;
+	(void)action;
+
+	if (func != (void *)tier_count)
+		return 0;
+
+	/* IARG_ADDRINT, the counter */
+	va_start(ap, argc);
+	if (argc == 2 && va_arg(ap, ADDRINT) == IARG_ADDRINT)
+		counter = (tier_ent_t *)(uintptr_t)va_arg(ap, ADDRINT);
+	va_end(ap);
+	ncounters++;
+
+	return 0;
+}
+
+static uint32_t
+fake_remove(ADDRINT lo, ADDRINT hi, void *context)
+{
+	(void)context;
+
+	removed_lo = lo;
+	removed_hi = hi;
+	nremoved++;
+
+	return 0;
+}
+
+/* a block of NINS CPUIDs at lo; instrument it, if cold */
+static int
+cold(idft_context_t *context, ADDRINT lo, uint32_t ins_num)
+{
+	idft_ins_t ins[NINS];
+	uint32_t i;
+
+	for (i = 0; i < NINS; i++) {
+		ins[i].ins_indx		= XED_ICLASS_CPUID;
+		ins[i].ins_content	= (void *)(uintptr_t)(lo + i * STEP);
+	}
+
+	counter		= NULL;
+	ncounters	= 0;
+
+	return tier_cold(ins, ins_num, context);
+}
+
+int
+main(void)
+{
+	idft_executer_api_t api;
+	idft_context_t *context;
+	tier_ent_t *ent;
+	uint32_t i;
+
+	memset(&api, 0, sizeof(api));
+	api.INS_Opcode		= fake_opcode;
+	api.INS_Address		= fake_address;
+	api.INS_OperandIsReg	= fake_operand;
+	api.INS_OperandIsMemory	= fake_operand;
+	api.INS_OperandIsImmediate = fake_operand;
+	api.INS_InsertCall	= fake_insert;
+
+	if (libdft_init(&api, NULL, &context) != 0) {
+		puts("libdft_init failed");
+		return 1;
+	}
+
+	/* without RemoveInstrumentationInRange, nothing is tiered */
+	check("tiered without RemoveInstrumentationInRange",
+			cold(context, LO, NINS) == 0 && ncounters == 0);
+
+	api.RemoveInstrumentationInRange = fake_remove;
+	check("tiered an empty block", cold(context, LO, 0) == 0);
+
+	/* the counter does not fit IARG_ADDRINT; 32-bit ADDRINT, 64-bit host */
+	if (sizeof(ADDRINT) < sizeof(void *)) {
+		libdft_die(context);
+		return failed != 0;
+	}
+
+	check("default threshold",
+			libdft_tier_set_threshold(context, THRESHOLD) ==
+				TIER_THRESHOLD);
+
+	/* cold: one counter, at the entry */
+	check("not cold the first time", cold(context, LO, NINS) == 1);
+	check("no counter", ncounters == 1 && counter != NULL);
+	if ((ent = counter) == NULL) {
+		libdft_die(context);
+		return 1;
+	}
+	check("counter range", ent->lo == LO &&
+			ent->hi == LO + (NINS - 1) * STEP);
+
+	/* the runs before the threshold drop nothing */
+	for (i = 1; i < THRESHOLD; i++)
+		tier_count(ent);
+	check("removed before the threshold", nremoved == 0);
+
+	/* instrumented again before its runs are counted; still cold */
+	check("promoted early", cold(context, LO, NINS) == 1 &&
+			counter == ent);
+
+	/* the run at the threshold drops the whole block, once */
+	tier_count(ent);
+	check("not removed at the threshold", nremoved == 1);
+	check("removed range", removed_lo == LO &&
+			removed_hi == LO + (NINS - 1) * STEP);
+
+	/* the runs in flight are counted, but remove nothing more */
+	for (i = 0; i < 2 * THRESHOLD; i++)
+		tier_count(ent);
+	check("removed twice", nremoved == 1);
+
+	/* hot: left to the caller, with no counter */
+	check("still cold after promotion", cold(context, LO, NINS) == 0 &&
+			ncounters == 0);
+
+	/* another block keeps its own count */
+	check("another block is not cold",
+			cold(context, LO + NINS * STEP, NINS) == 1 &&
+			counter != NULL && counter != ent);
+	check("another block is promoted", nremoved == 1);
+
+	libdft_die(context);
+
+	return failed != 0;
+}
@@ -0,0 +1,126 @@
+/*
+ * XADD tag propagation
+ *
+ * XADD [m], r leaves m + r in memory and the old m in r; the
+ * memory tag must become t[m] | t[r], and the register one t[m]
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libicedft_api.h"
+#include "libicedft_core.h"
+#include "tagmap.h"
+
+
+/* a clean and an unaligned address */
+#define ADDR_A	0x1000
+#define ADDR_U	0x2003
+
+static int failed;
+
+static void
+check(const char *what, size_t got, size_t want)
+{
+	if (got == want)
+		return;
+
+	printf("%s: got %zx, want %zx\n", what, got, want);
+	failed++;
+}
+
+/*
+ * run XADD [addr], EAX (32-bit) with the given tags
+ *
+ * @addr:	the memory operand
+ * @mem:	1 to taint it
+ * @reg:	1 to taint EAX
+ */
+static void
+xadd_m2r_opl(ADDRINT addr, int mem, int reg)
+{
+	thread_ctx_t tc;
+	char what[64];
+
+	memset(&tc, 0, sizeof(tc));
+	tagmap_clrl(addr);
+
+	if (mem)
+		tagmap_setl(addr);
+	if (reg)
+		VCPU_GPR_SET(&tc, GPR_EAX, VCPU_MASK32);
+
+	_xadd_m2r_opl(&tc, GPR_EAX, addr);
+
+	snprintf(what, sizeof(what), "opl %#x mem %d reg %d: mem",
+			(unsigned int)addr, mem, reg);
+	check(what, tagmap_getl(addr) >> VIRT2BIT(addr),
+			(mem | reg) ? LONG_MASK : 0);
+
+	snprintf(what, sizeof(what), "opl %#x mem %d reg %d: reg",
+			(unsigned int)addr, mem, reg);
+	check(what, VCPU_GPR(&tc, GPR_EAX), mem ? VCPU_MASK32 : 0);
+}
+
+/* XADD [addr], AX and AH; the other lanes are left alone */
+static void
+xadd_m2r_narrow(ADDRINT addr)
+{
+	thread_ctx_t tc;
+
+	/* [m] tagged, AX clean */
+	memset(&tc, 0, sizeof(tc));
+	tagmap_clrl(addr);
+	tagmap_setw(addr);
+	VCPU_GPR_SET(&tc, GPR_EAX, 0x0C);
+
+	_xadd_m2r_opw(&tc, GPR_EAX, addr);
+
+	check("opw: mem", tagmap_getl(addr) >> VIRT2BIT(addr), WORD_MASK);
+	check("opw: reg", VCPU_GPR(&tc, GPR_EAX), 0x0F);
+
+	/* [m] clean, AH tagged */
+	memset(&tc, 0, sizeof(tc));
+	tagmap_clrl(addr);
+	VCPU_GPR_SET(&tc, GPR_EAX, 0x02);
+
+	_xadd_m2r_opb_u(&tc, GPR_EAX, addr);
+
+	check("opb_u: mem", tagmap_getl(addr) >> VIRT2BIT(addr), BYTE_MASK);
+	check("opb_u: reg", VCPU_GPR(&tc, GPR_EAX), 0);
+
+	/* [m] tagged, AL clean, AH tagged */
+	memset(&tc, 0, sizeof(tc));
+	tagmap_clrl(addr);
+	tagmap_setb(addr);
+	VCPU_GPR_SET(&tc, GPR_EAX, 0x02);
+
+	_xadd_m2r_opb_l(&tc, GPR_EAX, addr);
+
+	check("opb_l: mem", tagmap_getl(addr) >> VIRT2BIT(addr), BYTE_MASK);
+	check("opb_l: reg", VCPU_GPR(&tc, GPR_EAX), 0x03);
+}
+
+int
+main(void)
+{
+	int mem, reg;
+
+	if (tagmap_alloc() != 0) {
+		puts("tagmap_alloc failed");
+		return 1;
+	}
+
+	for (mem = 0; mem < 2; mem++)
+		for (reg = 0; reg < 2; reg++) {
+			xadd_m2r_opl(ADDR_A, mem, reg);
+			xadd_m2r_opl(ADDR_U, mem, reg);
+		}
+
+	xadd_m2r_narrow(ADDR_A);
+	xadd_m2r_narrow(ADDR_U);
+
+	tagmap_free();
+
+	return failed != 0;
+}